@@ -8,6 +8,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "esp_log.h"
 
@@ -34,6 +35,14 @@
                                         } while(0);
 #endif
 
+// The free slots of the event data slab form a stack linked by slot indexes, like the objects of heap pools. The upper
+// half of the top of the stack holds a tag which changes on every update, so that a compare-and-swap based on a stale
+// top fails even if the same slot is back on top (ABA problem).
+#define DATA_SLOT_NONE                0xffff
+#define DATA_SLOT_INDEX_MASK          0xffff
+#define DATA_SLOT_TAG_INCREMENT       0x10000
+#define DATA_SLOT_MAX_COUNT           (DATA_SLOT_NONE - 1)
+
 /* ------------------------- Static Variables ------------------------------- */
 
 static const char* TAG = "event";
@@ -311,7 +320,19 @@ static esp_err_t loop_node_add_handler(esp_event_loop_node_t* loop_node,
     }
 }
 
-static esp_err_t handler_instances_remove(esp_event_handler_nodes_t* handlers, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
+static void handler_node_delete(esp_event_loop_instance_t* loop, esp_event_handler_node_t* handler)
+{
+    if (loop->dispatching) {
+        // The handler may be the next one to execute in the dispatch in progress, free it afterwards
+        handler->removed = true;
+        SLIST_INSERT_HEAD(&(loop->removed_handlers), handler, next_removed);
+    } else {
+        free(handler->handler_ctx);
+        free(handler);
+    }
+}
+
+static esp_err_t handler_instances_remove(esp_event_loop_instance_t* loop, esp_event_handler_nodes_t* handlers, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
 {
     esp_event_handler_node_t *it, *temp;
 
@@ -319,15 +340,13 @@ static esp_err_t handler_instances_remove(esp_event_handler_nodes_t* handlers, e
         if (legacy) {
             if (it->handler_ctx->handler == handler_ctx->handler) {
                 SLIST_REMOVE(handlers, it, esp_event_handler_node, next);
-                free(it->handler_ctx);
-                free(it);
+                handler_node_delete(loop, it);
                 return ESP_OK;
             }
         } else {
             if (it->handler_ctx == handler_ctx) {
                 SLIST_REMOVE(handlers, it, esp_event_handler_node, next);
-                free(it->handler_ctx);
-                free(it);
+                handler_node_delete(loop, it);
                 return ESP_OK;
             }
         }
@@ -337,16 +356,16 @@ static esp_err_t handler_instances_remove(esp_event_handler_nodes_t* handlers, e
 }
 
 
-static esp_err_t base_node_remove_handler(esp_event_base_node_t* base_node, int32_t id, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
+static esp_err_t base_node_remove_handler(esp_event_loop_instance_t* loop, esp_event_base_node_t* base_node, int32_t id, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
 {
     if (id == ESP_EVENT_ANY_ID) {
-        return handler_instances_remove(&(base_node->handlers), handler_ctx, legacy);
+        return handler_instances_remove(loop, &(base_node->handlers), handler_ctx, legacy);
     }
     else {
         esp_event_id_node_t *it, *temp;
         SLIST_FOREACH_SAFE(it, &(base_node->id_nodes), next, temp) {
             if (it->id == id) {
-                esp_err_t res = handler_instances_remove(&(it->handlers), handler_ctx, legacy);
+                esp_err_t res = handler_instances_remove(loop, &(it->handlers), handler_ctx, legacy);
 
                 if (res == ESP_OK) {
                     if (SLIST_EMPTY(&(it->handlers))) {
@@ -362,16 +381,16 @@ static esp_err_t base_node_remove_handler(esp_event_base_node_t* base_node, int3
     return ESP_ERR_NOT_FOUND;
 }
 
-static esp_err_t loop_node_remove_handler(esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
+static esp_err_t loop_node_remove_handler(esp_event_loop_instance_t* loop, esp_event_loop_node_t* loop_node, esp_event_base_t base, int32_t id, esp_event_handler_instance_context_t* handler_ctx, bool legacy)
 {
     if (base == esp_event_any_base && id == ESP_EVENT_ANY_ID) {
-        return handler_instances_remove(&(loop_node->handlers), handler_ctx, legacy);
+        return handler_instances_remove(loop, &(loop_node->handlers), handler_ctx, legacy);
     }
     else {
         esp_event_base_node_t *it, *temp;
         SLIST_FOREACH_SAFE(it, &(loop_node->base_nodes), next, temp) {
             if (it->base == base) {
-                esp_err_t res = base_node_remove_handler(it, id, handler_ctx, legacy);
+                esp_err_t res = base_node_remove_handler(loop, it, id, handler_ctx, legacy);
 
                 if (res == ESP_OK) {
                     if (SLIST_EMPTY(&(it->handlers)) && SLIST_EMPTY(&(it->id_nodes))) {
@@ -421,20 +440,537 @@ static void loop_node_remove_all_handler(esp_event_loop_node_t* loop_node)
     }
 }
 
-static void inline __attribute__((always_inline)) post_instance_delete(esp_event_post_instance_t* post)
+// Hash of an event, for the buckets of the dispatch index and to pick the task of loops with several tasks
+static uint32_t event_hash(esp_event_base_t base, int32_t id)
 {
-#if CONFIG_ESP_EVENT_POST_FROM_ISR
-    if (post->data_allocated && post->data.ptr) {
-        free(post->data.ptr);
+    uint32_t hash = ((uint32_t) (uintptr_t) base) ^ ((uint32_t) id * 0x9e3779b1);
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    return hash ^ (hash >> 16);
+}
+
+static esp_event_dispatch_entry_t* dispatch_index_find(esp_event_dispatch_index_t* index, esp_event_base_t base, int32_t id)
+{
+    esp_event_dispatch_entry_t* entry = index->buckets[event_hash(base, id) & (index->bucket_count - 1)];
+
+    while (entry != NULL && (entry->base != base || entry->id != id)) {
+        entry = entry->next;
     }
-#else
-    if (post->data) {
-        free(post->data);
+
+    return entry;
+}
+
+// Finds the handlers to execute for an event, in the same order as the loop nodes are walked: loop level handlers,
+// then base level and id level handlers of each matching base node. If handlers is NULL, the handlers are only counted.
+static size_t dispatch_entry_collect(esp_event_loop_instance_t* loop, esp_event_base_t base, int32_t id,
+                                     esp_event_handler_node_t** handlers)
+{
+    size_t count = 0;
+    esp_event_loop_node_t *loop_node;
+    esp_event_base_node_t *base_node;
+    esp_event_id_node_t *id_node;
+    esp_event_handler_node_t *handler;
+
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(handler, &(loop_node->handlers), next) {
+            if (handlers) {
+                handlers[count] = handler;
+            }
+            count++;
+        }
+
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            if (base_node->base != base) {
+                continue;
+            }
+
+            SLIST_FOREACH(handler, &(base_node->handlers), next) {
+                if (handlers) {
+                    handlers[count] = handler;
+                }
+                count++;
+            }
+
+            SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                if (id_node->id == id) {
+                    SLIST_FOREACH(handler, &(id_node->handlers), next) {
+                        if (handlers) {
+                            handlers[count] = handler;
+                        }
+                        count++;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static bool dispatch_index_add(esp_event_loop_instance_t* loop, esp_event_dispatch_index_t* index,
+                               esp_event_dispatch_entry_t* entry, esp_event_base_t base, int32_t id)
+{
+    if (dispatch_index_find(index, base, id) != NULL) {
+        return false;
+    }
+
+    size_t bucket = event_hash(base, id) & (index->bucket_count - 1);
+    entry->base = base;
+    entry->id = id;
+    entry->handler_count = dispatch_entry_collect(loop, base, id, NULL);
+    entry->next = index->buckets[bucket];
+    index->buckets[bucket] = entry;
+
+    return true;
+}
+
+// Builds the dispatch index of a loop. There is an entry for each event with id level handlers, one for each base
+// for the events of the base with no id level handlers, and one for the events of the other bases.
+static esp_event_dispatch_index_t* dispatch_index_build(esp_event_loop_instance_t* loop)
+{
+    esp_event_loop_node_t *loop_node;
+    esp_event_base_node_t *base_node;
+    esp_event_id_node_t *id_node;
+
+    size_t max_entries = 0;
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            max_entries++;
+            SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                max_entries++;
+            }
+        }
+    }
+
+    size_t bucket_count = 1;
+    while (bucket_count < max_entries) {
+        bucket_count <<= 1;
+    }
+
+    esp_event_dispatch_index_t* index = calloc(1, sizeof(*index) + bucket_count * sizeof(esp_event_dispatch_entry_t*)
+                                                  + max_entries * sizeof(esp_event_dispatch_entry_t));
+    if (index == NULL) {
+        return NULL;
+    }
+
+    index->bucket_count = bucket_count;
+    index->buckets = (esp_event_dispatch_entry_t**) (index + 1);
+    esp_event_dispatch_entry_t* entries = (esp_event_dispatch_entry_t*) (index->buckets + bucket_count);
+    size_t entry_count = 0;
+
+    // Create the entries and count their handlers
+    index->any.base = esp_event_any_base;
+    index->any.id = ESP_EVENT_ANY_ID;
+    index->any.handler_count = dispatch_entry_collect(loop, esp_event_any_base, ESP_EVENT_ANY_ID, NULL);
+    size_t handler_count = index->any.handler_count;
+
+    SLIST_FOREACH(loop_node, &(loop->loop_nodes), next) {
+        SLIST_FOREACH(base_node, &(loop_node->base_nodes), next) {
+            if (dispatch_index_add(loop, index, &entries[entry_count], base_node->base, ESP_EVENT_ANY_ID)) {
+                handler_count += entries[entry_count++].handler_count;
+            }
+            SLIST_FOREACH(id_node, &(base_node->id_nodes), next) {
+                if (dispatch_index_add(loop, index, &entries[entry_count], base_node->base, id_node->id)) {
+                    handler_count += entries[entry_count++].handler_count;
+                }
+            }
+        }
+    }
+
+    index->handlers = malloc(handler_count * sizeof(esp_event_handler_node_t*));
+    if (index->handlers == NULL && handler_count != 0) {
+        free(index);
+        return NULL;
+    }
+
+    // Fill in the handlers of the entries
+    esp_event_handler_node_t** handlers = index->handlers;
+
+    index->any.handlers = handlers;
+    dispatch_entry_collect(loop, esp_event_any_base, ESP_EVENT_ANY_ID, handlers);
+    handlers += index->any.handler_count;
+
+    for (size_t i = 0; i < entry_count; i++) {
+        entries[i].handlers = handlers;
+        dispatch_entry_collect(loop, entries[i].base, entries[i].id, handlers);
+        handlers += entries[i].handler_count;
+    }
+
+    return index;
+}
+
+static void dispatch_index_delete(esp_event_dispatch_index_t* index)
+{
+    if (index) {
+        free(index->handlers);
+        free(index);
+    }
+}
+
+// Called when handlers are registered or unregistered, the index is built again on the next dispatch
+static void dispatch_index_invalidate(esp_event_loop_instance_t* loop)
+{
+    esp_event_dispatch_index_t* index = loop->dispatch_index;
+
+    if (index == NULL) {
+        return;
+    }
+
+    if (loop->dispatching) {
+        // The dispatch in progress may still walk the handlers of the index, free it afterwards
+        index->next = loop->retired_indexes;
+        loop->retired_indexes = index;
+    } else {
+        dispatch_index_delete(index);
+    }
+
+    loop->dispatch_index = NULL;
+}
+
+static esp_event_dispatch_entry_t* dispatch_index_lookup(esp_event_dispatch_index_t* index, esp_event_base_t base, int32_t id)
+{
+    esp_event_dispatch_entry_t* entry = dispatch_index_find(index, base, id);
+
+    if (entry == NULL) {
+        entry = dispatch_index_find(index, base, ESP_EVENT_ANY_ID);
+    }
+
+    return entry ? entry : &(index->any);
+}
+
+// Executes the handlers of an event by walking the loop nodes, for when the dispatch index can't be allocated
+static bool dispatch_nodes(esp_event_loop_instance_t* loop, esp_event_post_instance_t post)
+{
+    bool exec = false;
+
+    esp_event_handler_node_t *handler, *temp_handler;
+    esp_event_loop_node_t *loop_node, *temp_node;
+    esp_event_base_node_t *base_node, *temp_base;
+    esp_event_id_node_t *id_node, *temp_id_node;
+
+    SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
+        // Execute loop level handlers
+        SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
+            if (!handler->removed) {
+                handler_execute(loop, handler, post);
+                exec |= true;
+            }
+        }
+
+        SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
+            if (base_node->base == post.base) {
+                // Execute base level handlers
+                SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
+                    if (!handler->removed) {
+                        handler_execute(loop, handler, post);
+                        exec |= true;
+                    }
+                }
+
+                SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
+                    if (id_node->id == post.id) {
+                        // Execute id level handlers
+                        SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
+                            if (!handler->removed) {
+                                handler_execute(loop, handler, post);
+                                exec |= true;
+                            }
+                        }
+                        // Skip to next base node
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return exec;
+}
+
+// Called with the loop mutex held when handlers have been registered while the handlers of entry execute, the first
+// count of them being done. Returns the entry of the event in the index built again, setting count to the number of
+// its handlers which come before the next one to execute, so that the handlers registered after the one executing
+// are executed in this dispatch too, as when walking the handler lists.
+static esp_event_dispatch_entry_t* dispatch_entry_resume(esp_event_loop_instance_t* loop,
+        esp_event_dispatch_entry_t* entry, esp_event_post_instance_t post, size_t* count)
+{
+    if (loop->dispatch_index == NULL) {
+        loop->dispatch_index = dispatch_index_build(loop);
+    }
+
+    if (loop->dispatch_index == NULL) {
+        ESP_LOGD(TAG, "alloc for dispatch index failed, not executing the handlers registered during dispatch");
+        return entry;
+    }
+
+    esp_event_dispatch_entry_t* next = dispatch_index_lookup(loop->dispatch_index, post.base, post.id);
+    size_t resume = 0;
+
+    // The handlers keep their relative order in the index, resume after the last one already done
+    for (size_t i = 0; i < next->handler_count; i++) {
+        for (size_t j = 0; j < *count; j++) {
+            if (next->handlers[i] == entry->handlers[j]) {
+                resume = i + 1;
+                break;
+            }
+        }
+    }
+
+    *count = resume;
+    return next;
+}
+
+// Executes the handlers of an event, with the loop mutex held. Handlers may register and unregister handlers, so
+// the index and the handlers unregistered during the dispatch are only freed once it is over. For concurrent
+// dispatches by the tasks of loops with several tasks, the mutex is released while the handlers execute.
+static bool esp_event_loop_dispatch(esp_event_loop_instance_t* loop, esp_event_post_instance_t post, bool concurrent)
+{
+    bool exec = false;
+
+    if (loop->dispatch_index == NULL) {
+        loop->dispatch_index = dispatch_index_build(loop);
+    }
+
+    loop->dispatching++;
+
+    if (loop->dispatch_index != NULL) {
+        esp_event_dispatch_entry_t* entry = dispatch_index_lookup(loop->dispatch_index, post.base, post.id);
+        uint32_t registrations = atomic_load_explicit(&loop->registrations, memory_order_relaxed);
+
+        if (concurrent) {
+            xSemaphoreGiveRecursive(loop->mutex);
+        }
+
+        size_t i = 0;
+        while (i < entry->handler_count) {
+            esp_event_handler_node_t* handler = entry->handlers[i++];
+
+            if (!handler->removed) {
+                handler_execute(loop, handler, post);
+                exec = true;
+            }
+
+            if (atomic_load_explicit(&loop->registrations, memory_order_relaxed) != registrations) {
+                if (concurrent) {
+                    xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+                }
+
+                registrations = atomic_load_explicit(&loop->registrations, memory_order_relaxed);
+                entry = dispatch_entry_resume(loop, entry, post, &i);
+
+                if (concurrent) {
+                    xSemaphoreGiveRecursive(loop->mutex);
+                }
+            }
+        }
+
+        if (concurrent) {
+            xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+        }
+    } else {
+        ESP_LOGD(TAG, "alloc for dispatch index failed, walking handler lists");
+        exec = dispatch_nodes(loop, post);
+    }
+
+    loop->dispatching--;
+
+    if (!loop->dispatching) {
+        esp_event_dispatch_index_t* index;
+        while ((index = loop->retired_indexes) != NULL) {
+            loop->retired_indexes = index->next;
+            dispatch_index_delete(index);
+        }
+
+        esp_event_handler_node_t* handler;
+        while ((handler = SLIST_FIRST(&(loop->removed_handlers))) != NULL) {
+            SLIST_REMOVE_HEAD(&(loop->removed_handlers), next_removed);
+            free(handler->handler_ctx);
+            free(handler);
+        }
+    }
+
+    return exec;
+}
+
+static void* data_slot_alloc(esp_event_loop_instance_t* loop)
+{
+    uint32_t top = atomic_load_explicit(&loop->data_slots_free, memory_order_acquire);
+    uint32_t new_top;
+    size_t index;
+    do {
+        index = top & DATA_SLOT_INDEX_MASK;
+        if (index == DATA_SLOT_NONE) {
+            return NULL;
+        }
+        // if the slot was taken in the meantime, this reads a stale index but the tag makes the exchange fail
+        uint16_t next = atomic_load_explicit(&loop->data_slots_next[index], memory_order_relaxed);
+        new_top = ((top + DATA_SLOT_TAG_INCREMENT) & ~DATA_SLOT_INDEX_MASK) | next;
+    } while (!atomic_compare_exchange_weak_explicit(&loop->data_slots_free, &top, new_top,
+                                                    memory_order_acquire, memory_order_acquire));
+
+    return loop->data_slots + index * loop->data_slot_size;
+}
+
+static bool data_slot_free(esp_event_loop_instance_t* loop, void* data)
+{
+    uint8_t* slot = (uint8_t*) data;
+
+    if (slot < loop->data_slots || slot >= loop->data_slots + loop->data_slot_count * loop->data_slot_size) {
+        // allocated from heap
+        return false;
     }
+
+    size_t index = (slot - loop->data_slots) / loop->data_slot_size;
+    uint32_t top = atomic_load_explicit(&loop->data_slots_free, memory_order_relaxed);
+    uint32_t new_top;
+    do {
+        atomic_store_explicit(&loop->data_slots_next[index], top & DATA_SLOT_INDEX_MASK, memory_order_relaxed);
+        new_top = ((top + DATA_SLOT_TAG_INCREMENT) & ~DATA_SLOT_INDEX_MASK) | index;
+    } while (!atomic_compare_exchange_weak_explicit(&loop->data_slots_free, &top, new_top,
+                                                    memory_order_release, memory_order_relaxed));
+    return true;
+}
+
+static void inline __attribute__((always_inline)) post_instance_delete(esp_event_loop_instance_t* loop,
+                                                                       esp_event_post_instance_t* post)
+{
+#if CONFIG_ESP_EVENT_POST_FROM_ISR
+    void* data = post->data_allocated ? post->data.ptr : NULL;
+#else
+    void* data = post->data;
 #endif
+    if (data != NULL && !data_slot_free(loop, data)) {
+        free(data);
+    }
     memset(post, 0, sizeof(*post));
 }
 
+static void esp_event_loop_run_worker_task(void* args)
+{
+    esp_event_loop_worker_t* worker = (esp_event_loop_worker_t*) args;
+    esp_event_loop_instance_t* loop = worker->loop;
+    esp_event_post_instance_t post;
+
+    ESP_LOGD(TAG, "running task %p for loop %p", worker->task, loop);
+
+    while(1) {
+        if (xQueueReceive(worker->queue, &post, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        xSemaphoreTake(worker->dispatch_mutex, portMAX_DELAY);
+        xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
+
+        bool exec = esp_event_loop_dispatch(loop, post, true);
+
+        xSemaphoreGiveRecursive(loop->mutex);
+        xSemaphoreGive(worker->dispatch_mutex);
+
+        if (!exec) {
+            // No handlers were registered, not even loop/base level handlers
+            ESP_LOGD(TAG, "no handlers have been registered for event %s:%d posted to loop %p", post.base, post.id, loop);
+        }
+
+        post_instance_delete(loop, &post);
+    }
+}
+
+static esp_err_t esp_event_loop_workers_create(esp_event_loop_instance_t* loop, const esp_event_loop_args_t* event_loop_args)
+{
+    loop->workers = calloc(event_loop_args->task_count, sizeof(esp_event_loop_worker_t));
+    if (loop->workers == NULL) {
+        ESP_LOGE(TAG, "alloc for event loop tasks failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    loop->worker_count = event_loop_args->task_count;
+
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        esp_event_loop_worker_t* worker = &(loop->workers[i]);
+
+        worker->loop = loop;
+
+        worker->queue = xQueueCreate(event_loop_args->queue_size, sizeof(esp_event_post_instance_t));
+        if (worker->queue == NULL) {
+            ESP_LOGE(TAG, "create event loop queue failed");
+            return ESP_ERR_NO_MEM;
+        }
+
+        worker->dispatch_mutex = xSemaphoreCreateMutex();
+        if (worker->dispatch_mutex == NULL) {
+            ESP_LOGE(TAG, "create event loop dispatch mutex failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        esp_event_loop_worker_t* worker = &(loop->workers[i]);
+        BaseType_t core_id = event_loop_args->task_core_id;
+
+        if (core_id != tskNO_AFFINITY) {
+            core_id = (core_id + i) % portNUM_PROCESSORS;
+        }
+
+        BaseType_t task_created = xTaskCreatePinnedToCore(esp_event_loop_run_worker_task, event_loop_args->task_name,
+                    event_loop_args->task_stack_size, (void*) worker,
+                    event_loop_args->task_priority, &(worker->task), core_id);
+
+        if (task_created != pdPASS) {
+            ESP_LOGE(TAG, "create task for loop failed");
+            worker->task = NULL;
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+// The tasks must not be dispatching events, see esp_event_loop_delete
+static void esp_event_loop_workers_delete(esp_event_loop_instance_t* loop)
+{
+    if (loop->workers == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        esp_event_loop_worker_t* worker = &(loop->workers[i]);
+
+        if (worker->task != NULL) {
+            vTaskDelete(worker->task);
+        }
+
+        if (worker->queue != NULL) {
+            // Drop existing posts on the queue
+            esp_event_post_instance_t post;
+            while(xQueueReceive(worker->queue, &post, 0) == pdTRUE) {
+                post_instance_delete(loop, &post);
+            }
+            vQueueDelete(worker->queue);
+        }
+
+        if (worker->dispatch_mutex != NULL) {
+            vSemaphoreDelete(worker->dispatch_mutex);
+        }
+    }
+
+    free(loop->workers);
+    loop->workers = NULL;
+}
+
+static bool esp_event_loop_is_worker(esp_event_loop_instance_t* loop, TaskHandle_t task)
+{
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        if (loop->workers[i].task == task) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /* ---------------------------- Public API --------------------------------- */
 
 esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, esp_event_loop_handle_t* event_loop)
@@ -452,16 +988,61 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
     esp_event_loop_instance_t* loop;
     esp_err_t err = ESP_ERR_NO_MEM; // most likely error
 
+    if (event_loop_args->task_count > 1 && event_loop_args->task_name == NULL) {
+        ESP_LOGE(TAG, "task_count was larger than 1 with no task name");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (event_loop_args->data_slot_count > DATA_SLOT_MAX_COUNT) {
+        ESP_LOGE(TAG, "data_slot_count was larger than %d", DATA_SLOT_MAX_COUNT);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     loop = calloc(1, sizeof(*loop));
     if (loop == NULL) {
         ESP_LOGE(TAG, "alloc for event loop failed");
         return err;
     }
 
-    loop->queue = xQueueCreate(event_loop_args->queue_size , sizeof(esp_event_post_instance_t));
-    if (loop->queue == NULL) {
-        ESP_LOGE(TAG, "create event loop queue failed");
-        goto on_err;
+    atomic_init(&loop->data_slots_free, DATA_SLOT_NONE);
+    atomic_init(&loop->registrations, 0);
+
+    if (event_loop_args->data_slot_size != 0 && event_loop_args->data_slot_count != 0) {
+        size_t slot_size = (event_loop_args->data_slot_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        size_t slot_count = event_loop_args->data_slot_count;
+
+        if (slot_size < event_loop_args->data_slot_size
+                || slot_size > (SIZE_MAX - slot_count * sizeof(uint16_t)) / slot_count) {
+            ESP_LOGE(TAG, "data_slot_size was too large");
+            err = ESP_ERR_INVALID_ARG;
+            goto on_err;
+        }
+
+        // The slots are followed by the links of the free slots
+        loop->data_slots = malloc(slot_count * (slot_size + sizeof(uint16_t)));
+        if (loop->data_slots == NULL) {
+            ESP_LOGE(TAG, "alloc for event data slab failed");
+            goto on_err;
+        }
+
+        loop->data_slot_size = slot_size;
+        loop->data_slot_count = slot_count;
+        loop->data_slots_next = (atomic_uint_least16_t*) (loop->data_slots + slot_count * slot_size);
+        for (size_t i = 0; i < slot_count; i++) {
+            atomic_init(&loop->data_slots_next[i], (i + 1 < slot_count) ? i + 1 : DATA_SLOT_NONE);
+        }
+        atomic_init(&loop->data_slots_free, 0);
+    }
+
+    bool workers = event_loop_args->task_count > 1;
+
+    // Each task of loops with several tasks has its own queue
+    if (!workers) {
+        loop->queue = xQueueCreate(event_loop_args->queue_size , sizeof(esp_event_post_instance_t));
+        if (loop->queue == NULL) {
+            ESP_LOGE(TAG, "create event loop queue failed");
+            goto on_err;
+        }
     }
 
     loop->mutex = xSemaphoreCreateRecursiveMutex();
@@ -481,7 +1062,17 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
     SLIST_INIT(&(loop->loop_nodes));
 
     // Create the loop task if requested
-    if (event_loop_args->task_name != NULL) {
+    if (workers) {
+        err = esp_event_loop_workers_create(loop, event_loop_args);
+        if (err != ESP_OK) {
+            goto on_err;
+        }
+
+        loop->name = event_loop_args->task_name;
+        loop->task = NULL;
+
+        ESP_LOGD(TAG, "created %u tasks for loop %p", (unsigned) loop->worker_count, loop);
+    } else if (event_loop_args->task_name != NULL) {
         BaseType_t task_created = xTaskCreatePinnedToCore(esp_event_loop_run_task, event_loop_args->task_name,
                     event_loop_args->task_stack_size, (void*) loop,
                     event_loop_args->task_priority, &(loop->task), event_loop_args->task_core_id);
@@ -515,6 +1106,8 @@ esp_err_t esp_event_loop_create(const esp_event_loop_args_t* event_loop_args, es
     return ESP_OK;
 
 on_err:
+    esp_event_loop_workers_delete(loop);
+
     if (loop->queue != NULL) {
         vQueueDelete(loop->queue);
     }
@@ -529,23 +1122,29 @@ on_err:
     }
 #endif
 
+    free(loop->data_slots);
     free(loop);
 
     return err;
 }
 
-// On event lookup performance: The library implements the event list as a linked list, which results to O(n)
-// lookup time. The test comparing this implementation to the O(lg n) performance of rbtrees
-// (https://github.com/freebsd/freebsd/blob/master/sys/sys/tree.h)
-// indicate that the difference is not that substantial, especially considering the additional
-// pointers per node of rbtrees. Code for the rbtree implementation of the event loop library is archived
-// in feature/esp_event_loop_library_rbtrees if needed.
+// On event lookup performance: The library keeps the registered handlers in linked lists of loop, base and id nodes,
+// which preserve the registration order. Dispatch doesn't walk these lists: the handlers to execute for each
+// registered event are collected once into the dispatch index, a hash table by event base and id which is built again
+// after handlers are registered or unregistered. Dispatch cost therefore doesn't depend on the number of registered
+// events.
 esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t ticks_to_run)
 {
     assert(event_loop);
 
     esp_event_loop_instance_t* loop = (esp_event_loop_instance_t*) event_loop;
     esp_event_post_instance_t post;
+
+    if (loop->workers != NULL) {
+        ESP_LOGE(TAG, "loop %p is run by its tasks", loop);
+        return ESP_ERR_INVALID_STATE;
+    }
+
     TickType_t marker = xTaskGetTickCount();
     TickType_t end = 0;
 
@@ -561,47 +1160,12 @@ esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t tick
 
         loop->running_task = xTaskGetCurrentTaskHandle();
 
-        bool exec = false;
-
-        esp_event_handler_node_t *handler, *temp_handler;
-        esp_event_loop_node_t *loop_node, *temp_node;
-        esp_event_base_node_t *base_node, *temp_base;
-        esp_event_id_node_t *id_node, *temp_id_node;
-
-        SLIST_FOREACH_SAFE(loop_node, &(loop->loop_nodes), next, temp_node) {
-            // Execute loop level handlers
-            SLIST_FOREACH_SAFE(handler, &(loop_node->handlers), next, temp_handler) {
-                handler_execute(loop, handler, post);
-                exec |= true;
-            }
-
-            SLIST_FOREACH_SAFE(base_node, &(loop_node->base_nodes), next, temp_base) {
-                if (base_node->base == post.base) {
-                    // Execute base level handlers
-                    SLIST_FOREACH_SAFE(handler, &(base_node->handlers), next, temp_handler) {
-                        handler_execute(loop, handler, post);
-                        exec |= true;
-                    }
-
-                    SLIST_FOREACH_SAFE(id_node, &(base_node->id_nodes), next, temp_id_node) {
-                        if (id_node->id == post.id) {
-                            // Execute id level handlers
-                            SLIST_FOREACH_SAFE(handler, &(id_node->handlers), next, temp_handler) {
-                                handler_execute(loop, handler, post);
-                                exec |= true;
-                            }
-                            // Skip to next base node
-                            break;
-                        }
-                    }
-                }
-            }
-        }
+        bool exec = esp_event_loop_dispatch(loop, post, false);
 
         esp_event_base_t base = post.base;
         int32_t id = post.id;
 
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
         if (ticks_to_run != portMAX_DELAY) {
             end = xTaskGetTickCount();
@@ -638,6 +1202,12 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
     SemaphoreHandle_t loop_profiling_mutex = loop->profiling_mutex;
 #endif
 
+    // Wait for the tasks of the loop to finish their dispatches, they take the loop mutex while holding their dispatch
+    // mutex
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        xSemaphoreTake(loop->workers[i].dispatch_mutex, portMAX_DELAY);
+    }
+
     xSemaphoreTakeRecursive(loop->mutex, portMAX_DELAY);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
@@ -652,6 +1222,12 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
         vTaskDelete(loop->task);
     }
 
+    for (uint32_t i = 0; i < loop->worker_count; i++) {
+        vTaskDelete(loop->workers[i].task);
+        loop->workers[i].task = NULL;
+        xSemaphoreGive(loop->workers[i].dispatch_mutex);
+    }
+
     // Remove all registered events and handlers in the loop
     esp_event_loop_node_t *it, *temp;
     SLIST_FOREACH_SAFE(it, &(loop->loop_nodes), next, temp) {
@@ -661,13 +1237,19 @@ esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
     }
 
     // Drop existing posts on the queue
-    esp_event_post_instance_t post;
-    while(xQueueReceive(loop->queue, &post, 0) == pdTRUE) {
-        post_instance_delete(&post);
+    if (loop->queue != NULL) {
+        esp_event_post_instance_t post;
+        while(xQueueReceive(loop->queue, &post, 0) == pdTRUE) {
+            post_instance_delete(loop, &post);
+        }
+
+        vQueueDelete(loop->queue);
     }
 
     // Cleanup loop
-    vQueueDelete(loop->queue);
+    esp_event_loop_workers_delete(loop);
+    dispatch_index_delete(loop->dispatch_index);
+    free(loop->data_slots);
     free(loop);
     // Free loop mutex before deleting
     xSemaphoreGiveRecursive(loop_mutex);
@@ -742,6 +1324,11 @@ esp_err_t esp_event_handler_register_with_internal(esp_event_loop_handle_t event
         err = loop_node_add_handler(last_loop_node, event_base, event_id, event_handler, event_handler_arg, handler_ctx_arg, legacy);
     }
 
+    if (err == ESP_OK) {
+        dispatch_index_invalidate(loop);
+        atomic_fetch_add_explicit(&loop->registrations, 1, memory_order_relaxed);
+    }
+
 on_err:
     xSemaphoreGiveRecursive(loop->mutex);
     return err;
@@ -782,7 +1369,7 @@ esp_err_t esp_event_handler_unregister_with_internal(esp_event_loop_handle_t eve
     esp_event_loop_node_t *it, *temp;
 
     SLIST_FOREACH_SAFE(it, &(loop->loop_nodes), next, temp) {
-        esp_err_t res = loop_node_remove_handler(it, event_base, event_id, handler_ctx, legacy);
+        esp_err_t res = loop_node_remove_handler(loop, it, event_base, event_id, handler_ctx, legacy);
 
         if (res == ESP_OK && SLIST_EMPTY(&(it->base_nodes)) && SLIST_EMPTY(&(it->handlers))) {
             SLIST_REMOVE(&(loop->loop_nodes), it, esp_event_loop_node, next);
@@ -791,8 +1378,20 @@ esp_err_t esp_event_handler_unregister_with_internal(esp_event_loop_handle_t eve
         }
     }
 
+    dispatch_index_invalidate(loop);
+
     xSemaphoreGiveRecursive(loop->mutex);
 
+    // The tasks of loops with several tasks execute handlers without the loop mutex. Wait for the dispatches in
+    // progress to finish, so that the handler is not executing anymore once this returns, unless it is unregistered
+    // from a handler.
+    if (loop->workers != NULL && !esp_event_loop_is_worker(loop, xTaskGetCurrentTaskHandle())) {
+        for (uint32_t i = 0; i < loop->worker_count; i++) {
+            xSemaphoreTake(loop->workers[i].dispatch_mutex, portMAX_DELAY);
+            xSemaphoreGive(loop->workers[i].dispatch_mutex);
+        }
+    }
+
     return ESP_OK;
 }
 
@@ -829,11 +1428,19 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     memset((void*)(&post), 0, sizeof(post));
 
     if (event_data != NULL && event_data_size != 0) {
-        // Make persistent copy of event data on heap.
-        void* event_data_copy = calloc(1, event_data_size);
+        // Make persistent copy of event data, in a slot of the loop's slab if it fits and one is free, or on heap.
+        void* event_data_copy = NULL;
+
+        if (event_data_size <= loop->data_slot_size) {
+            event_data_copy = data_slot_alloc(loop);
+        }
 
         if (event_data_copy == NULL) {
-            return ESP_ERR_NO_MEM;
+            event_data_copy = calloc(1, event_data_size);
+
+            if (event_data_copy == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
         }
 
         memcpy(event_data_copy, event_data, event_data_size);
@@ -849,33 +1456,42 @@ esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t
     post.id = event_id;
 
     BaseType_t result = pdFALSE;
+    QueueHandle_t queue = loop->queue;
+    TaskHandle_t task = loop->task;
+
+    if (loop->workers != NULL) {
+        // Events with the same base and id are always dispatched by the same task, in the order they were posted
+        esp_event_loop_worker_t* worker = &(loop->workers[event_hash(event_base, event_id) % loop->worker_count]);
+        queue = worker->queue;
+        task = worker->task;
+    }
 
-    // Find the task that currently executes the loop. It is safe to query loop->task since it is
-    // not mutated since loop creation. ENSURE THIS REMAINS TRUE.
-    if (loop->task == NULL) {
+    // Find the task that currently executes the loop. It is safe to query loop->task and the tasks of
+    // loop->workers since they are not mutated since loop creation. ENSURE THIS REMAINS TRUE.
+    if (task == NULL) {
         // The loop has no dedicated task. Find out what task is currently running it.
         result = xSemaphoreTakeRecursive(loop->mutex, ticks_to_wait);
 
         if (result == pdTRUE) {
             if (loop->running_task != xTaskGetCurrentTaskHandle()) {
                 xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
+                result = xQueueSendToBack(queue, &post, ticks_to_wait);
             } else {
                 xSemaphoreGiveRecursive(loop->mutex);
-                result = xQueueSendToBack(loop->queue, &post, 0);
+                result = xQueueSendToBack(queue, &post, 0);
             }
         }
     } else {
         // The loop has a dedicated task.
-        if (loop->task != xTaskGetCurrentTaskHandle()) {
-            result = xQueueSendToBack(loop->queue, &post, ticks_to_wait);
+        if (task != xTaskGetCurrentTaskHandle()) {
+            result = xQueueSendToBack(queue, &post, ticks_to_wait);
         } else {
-            result = xQueueSendToBack(loop->queue, &post, 0);
+            result = xQueueSendToBack(queue, &post, 0);
         }
     }
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
@@ -918,12 +1534,17 @@ esp_err_t esp_event_isr_post_to(esp_event_loop_handle_t event_loop, esp_event_ba
     post.id = event_id;
 
     BaseType_t result = pdFALSE;
+    QueueHandle_t queue = loop->queue;
+
+    if (loop->workers != NULL) {
+        queue = loop->workers[event_hash(event_base, event_id) % loop->worker_count].queue;
+    }
 
     // Post the event from an ISR,
-    result = xQueueSendToBackFromISR(loop->queue, &post, task_unblocked);
+    result = xQueueSendToBackFromISR(queue, &post, task_unblocked);
 
     if (result != pdTRUE) {
-        post_instance_delete(&post);
+        post_instance_delete(loop, &post);
 
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
         atomic_fetch_add(&loop->events_dropped, 1);
@@ -966,7 +1587,7 @@ esp_err_t esp_event_dump(FILE* file)
         events_recieved = atomic_load(&loop_it->events_recieved);
         events_dropped = atomic_load(&loop_it->events_dropped);
 
-        PRINT_DUMP_INFO(dst, sz, LOOP_DUMP_FORMAT, loop_it, loop_it->task != NULL ? loop_it->name : "none" ,
+        PRINT_DUMP_INFO(dst, sz, LOOP_DUMP_FORMAT, loop_it, (loop_it->task != NULL || loop_it->workers != NULL) ? loop_it->name : "none" ,
                         events_recieved, events_dropped);
 
         int sz_bak = sz;
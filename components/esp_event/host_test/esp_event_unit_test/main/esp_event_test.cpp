@@ -10,6 +10,12 @@
 #define CATCH_CONFIG_MAIN
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "esp_event.h"
 
 #include "catch.hpp"
@@ -43,6 +49,88 @@ static esp_event_loop_args_t test_event_get_default_loop_args(void)
 
 void dummy_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data) { }
 
+ESP_EVENT_DEFINE_BASE(s_test_base);
+ESP_EVENT_DEFINE_BASE(s_test_base2);
+
+// Records the data of each dispatched event, the size of the data is the event id
+void record_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    std::vector<std::vector<uint8_t> > *received = static_cast<std::vector<std::vector<uint8_t> >*>(event_handler_arg);
+    const uint8_t *data = static_cast<const uint8_t*>(event_data);
+    received->emplace_back(data, data + event_id);
+}
+
+// Records the handler argument of each executed handler
+void order_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    std::vector<int> *order = *static_cast<std::vector<int>**>(event_data);
+    order->push_back(static_cast<int>(reinterpret_cast<intptr_t>(event_handler_arg)));
+}
+
+// Registers order_handler with the argument 10 for the dispatched event and 11 for any event, the first time only
+void registering_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    esp_event_loop_handle_t *loop = static_cast<esp_event_loop_handle_t*>(event_handler_arg);
+    esp_event_handler_instance_t instance;
+    if (*loop != nullptr) {
+        CHECK(ESP_OK == esp_event_handler_instance_register_with(*loop, event_base, event_id, order_handler,
+                reinterpret_cast<void*>(10), &instance));
+        CHECK(ESP_OK == esp_event_handler_instance_register_with(*loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID,
+                order_handler, reinterpret_cast<void*>(11), &instance));
+        *loop = nullptr;
+    }
+}
+
+// Checks that the events of each id are dispatched in the order they were posted, the event data being the sequence
+// number of the event among the events with the same id
+struct SequenceCheck {
+    static const int IDS = 8;
+
+    SequenceCheck(int handler_us) : handler_us(handler_us)
+    {
+        for (int id = 0; id < IDS; id++) {
+            last[id] = -1;
+        }
+    }
+
+    int handler_us;
+    std::atomic<int> last[IDS];
+    std::atomic<int> out_of_order{0};
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    std::atomic<int> dispatched{0};
+};
+
+void sequence_handler(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    SequenceCheck *check = static_cast<SequenceCheck*>(event_handler_arg);
+    int sequence = *static_cast<int*>(event_data);
+
+    int running = ++check->running;
+    int max_running = check->max_running;
+    while (running > max_running && !check->max_running.compare_exchange_weak(max_running, running)) { }
+
+    if (check->last[event_id].exchange(sequence) != sequence - 1) {
+        check->out_of_order++;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(check->handler_us));
+
+    check->running--;
+    check->dispatched++;
+}
+
+void wait_dispatched(SequenceCheck &check, int events)
+{
+    while (check.dispatched < events) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+double elapsed_ns(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
 }
 
 // TODO: IDF-2693, function definition just to satisfy linker, implement esp_common instead
@@ -150,3 +238,304 @@ TEST_CASE("registering with ANY_BASE but specific ID fails") {
             dummy_handler,
             nullptr) == ESP_ERR_INVALID_ARG);
 }
+
+
+TEST_CASE("test esp_event_loop_create with too many data slots fails")
+{
+    esp_event_loop_handle_t loop;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.data_slot_size = 16;
+    loop_args.data_slot_count = 0x10000;
+
+    CHECK(ESP_ERR_INVALID_ARG == esp_event_loop_create(&loop_args, &loop));
+}
+
+TEST_CASE("event data is copied into data slots or on heap")
+{
+    FakeQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    std::vector<std::vector<uint8_t> > received;
+
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    loop_args.data_slot_size = 8;
+    loop_args.data_slot_count = 2;
+
+    REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+    REQUIRE(ESP_OK == esp_event_handler_register_with(loop, s_test_base, ESP_EVENT_ANY_ID, record_handler, &received));
+
+    // the first two events fit in the slots, the third one doesn't find a free slot and the last one is too large
+    std::vector<std::vector<uint8_t> > posted;
+    for (int size : { 8, 1, 5, 33 }) {
+        std::vector<uint8_t> data(size);
+        for (int i = 0; i < size; i++) {
+            data[i] = size + i;
+        }
+        CHECK(ESP_OK == esp_event_post_to(loop, s_test_base, size, data.data(), size, 0));
+        posted.push_back(data);
+    }
+    CHECK(ESP_OK == esp_event_loop_run(loop, portMAX_DELAY));
+    CHECK(received == posted);
+
+    // slots are released after dispatch
+    received.clear();
+    for (int i = 0; i < 3; i++) {
+        for (int size : { 4, 8 }) {
+            uint8_t data[8] = { };
+            CHECK(ESP_OK == esp_event_post_to(loop, s_test_base, size, data, size, 0));
+        }
+        CHECK(ESP_OK == esp_event_loop_run(loop, portMAX_DELAY));
+    }
+    CHECK(received.size() == 6);
+
+    // events still in the queue are dropped when the loop is deleted
+    uint8_t data[64] = { };
+    CHECK(ESP_OK == esp_event_post_to(loop, s_test_base, 8, data, 8, 0));
+    CHECK(ESP_OK == esp_event_post_to(loop, s_test_base, 64, data, 64, 0));
+    CHECK(ESP_OK == esp_event_loop_delete(loop));
+}
+
+TEST_CASE("posting throughput benchmark", "[benchmark][.]")
+{
+    const int EVENTS = 100000;
+    const size_t DATA_SIZE = 16;
+
+    for (uint32_t slots : { 0u, QUEUE_SIZE }) {
+        FakeQueue queue;
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_name = nullptr;
+        loop_args.data_slot_size = slots ? DATA_SIZE : 0;
+        loop_args.data_slot_count = slots;
+
+        REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+        REQUIRE(ESP_OK == esp_event_handler_register_with(loop, s_test_base, ESP_EVENT_ANY_ID, dummy_handler, nullptr));
+
+        // events are posted in batches of the queue size, then dispatched
+        uint8_t data[DATA_SIZE] = { };
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < EVENTS; i++) {
+            esp_event_post_to(loop, s_test_base, i, data, sizeof(data), 0);
+            if (i % QUEUE_SIZE == QUEUE_SIZE - 1) {
+                esp_event_loop_run(loop, portMAX_DELAY);
+            }
+        }
+        esp_event_loop_run(loop, portMAX_DELAY);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        CHECK(FakeQueue::items.empty());
+
+        printf("%s, %u bytes of data: %.1f ns per posted and dispatched event\n",
+                slots ? "data slab" : "heap", (unsigned) DATA_SIZE, elapsed_ns(start, end) / EVENTS);
+
+        CHECK(ESP_OK == esp_event_loop_delete(loop));
+    }
+}
+
+TEST_CASE("handlers are dispatched in registration order")
+{
+    FakeQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_handler_instance_t instances[5];
+
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+
+    const struct {
+        esp_event_base_t base;
+        int32_t id;
+    } registrations[] = {
+        { ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID },
+        { s_test_base, 1 },
+        { s_test_base, ESP_EVENT_ANY_ID },
+        { ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID },
+        { s_test_base, 1 },
+    };
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(ESP_OK == esp_event_handler_instance_register_with(loop, registrations[i].base, registrations[i].id,
+                order_handler, reinterpret_cast<void*>(i), &instances[i]));
+    }
+
+    auto dispatch = [loop](esp_event_base_t base, int32_t id) {
+        std::vector<int> order;
+        std::vector<int> *order_ptr = &order;
+        CHECK(ESP_OK == esp_event_post_to(loop, base, id, &order_ptr, sizeof(order_ptr), 0));
+        CHECK(ESP_OK == esp_event_loop_run(loop, portMAX_DELAY));
+        return order;
+    };
+
+    CHECK(dispatch(s_test_base, 1) == std::vector<int>({ 0, 1, 2, 3, 4 }));
+    CHECK(dispatch(s_test_base, 2) == std::vector<int>({ 0, 2, 3 }));
+    CHECK(dispatch(s_test_base2, 1) == std::vector<int>({ 0, 3 }));
+
+    REQUIRE(ESP_OK == esp_event_handler_instance_unregister_with(loop, s_test_base, 1, instances[1]));
+    REQUIRE(ESP_OK == esp_event_handler_instance_unregister_with(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, instances[0]));
+    CHECK(dispatch(s_test_base, 1) == std::vector<int>({ 2, 3, 4 }));
+    CHECK(dispatch(s_test_base2, 1) == std::vector<int>({ 3 }));
+
+    CHECK(ESP_OK == esp_event_loop_delete(loop));
+}
+
+TEST_CASE("handlers registered during a dispatch are executed in that dispatch")
+{
+    FakeQueue queue;
+    esp_event_loop_handle_t loop = nullptr;
+
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+
+    esp_event_loop_handle_t registering_loop = loop;
+    esp_event_handler_instance_t instance;
+    REQUIRE(ESP_OK == esp_event_handler_instance_register_with(loop, s_test_base, 1, order_handler,
+            reinterpret_cast<void*>(0), &instance));
+    REQUIRE(ESP_OK == esp_event_handler_register_with(loop, s_test_base, 1, registering_handler, &registering_loop));
+    REQUIRE(ESP_OK == esp_event_handler_instance_register_with(loop, s_test_base, 1, order_handler,
+            reinterpret_cast<void*>(2), &instance));
+
+    auto dispatch = [loop]() {
+        std::vector<int> order;
+        std::vector<int> *order_ptr = &order;
+        CHECK(ESP_OK == esp_event_post_to(loop, s_test_base, 1, &order_ptr, sizeof(order_ptr), 0));
+        CHECK(ESP_OK == esp_event_loop_run(loop, portMAX_DELAY));
+        return order;
+    };
+
+    // like the handlers registered before, they come after the handler being executed
+    CHECK(dispatch() == std::vector<int>({ 0, 2, 10, 11 }));
+    CHECK(dispatch() == std::vector<int>({ 0, 2, 10, 11 }));
+
+    CHECK(ESP_OK == esp_event_loop_delete(loop));
+}
+
+TEST_CASE("dispatch latency benchmark", "[benchmark][.]")
+{
+    const int EVENTS = 100000;
+    const int BASES = 16;
+    const int IDS = 8;
+    static const char *bases[BASES];
+
+    for (bool many : { false, true }) {
+        FakeQueue queue;
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_name = nullptr;
+        REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+
+        int handlers = 0;
+        for (int b = 0; b < (many ? BASES : 1); b++) {
+            bases[b] = reinterpret_cast<const char*>(&bases[b]);
+            for (int id = 0; id < (many ? IDS : 1); id++) {
+                REQUIRE(ESP_OK == esp_event_handler_register_with(loop, bases[b], id, dummy_handler, nullptr));
+                handlers++;
+            }
+        }
+
+        // the event registered last is the one found last by walking the registrations
+        esp_event_base_t base = bases[many ? BASES - 1 : 0];
+        int32_t id = many ? IDS - 1 : 0;
+        esp_event_post_to(loop, base, id, nullptr, 0, 0);
+        esp_event_loop_run(loop, portMAX_DELAY);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < EVENTS; i++) {
+            esp_event_post_to(loop, base, id, nullptr, 0, 0);
+            esp_event_loop_run(loop, portMAX_DELAY);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        printf("%d handlers registered: %.1f ns per posted and dispatched event\n", handlers, elapsed_ns(start, end) / EVENTS);
+
+        CHECK(ESP_OK == esp_event_loop_delete(loop));
+    }
+}
+
+TEST_CASE("test esp_event_loop_create with several tasks and no task name fails")
+{
+    CMockFix fix;
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_name = nullptr;
+    loop_args.task_count = 2;
+
+    CHECK(ESP_ERR_INVALID_ARG == esp_event_loop_create(&loop_args, &loop));
+}
+
+TEST_CASE("several tasks dispatch events concurrently, in order for each event")
+{
+    const int TASKS = 4;
+    const int EVENTS = 50;
+    FakeTasks tasks;
+    SequenceCheck check(500);
+    esp_event_loop_handle_t loop = nullptr;
+    esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+    loop_args.task_count = TASKS;
+    REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+
+    std::vector<BaseType_t> core_ids;
+    for (int i = 0; i < TASKS; i++) {
+        core_ids.push_back(i % portNUM_PROCESSORS);
+    }
+    CHECK(FakeTasks::core_ids == core_ids);
+    CHECK(ESP_ERR_INVALID_STATE == esp_event_loop_run(loop, 0));
+
+    REQUIRE(ESP_OK == esp_event_handler_register_with(loop, s_test_base, ESP_EVENT_ANY_ID, sequence_handler, &check));
+    for (int sequence = 0; sequence < EVENTS; sequence++) {
+        for (int id = 0; id < SequenceCheck::IDS; id++) {
+            REQUIRE(ESP_OK == esp_event_post_to(loop, s_test_base, id, &sequence, sizeof(sequence), portMAX_DELAY));
+        }
+    }
+    wait_dispatched(check, EVENTS * SequenceCheck::IDS);
+
+    CHECK(check.out_of_order == 0);
+    CHECK(check.max_running > 1);
+
+    // once unregistered, the handler is not executing anymore and not executed for events posted afterwards
+    for (int id = 0; id < SequenceCheck::IDS; id++) {
+        int sequence = EVENTS;
+        REQUIRE(ESP_OK == esp_event_post_to(loop, s_test_base, id, &sequence, sizeof(sequence), portMAX_DELAY));
+    }
+    REQUIRE(ESP_OK == esp_event_handler_unregister_with(loop, s_test_base, ESP_EVENT_ANY_ID, sequence_handler));
+    CHECK(check.running == 0);
+    int dispatched = check.dispatched;
+
+    int sequence = EVENTS + 1;
+    REQUIRE(ESP_OK == esp_event_post_to(loop, s_test_base, 0, &sequence, sizeof(sequence), portMAX_DELAY));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(check.dispatched == dispatched);
+
+    CHECK(ESP_OK == esp_event_loop_delete(loop));
+}
+
+TEST_CASE("dispatch throughput with several tasks benchmark", "[benchmark][.]")
+{
+    const int EVENTS = 100;
+
+    for (uint32_t task_count : { 1, 2, 4 }) {
+        FakeTasks tasks;
+        SequenceCheck check(1000);
+        esp_event_loop_handle_t loop = nullptr;
+        esp_event_loop_args_t loop_args = test_event_get_default_loop_args();
+        loop_args.task_count = task_count;
+        REQUIRE(ESP_OK == esp_event_loop_create(&loop_args, &loop));
+        REQUIRE(ESP_OK == esp_event_handler_register_with(loop, s_test_base, ESP_EVENT_ANY_ID, sequence_handler, &check));
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int sequence = 0; sequence < EVENTS; sequence++) {
+            for (int id = 0; id < SequenceCheck::IDS; id++) {
+                esp_event_post_to(loop, s_test_base, id, &sequence, sizeof(sequence), portMAX_DELAY);
+            }
+        }
+        wait_dispatched(check, EVENTS * SequenceCheck::IDS);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        printf("%u tasks: %.0f events per second with 1 ms handlers\n", (unsigned) task_count,
+                EVENTS * SequenceCheck::IDS / (elapsed_ns(start, end) / 1e9));
+
+        CHECK(check.out_of_order == 0);
+        CHECK(ESP_OK == esp_event_loop_delete(loop));
+    }
+}
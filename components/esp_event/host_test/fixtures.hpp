@@ -7,6 +7,16 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "esp_event.h"
 
 #include "catch.hpp"
@@ -146,3 +156,262 @@ struct MockTask : public CMockFix {
 
     TaskHandle_t task;
 };
+
+/**
+ * Replaces the event queue by an unbounded FIFO, so that events can be posted to a loop without a dedicated task
+ * and dispatched afterwards with esp_event_loop_run(). The mutexes of the loop are mocked as always available.
+ */
+struct FakeQueue : public CMockFix {
+    FakeQueue() : mutex(reinterpret_cast<QueueHandle_t>(0xdeadbeef))
+    {
+        items.clear();
+        xQueueGenericCreate_Stub(create);
+        xQueueGenericSend_Stub(send);
+        xQueueReceive_Stub(receive);
+        vQueueDelete_Ignore();
+        xQueueCreateMutex_IgnoreAndReturn(mutex);
+        xQueueTakeMutexRecursive_IgnoreAndReturn(pdTRUE);
+        xQueueGiveMutexRecursive_IgnoreAndReturn(pdTRUE);
+        xTaskGetCurrentTaskHandle_IgnoreAndReturn(nullptr);
+        xTaskGetTickCount_IgnoreAndReturn(0);
+    }
+
+    ~FakeQueue()
+    {
+        xQueueGenericCreate_Stub(nullptr);
+        xQueueGenericSend_Stub(nullptr);
+        xQueueReceive_Stub(nullptr);
+        vQueueDelete_StopIgnore();
+        xQueueCreateMutex_StopIgnore();
+        xQueueTakeMutexRecursive_StopIgnore();
+        xQueueGiveMutexRecursive_StopIgnore();
+        xTaskGetCurrentTaskHandle_StopIgnore();
+        xTaskGetTickCount_StopIgnore();
+    }
+
+    static QueueHandle_t create(const UBaseType_t length, const UBaseType_t size, const uint8_t type, int calls)
+    {
+        item_size = size;
+        return reinterpret_cast<QueueHandle_t>(&items);
+    }
+
+    static BaseType_t send(QueueHandle_t queue, const void * const item, TickType_t ticks, const BaseType_t position,
+            int calls)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t*>(item);
+        items.emplace_back(bytes, bytes + item_size);
+        return pdTRUE;
+    }
+
+    static BaseType_t receive(QueueHandle_t queue, void * const item, TickType_t ticks, int calls)
+    {
+        if (items.empty()) {
+            return pdFALSE;
+        }
+        std::copy(items.front().begin(), items.front().end(), static_cast<uint8_t*>(item));
+        items.pop_front();
+        return pdTRUE;
+    }
+
+    QueueHandle_t mutex;
+    static inline size_t item_size;
+    static inline std::deque<std::vector<uint8_t> > items;
+};
+
+/**
+ * Backs tasks by threads and queues and mutexes by blocking ones, so that the tasks of a loop dispatch its events
+ * concurrently like on a target. A task deleted with vTaskDelete() stops in the next queue or mutex operation it
+ * blocks on and never resumes.
+ */
+struct FakeTasks : public CMockFix {
+    struct Queue {
+        std::mutex lock;
+        std::condition_variable changed;
+        size_t length;
+        size_t item_size;
+        std::deque<std::vector<uint8_t> > items;
+        std::thread::id holder;
+        int held;
+    };
+
+    struct Task {
+        std::atomic<bool> deleted{false};
+        std::atomic<bool> stopped{false};
+    };
+
+    FakeTasks()
+    {
+        xQueueGenericCreate_Stub(create);
+        xQueueCreateMutex_Stub(create_mutex);
+        xQueueGenericSend_Stub(send);
+        xQueueReceive_Stub(receive);
+        xQueueSemaphoreTake_Stub(take);
+        xQueueTakeMutexRecursive_Stub(take_recursive);
+        xQueueGiveMutexRecursive_Stub(give_recursive);
+        vQueueDelete_Ignore();
+        xTaskCreatePinnedToCore_Stub(create_task);
+        vTaskDelete_Stub(delete_task);
+        xTaskGetCurrentTaskHandle_Stub(current_task_handle);
+        xTaskGetTickCount_IgnoreAndReturn(0);
+        core_ids.clear();
+    }
+
+    ~FakeTasks()
+    {
+        xQueueGenericCreate_Stub(nullptr);
+        xQueueCreateMutex_Stub(nullptr);
+        xQueueGenericSend_Stub(nullptr);
+        xQueueReceive_Stub(nullptr);
+        xQueueSemaphoreTake_Stub(nullptr);
+        xQueueTakeMutexRecursive_Stub(nullptr);
+        xQueueGiveMutexRecursive_Stub(nullptr);
+        vQueueDelete_StopIgnore();
+        xTaskCreatePinnedToCore_Stub(nullptr);
+        vTaskDelete_Stub(nullptr);
+        xTaskGetCurrentTaskHandle_Stub(nullptr);
+        xTaskGetTickCount_StopIgnore();
+
+        // All tasks have been deleted and stopped with their loops, the queues are not used anymore
+        queues.clear();
+        tasks.clear();
+    }
+
+    static QueueHandle_t create(const UBaseType_t length, const UBaseType_t size, const uint8_t type, int calls)
+    {
+        queues.emplace_back(new Queue());
+        queues.back()->length = length;
+        queues.back()->item_size = size;
+        queues.back()->held = 0;
+        return reinterpret_cast<QueueHandle_t>(queues.back().get());
+    }
+
+    static QueueHandle_t create_mutex(const uint8_t type, int calls)
+    {
+        // A mutex is a queue of length 1 holding a token while it is available
+        QueueHandle_t mutex = create(1, 0, type, calls);
+        reinterpret_cast<Queue*>(mutex)->items.emplace_back();
+        return mutex;
+    }
+
+    static BaseType_t send(QueueHandle_t handle, const void * const item, TickType_t ticks, const BaseType_t position,
+            int calls)
+    {
+        Queue *queue = reinterpret_cast<Queue*>(handle);
+        std::unique_lock<std::mutex> lock(queue->lock);
+
+        if (!wait(queue, lock, ticks, [queue]() { return queue->items.size() < queue->length; })) {
+            return pdFALSE;
+        }
+
+        const uint8_t *bytes = static_cast<const uint8_t*>(item);
+        queue->items.emplace_back(bytes, bytes + (item != nullptr ? queue->item_size : 0));
+        queue->changed.notify_all();
+        return pdTRUE;
+    }
+
+    static BaseType_t receive(QueueHandle_t handle, void * const item, TickType_t ticks, int calls)
+    {
+        Queue *queue = reinterpret_cast<Queue*>(handle);
+        std::unique_lock<std::mutex> lock(queue->lock);
+
+        if (!wait(queue, lock, ticks, [queue]() { return !queue->items.empty(); })) {
+            return pdFALSE;
+        }
+
+        std::copy(queue->items.front().begin(), queue->items.front().end(), static_cast<uint8_t*>(item));
+        queue->items.pop_front();
+        queue->changed.notify_all();
+        return pdTRUE;
+    }
+
+    static BaseType_t take(QueueHandle_t handle, TickType_t ticks, int calls)
+    {
+        return receive(handle, nullptr, ticks, calls);
+    }
+
+    static BaseType_t take_recursive(QueueHandle_t handle, TickType_t ticks, int calls)
+    {
+        Queue *queue = reinterpret_cast<Queue*>(handle);
+        std::unique_lock<std::mutex> lock(queue->lock);
+        std::thread::id self = std::this_thread::get_id();
+
+        if (!wait(queue, lock, ticks, [queue, self]() { return queue->held == 0 || queue->holder == self; })) {
+            return pdFALSE;
+        }
+
+        queue->holder = self;
+        queue->held++;
+        return pdTRUE;
+    }
+
+    static BaseType_t give_recursive(QueueHandle_t handle, int calls)
+    {
+        Queue *queue = reinterpret_cast<Queue*>(handle);
+        std::unique_lock<std::mutex> lock(queue->lock);
+
+        if (--queue->held == 0) {
+            queue->changed.notify_all();
+        }
+        return pdTRUE;
+    }
+
+    static BaseType_t create_task(TaskFunction_t function, const char * const name, const uint32_t stack_depth,
+            void * const arg, UBaseType_t priority, TaskHandle_t * const handle, const BaseType_t core_id, int calls)
+    {
+        tasks.emplace_back(new Task());
+        Task *task = tasks.back().get();
+        core_ids.push_back(core_id);
+
+        // The handle is set before the task runs, like xTaskCreatePinnedToCore() does
+        *handle = reinterpret_cast<TaskHandle_t>(task);
+        std::thread([task, function, arg]() {
+            current_task = task;
+            function(arg);
+        }).detach();
+        return pdPASS;
+    }
+
+    static void delete_task(TaskHandle_t handle, int calls)
+    {
+        Task *task = reinterpret_cast<Task*>(handle);
+        task->deleted = true;
+        while (!task->stopped) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    static TaskHandle_t current_task_handle(int calls)
+    {
+        return reinterpret_cast<TaskHandle_t>(current_task);
+    }
+
+    /**
+     * Waits until ready() holds or the ticks elapse. A deleted task stops here instead.
+     */
+    template<typename Ready>
+    static bool wait(Queue *queue, std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready ready)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks * portTICK_PERIOD_MS);
+
+        while (current_task == nullptr || !current_task->deleted) {
+            if (ready()) {
+                return true;
+            }
+            if (ticks != portMAX_DELAY && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            queue->changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+
+        current_task->stopped = true;
+        lock.unlock();
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+
+    static inline std::list<std::unique_ptr<Queue> > queues;
+    static inline std::list<std::unique_ptr<Task> > tasks;
+    static inline std::vector<BaseType_t> core_ids;
+    static inline thread_local Task *current_task;
+};
@@ -20,7 +20,12 @@
 extern "C" {
 #endif
 
-/// Configuration for creating event loops
+/**
+ * Configuration for creating event loops
+ *
+ * The structure has to be zero-initialized, for example with a designated initializer, so that
+ * fields which are not set, including fields added in later versions, default to 0.
+ */
 typedef struct {
     int32_t queue_size;                         /**< size of the event loop queue */
     const char *task_name;                      /**< name of the event loop task; if NULL,
@@ -28,7 +33,21 @@ typedef struct {
     UBaseType_t task_priority;                  /**< priority of the event loop task, ignored if task name is NULL */
     uint32_t task_stack_size;                   /**< stack size of the event loop task, ignored if task name is NULL */
     BaseType_t task_core_id;                    /**< core to which the event loop task is pinned to,
-                                                        ignored if task name is NULL */
+                                                        ignored if task name is NULL; with several tasks, the
+                                                        tasks are pinned to the cores in turn starting from this
+                                                        one, unless it is tskNO_AFFINITY */
+    size_t data_slot_size;                      /**< size of the slots of the event data slab; event data of at most
+                                                        this size is copied into a free slot instead of a heap allocation
+                                                        when posted, 0 (the zero-initialized default) for no slab */
+    uint32_t data_slot_count;                   /**< number of slots in the event data slab, at most 65534;
+                                                        0 for no slab */
+    uint32_t task_count;                        /**< number of event loop tasks dispatching events concurrently,
+                                                        each with its own queue of queue_size events; events with
+                                                        the same base and id are dispatched by the same task, in
+                                                        the order they were posted. 0 (the zero-initialized
+                                                        default) or 1 for a single task, must be 0 or 1 if task
+                                                        name is NULL, so configurations which are not
+                                                        zero-initialized may fail to create a loop */
 } esp_event_loop_args_t;
 
 /**
@@ -101,6 +120,7 @@ esp_err_t esp_event_loop_delete_default(void);
  *
  * @return
  *  - ESP_OK: Success
+ *  - ESP_ERR_INVALID_STATE: the loop has several tasks dispatching its events
  *  - Others: Fail
  */
 esp_err_t esp_event_loop_run(esp_event_loop_handle_t event_loop, TickType_t ticks_to_run);
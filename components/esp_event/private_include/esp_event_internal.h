@@ -34,11 +34,14 @@ typedef struct esp_event_handler_context {
 /// Event handler
 typedef struct esp_event_handler_node {
     esp_event_handler_instance_context_t* handler_ctx;              /**< event handler context*/
+    bool removed;                                                   /**< unregistered during a dispatch, to be freed
+                                                                            once the dispatch is over */
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     uint32_t invoked;                                               /**< number of times this handler has been invoked */
     int64_t time;                                                   /**< total runtime of this handler across all calls */
 #endif
     SLIST_ENTRY(esp_event_handler_node) next;                   /**< next event handler in the list */
+    SLIST_ENTRY(esp_event_handler_node) next_removed;           /**< next event handler in the list of removed handlers */
 } esp_event_handler_node_t;
 
 typedef SLIST_HEAD(esp_event_handler_instances, esp_event_handler_node) esp_event_handler_nodes_t;
@@ -73,6 +76,34 @@ typedef struct esp_event_loop_node {
 
 typedef SLIST_HEAD(esp_event_loop_nodes, esp_event_loop_node) esp_event_loop_nodes_t;
 
+/// Handlers to execute for an event
+typedef struct esp_event_dispatch_entry {
+    esp_event_base_t base;                                          /**< base identifier of the event */
+    int32_t id;                                                     /**< id of the event, or ESP_EVENT_ANY_ID for the
+                                                                            events of the base with no id level handlers */
+    size_t handler_count;                                           /**< number of handlers to execute */
+    esp_event_handler_node_t** handlers;                            /**< handlers to execute, in dispatch order */
+    struct esp_event_dispatch_entry* next;                          /**< next entry in the same hash bucket */
+} esp_event_dispatch_entry_t;
+
+/// Hash table of the handlers to execute for each event, built from the loop nodes
+typedef struct esp_event_dispatch_index {
+    esp_event_dispatch_entry_t any;                                 /**< handlers to execute for events of bases with
+                                                                            no base or id level handlers */
+    size_t bucket_count;                                            /**< number of hash buckets, a power of 2 */
+    esp_event_dispatch_entry_t** buckets;                           /**< hash buckets, hashed by base and id */
+    esp_event_handler_node_t** handlers;                            /**< storage for the handlers of all entries */
+    struct esp_event_dispatch_index* next;                          /**< next index in the list of retired indexes */
+} esp_event_dispatch_index_t;
+
+/// Task of an event loop with several tasks
+typedef struct esp_event_loop_worker {
+    struct esp_event_loop_instance* loop;                           /**< event loop of the task */
+    QueueHandle_t queue;                                            /**< queue of the events dispatched by the task */
+    TaskHandle_t task;                                              /**< task that consumes the queue */
+    SemaphoreHandle_t dispatch_mutex;                               /**< mutex held while the task executes handlers */
+} esp_event_loop_worker_t;
+
 /// Event loop
 typedef struct esp_event_loop_instance {
     const char* name;                                               /**< name of this event loop */
@@ -81,8 +112,22 @@ typedef struct esp_event_loop_instance {
     TaskHandle_t running_task;                                      /**< for loops with no dedicated task, the
                                                                             task that consumes the queue */
     SemaphoreHandle_t mutex;                                        /**< mutex for updating the events linked list */
+    esp_event_loop_worker_t* workers;                               /**< for loops with several tasks, the tasks and
+                                                                            their queues, NULL otherwise */
+    uint32_t worker_count;                                          /**< number of tasks of the loop in workers */
     esp_event_loop_nodes_t loop_nodes;                              /**< set of linked lists containing the
                                                                             registered handlers for the loop */
+    esp_event_dispatch_index_t* dispatch_index;                     /**< index of the handlers to execute for each
+                                                                            event, NULL until built on the next dispatch */
+    esp_event_dispatch_index_t* retired_indexes;                    /**< indexes replaced during a dispatch */
+    esp_event_handler_nodes_t removed_handlers;                     /**< handlers unregistered during a dispatch */
+    uint32_t dispatching;                                           /**< number of dispatches in progress */
+    atomic_uint_least32_t registrations;                            /**< number of handlers registered so far */
+    uint8_t* data_slots;                                            /**< event data slab, NULL if the loop has none */
+    size_t data_slot_size;                                          /**< size of each slot of the slab */
+    size_t data_slot_count;                                         /**< number of slots of the slab */
+    atomic_uint_least32_t data_slots_free;                          /**< tag << 16 | index of the first free slot */
+    atomic_uint_least16_t* data_slots_next;                         /**< index of the next free slot, for each slot */
 #ifdef CONFIG_ESP_EVENT_LOOP_PROFILING
     atomic_uint_least32_t events_recieved;                          /**< number of events successfully posted to the loop */
     atomic_uint_least32_t events_dropped;                           /**< number of events dropped due to queue being full */
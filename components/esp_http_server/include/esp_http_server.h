@@ -27,6 +27,8 @@ initializer that should be kept in sync
         .task_priority      = tskIDLE_PRIORITY+5,       \
         .stack_size         = 4096,                     \
         .core_id            = tskNO_AFFINITY,           \
+        .worker_count       = 0,                        \
+        .worker_core_id     = tskNO_AFFINITY,           \
         .server_port        = 80,                       \
         .ctrl_port          = 32768,                    \
         .max_open_sockets   = 7,                        \
@@ -138,6 +140,28 @@ typedef struct httpd_config {
     size_t      stack_size;         /*!< The maximum stack size allowed for the server task */
     BaseType_t  core_id;            /*!< The core the HTTP server task will run on */
 
+    /**
+     * Number of worker tasks processing the requests.
+     *
+     * With 0 workers, the requests are received, parsed and handled by the
+     * server task itself, one after the other. Otherwise, the server task only
+     * waits for the sockets to become readable and accepts new connections, and
+     * hands each session with an incoming request to a free worker task, which
+     * processes the request and hands the session back to the server task, so
+     * that the next request of a persistent connection can be waited for.
+     * Requests of different sessions are then handled concurrently, so the URI
+     * handlers must protect the state they share.
+     *
+     * The worker tasks have the priority and stack size of the server task.
+     */
+    uint8_t     worker_count;
+
+    /**
+     * The core the first worker task will run on. The next worker tasks are
+     * pinned to the next cores in turn, unless it is tskNO_AFFINITY.
+     */
+    BaseType_t  worker_core_id;
+
     /**
      * TCP Port number for receiving and transmitting HTTP traffic
      */
@@ -1495,12 +1519,17 @@ esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd);
  * @note    Calling this API is only necessary if the LRU Purge Enable option
  *          is enabled.
  *
+ * @note    When called from a task other than the server task, e.g. from a
+ *          URI handler run by a worker task, the update is queued to the
+ *          server task and done asynchronously.
+ *
  * @param[in] handle    Handle to server returned by httpd_start
  * @param[in] sockfd    The socket descriptor of the session for which LRU counter
  *                      is to be updated
  *
  * @return
- *  - ESP_OK : Socket found and LRU counter updated
+ *  - ESP_OK : Socket found and LRU counter updated (or update queued)
+ *  - ESP_FAIL : Failure in ctrl socket, when queueing the update
  *  - ESP_ERR_NOT_FOUND   : Socket not found
  *  - ESP_ERR_INVALID_ARG : Null arguments
  */
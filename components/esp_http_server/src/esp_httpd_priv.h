@@ -17,6 +17,7 @@
 
 #include <esp_http_server.h>
 #include "osal.h"
+#include <freertos/queue.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,8 +28,12 @@ extern "C" {
  * exceed the scratch buffer size and should at least be 8 bytes */
 #define PARSER_BLOCK_SIZE  128
 
-/* Calculate the maximum size needed for the scratch buffer */
-#define HTTPD_SCRATCH_BUF  MAX(HTTPD_MAX_REQ_HDR_LEN, HTTPD_MAX_URI_LEN)
+/* Size of the buffer in which responses are assembled before being sent */
+#define HTTPD_RESP_BUF_LEN  CONFIG_HTTPD_RESP_BUF_LEN
+
+/* Calculate the maximum size needed for the scratch buffer, which is
+ * also used for assembling responses once the request is parsed */
+#define HTTPD_SCRATCH_BUF  MAX(MAX(HTTPD_MAX_REQ_HDR_LEN, HTTPD_MAX_URI_LEN), HTTPD_RESP_BUF_LEN)
 
 /* Formats a log string to prepend context function name */
 #define LOG_FMT(x)      "%s: " x, __func__
@@ -64,6 +69,9 @@ struct sock_db {
     bool lru_socket;                        /*!< Flag indicating LRU socket */
     char pending_data[PARSER_BLOCK_SIZE];   /*!< Buffer for pending data to be received */
     size_t pending_len;                     /*!< Length of pending data to be received */
+    bool worker_owned;                      /*!< Flag indicating that a worker task is processing a request of the session */
+    bool worker_failed;                     /*!< Flag indicating that the worker task failed to process the request */
+    bool close_pending;                     /*!< Flag indicating that the session is to be closed once handed back by the worker task */
 #ifdef CONFIG_HTTPD_WS_SUPPORT
     bool ws_handshake_done;                 /*!< True if it has done WebSocket handshake (if this socket is a valid WS) */
     bool ws_close;                          /*!< Set to true to close the socket later (when WS Close frame received) */
@@ -99,6 +107,16 @@ struct httpd_req_aux {
 #endif
 };
 
+/**
+ * @brief   Worker task processing the requests handed by the server task
+ */
+struct httpd_worker {
+    struct httpd_data *hd;                  /*!< Server instance of the worker */
+    struct thread_data td;                  /*!< Information for the worker thread */
+    struct httpd_req req;                   /*!< The request processed by the worker */
+    struct httpd_req_aux req_aux;           /*!< Additional data about the request kept unexposed */
+};
+
 /**
  * @brief   Server data for each instance. This is exposed publicly as
  *          httpd_handle_t but internal structure/members are kept private.
@@ -114,9 +132,12 @@ struct httpd_data {
     struct thread_data hd_td;               /*!< Information for the HTTPD thread */
     struct sock_db *hd_sd;                  /*!< The socket database */
     int hd_sd_active_count;                 /*!< The number of the active sockets */
+    int hd_sd_worker_count;                 /*!< The number of the sockets handed to worker tasks */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
     struct httpd_req hd_req;                /*!< The current HTTPD request */
     struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
+    struct httpd_worker *hd_workers;        /*!< The worker tasks, NULL if requests are processed by the HTTPD thread */
+    QueueHandle_t hd_work_queue;            /*!< Sessions handed to the worker tasks */
     uint64_t lru_counter;                   /*!< LRU counter */
 
     /* Array of registered error handler functions */
@@ -201,6 +222,27 @@ esp_err_t httpd_sess_new(struct httpd_data *hd, int newfd);
  */
 esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session);
 
+/**
+ * @brief   Hands a session to the worker tasks, which process its incoming
+ *          HTTP request. The session is skipped by the server task until
+ *          the worker hands it back with httpd_sess_release().
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] session Session
+ */
+void httpd_sess_hand_off(struct httpd_data *hd, struct sock_db *session);
+
+/**
+ * @brief   Hands a session processed by a worker task back to the server task,
+ *          which closes it if processing the request failed or if it was
+ *          requested to be closed meanwhile.
+ *
+ * @param[in] hd      Server instance data
+ * @param[in] session Session
+ * @param[in] ret     Result of httpd_sess_process() for the session
+ */
+void httpd_sess_release(struct httpd_data *hd, struct sock_db *session, esp_err_t ret);
+
 /**
  * @brief   Remove client descriptor from the session / socket database
  *          and close the connection for this client.
@@ -298,12 +340,13 @@ void httpd_sess_close_all(struct httpd_data *hd);
  *          and invokes the appropriate one if found
  *
  * @param[in] hd  Server instance data for which handler needs to be invoked
+ * @param[in] req Parsed HTTP request
  *
  * @return
  *  - ESP_OK    : if handler found and executed successfully
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_uri(struct httpd_data *hd);
+esp_err_t httpd_uri(struct httpd_data *hd, httpd_req_t *req);
 
 /**
  * @brief   Unregister all URI handlers
@@ -352,25 +395,38 @@ bool httpd_validate_req_ptr(httpd_req_t *r);
  * http_recv() after this reads the body of the request.
  *
  * @param[in] hd  Server instance data
+ * @param[in] r   Request to fill, of the HTTPD thread or of a worker task
+ * @param[in] ra  Auxiliary data of the request
  * @param[in] sd  Pointer to socket which is needed for receiving TCP packets.
  *
  * @return
  *  - ESP_OK    : if request packet is valid
  *  - ESP_FAIL  : otherwise
  */
-esp_err_t httpd_req_new(struct httpd_data *hd, struct sock_db *sd);
+esp_err_t httpd_req_new(struct httpd_data *hd, httpd_req_t *r, struct httpd_req_aux *ra, struct sock_db *sd);
 
 /**
  * @brief   For an HTTP request, resets the resources allocated for it and
  *          purges any data left to be received
  *
- * @param[in] hd  Server instance data
+ * @param[in] r   Request to delete
  *
  * @return
  *  - ESP_OK    : if request packet deleted and resources cleaned.
  *  - ESP_FAIL  : otherwise.
  */
-esp_err_t httpd_req_delete(struct httpd_data *hd);
+esp_err_t httpd_req_delete(httpd_req_t *r);
+
+/**
+ * @brief   Returns the worker task running this function
+ *
+ * @param[in] hd  Server instance data
+ *
+ * @return
+ *  - Worker of the calling task
+ *  - NULL : if the calling task is not a worker task of the server
+ */
+struct httpd_worker *httpd_worker_current(struct httpd_data *hd);
 
 /**
  * @brief   For handling HTTP errors by invoking registered
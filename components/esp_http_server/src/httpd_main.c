@@ -192,12 +192,19 @@ static int httpd_process_session(struct sock_db *session, void *context)
         return 1;
     }
 
+    if (session->worker_owned) {
+        /* Skip sessions processed by a worker until handed back */
+        return 1;
+    }
+
     process_session_context_t *ctx = (process_session_context_t *)context;
     int fd = session->fd;
 
     if (FD_ISSET(fd, ctx->fdset) || httpd_sess_pending(ctx->hd, session)) {
         ESP_LOGD(TAG, LOG_FMT("processing socket %d"), fd);
-        if (httpd_sess_process(ctx->hd, session) != ESP_OK) {
+        if (ctx->hd->hd_workers) {
+            httpd_sess_hand_off(ctx->hd, session);
+        } else if (httpd_sess_process(ctx->hd, session) != ESP_OK) {
             httpd_sess_delete(ctx->hd, session); // Delete session
         }
     }
@@ -209,10 +216,12 @@ static esp_err_t httpd_server(struct httpd_data *hd)
 {
     fd_set read_set;
     FD_ZERO(&read_set);
-    if (hd->config.lru_purge_enable || httpd_is_sess_available(hd)) {
+    if ((hd->config.lru_purge_enable && hd->hd_sd_worker_count < hd->hd_sd_active_count) ||
+            httpd_is_sess_available(hd)) {
         /* Only listen for new connections if server has capacity to
          * handle more (or when LRU purge is enabled, in which case
-         * older connections will be closed) */
+         * older connections, not being processed by a worker, will
+         * be closed) */
         FD_SET(hd->listen_fd, &read_set);
     }
     FD_SET(hd->ctrl_fd, &read_set);
@@ -260,6 +269,134 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     return ESP_OK;
 }
 
+/* Worker thread, processing the sessions handed by the HTTPD thread */
+static void httpd_worker_thread(void *arg)
+{
+    struct httpd_worker *worker = (struct httpd_worker *) arg;
+    struct httpd_data *hd = worker->hd;
+    struct sock_db *session;
+    worker->td.status = THREAD_RUNNING;
+
+    ESP_LOGD(TAG, LOG_FMT("worker started"));
+    while (xQueueReceive(hd->hd_work_queue, &session, portMAX_DELAY) == pdTRUE) {
+        /* A NULL session is queued to stop the worker */
+        if (session == NULL) {
+            break;
+        }
+        ESP_LOGD(TAG, LOG_FMT("processing socket %d"), session->fd);
+        httpd_sess_release(hd, session, httpd_sess_process(hd, session));
+    }
+
+    ESP_LOGD(TAG, LOG_FMT("worker exiting"));
+    worker->td.status = THREAD_STOPPED;
+    httpd_os_thread_delete();
+}
+
+struct httpd_worker *httpd_worker_current(struct httpd_data *hd)
+{
+    if (hd->hd_workers) {
+        othread_t handle = httpd_os_thread_handle();
+        for (int i = 0; i < hd->config.worker_count; i++) {
+            if (hd->hd_workers[i].td.handle == handle) {
+                return &hd->hd_workers[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t httpd_workers_alloc(struct httpd_data *hd)
+{
+    hd->hd_workers = calloc(hd->config.worker_count, sizeof(struct httpd_worker));
+    if (!hd->hd_workers) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *worker = &hd->hd_workers[i];
+        worker->hd = hd;
+        worker->req_aux.resp_hdrs = calloc(hd->config.max_resp_headers, sizeof(struct resp_hdr));
+        if (!worker->req_aux.resp_hdrs) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    /* Each session is queued at most once, the remaining
+     * entries are for stopping the workers */
+    hd->hd_work_queue = xQueueCreate(hd->config.max_open_sockets + hd->config.worker_count,
+                                     sizeof(struct sock_db *));
+    if (!hd->hd_work_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void httpd_workers_free(struct httpd_data *hd)
+{
+    if (!hd->hd_workers) {
+        return;
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        free(hd->hd_workers[i].req_aux.resp_hdrs);
+    }
+    free(hd->hd_workers);
+    hd->hd_workers = NULL;
+    if (hd->hd_work_queue) {
+        vQueueDelete(hd->hd_work_queue);
+        hd->hd_work_queue = NULL;
+    }
+}
+
+static esp_err_t httpd_workers_start(struct httpd_data *hd)
+{
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        BaseType_t core_id = hd->config.worker_core_id;
+        if (core_id != tskNO_AFFINITY) {
+            core_id = (core_id + i) % portNUM_PROCESSORS;
+        }
+        if (httpd_os_thread_create(&hd->hd_workers[i].td.handle, "httpd_worker",
+                                   hd->config.stack_size,
+                                   hd->config.task_priority,
+                                   httpd_worker_thread, &hd->hd_workers[i],
+                                   core_id) != ESP_OK) {
+            ESP_LOGE(TAG, LOG_FMT("failed to launch worker %d"), i);
+            hd->hd_workers[i].td.handle = NULL;
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Stops the worker threads once they are done with the sessions
+ * handed to them, handing these sessions back to the HTTPD thread */
+static void httpd_workers_stop(struct httpd_data *hd)
+{
+    if (!hd->hd_workers) {
+        return;
+    }
+    struct sock_db *stop = NULL;
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        if (hd->hd_workers[i].td.handle) {
+            xQueueSend(hd->hd_work_queue, &stop, portMAX_DELAY);
+        }
+    }
+    for (int i = 0; i < hd->config.worker_count; i++) {
+        struct httpd_worker *worker = &hd->hd_workers[i];
+        while (worker->td.handle && worker->td.status != THREAD_STOPPED) {
+            /* Keep receiving control messages, as the workers
+             * hand the sessions back through the control socket */
+            fd_set read_set;
+            FD_ZERO(&read_set);
+            FD_SET(hd->ctrl_fd, &read_set);
+            struct timeval tv = {
+                .tv_sec = 0,
+                .tv_usec = 10000
+            };
+            if (select(hd->ctrl_fd + 1, &read_set, NULL, NULL, &tv) > 0) {
+                httpd_process_ctrl_msg(hd);
+            }
+        }
+    }
+}
+
 /* The main HTTPD thread */
 static void httpd_thread(void *arg)
 {
@@ -276,6 +413,7 @@ static void httpd_thread(void *arg)
     }
 
     ESP_LOGD(TAG, LOG_FMT("web server exiting"));
+    httpd_workers_stop(hd);
     close(hd->msg_fd);
     cs_free_ctrl_sock(hd->ctrl_fd);
     httpd_sess_close_all(hd);
@@ -406,6 +544,7 @@ static void httpd_delete(struct httpd_data *hd)
     free(hd->err_handler_fns);
     free(ra->resp_hdrs);
     free(hd->hd_sd);
+    httpd_workers_free(hd);
 
     /* Free registered URI handlers */
     httpd_unregister_all_uri_handlers(hd);
@@ -454,18 +593,31 @@ esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
     }
 #endif
 
+    if (hd->config.worker_count && httpd_workers_alloc(hd) != ESP_OK) {
+        ESP_LOGE(TAG, LOG_FMT("Failed to allocate memory for HTTP worker tasks"));
+        httpd_delete(hd);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+
     if (httpd_server_init(hd) != ESP_OK) {
         httpd_delete(hd);
         return ESP_FAIL;
     }
 
     httpd_sess_init(hd);
+    if (hd->config.worker_count && httpd_workers_start(hd) != ESP_OK) {
+        /* Failed to launch worker tasks */
+        httpd_workers_stop(hd);
+        httpd_delete(hd);
+        return ESP_ERR_HTTPD_TASK;
+    }
     if (httpd_os_thread_create(&hd->hd_td.handle, "httpd",
                                hd->config.stack_size,
                                hd->config.task_priority,
                                httpd_thread, hd,
                                hd->config.core_id) != ESP_OK) {
         /* Failed to launch task */
+        httpd_workers_stop(hd);
         httpd_delete(hd);
         return ESP_ERR_HTTPD_TASK;
     }
@@ -87,7 +87,7 @@ static int enum_function(struct sock_db *session, void *context)
         break;
     // Set descriptor
     case HTTPD_TASK_SET_DESCRIPTOR:
-        if (session->fd != -1) {
+        if (session->fd != -1 && !session->worker_owned) {
             FD_SET(session->fd, ctx->fdset);
             if (session->fd > ctx->max_fd) {
                 ctx->max_fd = session->fd;
@@ -96,7 +96,7 @@ static int enum_function(struct sock_db *session, void *context)
         break;
     // Delete invalid session
     case HTTPD_TASK_DELETE_INVALID:
-        if (!fd_is_valid(session->fd)) {
+        if (!session->worker_owned && !fd_is_valid(session->fd)) {
             ESP_LOGW(TAG, LOG_FMT("Closing invalid socket %d"), session->fd);
             httpd_sess_delete(ctx->hd, session);
         }
@@ -107,6 +107,10 @@ static int enum_function(struct sock_db *session, void *context)
         if (session->fd == -1) {
             return 0;
         }
+        // Sessions processed by a worker are in use
+        if (session->worker_owned) {
+            break;
+        }
         // Check/update lowest lru
         if (session->lru_counter < ctx->lru_counter) {
             ctx->lru_counter = session->lru_counter;
@@ -141,10 +145,23 @@ static void httpd_sess_close(void *arg)
         return;
     }
     sock_db->lru_socket = false;
+    if (sock_db->worker_owned) {
+        // The session is closed when the worker hands it back
+        ESP_LOGD(TAG, LOG_FMT("Deferring session close for %d processed by a worker"), sock_db->fd);
+        sock_db->close_pending = true;
+        return;
+    }
     struct httpd_data *hd = (struct httpd_data *) sock_db->handle;
     httpd_sess_delete(hd, sock_db);
 }
 
+// Returns the request being processed by the calling task
+static httpd_req_t *httpd_sess_current_req(struct httpd_data *hd)
+{
+    struct httpd_worker *worker = httpd_worker_current(hd);
+    return worker ? &worker->req : &hd->hd_req;
+}
+
 struct sock_db *httpd_sess_get_free(struct httpd_data *hd)
 {
     if ((!hd) || (hd->hd_sd_active_count == hd->config.max_open_sockets)) {
@@ -170,8 +187,9 @@ struct sock_db *httpd_sess_get(struct httpd_data *hd, int sockfd)
 
     // Check if called inside a request handler, and the session sockfd in use is same as the parameter
     // => Just return the pointer to the sock_db corresponding to the request
-    if ((hd->hd_req_aux.sd) && (hd->hd_req_aux.sd->fd == sockfd)) {
-        return hd->hd_req_aux.sd;
+    struct httpd_req_aux *ra = httpd_sess_current_req(hd)->aux;
+    if ((ra) && (ra->sd) && (ra->sd->fd == sockfd)) {
+        return ra->sd;
     }
 
     enum_context_t context = {
@@ -264,9 +282,10 @@ void *httpd_sess_get_ctx(httpd_handle_t handle, int sockfd)
     // Check if the function has been called from inside a
     // request handler, in which case fetch the context from
     // the httpd_req_t structure
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        return hd->hd_req.sess_ctx;
+    httpd_req_t *r = httpd_sess_current_req((struct httpd_data *) handle);
+    struct httpd_req_aux *ra = r->aux;
+    if ((ra) && (ra->sd == session)) {
+        return r->sess_ctx;
     }
     return session->ctx;
 }
@@ -281,17 +300,18 @@ void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free
     // Check if the function has been called from inside a
     // request handler, in which case set the context inside
     // the httpd_req_t structure
-    struct httpd_data *hd = (struct httpd_data *) handle;
-    if (hd->hd_req_aux.sd == session) {
-        if (hd->hd_req.sess_ctx != ctx) {
+    httpd_req_t *r = httpd_sess_current_req((struct httpd_data *) handle);
+    struct httpd_req_aux *ra = r->aux;
+    if ((ra) && (ra->sd == session)) {
+        if (r->sess_ctx != ctx) {
             // Don't free previous context if it is in sockdb
             // as it will be freed inside httpd_req_cleanup()
-            if (session->ctx != hd->hd_req.sess_ctx) {
-                httpd_sess_free_ctx(&hd->hd_req.sess_ctx, hd->hd_req.free_ctx); // Free previous context
+            if (session->ctx != r->sess_ctx) {
+                httpd_sess_free_ctx(&r->sess_ctx, r->free_ctx); // Free previous context
             }
-            hd->hd_req.sess_ctx = ctx;
+            r->sess_ctx = ctx;
         }
-        hd->hd_req.free_ctx = free_fn;
+        r->free_ctx = free_fn;
         return;
     }
 
@@ -416,19 +436,78 @@ esp_err_t httpd_sess_process(struct httpd_data *hd, struct sock_db *session)
         return ESP_FAIL;
     }
 
+    // Requests are processed either by a worker task,
+    // with its own request data, or by the server task
+    struct httpd_worker *worker = httpd_worker_current(hd);
+    httpd_req_t *r = worker ? &worker->req : &hd->hd_req;
+    struct httpd_req_aux *ra = worker ? &worker->req_aux : &hd->hd_req_aux;
+
     ESP_LOGD(TAG, LOG_FMT("httpd_req_new"));
-    if (httpd_req_new(hd, session) != ESP_OK) {
+    if (httpd_req_new(hd, r, ra, session) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("httpd_req_delete"));
-    if (httpd_req_delete(hd) != ESP_OK) {
+    if (httpd_req_delete(r) != ESP_OK) {
         return ESP_FAIL;
     }
     ESP_LOGD(TAG, LOG_FMT("success"));
-    session->lru_counter = ++hd->lru_counter;
+    if (!worker) {
+        // The LRU counter of sessions processed by a worker
+        // is updated by the server task when handed off
+        session->lru_counter = ++hd->lru_counter;
+    }
     return ESP_OK;
 }
 
+void httpd_sess_hand_off(struct httpd_data *hd, struct sock_db *session)
+{
+    ESP_LOGD(TAG, LOG_FMT("fd = %d"), session->fd);
+    session->worker_owned = true;
+    session->worker_failed = false;
+    session->lru_counter = ++hd->lru_counter;
+    hd->hd_sd_worker_count++;
+    // The queue has room for all sessions, and a session
+    // is queued again only after being handed back
+    xQueueSend(hd->hd_work_queue, &session, portMAX_DELAY);
+}
+
+// Called by the server task for a session handed back by a worker
+static void httpd_sess_released(void *arg)
+{
+    struct sock_db *session = (struct sock_db *) arg;
+    struct httpd_data *hd = (struct httpd_data *) session->handle;
+
+    ESP_LOGD(TAG, LOG_FMT("fd = %d"), session->fd);
+    session->worker_owned = false;
+    hd->hd_sd_worker_count--;
+    if (session->worker_failed || session->close_pending) {
+        session->close_pending = false;
+        httpd_sess_delete(hd, session);
+    }
+}
+
+void httpd_sess_release(struct httpd_data *hd, struct sock_db *session, esp_err_t ret)
+{
+    session->worker_failed = (ret != ESP_OK);
+    // The session must be handed back for its socket to be selected again,
+    // so retry until the control socket has room for the message
+    while (httpd_queue_work(hd, httpd_sess_released, session) != ESP_OK) {
+        httpd_os_thread_sleep(10);
+    }
+}
+
+// Called by the server task, which alone updates the LRU counters
+static void httpd_sess_lru_update(void *arg)
+{
+    struct sock_db *session = (struct sock_db *) arg;
+    struct httpd_data *hd = (struct httpd_data *) session->handle;
+
+    // The session may have been closed in the meantime
+    if (session->fd != -1) {
+        session->lru_counter = ++hd->lru_counter;
+    }
+}
+
 esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
 {
     if (handle == NULL) {
@@ -442,11 +521,16 @@ esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
         .fd = sockfd
     };
     httpd_sess_enum(hd, enum_function, &context);
-    if (context.session) {
-        context.session->lru_counter = ++hd->lru_counter;
-        return ESP_OK;
+    if (!context.session) {
+        return ESP_ERR_NOT_FOUND;
     }
-    return ESP_ERR_NOT_FOUND;
+    if (httpd_os_thread_handle() != hd->hd_td.handle) {
+        // Called by a worker or another task, so defer the update
+        // to the server task instead of racing with it
+        return httpd_queue_work(handle, httpd_sess_lru_update, context.session);
+    }
+    httpd_sess_lru_update(context.session);
+    return ESP_OK;
 }
 
 esp_err_t httpd_sess_close_lru(struct httpd_data *hd)
@@ -6,6 +6,7 @@
 
 
 #include <errno.h>
+#include <sys/uio.h>
 #include <esp_log.h>
 #include <esp_err.h>
 
@@ -14,6 +15,8 @@
 
 static const char *TAG = "httpd_txrx";
 
+static int httpd_sock_err(const char *ctx, int sockfd);
+
 esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func)
 {
     struct sock_db *sess = httpd_sess_get(hd, sockfd);
@@ -81,6 +84,47 @@ static esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
     return ESP_OK;
 }
 
+/* Sends the buffers of iov one after the other. With the default send function,
+ * they are passed to the network stack together with sendmsg(), instead of with
+ * a send function call for each buffer */
+static esp_err_t httpd_send_all_iov(httpd_req_t *r, struct iovec *iov, int iovcnt)
+{
+    struct httpd_req_aux *ra = r->aux;
+
+    if (ra->sd->send_fn != httpd_default_send) {
+        for (int i = 0; i < iovcnt; i++) {
+            if (httpd_send_all(r, iov[i].iov_base, iov[i].iov_len) != ESP_OK) {
+                return ESP_FAIL;
+            }
+        }
+        return ESP_OK;
+    }
+
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = iovcnt,
+    };
+    while (msg.msg_iovlen > 0) {
+        int ret = sendmsg(ra->sd->fd, &msg, 0);
+        if (ret < 0) {
+            httpd_sock_err("sendmsg", ra->sd->fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGD(TAG, LOG_FMT("sent = %d"), ret);
+        /* Skip the buffers sent, and the part sent of the next one */
+        while (msg.msg_iovlen > 0 && ret >= msg.msg_iov->iov_len) {
+            ret -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + ret;
+            msg.msg_iov->iov_len -= ret;
+        }
+    }
+    return ESP_OK;
+}
+
 static size_t httpd_recv_pending(httpd_req_t *r, char *buf, size_t buf_len)
 {
     struct httpd_req_aux *ra = r->aux;
@@ -224,6 +268,49 @@ esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
     return ESP_OK;
 }
 
+/* Appends data to the response being assembled in the scratch buffer.
+ * The buffered data is sent first if the new data does not fit, and
+ * the new data is then sent right away if it does not fit either */
+static esp_err_t httpd_resp_buf_append(httpd_req_t *r, size_t *len, const char *buf, size_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+
+    if (*len + buf_len > sizeof(ra->scratch)) {
+        if (httpd_send_all(r, ra->scratch, *len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        *len = 0;
+        if (buf_len > sizeof(ra->scratch)) {
+            return httpd_send_all(r, buf, buf_len);
+        }
+    }
+    memcpy(ra->scratch + *len, buf, buf_len);
+    *len += buf_len;
+    return ESP_OK;
+}
+
+/* Appends the additional headers and the end of the header section
+ * to the response head, assembled in the scratch buffer */
+static esp_err_t httpd_resp_buf_append_hdrs(httpd_req_t *r, size_t *len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    const char *colon_separator = ": ";
+    const char *cr_lf_seperator = "\r\n";
+
+    /* Additional headers based on set_header */
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        if (httpd_resp_buf_append(r, len, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK ||
+                httpd_resp_buf_append(r, len, colon_separator, strlen(colon_separator)) != ESP_OK ||
+                httpd_resp_buf_append(r, len, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK ||
+                httpd_resp_buf_append(r, len, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+
+    /* End header section */
+    return httpd_resp_buf_append(r, len, cr_lf_seperator, strlen(cr_lf_seperator));
+}
+
 esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 {
     if (r == NULL) {
@@ -236,8 +323,6 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
 
     struct httpd_req_aux *ra = r->aux;
     const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     if (buf_len == HTTPD_RESP_USE_STRLEN) {
         buf_len = strlen(buf);
@@ -247,47 +332,36 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
     ra->req_hdrs_count = 0;
 
     /* Size of essential headers is limited by scratch buffer size */
-    if (snprintf(ra->scratch, sizeof(ra->scratch), httpd_hdr_str,
-                 ra->status, ra->content_type, buf_len) >= sizeof(ra->scratch)) {
+    int len = snprintf(ra->scratch, sizeof(ra->scratch), httpd_hdr_str,
+                       ra->status, ra->content_type, buf_len);
+    if (len >= sizeof(ra->scratch)) {
         return ESP_ERR_HTTPD_RESP_HDR;
     }
 
-    /* Sending essential headers */
-    if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
+    /* The essential and additional headers are assembled in the scratch buffer */
+    size_t resp_len = len;
+    if (httpd_resp_buf_append_hdrs(r, &resp_len) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
-    /* Sending additional headers based on set_header */
-    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-        /* Send header field */
-        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send ': ' */
-        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send header value */
-        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send CR + LF */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
+    /* The content is appended to the headers if it fits,
+     * and sent along with them from its buffer otherwise */
+    struct iovec iov[] = {
+        { .iov_base = ra->scratch },
+        { .iov_base = (char *) buf },
+    };
+    if (buf && buf_len) {
+        if (resp_len + buf_len <= sizeof(ra->scratch)) {
+            memcpy(ra->scratch + resp_len, buf, buf_len);
+            resp_len += buf_len;
+        } else {
+            iov[1].iov_len = buf_len;
         }
     }
-
-    /* End header section */
-    if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    iov[0].iov_len = resp_len;
+    if (httpd_send_all_iov(r, iov, iov[1].iov_len ? 2 : 1) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
-
-    /* Sending content */
-    if (buf && buf_len) {
-        if (httpd_send_all(r, buf, buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-    }
     return ESP_OK;
 }
 
@@ -307,66 +381,59 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len
 
     struct httpd_req_aux *ra = r->aux;
     const char *httpd_chunked_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
+    size_t resp_len = 0;
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
     if (!ra->first_chunk_sent) {
         /* Size of essential headers is limited by scratch buffer size */
-        if (snprintf(ra->scratch, sizeof(ra->scratch), httpd_chunked_hdr_str,
-                     ra->status, ra->content_type) >= sizeof(ra->scratch)) {
+        int len = snprintf(ra->scratch, sizeof(ra->scratch), httpd_chunked_hdr_str,
+                           ra->status, ra->content_type);
+        if (len >= sizeof(ra->scratch)) {
             return ESP_ERR_HTTPD_RESP_HDR;
         }
 
-        /* Sending essential headers */
-        if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-
-        /* Sending additional headers based on set_header */
-        for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-            /* Send header field */
-            if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send ': ' */
-            if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send header value */
-            if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send CR + LF */
-            if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-        }
-
-        /* End header section */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+        /* The headers are sent along with the first chunk */
+        resp_len = len;
+        if (httpd_resp_buf_append_hdrs(r, &resp_len) != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
         ra->first_chunk_sent = true;
     }
 
-    /* Sending chunked content */
+    /* Chunk size */
     char len_str[10];
     snprintf(len_str, sizeof(len_str), "%x\r\n", buf_len);
-    if (httpd_send_all(r, len_str, strlen(len_str)) != ESP_OK) {
+    if (httpd_resp_buf_append(r, &resp_len, len_str, strlen(len_str)) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
 
-    if (buf) {
-        if (httpd_send_all(r, buf, (size_t) buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
+    /* The chunked content and the end of chunk are appended to the
+     * chunk size if they fit, and sent along with it otherwise */
+    const char *cr_lf_seperator = "\r\n";
+    size_t cr_lf_len = strlen(cr_lf_seperator);
+    if (!buf) {
+        buf_len = 0;
+    }
+    struct iovec iov[] = {
+        { .iov_base = ra->scratch },
+        { .iov_base = (char *) buf },
+        { .iov_base = (char *) cr_lf_seperator, .iov_len = cr_lf_len },
+    };
+    int iovcnt = 3;
+    if (resp_len + buf_len + cr_lf_len <= sizeof(ra->scratch)) {
+        if (buf_len) {
+            memcpy(ra->scratch + resp_len, buf, buf_len);
         }
+        memcpy(ra->scratch + resp_len + buf_len, cr_lf_seperator, cr_lf_len);
+        resp_len += buf_len + cr_lf_len;
+        iovcnt = 1;
+    } else {
+        iov[1].iov_len = buf_len;
     }
-
-    /* Indicate end of chunk */
-    if (httpd_send_all(r, "\r\n", strlen("\r\n")) != ESP_OK) {
+    iov[0].iov_len = resp_len;
+    if (httpd_send_all_iov(r, iov, iovcnt) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
     return ESP_OK;
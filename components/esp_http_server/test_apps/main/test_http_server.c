@@ -6,8 +6,15 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/param.h>
 #include <esp_system.h>
 #include <esp_http_server.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 #include "unity.h"
 #include "test_utils.h"
@@ -244,6 +251,272 @@ TEST_CASE("Max Allowed Sockets Test", "[HTTP SERVER]")
     TEST_ASSERT(httpd_start(&hd, &config) != ESP_OK);
 }
 
+/********************* Worker Pool Load Test *******************/
+
+#define LOAD_TEST_CLIENTS       3
+#define LOAD_TEST_DURATION_MS   2000
+
+typedef struct {
+    uint16_t port;
+    TickType_t end;
+    unsigned requests;
+    bool failed;
+    SemaphoreHandle_t done;
+} load_test_client_t;
+
+/* Handler waiting for a tick, as handlers blocking on I/O would do */
+static esp_err_t load_test_handler(httpd_req_t *req)
+{
+    vTaskDelay(1);
+    return httpd_resp_send(req, "ok", HTTPD_RESP_USE_STRLEN);
+}
+
+/* Reads a response to the end of its body, returns false on error */
+static bool load_test_recv_response(int fd)
+{
+    char buf[256];
+    int len = 0;
+    while (len < sizeof(buf) - 1) {
+        int ret = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret <= 0) {
+            return false;
+        }
+        len += ret;
+        buf[len] = '\0';
+        char *body = strstr(buf, "\r\n\r\n");
+        if (body) {
+            if (strncmp(buf, "HTTP/1.1 200", 12) != 0) {
+                return false;
+            }
+            if (strcmp(body + 4, "ok") == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Client sending requests one after the other on a persistent connection */
+static void load_test_client_task(void *arg)
+{
+    load_test_client_t *client = (load_test_client_t *) arg;
+    static const char request[] = "GET /load HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(client->port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        client->failed = true;
+    }
+    while (!client->failed && xTaskGetTickCount() < client->end) {
+        if (send(fd, request, sizeof(request) - 1, 0) != sizeof(request) - 1 ||
+                !load_test_recv_response(fd)) {
+            client->failed = true;
+            break;
+        }
+        client->requests++;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    xSemaphoreGive(client->done);
+    vTaskDelete(NULL);
+}
+
+static unsigned load_test_run(uint8_t worker_count)
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    /* The server uses 3 sockets, the clients 1 socket each */
+    config.max_open_sockets = LOAD_TEST_CLIENTS;
+    config.worker_count = worker_count;
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+
+    httpd_uri_t uri = {
+        .uri      = "/load",
+        .method   = HTTP_GET,
+        .handler  = load_test_handler,
+    };
+    TEST_ASSERT(httpd_register_uri_handler(hd, &uri) == ESP_OK);
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(LOAD_TEST_CLIENTS, 0);
+    TEST_ASSERT_NOT_NULL(done);
+    load_test_client_t clients[LOAD_TEST_CLIENTS];
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(LOAD_TEST_DURATION_MS);
+    for (int i = 0; i < LOAD_TEST_CLIENTS; i++) {
+        clients[i] = (load_test_client_t) {
+            .port = config.server_port,
+            .end = end,
+            .done = done,
+        };
+        TEST_ASSERT(xTaskCreate(load_test_client_task, "load_client", 4096,
+                                &clients[i], config.task_priority, NULL) == pdPASS);
+    }
+
+    unsigned requests = 0;
+    for (int i = 0; i < LOAD_TEST_CLIENTS; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    for (int i = 0; i < LOAD_TEST_CLIENTS; i++) {
+        TEST_ASSERT_FALSE(clients[i].failed);
+        requests += clients[i].requests;
+    }
+    vSemaphoreDelete(done);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+    return requests * 1000 / LOAD_TEST_DURATION_MS;
+}
+
+TEST_CASE("Worker Pool Load Test", "[HTTP SERVER]")
+{
+    static const uint8_t worker_counts[] = { 0, 1, 2, 3 };
+    unsigned rate[sizeof(worker_counts)];
+
+    test_case_uses_tcpip();
+
+    for (int i = 0; i < sizeof(worker_counts); i++) {
+        rate[i] = load_test_run(worker_counts[i]);
+        printf("%d workers: %u requests/s\n", worker_counts[i], rate[i]);
+    }
+    /* Requests of the clients are processed concurrently
+     * by several workers, so they wait for ticks together */
+    TEST_ASSERT_GREATER_THAN(rate[0], rate[sizeof(worker_counts) - 1]);
+}
+
+/********************* Response Send Test *******************/
+
+#define RESP_TEST_REQUESTS      100
+#define RESP_TEST_BODY_LEN      2048
+
+static unsigned resp_test_send_count;
+static char resp_test_body[RESP_TEST_BODY_LEN];
+
+static int resp_test_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    resp_test_send_count++;
+    int ret = send(sockfd, buf, buf_len, flags);
+    return ret < 0 ? HTTPD_SOCK_ERR_FAIL : ret;
+}
+
+static esp_err_t resp_test_open_fn(httpd_handle_t hd, int sockfd)
+{
+    /* Count the calls to the send function */
+    return httpd_sess_set_send_override(hd, sockfd, resp_test_send);
+}
+
+/* Small response with custom headers */
+static esp_err_t resp_test_hdr_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "X-Request-Id", "1234");
+    httpd_resp_set_hdr(req, "X-Server", "esp_http_server");
+    httpd_resp_set_hdr(req, "Connection", "keep-alive");
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    return httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
+}
+
+/* Response with a body larger than the response buffer */
+static esp_err_t resp_test_big_handler(httpd_req_t *req)
+{
+    return httpd_resp_send(req, resp_test_body, sizeof(resp_test_body));
+}
+
+/* Reads a response to the end of its body, returns false on error */
+static bool resp_test_recv_response(int fd)
+{
+    char buf[512];
+    int len = 0;
+    char *body = NULL;
+    while (!body) {
+        if (len == sizeof(buf) - 1) {
+            return false;
+        }
+        int ret = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (ret <= 0) {
+            return false;
+        }
+        len += ret;
+        buf[len] = '\0';
+        body = strstr(buf, "\r\n\r\n");
+    }
+    char *content_len = strstr(buf, "Content-Length: ");
+    if (strncmp(buf, "HTTP/1.1 200", 12) != 0 || !content_len || content_len > body) {
+        return false;
+    }
+    int remaining = atoi(content_len + strlen("Content-Length: ")) - (buf + len - body - 4);
+    while (remaining > 0) {
+        int ret = recv(fd, buf, MIN(remaining, sizeof(buf)), 0);
+        if (ret <= 0) {
+            return false;
+        }
+        remaining -= ret;
+    }
+    return remaining == 0;
+}
+
+/* Sends requests for uri one after the other on a persistent connection,
+ * and returns the mean time until the whole response is received */
+static int64_t resp_test_run(uint16_t port, const char *uri)
+{
+    char request[64];
+    int request_len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", uri);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    int64_t total = 0;
+    for (int i = 0; i < RESP_TEST_REQUESTS; i++) {
+        int64_t start = esp_timer_get_time();
+        TEST_ASSERT_EQUAL(request_len, send(fd, request, request_len, 0));
+        TEST_ASSERT(resp_test_recv_response(fd));
+        total += esp_timer_get_time() - start;
+    }
+    close(fd);
+    return total / RESP_TEST_REQUESTS;
+}
+
+TEST_CASE("Response Send Test", "[HTTP SERVER]")
+{
+    httpd_uri_t uris[] = {
+        { .uri = "/hdr", .method = HTTP_GET, .handler = resp_test_hdr_handler },
+        { .uri = "/big", .method = HTTP_GET, .handler = resp_test_big_handler },
+    };
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+    test_case_uses_tcpip();
+    memset(resp_test_body, 'a', sizeof(resp_test_body));
+
+    /* With the default send function, the response head
+     * and body are passed to the network stack at once */
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    for (int i = 0; i < sizeof(uris) / sizeof(uris[0]); i++) {
+        TEST_ASSERT(httpd_register_uri_handler(hd, &uris[i]) == ESP_OK);
+        printf("%s: %lld us/response\n", uris[i].uri, resp_test_run(config.server_port, uris[i].uri));
+    }
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+
+    /* A send function override is called once with the response buffer,
+     * holding the status line, headers and body of a small response */
+    config.open_fn = resp_test_open_fn;
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    TEST_ASSERT(httpd_register_uri_handler(hd, &uris[0]) == ESP_OK);
+    resp_test_send_count = 0;
+    int64_t latency = resp_test_run(config.server_port, uris[0].uri);
+    printf("%s, send override: %u sends/response, %lld us/response\n", uris[0].uri,
+           resp_test_send_count / RESP_TEST_REQUESTS, latency);
+    TEST_ASSERT_EQUAL(RESP_TEST_REQUESTS, resp_test_send_count);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
 void app_main(void)
 {
     unity_run_menu();
@@ -45,9 +45,33 @@ typedef enum {
      * time.
      */
     RINGBUF_TYPE_BYTEBUF,
+    /**
+     * Single-producer/single-consumer variant of RINGBUF_TYPE_NOSPLIT. Sending
+     * and receiving do not take the ring buffer's spinlock, and the semaphores
+     * are only used to wake a task blocked on a full or empty buffer. Only one
+     * task or ISR may send to the buffer and only one task or ISR may receive
+     * from it. Received items must be returned in the order they were received.
+     */
+    RINGBUF_TYPE_NOSPLIT_SPSC,
+    /**
+     * Single-producer/single-consumer variant of RINGBUF_TYPE_BYTEBUF. Sending
+     * and receiving do not take the ring buffer's spinlock, and the semaphores
+     * are only used to wake a task blocked on a full or empty buffer. Only one
+     * task or ISR may send to the buffer and only one task or ISR may receive
+     * from it.
+     */
+    RINGBUF_TYPE_BYTEBUF_SPSC,
     RINGBUF_TYPE_MAX,
 } RingbufferType_t;
 
+/**
+ * @brief Item retrieved by xRingbufferReceiveMultiple()
+ */
+typedef struct {
+    void *pvItem;       /**< Pointer to the retrieved item */
+    size_t xItemSize;   /**< Size of the retrieved item */
+} RingbufferItem_t;
+
 /**
  * @brief Struct that is equivalent in size to the ring buffer's data structure
  *
@@ -66,6 +90,8 @@ typedef struct xSTATIC_RINGBUFFER {
     void *pvDummy4[11];
     StaticSemaphore_t xDummy5[2];
     portMUX_TYPE muxDummy;
+    size_t xDummy6[3];
+    BaseType_t xDummy7[2];
     /** @endcond */
 } StaticRingbuffer_t;
 #endif
@@ -185,10 +211,10 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
  * @param[in]   xItemSize       Size of item to acquire.
  * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
  *
- * @note Only applicable for no-split ring buffers now, the actual size of
- *       memory that the item will occupy will be rounded up to the nearest 32-bit
- *       aligned size. This is done to ensure all items are always stored in 32-bit
- *       aligned fashion.
+ * @note Only applicable for no-split ring buffers now (not RINGBUF_TYPE_NOSPLIT_SPSC),
+ *       the actual size of memory that the item will occupy will be rounded up to
+ *       the nearest 32-bit aligned size. This is done to ensure all items are always
+ *       stored in 32-bit aligned fashion.
  *
  * @return
  *      - pdTRUE if succeeded
@@ -356,6 +382,30 @@ void *xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer,
  */
 void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize, size_t xMaxSize);
 
+/**
+ * @brief   Retrieve multiple items from a no-split ring buffer at once
+ *
+ * Attempt to retrieve up to uxMaxItems items from a no-split ring buffer. This
+ * function will block until at least one item is available or until it times
+ * out, then retrieves all the available items up to uxMaxItems without
+ * releasing the ring buffer in between.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  pxItems         Array to which the retrieved items and their sizes will be written, in FIFO order
+ * @param[in]   uxMaxItems      Maximum number of items to retrieve (number of elements in pxItems)
+ * @param[in]   xTicksToWait    Ticks to wait for items in the ring buffer.
+ *
+ * @note    The retrieved items must be returned, either by calling vRingbufferReturnMultiple()
+ *          or by calling vRingbufferReturnItem() for each item.
+ * @note    This function should only be called on no-split buffers (RINGBUF_TYPE_NOSPLIT or RINGBUF_TYPE_NOSPLIT_SPSC)
+ *
+ * @return  Number of items retrieved, 0 on timeout
+ */
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer,
+                                       RingbufferItem_t *pxItems,
+                                       UBaseType_t uxMaxItems,
+                                       TickType_t xTicksToWait);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer
  *
@@ -378,6 +428,20 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
  */
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief   Return multiple previously-retrieved items to the ring buffer at once
+ *
+ * The items are returned without releasing the ring buffer in between, and
+ * blocked senders are only notified once.
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   pxItems     Items that were received earlier, e.g. by xRingbufferReceiveMultiple()
+ * @param[in]   uxItems     Number of items in pxItems
+ *
+ * @note    Items of RINGBUF_TYPE_NOSPLIT_SPSC buffers must be passed in the order they were retrieved
+ */
+void vRingbufferReturnMultiple(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems);
+
 /**
  * @brief   Delete a ring buffer
  *
@@ -438,6 +502,9 @@ size_t xRingbufferGetCurFreeSize(RingbufHandle_t xRingbuffer);
  * @param[in]   xRingbuffer     Ring buffer to add to the queue set
  * @param[in]   xQueueSet       Queue set to add the ring buffer's read semaphore to
  *
+ * @note    Single-producer/single-consumer ring buffers only give their read
+ *          semaphore to a blocked consumer, thus cannot be added to a queue set.
+ *
  * @return
  *      - pdTRUE on success, pdFALSE otherwise
  */
@@ -21,6 +21,7 @@
 #define rbBYTE_BUFFER_FLAG          ( ( UBaseType_t ) 2 )   //The ring buffer is a byte buffer
 #define rbBUFFER_FULL_FLAG          ( ( UBaseType_t ) 4 )   //The ring buffer is currently full (write pointer == free pointer)
 #define rbBUFFER_STATIC_FLAG        ( ( UBaseType_t ) 8 )   //The ring buffer is statically allocated
+#define rbSPSC_FLAG                 ( ( UBaseType_t ) 16 )  //The ring buffer has a single producer and a single consumer and is lock-free
 
 //Item flags
 #define rbITEM_FREE_FLAG            ( ( UBaseType_t ) 1 )   //Item has been retrieved and returned by application, free to overwrite
@@ -95,6 +96,18 @@ typedef struct RingbufferDefinition {
     SemaphoreHandle_t xRecvSemHandle;
 #endif
     portMUX_TYPE mux;                           //Spinlock required for SMP
+
+    /*
+     * Positions used by single-producer/single-consumer ring buffers instead
+     * of the pointers above. Positions are kept in the range [0, 2 * xSize) so
+     * that a full buffer can be told apart from an empty one without a shared
+     * flag (see prvSpscOffset()). Each position is only ever written by one side.
+     */
+    size_t xSpscWrite;                          //Position up to which items have been written. Written by the producer
+    size_t xSpscFree;                           //Position up to which items have been returned. Written by the consumer
+    size_t xSpscRead;                           //Position up to which items have been retrieved. Only used by the consumer
+    BaseType_t xSpscTxWaiting;                  //Producer is about to block on TransSem. Written by the producer
+    BaseType_t xSpscRxWaiting;                  //Consumer is about to block on RecvSem. Written by the consumer
 } Ringbuffer_t;
 
 #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
@@ -201,6 +214,73 @@ static size_t prvGetCurMaxSizeAllowSplit(Ringbuffer_t *pxRingbuffer);
 //Get the maximum size an item that can currently have if sent to a byte buffer
 static size_t prvGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer);
 
+/*
+ * The following functions implement single-producer/single-consumer ring
+ * buffers. They ARE thread safe as long as only one task (or ISR) sends to the
+ * ring buffer and only one task (or ISR) receives from it, and do not need to
+ * be called within a critical section.
+ */
+
+//Checks if an item will currently fit in a SPSC no-split ring buffer
+static BaseType_t prvSpscCheckItemFitsNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Checks if an item will currently fit in a SPSC byte buffer
+static BaseType_t prvSpscCheckItemFitsByteBuf(Ringbuffer_t *pxRingbuffer, size_t xItemSize);
+
+//Copies an item to a SPSC no-split ring buffer and publishes it to the consumer. Only call this function after calling prvSpscCheckItemFitsNoSplit()
+static void prvSpscCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
+
+//Copies an item to a SPSC byte buffer and publishes it to the consumer. Only call this function after calling prvSpscCheckItemFitsByteBuf()
+static void prvSpscCopyItemByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize);
+
+//Checks if an item/data is currently available for retrieval from a SPSC ring buffer
+static BaseType_t prvSpscCheckItemAvail(Ringbuffer_t *pxRingbuffer);
+
+//Retrieve item from SPSC no-split ring buffer. Returns NULL if no item is available
+static void *prvSpscGetItemNoSplit(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxIsSplit,
+                                   size_t xUnusedParam,
+                                   size_t *pxItemSize);
+
+//Retrieve data from SPSC byte buffer. If xMaxSize is 0, all continuous data is retrieved. Returns NULL if no data is available
+static void *prvSpscGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxUnusedParam,
+                                   size_t xMaxSize,
+                                   size_t *pxItemSize);
+
+//Return an item to a SPSC no-split ring buffer. Items must be returned in the order they were retrieved
+static void prvSpscReturnItemNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+//Return data to a SPSC byte buffer
+static void prvSpscReturnItemByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem);
+
+//Get the maximum size an item that can currently have if sent to a SPSC no-split ring buffer
+static size_t prvSpscGetCurMaxSizeNoSplit(Ringbuffer_t *pxRingbuffer);
+
+//Get the maximum size an item that can currently have if sent to a SPSC byte buffer
+static size_t prvSpscGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer);
+
+//Send an item to a SPSC ring buffer, blocking on TransSem only if the ring buffer is full
+static BaseType_t prvSpscSend(Ringbuffer_t *pxRingbuffer,
+                              const void *pvItem,
+                              size_t xItemSize,
+                              TickType_t xTicksToWait);
+
+//Retrieve an item/data from a SPSC ring buffer, blocking on RecvSem only if the ring buffer is empty
+static BaseType_t prvSpscReceive(Ringbuffer_t *pxRingbuffer,
+                                 void **pvItem,
+                                 size_t *xItemSize,
+                                 size_t xMaxSize,
+                                 TickType_t xTicksToWait);
+
+//Get the positions of a SPSC ring buffer for vRingbufferGetInfo()
+static void prvSpscGetInfo(Ringbuffer_t *pxRingbuffer,
+                           UBaseType_t *uxFree,
+                           UBaseType_t *uxRead,
+                           UBaseType_t *uxWrite,
+                           UBaseType_t *uxAcquire,
+                           UBaseType_t *uxItemsWaiting);
+
 /**
  * Generic function used to retrieve an item/data from ring buffers. If called on
  * an allow-split buffer, and pvItem2 and xItemSize2 are not NULL, both parts of
@@ -262,7 +342,7 @@ static void prvInitializeNewRingbuffer(size_t xBufferSize,
         //Worst case an item is split into two, incurring two headers of overhead
         pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize - (sizeof(ItemHeader_t) * 2);
         pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeAllowSplit;
-    } else { //Byte Buffer
+    } else if (xBufferType == RINGBUF_TYPE_BYTEBUF) {
         pxNewRingbuffer->uxRingbufferFlags |= rbBYTE_BUFFER_FLAG;
         pxNewRingbuffer->xCheckItemFits = prvCheckItemFitsByteBuffer;
         pxNewRingbuffer->vCopyItem = prvCopyItemByteBuf;
@@ -271,8 +351,33 @@ static void prvInitializeNewRingbuffer(size_t xBufferSize,
         //Byte buffers do not incur any overhead
         pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize;
         pxNewRingbuffer->xGetCurMaxSize = prvGetCurMaxSizeByteBuf;
+    } else if (xBufferType == RINGBUF_TYPE_NOSPLIT_SPSC) {
+        pxNewRingbuffer->uxRingbufferFlags |= rbSPSC_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvSpscCheckItemFitsNoSplit;
+        pxNewRingbuffer->vCopyItem = prvSpscCopyItemNoSplit;
+        pxNewRingbuffer->pvGetItem = prvSpscGetItemNoSplit;
+        pxNewRingbuffer->vReturnItem = prvSpscReturnItemNoSplit;
+        //Same worst case as no-split buffers, the item must fit either before or after the halfway point
+        pxNewRingbuffer->xMaxItemSize = rbALIGN_SIZE(pxNewRingbuffer->xSize / 2) - rbHEADER_SIZE;
+        pxNewRingbuffer->xGetCurMaxSize = prvSpscGetCurMaxSizeNoSplit;
+    } else { //SPSC Byte Buffer
+        pxNewRingbuffer->uxRingbufferFlags |= rbBYTE_BUFFER_FLAG | rbSPSC_FLAG;
+        pxNewRingbuffer->xCheckItemFits = prvSpscCheckItemFitsByteBuf;
+        pxNewRingbuffer->vCopyItem = prvSpscCopyItemByteBuf;
+        pxNewRingbuffer->pvGetItem = prvSpscGetItemByteBuf;
+        pxNewRingbuffer->vReturnItem = prvSpscReturnItemByteBuf;
+        pxNewRingbuffer->xMaxItemSize = pxNewRingbuffer->xSize;
+        pxNewRingbuffer->xGetCurMaxSize = prvSpscGetCurMaxSizeByteBuf;
+    }
+    pxNewRingbuffer->xSpscWrite = 0;
+    pxNewRingbuffer->xSpscFree = 0;
+    pxNewRingbuffer->xSpscRead = 0;
+    pxNewRingbuffer->xSpscTxWaiting = pdFALSE;
+    pxNewRingbuffer->xSpscRxWaiting = pdFALSE;
+    if ((pxNewRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) == 0) {
+        //SPSC ring buffers only give TransSem to a producer that is blocked
+        xSemaphoreGive(rbGET_TX_SEM_HANDLE(pxNewRingbuffer));
     }
-    xSemaphoreGive(rbGET_TX_SEM_HANDLE(pxNewRingbuffer));
     portMUX_INITIALIZE(&pxNewRingbuffer->mux);
 }
 
@@ -759,6 +864,322 @@ static size_t prvGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer)
     return xFreeSize;
 }
 
+/*
+ * Positions of SPSC ring buffers run over twice the size of the storage area.
+ * The offset into the storage area is the position modulo xSize, and the
+ * number of bytes between two positions can be anything from 0 (empty) to
+ * xSize (full).
+ */
+static inline size_t prvSpscOffset(Ringbuffer_t *pxRingbuffer, size_t xPos)
+{
+    return (xPos < pxRingbuffer->xSize) ? xPos : xPos - pxRingbuffer->xSize;
+}
+
+static inline size_t prvSpscAdvance(Ringbuffer_t *pxRingbuffer, size_t xPos, size_t xLen)
+{
+    xPos += xLen;
+    return (xPos < 2 * pxRingbuffer->xSize) ? xPos : xPos - 2 * pxRingbuffer->xSize;
+}
+
+static inline size_t prvSpscUsed(Ringbuffer_t *pxRingbuffer, size_t xFrom, size_t xTo)
+{
+    return (xTo >= xFrom) ? xTo - xFrom : xTo + 2 * pxRingbuffer->xSize - xFrom;
+}
+
+/*
+ * Wake the other side if it announced that it is about to block. The fence
+ * orders the preceding position update before reading the waiting flag, and
+ * pairs with the fence in prvSpscSend()/prvSpscReceive() between setting the
+ * flag and checking the position again. One of the two sides is therefore
+ * guaranteed to see the other's write, so a wake up can never be lost.
+ */
+static inline void prvSpscWakeWaiter(BaseType_t *pxWaiting, SemaphoreHandle_t xSemaphore, BaseType_t xFromISR, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(pxWaiting, __ATOMIC_RELAXED) == pdTRUE) {
+        if (xFromISR == pdTRUE) {
+            xSemaphoreGiveFromISR(xSemaphore, pxHigherPriorityTaskWoken);
+        } else {
+            xSemaphoreGive(xSemaphore);
+        }
+    }
+}
+
+//Get the header of the item at *pxPos, skipping over the padding a no-split producer leaves when wrapping around
+static inline ItemHeader_t *prvSpscGetHeader(Ringbuffer_t *pxRingbuffer, size_t *pxPos)
+{
+    size_t xOffset = prvSpscOffset(pxRingbuffer, *pxPos);
+    size_t xRemLen = pxRingbuffer->xSize - xOffset;
+    if (xRemLen < rbHEADER_SIZE || (((ItemHeader_t *)(pxRingbuffer->pucHead + xOffset))->uxItemFlags & rbITEM_DUMMY_DATA_FLAG)) {
+        *pxPos = prvSpscAdvance(pxRingbuffer, *pxPos, xRemLen);
+        xOffset = 0;
+    }
+    return (ItemHeader_t *)(pxRingbuffer->pucHead + xOffset);
+}
+
+//Space a no-split item written at xWrite occupies, including the padding at the end of the buffer if it has to wrap around
+static inline size_t prvSpscSpaceNeededNoSplit(Ringbuffer_t *pxRingbuffer, size_t xWrite, size_t xItemSize)
+{
+    size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;
+    size_t xRemLen = pxRingbuffer->xSize - prvSpscOffset(pxRingbuffer, xWrite);
+    return (xRemLen < xTotalItemSize) ? xRemLen + xTotalItemSize : xTotalItemSize;
+}
+
+static BaseType_t prvSpscCheckItemFitsNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    size_t xWrite = pxRingbuffer->xSpscWrite;
+    size_t xFree = __atomic_load_n(&pxRingbuffer->xSpscFree, __ATOMIC_ACQUIRE);
+    size_t xFreeSize = pxRingbuffer->xSize - prvSpscUsed(pxRingbuffer, xFree, xWrite);
+    return (prvSpscSpaceNeededNoSplit(pxRingbuffer, xWrite, xItemSize) <= xFreeSize) ? pdTRUE : pdFALSE;
+}
+
+static BaseType_t prvSpscCheckItemFitsByteBuf(Ringbuffer_t *pxRingbuffer, size_t xItemSize)
+{
+    size_t xFree = __atomic_load_n(&pxRingbuffer->xSpscFree, __ATOMIC_ACQUIRE);
+    size_t xFreeSize = pxRingbuffer->xSize - prvSpscUsed(pxRingbuffer, xFree, pxRingbuffer->xSpscWrite);
+    return (xItemSize <= xFreeSize) ? pdTRUE : pdFALSE;
+}
+
+static void prvSpscCopyItemNoSplit(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    size_t xWrite = pxRingbuffer->xSpscWrite;
+    size_t xTotalItemSize = rbALIGN_SIZE(xItemSize) + rbHEADER_SIZE;
+    size_t xOffset = prvSpscOffset(pxRingbuffer, xWrite);
+    size_t xRemLen = pxRingbuffer->xSize - xOffset;
+
+    //If remaining length can't fit item, mark it as dummy data (if a header fits) and wrap around
+    if (xRemLen < xTotalItemSize) {
+        if (xRemLen >= rbHEADER_SIZE) {
+            ItemHeader_t *pxDummy = (ItemHeader_t *)(pxRingbuffer->pucHead + xOffset);
+            pxDummy->uxItemFlags = rbITEM_DUMMY_DATA_FLAG;
+            pxDummy->xItemLen = 0;
+        }
+        xWrite = prvSpscAdvance(pxRingbuffer, xWrite, xRemLen);
+        xOffset = 0;
+    }
+    ItemHeader_t *pxHeader = (ItemHeader_t *)(pxRingbuffer->pucHead + xOffset);
+    pxHeader->xItemLen = xItemSize;
+    pxHeader->uxItemFlags = 0;
+    memcpy(pxRingbuffer->pucHead + xOffset + rbHEADER_SIZE, pucItem, xItemSize);
+
+    //Publish the item to the consumer. The release orders the copy before the new position
+    __atomic_store_n(&pxRingbuffer->xSpscWrite, prvSpscAdvance(pxRingbuffer, xWrite, xTotalItemSize), __ATOMIC_RELEASE);
+}
+
+static void prvSpscCopyItemByteBuf(Ringbuffer_t *pxRingbuffer, const uint8_t *pucItem, size_t xItemSize)
+{
+    size_t xWrite = pxRingbuffer->xSpscWrite;
+    size_t xOffset = prvSpscOffset(pxRingbuffer, xWrite);
+    size_t xRemLen = pxRingbuffer->xSize - xOffset;
+
+    if (xRemLen < xItemSize) {
+        //Copy as much as possible into remaining length, and the rest to the start of the buffer
+        memcpy(pxRingbuffer->pucHead + xOffset, pucItem, xRemLen);
+        memcpy(pxRingbuffer->pucHead, pucItem + xRemLen, xItemSize - xRemLen);
+    } else {
+        memcpy(pxRingbuffer->pucHead + xOffset, pucItem, xItemSize);
+    }
+
+    //Publish the data to the consumer. The release orders the copy before the new position
+    __atomic_store_n(&pxRingbuffer->xSpscWrite, prvSpscAdvance(pxRingbuffer, xWrite, xItemSize), __ATOMIC_RELEASE);
+}
+
+static BaseType_t prvSpscCheckItemAvail(Ringbuffer_t *pxRingbuffer)
+{
+    if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && pxRingbuffer->xSpscRead != pxRingbuffer->xSpscFree) {
+        return pdFALSE;     //Byte buffers do not allow multiple retrievals before return
+    }
+    return (__atomic_load_n(&pxRingbuffer->xSpscWrite, __ATOMIC_ACQUIRE) != pxRingbuffer->xSpscRead) ? pdTRUE : pdFALSE;
+}
+
+static void *prvSpscGetItemNoSplit(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxIsSplit,
+                                   size_t xUnusedParam,
+                                   size_t *pxItemSize)
+{
+    if (prvSpscCheckItemAvail(pxRingbuffer) == pdFALSE) {
+        return NULL;
+    }
+    size_t xRead = pxRingbuffer->xSpscRead;
+    ItemHeader_t *pxHeader = prvSpscGetHeader(pxRingbuffer, &xRead);
+    configASSERT(pxHeader->xItemLen <= pxRingbuffer->xMaxItemSize);
+
+    *pxItemSize = pxHeader->xItemLen;
+    if (pxIsSplit != NULL) {
+        *pxIsSplit = pdFALSE;
+    }
+    pxRingbuffer->xSpscRead = prvSpscAdvance(pxRingbuffer, xRead, rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen));
+    return (uint8_t *)pxHeader + rbHEADER_SIZE;
+}
+
+static void *prvSpscGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
+                                   BaseType_t *pxUnusedParam,
+                                   size_t xMaxSize,
+                                   size_t *pxItemSize)
+{
+    if (prvSpscCheckItemAvail(pxRingbuffer) == pdFALSE) {
+        return NULL;
+    }
+    size_t xRead = pxRingbuffer->xSpscRead;
+    size_t xWrite = __atomic_load_n(&pxRingbuffer->xSpscWrite, __ATOMIC_ACQUIRE);
+    size_t xOffset = prvSpscOffset(pxRingbuffer, xRead);
+
+    //Return contiguous data from read position until the write position or buffer tail, or xMaxSize
+    size_t xLen = prvSpscUsed(pxRingbuffer, xRead, xWrite);
+    if (xLen > pxRingbuffer->xSize - xOffset) {
+        xLen = pxRingbuffer->xSize - xOffset;
+    }
+    if (xMaxSize != 0 && xLen > xMaxSize) {
+        xLen = xMaxSize;
+    }
+    *pxItemSize = xLen;
+    pxRingbuffer->xSpscRead = prvSpscAdvance(pxRingbuffer, xRead, xLen);
+    return pxRingbuffer->pucHead + xOffset;
+}
+
+static void prvSpscReturnItemNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    size_t xFree = pxRingbuffer->xSpscFree;
+    configASSERT(xFree != pxRingbuffer->xSpscRead);     //There must be an item that has been retrieved
+    ItemHeader_t *pxHeader = prvSpscGetHeader(pxRingbuffer, &xFree);
+    configASSERT(pucItem == (uint8_t *)pxHeader + rbHEADER_SIZE);   //Items must be returned in the order they were retrieved
+
+    //Hand the space back to the producer. The release orders the reads of the item before the new position
+    __atomic_store_n(&pxRingbuffer->xSpscFree, prvSpscAdvance(pxRingbuffer, xFree, rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen)), __ATOMIC_RELEASE);
+}
+
+static void prvSpscReturnItemByteBuf(Ringbuffer_t *pxRingbuffer, uint8_t *pucItem)
+{
+    configASSERT(pucItem == pxRingbuffer->pucHead + prvSpscOffset(pxRingbuffer, pxRingbuffer->xSpscFree));
+    //Byte buffers do not allow multiple outstanding reads, free everything that has been retrieved
+    __atomic_store_n(&pxRingbuffer->xSpscFree, pxRingbuffer->xSpscRead, __ATOMIC_RELEASE);
+}
+
+static size_t prvSpscGetCurMaxSizeNoSplit(Ringbuffer_t *pxRingbuffer)
+{
+    size_t xWrite = __atomic_load_n(&pxRingbuffer->xSpscWrite, __ATOMIC_ACQUIRE);
+    size_t xFree = __atomic_load_n(&pxRingbuffer->xSpscFree, __ATOMIC_ACQUIRE);
+    size_t xFreeSize = pxRingbuffer->xSize - prvSpscUsed(pxRingbuffer, xFree, xWrite);
+    size_t xRemLen = pxRingbuffer->xSize - prvSpscOffset(pxRingbuffer, xWrite);
+
+    //If free space wraps around, select the larger of the two contiguous parts
+    if (xFreeSize > xRemLen) {
+        xFreeSize = (xRemLen > xFreeSize - xRemLen) ? xRemLen : xFreeSize - xRemLen;
+    }
+    //No-split ring buffer items need space for a header
+    if (xFreeSize < rbHEADER_SIZE) {
+        return 0;
+    }
+    xFreeSize -= rbHEADER_SIZE;
+    return (xFreeSize > pxRingbuffer->xMaxItemSize) ? pxRingbuffer->xMaxItemSize : xFreeSize;
+}
+
+static size_t prvSpscGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer)
+{
+    size_t xWrite = __atomic_load_n(&pxRingbuffer->xSpscWrite, __ATOMIC_ACQUIRE);
+    size_t xFree = __atomic_load_n(&pxRingbuffer->xSpscFree, __ATOMIC_ACQUIRE);
+    return pxRingbuffer->xSize - prvSpscUsed(pxRingbuffer, xFree, xWrite);
+}
+
+static BaseType_t prvSpscSend(Ringbuffer_t *pxRingbuffer,
+                              const void *pvItem,
+                              size_t xItemSize,
+                              TickType_t xTicksToWait)
+{
+    BaseType_t xReturn = pdFALSE;
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (1) {
+        if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
+            pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, xItemSize);
+            prvSpscWakeWaiter(&pxRingbuffer->xSpscRxWaiting, rbGET_RX_SEM_HANDLE(pxRingbuffer), pdFALSE, NULL);
+            xReturn = pdTRUE;
+            break;
+        }
+        if (xTicksRemaining == 0 || xTicksRemaining > xTicksToWait) {  //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+            break;
+        }
+        //Buffer is full. Announce that we are about to block, then check again as space may have been freed in between
+        __atomic_store_n(&pxRingbuffer->xSpscTxWaiting, pdTRUE, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdFALSE) {
+            xSemaphoreTake(rbGET_TX_SEM_HANDLE(pxRingbuffer), xTicksRemaining);
+        }
+        __atomic_store_n(&pxRingbuffer->xSpscTxWaiting, pdFALSE, __ATOMIC_RELAXED);
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+    }
+    return xReturn;
+}
+
+static BaseType_t prvSpscReceive(Ringbuffer_t *pxRingbuffer,
+                                 void **pvItem,
+                                 size_t *xItemSize,
+                                 size_t xMaxSize,
+                                 TickType_t xTicksToWait)
+{
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (1) {
+        *pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, xMaxSize, xItemSize);
+        if (*pvItem != NULL) {
+            return pdTRUE;
+        }
+        if (xTicksRemaining == 0 || xTicksRemaining > xTicksToWait) {  //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+            return pdFALSE;
+        }
+        //Buffer is empty. Announce that we are about to block, then check again as an item may have been sent in between
+        __atomic_store_n(&pxRingbuffer->xSpscRxWaiting, pdTRUE, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (prvSpscCheckItemAvail(pxRingbuffer) == pdFALSE) {
+            xSemaphoreTake(rbGET_RX_SEM_HANDLE(pxRingbuffer), xTicksRemaining);
+        }
+        __atomic_store_n(&pxRingbuffer->xSpscRxWaiting, pdFALSE, __ATOMIC_RELAXED);
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+    }
+}
+
+static void prvSpscGetInfo(Ringbuffer_t *pxRingbuffer,
+                           UBaseType_t *uxFree,
+                           UBaseType_t *uxRead,
+                           UBaseType_t *uxWrite,
+                           UBaseType_t *uxAcquire,
+                           UBaseType_t *uxItemsWaiting)
+{
+    size_t xWrite = __atomic_load_n(&pxRingbuffer->xSpscWrite, __ATOMIC_ACQUIRE);
+    size_t xRead = pxRingbuffer->xSpscRead;
+    if (uxFree != NULL) {
+        *uxFree = (UBaseType_t)prvSpscOffset(pxRingbuffer, pxRingbuffer->xSpscFree);
+    }
+    if (uxRead != NULL) {
+        *uxRead = (UBaseType_t)prvSpscOffset(pxRingbuffer, xRead);
+    }
+    if (uxWrite != NULL) {
+        *uxWrite = (UBaseType_t)prvSpscOffset(pxRingbuffer, xWrite);
+    }
+    if (uxAcquire != NULL) {
+        //Acquiring is not supported, so the acquire pointer always equals the write pointer
+        *uxAcquire = (UBaseType_t)prvSpscOffset(pxRingbuffer, xWrite);
+    }
+    if (uxItemsWaiting != NULL) {
+        if (pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) {
+            *uxItemsWaiting = (UBaseType_t)prvSpscUsed(pxRingbuffer, xRead, xWrite);
+        } else {
+            //Items are not counted on the fast path, walk the items that have not been retrieved yet
+            UBaseType_t uxCount = 0;
+            while (xRead != xWrite) {
+                ItemHeader_t *pxHeader = prvSpscGetHeader(pxRingbuffer, &xRead);
+                xRead = prvSpscAdvance(pxRingbuffer, xRead, rbHEADER_SIZE + rbALIGN_SIZE(pxHeader->xItemLen));
+                uxCount++;
+            }
+            *uxItemsWaiting = uxCount;
+        }
+    }
+}
+
 static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer,
                                     void **pvItem1,
                                     void **pvItem2,
@@ -767,6 +1188,10 @@ static BaseType_t prvReceiveGeneric(Ringbuffer_t *pxRingbuffer,
                                     size_t xMaxSize,
                                     TickType_t xTicksToWait)
 {
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvSpscReceive(pxRingbuffer, pvItem1, xItemSize1, xMaxSize, xTicksToWait);
+    }
+
     BaseType_t xReturn = pdFALSE;
     BaseType_t xReturnSemaphore = pdFALSE;
     TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
@@ -831,6 +1256,11 @@ static BaseType_t prvReceiveGenericFromISR(Ringbuffer_t *pxRingbuffer,
                                            size_t *xItemSize2,
                                            size_t xMaxSize)
 {
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        *pvItem1 = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, xMaxSize, xItemSize1);
+        return (*pvItem1 != NULL) ? pdTRUE : pdFALSE;
+    }
+
     BaseType_t xReturn = pdFALSE;
     BaseType_t xReturnSemaphore = pdFALSE;
 
@@ -875,7 +1305,7 @@ RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferTy
     configASSERT(xBufferType < RINGBUF_TYPE_MAX);
 
     //Allocate memory
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+    if (xBufferType != RINGBUF_TYPE_BYTEBUF && xBufferType != RINGBUF_TYPE_BYTEBUF_SPSC) {
         xBufferSize = rbALIGN_SIZE(xBufferSize);    //xBufferSize is rounded up for no-split/allow-split buffers
     }
     Ringbuffer_t *pxNewRingbuffer = calloc(1, sizeof(Ringbuffer_t));
@@ -928,7 +1358,7 @@ RingbufHandle_t xRingbufferCreateStatic(size_t xBufferSize,
     configASSERT(xBufferSize > 0);
     configASSERT(xBufferType < RINGBUF_TYPE_MAX);
     configASSERT(pucRingbufferStorage != NULL && pxStaticRingbuffer != NULL);
-    if (xBufferType != RINGBUF_TYPE_BYTEBUF) {
+    if (xBufferType != RINGBUF_TYPE_BYTEBUF && xBufferType != RINGBUF_TYPE_BYTEBUF_SPSC) {
         //No-split/allow-split buffer sizes must be 32-bit aligned
         configASSERT(rbCHECK_ALIGNED(xBufferSize));
     }
@@ -949,7 +1379,7 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
     configASSERT(pxRingbuffer);
     configASSERT(ppvItem != NULL || xItemSize == 0);
     //currently only supported in NoSplit buffers
-    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG | rbSPSC_FLAG)) == 0);
 
     *ppvItem = NULL;
     if (xItemSize > pxRingbuffer->xMaxItemSize) {
@@ -1007,7 +1437,7 @@ BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
-    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG | rbSPSC_FLAG)) == 0);
 
     portENTER_CRITICAL(&pxRingbuffer->mux);
     prvSendItemDoneNoSplit(pxRingbuffer, pvItem);
@@ -1032,6 +1462,9 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer,
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return prvSpscSend(pxRingbuffer, pvItem, xItemSize, xTicksToWait);
+    }
 
     //Attempt to send an item
     BaseType_t xReturn = pdFALSE;
@@ -1093,6 +1526,14 @@ BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
     if ((pxRingbuffer->uxRingbufferFlags & rbBYTE_BUFFER_FLAG) && xItemSize == 0) {
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdFALSE) {
+            return pdFALSE;
+        }
+        pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, xItemSize);
+        prvSpscWakeWaiter(&pxRingbuffer->xSpscRxWaiting, rbGET_RX_SEM_HANDLE(pxRingbuffer), pdTRUE, pxHigherPriorityTaskWoken);
+        return pdTRUE;
+    }
 
     //Attempt to send an item
     BaseType_t xReturn;
@@ -1285,12 +1726,82 @@ void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemS
     }
 }
 
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer,
+                                       RingbufferItem_t *pxItems,
+                                       UBaseType_t uxMaxItems,
+                                       TickType_t xTicksToWait)
+{
+    //Check arguments
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);    //This function should only be called for no-split buffers
+    configASSERT(pxItems != NULL || uxMaxItems == 0);
+    if (uxMaxItems == 0) {
+        return 0;
+    }
+
+    UBaseType_t uxCount = 0;
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        //Block for the first item only, then take whatever else is already available
+        if (prvSpscReceive(pxRingbuffer, &pxItems[0].pvItem, &pxItems[0].xItemSize, 0, xTicksToWait) == pdTRUE) {
+            for (uxCount = 1; uxCount < uxMaxItems; uxCount++) {
+                pxItems[uxCount].pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, NULL, 0, &pxItems[uxCount].xItemSize);
+                if (pxItems[uxCount].pvItem == NULL) {
+                    break;
+                }
+            }
+        }
+        return uxCount;
+    }
+
+    BaseType_t xReturnSemaphore = pdFALSE;
+    TickType_t xTicksEnd = xTaskGetTickCount() + xTicksToWait;
+    TickType_t xTicksRemaining = xTicksToWait;
+    while (xTicksRemaining <= xTicksToWait) {   //xTicksToWait will underflow once xTaskGetTickCount() > ticks_end
+        //Block until an item becomes available or timeout
+        if (xSemaphoreTake(rbGET_RX_SEM_HANDLE(pxRingbuffer), xTicksRemaining) != pdTRUE) {
+            break;
+        }
+
+        //Semaphore obtained, retrieve as many items as available in a single critical section
+        portENTER_CRITICAL(&pxRingbuffer->mux);
+        while (uxCount < uxMaxItems && prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+            BaseType_t xIsSplit;
+            //Third argument (xMaxSize) is unused for no-split buffers
+            pxItems[uxCount].pvItem = pxRingbuffer->pvGetItem(pxRingbuffer, &xIsSplit, 0, &pxItems[uxCount].xItemSize);
+            uxCount++;
+        }
+        if (uxCount > 0) {
+            if (pxRingbuffer->xItemsWaiting > 0) {
+                xReturnSemaphore = pdTRUE;
+            }
+            portEXIT_CRITICAL(&pxRingbuffer->mux);
+            break;
+        }
+        //No item available for retrieval, adjust ticks and take the semaphore again
+        if (xTicksToWait != portMAX_DELAY) {
+            xTicksRemaining = xTicksEnd - xTaskGetTickCount();
+        }
+        portEXIT_CRITICAL(&pxRingbuffer->mux);
+    }
+
+    if (xReturnSemaphore == pdTRUE) {
+        xSemaphoreGive(rbGET_RX_SEM_HANDLE(pxRingbuffer));  //Give semaphore back so other tasks can retrieve
+    }
+    return uxCount;
+}
+
 void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+        prvSpscWakeWaiter(&pxRingbuffer->xSpscTxWaiting, rbGET_TX_SEM_HANDLE(pxRingbuffer), pdFALSE, NULL);
+        return;
+    }
     portENTER_CRITICAL(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL(&pxRingbuffer->mux);
@@ -1303,12 +1814,43 @@ void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, Bas
     configASSERT(pxRingbuffer);
     configASSERT(pvItem != NULL);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
+        prvSpscWakeWaiter(&pxRingbuffer->xSpscTxWaiting, rbGET_TX_SEM_HANDLE(pxRingbuffer), pdTRUE, pxHigherPriorityTaskWoken);
+        return;
+    }
     portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
     pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pvItem);
     portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
     xSemaphoreGiveFromISR(rbGET_TX_SEM_HANDLE(pxRingbuffer), pxHigherPriorityTaskWoken);
 }
 
+void vRingbufferReturnMultiple(RingbufHandle_t xRingbuffer, const RingbufferItem_t *pxItems, UBaseType_t uxItems)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL || uxItems == 0);
+    if (uxItems == 0) {
+        return;
+    }
+
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        for (UBaseType_t i = 0; i < uxItems; i++) {
+            configASSERT(pxItems[i].pvItem != NULL);
+            pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pxItems[i].pvItem);
+        }
+        prvSpscWakeWaiter(&pxRingbuffer->xSpscTxWaiting, rbGET_TX_SEM_HANDLE(pxRingbuffer), pdFALSE, NULL);
+        return;
+    }
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItems; i++) {
+        configASSERT(pxItems[i].pvItem != NULL);
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pxItems[i].pvItem);
+    }
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+    xSemaphoreGive(rbGET_TX_SEM_HANDLE(pxRingbuffer));
+}
+
 void vRingbufferDelete(RingbufHandle_t xRingbuffer)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
@@ -1350,6 +1892,9 @@ BaseType_t xRingbufferAddToQueueSetRead(RingbufHandle_t xRingbuffer, QueueSetHan
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        return pdFALSE;     //SPSC ring buffers only give RecvSem to a consumer that is blocked
+    }
 
     BaseType_t xReturn;
     portENTER_CRITICAL(&pxRingbuffer->mux);
@@ -1402,6 +1947,10 @@ void vRingbufferGetInfo(RingbufHandle_t xRingbuffer,
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
 
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        prvSpscGetInfo(pxRingbuffer, uxFree, uxRead, uxWrite, uxAcquire, uxItemsWaiting);
+        return;
+    }
     portENTER_CRITICAL(&pxRingbuffer->mux);
     if (uxFree != NULL) {
         *uxFree = (UBaseType_t)(pxRingbuffer->pucFree - pxRingbuffer->pucHead);
@@ -1425,6 +1974,14 @@ void xRingbufferPrintInfo(RingbufHandle_t xRingbuffer)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
     configASSERT(pxRingbuffer);
+    if (pxRingbuffer->uxRingbufferFlags & rbSPSC_FLAG) {
+        UBaseType_t uxFree, uxRead, uxWrite;
+        prvSpscGetInfo(pxRingbuffer, &uxFree, &uxRead, &uxWrite, NULL, NULL);
+        printf("Rb size:%d\tfree: %d\trptr: %d\tfreeptr: %d\twptr: %d (SPSC)\n",
+               pxRingbuffer->xSize, pxRingbuffer->xSize - prvSpscUsed(pxRingbuffer, pxRingbuffer->xSpscFree, pxRingbuffer->xSpscWrite),
+               uxRead, uxFree, uxWrite);
+        return;
+    }
     printf("Rb size:%d\tfree: %d\trptr: %d\tfreeptr: %d\twptr: %d, aptr: %d\n",
            pxRingbuffer->xSize, prvGetFreeSize(pxRingbuffer),
            pxRingbuffer->pucRead - pxRingbuffer->pucHead,
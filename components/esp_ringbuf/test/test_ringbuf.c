@@ -18,6 +18,7 @@
 #include "unity.h"
 #include "test_utils.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
 
 //Definitions used in multiple test cases
 #define TIMEOUT_TICKS               10
@@ -857,7 +858,7 @@ static void read_from_buffer(RingbufHandle_t buffer, RingbufferType_t buf_type,
             char *item_data, *item_data2;
 
             //Select appropriate receive function for type of ring buffer
-            if (buf_type ==  RINGBUF_TYPE_NOSPLIT) {
+            if (buf_type ==  RINGBUF_TYPE_NOSPLIT || buf_type == RINGBUF_TYPE_NOSPLIT_SPSC) {
                 item_data = (char *)xRingbufferReceive(buffer, &item_size, TIMEOUT_TICKS);
             } else if (buf_type == RINGBUF_TYPE_ALLOWSPLIT) {
                 BaseType_t ret = xRingbufferReceiveSplit(buffer, (void **)&item_data, (void **)&item_data2, &item_size, &item_size2, TIMEOUT_TICKS);
@@ -868,7 +869,7 @@ static void read_from_buffer(RingbufHandle_t buffer, RingbufferType_t buf_type,
 
             //Check received item and return it
             TEST_ASSERT_MESSAGE(item_data != NULL, "Failed to receive an item");
-            if (buf_type == RINGBUF_TYPE_BYTEBUF) {
+            if (buf_type == RINGBUF_TYPE_BYTEBUF || buf_type == RINGBUF_TYPE_BYTEBUF_SPSC) {
                 TEST_ASSERT_MESSAGE(item_size <= max_rec_size, "Received data exceeds max size");
             }
             for (int i = 0; i < item_size; i++) {
@@ -942,7 +943,7 @@ static void cleanup(void)
 TEST_CASE("Test ring buffer SMP", "[esp_ringbuf]")
 {
     setup();
-    //Iterate through buffer types (No split, split, then byte buff)
+    //Iterate through buffer types (No split, split, byte buff, then their SPSC variants)
     for (RingbufferType_t buf_type = 0; buf_type < RINGBUF_TYPE_MAX; buf_type++) {
         //Create buffer
         task_args_t task_args;
@@ -974,7 +975,7 @@ TEST_CASE("Test ring buffer SMP", "[esp_ringbuf]")
 TEST_CASE("Test static ring buffer SMP", "[esp_ringbuf]")
 {
     setup();
-    //Iterate through buffer types (No split, split, then byte buff)
+    //Iterate through buffer types (No split, split, byte buff, then their SPSC variants)
     for (RingbufferType_t buf_type = 0; buf_type < RINGBUF_TYPE_MAX; buf_type++) {
         StaticRingbuffer_t *buffer_struct;
         uint8_t *buffer_storage;
@@ -1019,6 +1020,217 @@ TEST_CASE("Test static ring buffer SMP", "[esp_ringbuf]")
 }
 #endif
 
+/* ----------------------- Test SPSC ring buffer ---------------------------- */
+
+TEST_CASE("Test SPSC ring buffers", "[esp_ringbuf]")
+{
+    size_t item_size;
+    uint8_t *item;
+
+    //Byte buffer: data is merged, and can be received up to a maximum size
+    RingbufHandle_t buffer = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF_SPSC);
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, xRingbufferGetCurFreeSize(buffer));
+    for (int i = 0; i < BUFFER_SIZE / SMALL_ITEM_SIZE; i++) {
+        send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+    }
+    TEST_ASSERT_EQUAL(0, xRingbufferGetCurFreeSize(buffer));
+    send_item_and_check_failure(buffer, small_item, SMALL_ITEM_SIZE, TIMEOUT_TICKS, false);
+    send_item_and_check_failure(buffer, small_item, SMALL_ITEM_SIZE, 0, true);
+    item = (uint8_t *)xRingbufferReceiveUpTo(buffer, &item_size, 0, SMALL_ITEM_SIZE + 2);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE + 2, item_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(small_item, item, SMALL_ITEM_SIZE);
+    TEST_ASSERT_NULL(xRingbufferReceive(buffer, &item_size, 0));   //Byte buffers do not allow multiple retrievals before returning
+    vRingbufferReturnItem(buffer, item);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE + 2, xRingbufferGetCurFreeSize(buffer));
+    //Data sent now wraps around, and is received in two parts
+    send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, 0, true);
+    item = (uint8_t *)xRingbufferReceive(buffer, &item_size, 0);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE - SMALL_ITEM_SIZE - 2, item_size);
+    vRingbufferReturnItem(buffer, item);
+    item = (uint8_t *)xRingbufferReceiveFromISR(buffer, &item_size);
+    TEST_ASSERT_EQUAL(SMALL_ITEM_SIZE, item_size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(small_item, item, SMALL_ITEM_SIZE);
+    vRingbufferReturnItemFromISR(buffer, item, NULL);
+    TEST_ASSERT_NULL(xRingbufferReceive(buffer, &item_size, TIMEOUT_TICKS));
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, xRingbufferGetCurFreeSize(buffer));
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferAddToQueueSetRead(buffer, NULL));
+    vRingbufferDelete(buffer);
+
+    //No-split buffer: several items can be retrieved, and are returned in order
+    buffer = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT_SPSC);
+    TEST_ASSERT_NOT_NULL(buffer);
+    TEST_ASSERT_EQUAL(BUFFER_SIZE / 2 - ITEM_HDR_SIZE, xRingbufferGetMaxItemSize(buffer));
+    int no_of_items = 0;
+    while (xRingbufferSend(buffer, large_item, LARGE_ITEM_SIZE, 0) == pdTRUE) {
+        no_of_items++;
+    }
+    TEST_ASSERT_EQUAL(BUFFER_SIZE / (LARGE_ITEM_SIZE + ITEM_HDR_SIZE), no_of_items);
+    UBaseType_t items_waiting;
+    vRingbufferGetInfo(buffer, NULL, NULL, NULL, NULL, &items_waiting);
+    TEST_ASSERT_EQUAL(no_of_items, items_waiting);
+    uint8_t *first = (uint8_t *)xRingbufferReceive(buffer, &item_size, 0);
+    uint8_t *second = (uint8_t *)xRingbufferReceive(buffer, &item_size, 0);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(large_item, second, LARGE_ITEM_SIZE);
+    vRingbufferReturnItem(buffer, first);
+    vRingbufferReturnItem(buffer, second);
+    //Small item fills the end of the buffer, large item wraps around to the freed space at the start
+    send_item_and_check(buffer, small_item, SMALL_ITEM_SIZE, 0, false);
+    send_item_and_check(buffer, large_item, LARGE_ITEM_SIZE, 0, true);
+    for (int i = 0; i < no_of_items - 2; i++) {
+        receive_check_and_return_item_no_split(buffer, large_item, LARGE_ITEM_SIZE, 0, false);
+    }
+    receive_check_and_return_item_no_split(buffer, small_item, SMALL_ITEM_SIZE, 0, true);
+    receive_check_and_return_item_no_split(buffer, large_item, LARGE_ITEM_SIZE, 0, false);
+    vRingbufferGetInfo(buffer, NULL, NULL, NULL, NULL, &items_waiting);
+    TEST_ASSERT_EQUAL(0, items_waiting);
+    vRingbufferDelete(buffer);
+}
+
+/* -------------------- Test ring buffer receive multiple ------------------- */
+
+#define MULTIPLE_BATCH_LEN              32
+#define MULTIPLE_ITERATIONS             200
+
+static void fill_no_split_buffer(RingbufHandle_t buffer, int no_of_items)
+{
+    for (int i = 0; i < no_of_items; i++) {
+        uint32_t value = i;
+        send_item_and_check(buffer, (uint8_t *)&value, sizeof(value), 0, false);
+    }
+}
+
+TEST_CASE("Test ring buffer receive multiple", "[esp_ringbuf]")
+{
+    RingbufferItem_t items[MULTIPLE_BATCH_LEN];
+    const RingbufferType_t types[] = {RINGBUF_TYPE_NOSPLIT, RINGBUF_TYPE_NOSPLIT_SPSC};
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        RingbufHandle_t buffer = xRingbufferCreate((sizeof(uint32_t) + ITEM_HDR_SIZE) * MULTIPLE_BATCH_LEN * 2, types[t]);
+        TEST_ASSERT_NOT_NULL(buffer);
+
+        //Times out when empty, and retrieves items in FIFO order up to the maximum
+        TEST_ASSERT_EQUAL(0, xRingbufferReceiveMultiple(buffer, items, MULTIPLE_BATCH_LEN, TIMEOUT_TICKS));
+        fill_no_split_buffer(buffer, MULTIPLE_BATCH_LEN + 4);
+        TEST_ASSERT_EQUAL(MULTIPLE_BATCH_LEN, xRingbufferReceiveMultiple(buffer, items, MULTIPLE_BATCH_LEN, 0));
+        for (int i = 0; i < MULTIPLE_BATCH_LEN; i++) {
+            TEST_ASSERT_EQUAL(sizeof(uint32_t), items[i].xItemSize);
+            TEST_ASSERT_EQUAL(i, *(uint32_t *)items[i].pvItem);
+        }
+        vRingbufferReturnMultiple(buffer, items, MULTIPLE_BATCH_LEN);
+        TEST_ASSERT_EQUAL(4, xRingbufferReceiveMultiple(buffer, items, MULTIPLE_BATCH_LEN, 0));
+        TEST_ASSERT_EQUAL(MULTIPLE_BATCH_LEN + 3, *(uint32_t *)items[3].pvItem);
+        vRingbufferReturnMultiple(buffer, items, 4);
+        TEST_ASSERT_EQUAL(xRingbufferGetMaxItemSize(buffer), xRingbufferGetCurFreeSize(buffer));
+
+        //Compare draining the buffer one item at a time and in batches
+        int64_t single_us = 0, multiple_us = 0;
+        for (int iter = 0; iter < MULTIPLE_ITERATIONS; iter++) {
+            fill_no_split_buffer(buffer, MULTIPLE_BATCH_LEN);
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < MULTIPLE_BATCH_LEN; i++) {
+                size_t item_size;
+                void *item = xRingbufferReceive(buffer, &item_size, 0);
+                vRingbufferReturnItem(buffer, item);
+            }
+            single_us += esp_timer_get_time() - start;
+
+            fill_no_split_buffer(buffer, MULTIPLE_BATCH_LEN);
+            start = esp_timer_get_time();
+            UBaseType_t count = xRingbufferReceiveMultiple(buffer, items, MULTIPLE_BATCH_LEN, 0);
+            vRingbufferReturnMultiple(buffer, items, count);
+            multiple_us += esp_timer_get_time() - start;
+            TEST_ASSERT_EQUAL(MULTIPLE_BATCH_LEN, count);
+        }
+        IDF_LOG_PERFORMANCE("RINGBUF_RECEIVE_SINGLE", "%d ns per item, type: %d", (int)(single_us * 1000 / (MULTIPLE_ITERATIONS * MULTIPLE_BATCH_LEN)), types[t]);
+        IDF_LOG_PERFORMANCE("RINGBUF_RECEIVE_MULTIPLE", "%d ns per item, type: %d", (int)(multiple_us * 1000 / (MULTIPLE_ITERATIONS * MULTIPLE_BATCH_LEN)), types[t]);
+        vRingbufferDelete(buffer);
+    }
+}
+
+/*
+ * The following test measures the throughput of a stream of data sent from
+ * one task to another through a ring buffer, comparing each SPSC ring buffer
+ * type with its locking counterpart. Every permutation of core pinning of the
+ * sending and receiving task is measured.
+ */
+
+#define THROUGHPUT_BUFF_LEN             1024
+#define THROUGHPUT_ITEM_LEN             64
+#define THROUGHPUT_TOTAL_LEN            (256 * 1024)
+
+static SemaphoreHandle_t throughput_done;
+
+static void throughput_send_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    uint8_t item[THROUGHPUT_ITEM_LEN];
+    for (int i = 0; i < THROUGHPUT_ITEM_LEN; i++) {
+        item[i] = i;
+    }
+    for (int sent = 0; sent < THROUGHPUT_TOTAL_LEN; sent += THROUGHPUT_ITEM_LEN) {
+        TEST_ASSERT_MESSAGE(xRingbufferSend(buffer, item, THROUGHPUT_ITEM_LEN, portMAX_DELAY) == pdTRUE, "Failed to send an item");
+    }
+    xSemaphoreGive(throughput_done);
+    vTaskDelete(NULL);
+}
+
+static void throughput_rec_task(void *args)
+{
+    RingbufHandle_t buffer = (RingbufHandle_t)args;
+    int received = 0;
+    while (received < THROUGHPUT_TOTAL_LEN) {
+        size_t item_size;
+        uint8_t *item = (uint8_t *)xRingbufferReceive(buffer, &item_size, portMAX_DELAY);
+        TEST_ASSERT_MESSAGE(item != NULL, "Failed to receive an item");
+        for (int i = 0; i < item_size; i++) {
+            TEST_ASSERT_MESSAGE(item[i] == (received + i) % THROUGHPUT_ITEM_LEN, "Received data is corrupted");
+        }
+        received += item_size;
+        vRingbufferReturnItem(buffer, item);
+    }
+    xSemaphoreGive(throughput_done);
+    vTaskDelete(NULL);
+}
+
+static uint32_t measure_throughput(RingbufferType_t buf_type, int send_core, int rec_core)
+{
+    RingbufHandle_t buffer = xRingbufferCreate(THROUGHPUT_BUFF_LEN, buf_type);
+    TEST_ASSERT_MESSAGE(buffer != NULL, "Failed to create ring buffer");
+
+    int64_t start = esp_timer_get_time();
+    xTaskCreatePinnedToCore(throughput_rec_task, "rec tsk", 2048, buffer, 10, NULL, rec_core);
+    xTaskCreatePinnedToCore(throughput_send_task, "send tsk", 2048, buffer, 10, NULL, send_core);
+    xSemaphoreTake(throughput_done, portMAX_DELAY);
+    xSemaphoreTake(throughput_done, portMAX_DELAY);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    vRingbufferDelete(buffer);
+    vTaskDelay(5);  //Allow idle to clean up
+    return (uint32_t)(THROUGHPUT_TOTAL_LEN * 1000000LL / 1024 / elapsed);
+}
+
+TEST_CASE("Test SPSC ring buffer throughput", "[esp_ringbuf]")
+{
+    throughput_done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT_NOT_NULL(throughput_done);
+    for (int send_core = 0; send_core < portNUM_PROCESSORS; send_core++) {
+        for (int rec_core = 0; rec_core < portNUM_PROCESSORS; rec_core++) {
+            uint32_t byte_buf = measure_throughput(RINGBUF_TYPE_BYTEBUF, send_core, rec_core);
+            uint32_t byte_buf_spsc = measure_throughput(RINGBUF_TYPE_BYTEBUF_SPSC, send_core, rec_core);
+            uint32_t no_split = measure_throughput(RINGBUF_TYPE_NOSPLIT, send_core, rec_core);
+            uint32_t no_split_spsc = measure_throughput(RINGBUF_TYPE_NOSPLIT_SPSC, send_core, rec_core);
+            IDF_LOG_PERFORMANCE("RINGBUF_BYTEBUF", "%u KB/s, SC: %d, RC: %d", byte_buf, send_core, rec_core);
+            IDF_LOG_PERFORMANCE("RINGBUF_BYTEBUF_SPSC", "%u KB/s, SC: %d, RC: %d", byte_buf_spsc, send_core, rec_core);
+            IDF_LOG_PERFORMANCE("RINGBUF_NOSPLIT", "%u KB/s, SC: %d, RC: %d", no_split, send_core, rec_core);
+            IDF_LOG_PERFORMANCE("RINGBUF_NOSPLIT_SPSC", "%u KB/s, SC: %d, RC: %d", no_split_spsc, send_core, rec_core);
+        }
+    }
+    vSemaphoreDelete(throughput_done);
+}
+
 /* -------------------------- Test ring buffer IRAM ------------------------- */
 
 static IRAM_ATTR __attribute__((noinline)) bool iram_ringbuf_test(void)
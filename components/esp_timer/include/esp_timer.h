@@ -27,7 +27,10 @@
  * used for simple callback functions, which do not take longer than a few
  * microseconds to run.
  *
- * Timer callbacks are called from a task running on the PRO CPU.
+ * Timer callbacks are called from a task running on the PRO CPU, unless
+ * CONFIG_ESP_TIMER_TASK_PER_CORE is enabled. In that case, each core has its
+ * own task and the callbacks of each timer are called from the task of the core
+ * selected when the timer was created.
  */
 
 #include <stdint.h>
@@ -63,6 +66,11 @@ typedef enum {
     ESP_TIMER_MAX,      //!< Count of the methods for dispatching timer callback
 } esp_timer_dispatch_t;
 
+/**
+ * @brief Value of esp_timer_create_args_t::task_core_id to let esp_timer select the core of the timer
+ */
+#define ESP_TIMER_ANY_CORE (-1)
+
 /**
  * @brief Timer configuration passed to esp_timer_create
  */
@@ -72,6 +80,11 @@ typedef struct {
     esp_timer_dispatch_t dispatch_method;   //!< Call the callback from task or from ISR
     const char* name;               //!< Timer name, used in esp_timer_dump function
     bool skip_unhandled_events;     //!< Skip unhandled events for periodic timers
+    uint32_t slack_us;              //!< Time by which the callback may be delayed, in microseconds,
+                                    //!< so that it is dispatched together with the callbacks of other timers
+    int task_core_id;               //!< Core of the task calling the callback of an ESP_TIMER_TASK timer, if
+                                    //!< CONFIG_ESP_TIMER_TASK_PER_CORE is enabled. With ESP_TIMER_ANY_CORE,
+                                    //!< the timers are assigned to the cores in turn.
 } esp_timer_create_args_t;
 
 
@@ -183,6 +196,9 @@ esp_err_t esp_timer_stop(esp_timer_handle_t timer);
  * The timer must be stopped before deleting. A one-shot timer which has expired
  * does not need to be stopped.
  *
+ * With CONFIG_ESP_TIMER_TASK_PER_CORE, the callback of a one-shot timer which has
+ * expired is not called if it is still waiting for the task of its core.
+ *
  * @param timer timer handle allocated using esp_timer_create
  * @return
  *      - ESP_OK on success
@@ -198,6 +214,9 @@ int64_t esp_timer_get_time(void);
 
 /**
  * @brief Get the timestamp when the next timeout is expected to occur
+ *
+ * For timers created with a slack, this is the latest time at which their callbacks are dispatched.
+ *
  * @return Timestamp of the nearest timer event, in microseconds.
  *         The timebase is the same as for the values returned by esp_timer_get_time.
  */
@@ -205,6 +224,9 @@ int64_t esp_timer_get_next_alarm(void);
 
 /**
  * @brief Get the timestamp when the next timeout is expected to occur skipping those which have skip_unhandled_events flag
+ *
+ * For timers created with a slack, this is the latest time at which their callbacks are dispatched.
+ *
  * @return Timestamp of the nearest timer event, in microseconds.
  *         The timebase is the same as for the values returned by esp_timer_get_time.
  */
@@ -251,7 +273,8 @@ esp_err_t esp_timer_get_expiry_time(esp_timer_handle_t timer, uint64_t *expiry);
  *
  * The format is:
  *
- *   name  period  alarm  times_armed  times_triggered  total_callback_run_time
+ *   name  period  alarm  times_armed  times_triggered  times_skipped  total_callback_run_time
+ *   max_callback_run_time  total_latency  max_latency
  *
  * where:
  *
@@ -264,7 +287,18 @@ esp_err_t esp_timer_get_expiry_time(esp_timer_handle_t timer, uint64_t *expiry);
  *
  * times_armed — number of times the timer was armed via esp_timer_start_X
  * times_triggered - number of times the callback was called
+ * times_skipped - number of callbacks skipped by a periodic timer with skip_unhandled_events flag
  * total_callback_run_time - total time taken by callback to execute, across all calls
+ * max_callback_run_time - longest time taken by callback to execute
+ * total_latency - total time between the alarms and the calls of the callback, across all calls
+ * max_latency - longest time between an alarm and the call of the callback
+ *
+ * The list of timers is followed by the number of times callbacks were dispatched
+ * for each dispatch method, the number of callbacks called, and the number of
+ * callbacks which were called together with an earlier callback instead of
+ * requiring a wakeup of their own:
+ *
+ *   dispatch_method  wakeups  callbacks  coalesced
  *
  * @param stream stream (such as stdout) to dump the information to
  * @return
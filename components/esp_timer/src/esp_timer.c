@@ -6,6 +6,7 @@
 
 #include <sys/param.h>
 #include <string.h>
+#include <inttypes.h>
 #include "soc/soc.h"
 #include "esp_types.h"
 #include "esp_attr.h"
@@ -57,6 +58,14 @@ typedef enum {
     FL_SKIP_UNHANDLED_EVENTS = (1 << 1),  //!< 0=NOT skip unhandled events for periodic timers, 1=Skip unhandled events for periodic timers
 } flags_t;
 
+#define FL_TASK_CORE_SHIFT  2   //!< the remaining flags are the core of the task calling the callback
+
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+#define TIMER_TASK_COUNT    portNUM_PROCESSORS
+#else
+#define TIMER_TASK_COUNT    1
+#endif
+
 struct esp_timer {
     uint64_t alarm;
     uint64_t period:56;
@@ -66,34 +75,67 @@ struct esp_timer {
         uint32_t event_id;
     };
     void* arg;
+    size_t heap_index;
+    uint32_t slack;
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    uint32_t dispatch_pending;
+    TAILQ_ENTRY(esp_timer) dispatch_entry;
+#endif
 #if WITH_PROFILING
     const char* name;
     size_t times_triggered;
     size_t times_armed;
     size_t times_skipped;
     uint64_t total_callback_run_time;
-#endif // WITH_PROFILING
+    uint64_t max_callback_run_time;
+    uint64_t total_latency;
+    uint64_t max_latency;
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    uint64_t dispatch_alarm;
+#endif
     LIST_ENTRY(esp_timer) list_entry;
+#endif // WITH_PROFILING
 };
 
+// binary min-heap of armed timers, ordered by alarm
+typedef struct {
+    esp_timer_handle_t* timers;
+    size_t count;
+    size_t capacity;
+} timer_heap_t;
+
 static inline bool is_initialized(void);
 static esp_err_t timer_insert(esp_timer_handle_t timer, bool without_update_alarm);
+static esp_err_t timer_heaps_reserve(size_t timer_count);
 static esp_err_t timer_remove(esp_timer_handle_t timer);
 static bool timer_armed(esp_timer_handle_t timer);
+static uint64_t timer_deadline(esp_timer_handle_t timer);
 static void timer_list_lock(esp_timer_dispatch_t timer_type);
 static void timer_list_unlock(esp_timer_dispatch_t timer_type);
+static void timer_heap_push(timer_heap_t* heap, esp_timer_handle_t timer);
+static void timer_heap_remove(timer_heap_t* heap, esp_timer_handle_t timer);
+static esp_timer_handle_t timer_heap_first(const timer_heap_t* heap);
+static void timer_update_alarm(esp_timer_dispatch_t dispatch_method);
+
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+static bool timer_dispatch_enqueue(esp_timer_handle_t timer, uint64_t alarm);
+static void timer_dispatch_cancel(esp_timer_handle_t timer);
+#endif
 
 #if WITH_PROFILING
 static void timer_insert_inactive(esp_timer_handle_t timer);
 static void timer_remove_inactive(esp_timer_handle_t timer);
+static void timer_update_stats(esp_timer_handle_t timer, uint64_t alarm, int64_t callback_start);
 #endif // WITH_PROFILING
 
 __attribute__((unused)) static const char* TAG = "esp_timer";
 
-// lists of currently armed timers for two dispatch methods: ISR and TASK
-static LIST_HEAD(esp_timer_list, esp_timer) s_timers[ESP_TIMER_MAX] = {
-    [0 ... (ESP_TIMER_MAX - 1)] = LIST_HEAD_INITIALIZER(s_timers)
-};
+// heaps of currently armed timers for two dispatch methods: ISR and TASK.
+// Their capacity is reserved for all the existing timers when a timer is created,
+// so that timers can be armed from a critical section or an ISR without allocating.
+static timer_heap_t s_timers[ESP_TIMER_MAX];
+// number of existing timers, including deleted timers not yet freed by the timer task
+static size_t s_timer_count;
 #if WITH_PROFILING
 // lists of unarmed timers for two dispatch methods: ISR and TASK,
 // used only to be able to dump statistics about all the timers
@@ -101,10 +143,26 @@ static LIST_HEAD(esp_inactive_timer_list, esp_timer) s_inactive_timers[ESP_TIMER
     [0 ... (ESP_TIMER_MAX - 1)] = LIST_HEAD_INITIALIZER(s_timers)
 };
 #endif
-// task used to dispatch timer callbacks
-static TaskHandle_t s_timer_task;
+// alarms set for the two dispatch methods: the earliest time by which a timer must be dispatched,
+// which is its alarm plus its slack. All timers with an alarm before it are dispatched together.
+static uint64_t s_next_alarm[ESP_TIMER_MAX] = {
+    [0 ... (ESP_TIMER_MAX - 1)] = UINT64_MAX
+};
+// number of times the timers of each dispatch method were processed and callbacks were called
+static uint32_t s_wakeups[ESP_TIMER_MAX];
+// number of callbacks called for each dispatch method
+static uint32_t s_callbacks[ESP_TIMER_MAX];
+// tasks used to dispatch timer callbacks, one for each core with CONFIG_ESP_TIMER_TASK_PER_CORE
+static TaskHandle_t s_timer_tasks[TIMER_TASK_COUNT];
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+// expired ESP_TIMER_TASK timers of each core, in alarm order, waiting for the task of the core to call their callbacks
+static TAILQ_HEAD(esp_timer_dispatch_queue, esp_timer) s_dispatch_queues[portNUM_PROCESSORS];
+// core assigned to the next timer created with ESP_TIMER_ANY_CORE
+static unsigned s_next_task_core;
+#endif
 
-// lock protecting s_timers, s_inactive_timers
+// lock protecting s_timers, s_inactive_timers, s_next_alarm and the statistics,
+// and s_timer_count, s_dispatch_queues and s_next_task_core for ESP_TIMER_TASK
 static portMUX_TYPE s_timer_lock[ESP_TIMER_MAX] = {
     [0 ... (ESP_TIMER_MAX - 1)] = portMUX_INITIALIZER_UNLOCKED
 };
@@ -121,17 +179,41 @@ esp_err_t esp_timer_create(const esp_timer_create_args_t* args,
         return ESP_ERR_INVALID_STATE;
     }
     if (args == NULL || args->callback == NULL || out_handle == NULL ||
-        args->dispatch_method < 0 || args->dispatch_method >= ESP_TIMER_MAX) {
+        args->dispatch_method < 0 || args->dispatch_method >= ESP_TIMER_MAX ||
+        (args->task_core_id != ESP_TIMER_ANY_CORE && (args->task_core_id < 0 || args->task_core_id >= portNUM_PROCESSORS))) {
         return ESP_ERR_INVALID_ARG;
     }
     esp_timer_handle_t result = (esp_timer_handle_t) heap_caps_calloc(1, sizeof(*result), MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
     if (result == NULL) {
         return ESP_ERR_NO_MEM;
     }
+    unsigned task_core = 0;
+    timer_list_lock(ESP_TIMER_TASK);
+    size_t timer_count = ++s_timer_count;
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    if (args->dispatch_method == ESP_TIMER_TASK) {
+        if (args->task_core_id == ESP_TIMER_ANY_CORE) {
+            task_core = s_next_task_core;
+            s_next_task_core = (s_next_task_core + 1) % portNUM_PROCESSORS;
+        } else {
+            task_core = args->task_core_id;
+        }
+    }
+#endif
+    timer_list_unlock(ESP_TIMER_TASK);
+    if (timer_heaps_reserve(timer_count) != ESP_OK) {
+        timer_list_lock(ESP_TIMER_TASK);
+        --s_timer_count;
+        timer_list_unlock(ESP_TIMER_TASK);
+        free(result);
+        return ESP_ERR_NO_MEM;
+    }
     result->callback = args->callback;
     result->arg = args->arg;
+    result->slack = args->slack_us;
     result->flags = (args->dispatch_method ? FL_ISR_DISPATCH_METHOD : 0) |
-                    (args->skip_unhandled_events ? FL_SKIP_UNHANDLED_EVENTS : 0);
+                    (args->skip_unhandled_events ? FL_SKIP_UNHANDLED_EVENTS : 0) |
+                    (task_core << FL_TASK_CORE_SHIFT);
 #if WITH_PROFILING
     result->name = args->name;
     esp_timer_dispatch_t dispatch_method = result->flags & FL_ISR_DISPATCH_METHOD;
@@ -250,15 +332,21 @@ esp_err_t esp_timer_delete(esp_timer_handle_t timer)
         return ESP_ERR_INVALID_STATE;
     }
     // A case for the timer with ESP_TIMER_ISR:
-    // This ISR timer was removed from the ISR list in esp_timer_stop() or in timer_process_alarm() -> LIST_REMOVE(it, list_entry)
-    // and here this timer will be added to another the TASK list, see below.
+    // This ISR timer was removed from the ISR heap in esp_timer_stop() or in timer_process_alarm() -> timer_heap_remove()
+    // and here this timer will be added to another the TASK heap, see below.
     // We do this because we want to free memory of the timer in a task context instead of an isr context.
+    // With CONFIG_ESP_TIMER_TASK_PER_CORE, the memory is freed by the task of the core of the timer, after the callbacks
+    // it has already queued. The callbacks queued for this timer but not called yet are cancelled.
     int64_t alarm = esp_timer_get_time();
     timer_list_lock(ESP_TIMER_TASK);
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    timer_dispatch_cancel(timer);
+#endif
     timer->flags &= ~FL_ISR_DISPATCH_METHOD;
     timer->event_id = EVENT_ID_DELETE_TIMER;
     timer->alarm = alarm;
     timer->period = 0;
+    timer->slack = 0;
     timer_insert(timer, false);
     timer_list_unlock(ESP_TIMER_TASK);
     return ESP_OK;
@@ -269,25 +357,13 @@ static IRAM_ATTR esp_err_t timer_insert(esp_timer_handle_t timer, bool without_u
 #if WITH_PROFILING
     timer_remove_inactive(timer);
 #endif
-    esp_timer_handle_t it, last = NULL;
     esp_timer_dispatch_t dispatch_method = timer->flags & FL_ISR_DISPATCH_METHOD;
-    if (LIST_FIRST(&s_timers[dispatch_method]) == NULL) {
-        LIST_INSERT_HEAD(&s_timers[dispatch_method], timer, list_entry);
-    } else {
-        LIST_FOREACH(it, &s_timers[dispatch_method], list_entry) {
-            if (timer->alarm < it->alarm) {
-                LIST_INSERT_BEFORE(it, timer, list_entry);
-                break;
-            }
-            last = it;
-        }
-        if (it == NULL) {
-            assert(last);
-            LIST_INSERT_AFTER(last, timer, list_entry);
-        }
-    }
-    if (without_update_alarm == false && timer == LIST_FIRST(&s_timers[dispatch_method])) {
-        esp_timer_impl_set_alarm_id(timer->alarm, dispatch_method);
+    timer_heap_push(&s_timers[dispatch_method], timer);
+    /* The timer is dispatched with the timers due at the current alarm, unless it must be dispatched earlier */
+    uint64_t deadline = timer_deadline(timer);
+    if (without_update_alarm == false && deadline < s_next_alarm[dispatch_method]) {
+        s_next_alarm[dispatch_method] = deadline;
+        esp_timer_impl_set_alarm_id(deadline, dispatch_method);
     }
     return ESP_OK;
 }
@@ -296,18 +372,16 @@ static IRAM_ATTR esp_err_t timer_remove(esp_timer_handle_t timer)
 {
     esp_timer_dispatch_t dispatch_method = timer->flags & FL_ISR_DISPATCH_METHOD;
     timer_list_lock(dispatch_method);
-    esp_timer_handle_t first_timer = LIST_FIRST(&s_timers[dispatch_method]);
-    LIST_REMOVE(timer, list_entry);
+    uint64_t deadline = timer_deadline(timer);
+    timer_heap_remove(&s_timers[dispatch_method], timer);
     timer->alarm = 0;
     timer->period = 0;
-    if (timer == first_timer) { // if this timer was the first in the list.
-        uint64_t next_timestamp = UINT64_MAX;
-        first_timer = LIST_FIRST(&s_timers[dispatch_method]);
-        if (first_timer) { // if after removing the timer from the list, this list is not empty.
-            next_timestamp = first_timer->alarm;
-        }
-        esp_timer_impl_set_alarm_id(next_timestamp, dispatch_method);
+    if (deadline == s_next_alarm[dispatch_method]) { // if the alarm was set for this timer
+        timer_update_alarm(dispatch_method);
     }
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    timer_dispatch_cancel(timer);
+#endif
 #if WITH_PROFILING
     timer_insert_inactive(timer);
 #endif
@@ -315,6 +389,148 @@ static IRAM_ATTR esp_err_t timer_remove(esp_timer_handle_t timer)
     return ESP_OK;
 }
 
+static esp_err_t timer_heaps_reserve(size_t timer_count)
+{
+    for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
+        timer_heap_t* heap = &s_timers[dispatch_method];
+        timer_list_lock(dispatch_method);
+        size_t capacity = heap->capacity;
+        timer_list_unlock(dispatch_method);
+        if (capacity >= timer_count) {
+            continue;
+        }
+        /* Grow the heap outside of the critical section, then swap the arrays in it */
+        capacity = MAX(MAX(capacity * 2, timer_count), 8);
+        esp_timer_handle_t* timers = heap_caps_malloc(capacity * sizeof(esp_timer_handle_t), MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+        if (timers == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        timer_list_lock(dispatch_method);
+        if (heap->capacity < capacity) {
+            esp_timer_handle_t* old_timers = heap->timers;
+            if (heap->count > 0) {
+                memcpy(timers, old_timers, heap->count * sizeof(esp_timer_handle_t));
+            }
+            heap->timers = timers;
+            heap->capacity = capacity;
+            timers = old_timers;
+        }
+        timer_list_unlock(dispatch_method);
+        free(timers);
+    }
+    return ESP_OK;
+}
+
+static IRAM_ATTR void timer_heap_set(timer_heap_t* heap, size_t index, esp_timer_handle_t timer)
+{
+    heap->timers[index] = timer;
+    timer->heap_index = index;
+}
+
+static IRAM_ATTR void timer_heap_sift_up(timer_heap_t* heap, size_t index)
+{
+    esp_timer_handle_t timer = heap->timers[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap->timers[parent]->alarm <= timer->alarm) {
+            break;
+        }
+        timer_heap_set(heap, index, heap->timers[parent]);
+        index = parent;
+    }
+    timer_heap_set(heap, index, timer);
+}
+
+static IRAM_ATTR void timer_heap_sift_down(timer_heap_t* heap, size_t index)
+{
+    esp_timer_handle_t timer = heap->timers[index];
+    while (2 * index + 1 < heap->count) {
+        size_t child = 2 * index + 1;
+        if (child + 1 < heap->count && heap->timers[child + 1]->alarm < heap->timers[child]->alarm) {
+            ++child;
+        }
+        if (timer->alarm <= heap->timers[child]->alarm) {
+            break;
+        }
+        timer_heap_set(heap, index, heap->timers[child]);
+        index = child;
+    }
+    timer_heap_set(heap, index, timer);
+}
+
+static IRAM_ATTR void timer_heap_push(timer_heap_t* heap, esp_timer_handle_t timer)
+{
+    assert(heap->count < heap->capacity);
+    timer_heap_set(heap, heap->count++, timer);
+    timer_heap_sift_up(heap, timer->heap_index);
+}
+
+static IRAM_ATTR void timer_heap_remove(timer_heap_t* heap, esp_timer_handle_t timer)
+{
+    size_t index = timer->heap_index;
+    assert(index < heap->count && heap->timers[index] == timer);
+    esp_timer_handle_t last = heap->timers[--heap->count];
+    if (last != timer) {
+        /* Move the last timer into the hole, then restore the heap order from there */
+        timer_heap_set(heap, index, last);
+        if (index > 0 && heap->timers[(index - 1) / 2]->alarm > last->alarm) {
+            timer_heap_sift_up(heap, index);
+        } else {
+            timer_heap_sift_down(heap, index);
+        }
+    }
+}
+
+static IRAM_ATTR esp_timer_handle_t timer_heap_first(const timer_heap_t* heap)
+{
+    return heap->count > 0 ? heap->timers[0] : NULL;
+}
+
+/* Finds the earliest deadline of the timers without any of skip_flags in the subtree of the heap rooted at index,
+ * if it is earlier than *deadline. The timers of a subtree do not expire before its root and their deadlines
+ * are not before their alarms, so the subtrees rooted at a timer expiring after *deadline are skipped.
+ */
+static IRAM_ATTR void timer_heap_find_deadline(const timer_heap_t* heap, size_t index, flags_t skip_flags, uint64_t* deadline)
+{
+    if (index >= heap->count || heap->timers[index]->alarm >= *deadline) {
+        return;
+    }
+    esp_timer_handle_t it = heap->timers[index];
+    if ((it->flags & skip_flags) == 0) {
+        *deadline = MIN(*deadline, timer_deadline(it));
+    }
+    timer_heap_find_deadline(heap, 2 * index + 1, skip_flags, deadline);
+    timer_heap_find_deadline(heap, 2 * index + 2, skip_flags, deadline);
+}
+
+/* Sets the alarm to the earliest deadline of the armed timers */
+static IRAM_ATTR void timer_update_alarm(esp_timer_dispatch_t dispatch_method)
+{
+    uint64_t next_alarm = UINT64_MAX;
+    timer_heap_find_deadline(&s_timers[dispatch_method], 0, 0, &next_alarm);
+    s_next_alarm[dispatch_method] = next_alarm;
+    esp_timer_impl_set_alarm_id(next_alarm, dispatch_method);
+}
+
+/* Removes the first timer from a copy of a heap, without updating the heap indexes of the timers */
+static void timer_array_pop_first(esp_timer_handle_t* timers, size_t* count)
+{
+    esp_timer_handle_t timer = timers[--*count];
+    size_t index = 0;
+    while (2 * index + 1 < *count) {
+        size_t child = 2 * index + 1;
+        if (child + 1 < *count && timers[child + 1]->alarm < timers[child]->alarm) {
+            ++child;
+        }
+        if (timer->alarm <= timers[child]->alarm) {
+            break;
+        }
+        timers[index] = timers[child];
+        index = child;
+    }
+    timers[index] = timer;
+}
+
 #if WITH_PROFILING
 
 static IRAM_ATTR void timer_insert_inactive(esp_timer_handle_t timer)
@@ -339,13 +555,97 @@ static IRAM_ATTR void timer_remove_inactive(esp_timer_handle_t timer)
     LIST_REMOVE(timer, list_entry);
 }
 
+static IRAM_ATTR void timer_update_stats(esp_timer_handle_t timer, uint64_t alarm, int64_t callback_start)
+{
+    uint64_t run_time = esp_timer_impl_get_time() - callback_start;
+    uint64_t latency = callback_start - alarm;
+    timer->times_triggered++;
+    timer->total_callback_run_time += run_time;
+    timer->max_callback_run_time = MAX(timer->max_callback_run_time, run_time);
+    timer->total_latency += latency;
+    timer->max_latency = MAX(timer->max_latency, latency);
+}
+
 #endif // WITH_PROFILING
 
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+
+static IRAM_ATTR unsigned timer_task_core(esp_timer_handle_t timer)
+{
+    return timer->flags >> FL_TASK_CORE_SHIFT;
+}
+
+/* Queues a callback of an expired ESP_TIMER_TASK timer, or its deletion, for the task of its core.
+ * Returns false if the callback is not needed, as one is already queued for a timer skipping unhandled events.
+ */
+static IRAM_ATTR bool timer_dispatch_enqueue(esp_timer_handle_t timer, uint64_t alarm)
+{
+    if (timer->dispatch_pending == 0) {
+        TAILQ_INSERT_TAIL(&s_dispatch_queues[timer_task_core(timer)], timer, dispatch_entry);
+#if WITH_PROFILING
+        timer->dispatch_alarm = alarm;
+#endif
+    } else if (timer->flags & FL_SKIP_UNHANDLED_EVENTS) {
+        return false;
+    }
+    timer->dispatch_pending++;
+    return true;
+}
+
+/* Cancels the callbacks of the timer which are queued and not called yet */
+static IRAM_ATTR void timer_dispatch_cancel(esp_timer_handle_t timer)
+{
+    if (timer->dispatch_pending > 0) {
+        TAILQ_REMOVE(&s_dispatch_queues[timer_task_core(timer)], timer, dispatch_entry);
+        timer->dispatch_pending = 0;
+    }
+}
+
+/* Calls the callbacks queued for the task of a core, and frees the timers deleted on this core */
+static void timer_dispatch_queued(unsigned core)
+{
+    timer_list_lock(ESP_TIMER_TASK);
+    esp_timer_handle_t it;
+    while ((it = TAILQ_FIRST(&s_dispatch_queues[core])) != NULL) {
+        TAILQ_REMOVE(&s_dispatch_queues[core], it, dispatch_entry);
+        if (it->event_id == EVENT_ID_DELETE_TIMER) {
+            free(it);
+            --s_timer_count;
+            continue;
+        }
+        /* A periodic timer with more callbacks pending goes after the timers which expired in the meantime */
+        if (--it->dispatch_pending > 0) {
+            TAILQ_INSERT_TAIL(&s_dispatch_queues[core], it, dispatch_entry);
+        }
+#if WITH_PROFILING
+        uint64_t alarm = it->dispatch_alarm;
+        it->dispatch_alarm += it->period;
+        int64_t callback_start = esp_timer_impl_get_time();
+#endif
+        esp_timer_cb_t callback = it->callback;
+        void* arg = it->arg;
+        timer_list_unlock(ESP_TIMER_TASK);
+        (*callback)(arg);
+        timer_list_lock(ESP_TIMER_TASK);
+#if WITH_PROFILING
+        timer_update_stats(it, alarm, callback_start);
+#endif
+    }
+    timer_list_unlock(ESP_TIMER_TASK);
+}
+
+#endif // CONFIG_ESP_TIMER_TASK_PER_CORE
+
 static IRAM_ATTR bool timer_armed(esp_timer_handle_t timer)
 {
     return timer->alarm > 0;
 }
 
+static IRAM_ATTR uint64_t timer_deadline(esp_timer_handle_t timer)
+{
+    return timer->alarm + timer->slack;
+}
+
 static IRAM_ATTR void timer_list_lock(esp_timer_dispatch_t timer_type)
 {
     portENTER_CRITICAL_SAFE(&s_timer_lock[timer_type]);
@@ -356,7 +656,7 @@ static IRAM_ATTR void timer_list_unlock(esp_timer_dispatch_t timer_type)
     portEXIT_CRITICAL_SAFE(&s_timer_lock[timer_type]);
 }
 
-#ifdef CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD || CONFIG_ESP_TIMER_TASK_PER_CORE
 static IRAM_ATTR bool timer_process_alarm(esp_timer_dispatch_t dispatch_method)
 #else
 static bool timer_process_alarm(esp_timer_dispatch_t dispatch_method)
@@ -364,22 +664,32 @@ static bool timer_process_alarm(esp_timer_dispatch_t dispatch_method)
 {
     timer_list_lock(dispatch_method);
     bool processed = false;
+    uint32_t callbacks = 0;
     esp_timer_handle_t it;
     while (1) {
-        it = LIST_FIRST(&s_timers[dispatch_method]);
+        it = timer_heap_first(&s_timers[dispatch_method]);
         int64_t now = esp_timer_impl_get_time();
         if (it == NULL || it->alarm > now) {
             break;
         }
         processed = true;
-        LIST_REMOVE(it, list_entry);
+        timer_heap_remove(&s_timers[dispatch_method], it);
         if (it->event_id == EVENT_ID_DELETE_TIMER) {
             // It is handled only by ESP_TIMER_TASK (see esp_timer_delete()).
             // All the ESP_TIMER_ISR timers which should be deleted are moved by esp_timer_delete() to the ESP_TIMER_TASK list.
             // We want to free memory of the timer in a task context instead of an isr context.
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+            // The ESP_TIMER_TASK timers are processed in the isr context, the timer is freed by the task of its core.
+            timer_dispatch_enqueue(it, 0);
+#else
             free(it);
+            --s_timer_count;
+#endif
             it = NULL;
         } else {
+#if WITH_PROFILING || CONFIG_ESP_TIMER_TASK_PER_CORE
+            uint64_t alarm = it->alarm;
+#endif
             if (it->period > 0) {
                 int skipped = (now - it->alarm) / it->period;
                 if ((it->flags & FL_SKIP_UNHANDLED_EVENTS) && (skipped > 1)) {
@@ -390,35 +700,41 @@ static bool timer_process_alarm(esp_timer_dispatch_t dispatch_method)
                 } else {
                     it->alarm += it->period;
                 }
-                timer_insert(it, true);
+                timer_heap_push(&s_timers[dispatch_method], it);
             } else {
                 it->alarm = 0;
 #if WITH_PROFILING
                 timer_insert_inactive(it);
 #endif
             }
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+            if (dispatch_method == ESP_TIMER_TASK) {
+                if (timer_dispatch_enqueue(it, alarm)) {
+                    callbacks++;
+                }
+                continue;
+            }
+#endif
 #if WITH_PROFILING
-            uint64_t callback_start = now;
+            int64_t callback_start = now;
 #endif
             esp_timer_cb_t callback = it->callback;
             void* arg = it->arg;
+            callbacks++;
             timer_list_unlock(dispatch_method);
             (*callback)(arg);
             timer_list_lock(dispatch_method);
 #if WITH_PROFILING
-            it->times_triggered++;
-            it->total_callback_run_time += esp_timer_impl_get_time() - callback_start;
+            timer_update_stats(it, alarm, callback_start);
 #endif
         }
     } // while(1)
-    if (it) {
-        if (dispatch_method == ESP_TIMER_TASK || (dispatch_method != ESP_TIMER_TASK && processed == true)) {
-            esp_timer_impl_set_alarm_id(it->alarm, dispatch_method);
-        }
-    } else {
-        if (processed) {
-            esp_timer_impl_set_alarm_id(UINT64_MAX, dispatch_method);
-        }
+    if (callbacks > 0) {
+        s_wakeups[dispatch_method]++;
+        s_callbacks[dispatch_method] += callbacks;
+    }
+    if (dispatch_method == ESP_TIMER_TASK || processed) {
+        timer_update_alarm(dispatch_method);
     }
     timer_list_unlock(dispatch_method);
     return processed;
@@ -426,10 +742,17 @@ static bool timer_process_alarm(esp_timer_dispatch_t dispatch_method)
 
 static void timer_task(void* arg)
 {
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    unsigned core = (uintptr_t) arg;
+#endif
     while (true){
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         // all deferred events are processed at a time
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+        timer_dispatch_queued(core);
+#else
         timer_process_alarm(ESP_TIMER_TASK);
+#endif
     }
 }
 
@@ -441,6 +764,34 @@ IRAM_ATTR void esp_timer_isr_dispatch_need_yield(void)
 }
 #endif
 
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+/* Queues the expired ESP_TIMER_TASK timers for the tasks of their cores and notifies these tasks */
+static IRAM_ATTR void timer_dispatch_to_tasks(BaseType_t* higher_priority_task_woken)
+{
+    timer_process_alarm(ESP_TIMER_TASK);
+    bool queued[portNUM_PROCESSORS];
+    timer_list_lock(ESP_TIMER_TASK);
+    for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+        queued[core] = !TAILQ_EMPTY(&s_dispatch_queues[core]);
+    }
+    timer_list_unlock(ESP_TIMER_TASK);
+    for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+        if (queued[core]) {
+            vTaskNotifyGiveFromISR(s_timer_tasks[core], higher_priority_task_woken);
+        }
+    }
+}
+#else
+static IRAM_ATTR bool timer_expired(esp_timer_dispatch_t dispatch_method)
+{
+    timer_list_lock(dispatch_method);
+    esp_timer_handle_t it = timer_heap_first(&s_timers[dispatch_method]);
+    bool expired = it != NULL && it->alarm <= esp_timer_impl_get_time();
+    timer_list_unlock(dispatch_method);
+    return expired;
+}
+#endif // CONFIG_ESP_TIMER_TASK_PER_CORE
+
 static void IRAM_ATTR timer_alarm_handler(void* arg)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -453,9 +804,16 @@ static void IRAM_ATTR timer_alarm_handler(void* arg)
     s_isr_dispatch_need_yield = pdFALSE;
 #endif
 
-    if (isr_timers_processed == false) {
-        vTaskNotifyGiveFromISR(s_timer_task, &xHigherPriorityTaskWoken);
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    (void) isr_timers_processed;
+    timer_dispatch_to_tasks(&xHigherPriorityTaskWoken);
+#else
+    /* Task timers which are already due are dispatched with this alarm as well,
+     * rather than with one of their own right after it */
+    if (isr_timers_processed == false || timer_expired(ESP_TIMER_TASK)) {
+        vTaskNotifyGiveFromISR(s_timer_tasks[0], &xHigherPriorityTaskWoken);
     }
+#endif
     if (xHigherPriorityTaskWoken == pdTRUE) {
         portYIELD_FROM_ISR();
     }
@@ -463,7 +821,7 @@ static void IRAM_ATTR timer_alarm_handler(void* arg)
 
 static IRAM_ATTR inline bool is_initialized(void)
 {
-    return s_timer_task != NULL;
+    return s_timer_tasks[0] != NULL;
 }
 
 esp_err_t esp_timer_early_init(void)
@@ -482,11 +840,23 @@ esp_err_t esp_timer_init(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    int ret = xTaskCreatePinnedToCore(&timer_task, "esp_timer",
-            ESP_TASK_TIMER_STACK, NULL, ESP_TASK_TIMER_PRIO, &s_timer_task, PRO_CPU_NUM);
-    if (ret != pdPASS) {
-        err = ESP_ERR_NO_MEM;
-        goto out;
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    for (int core = 0; core < portNUM_PROCESSORS; ++core) {
+        TAILQ_INIT(&s_dispatch_queues[core]);
+    }
+#endif
+    for (int core = 0; core < TIMER_TASK_COUNT; ++core) {
+        /* The task of the PRO CPU keeps its name, the tasks of the other cores are named after their core */
+        char task_name[configMAX_TASK_NAME_LEN] = "esp_timer";
+        if (core != PRO_CPU_NUM) {
+            snprintf(task_name, sizeof(task_name), "esp_timer%d", core);
+        }
+        int ret = xTaskCreatePinnedToCore(&timer_task, task_name,
+                ESP_TASK_TIMER_STACK, (void*) (intptr_t) core, ESP_TASK_TIMER_PRIO, &s_timer_tasks[core], core);
+        if (ret != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+            goto out;
+        }
     }
 
     err = esp_timer_impl_init(&timer_alarm_handler);
@@ -497,9 +867,11 @@ esp_err_t esp_timer_init(void)
     return ESP_OK;
 
 out:
-    if (s_timer_task) {
-        vTaskDelete(s_timer_task);
-        s_timer_task = NULL;
+    for (int core = TIMER_TASK_COUNT - 1; core >= 0; --core) {
+        if (s_timer_tasks[core]) {
+            vTaskDelete(s_timer_tasks[core]);
+            s_timer_tasks[core] = NULL;
+        }
     }
 
     return ESP_ERR_NO_MEM;
@@ -518,7 +890,7 @@ esp_err_t esp_timer_deinit(void)
 
     /* Check if there are any active timers */
     for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
-        if (!LIST_EMPTY(&s_timers[dispatch_method])) {
+        if (s_timers[dispatch_method].count != 0) {
             return ESP_ERR_INVALID_STATE;
         }
     }
@@ -536,8 +908,10 @@ esp_err_t esp_timer_deinit(void)
 
     esp_timer_impl_deinit();
 
-    vTaskDelete(s_timer_task);
-    s_timer_task = NULL;
+    for (int core = TIMER_TASK_COUNT - 1; core >= 0; --core) {
+        vTaskDelete(s_timer_tasks[core]);
+        s_timer_tasks[core] = NULL;
+    }
     return ESP_OK;
 }
 
@@ -551,15 +925,20 @@ static void print_timer_info(esp_timer_handle_t t, char** dst, size_t* dst_size)
     } else {
         cb = snprintf(*dst, *dst_size, "timer@%-10p  ", t);
     }
-    cb += snprintf(*dst + cb, *dst_size + cb, "%-10lld  %-12lld  %-12d  %-12d  %-12d  %-12lld\n",
+    cb = MIN(cb, *dst_size);
+    cb += snprintf(*dst + cb, *dst_size - cb, "%-10" PRIu64 "  %-12" PRIu64 "  %-12zu  %-12zu  %-12zu  %-12" PRIu64 "  %-12" PRIu64
+                    "  %-12" PRIu64 "  %-12" PRIu64 "\n",
                     (uint64_t)t->period, t->alarm, t->times_armed,
-                    t->times_triggered, t->times_skipped, t->total_callback_run_time);
+                    t->times_triggered, t->times_skipped, t->total_callback_run_time,
+                    t->max_callback_run_time, t->total_latency, t->max_latency);
     /* keep this in sync with the format string, used in esp_timer_dump */
-#define TIMER_INFO_LINE_LEN 90
+#define TIMER_INFO_LINE_LEN 145
 #else
-    size_t cb = snprintf(*dst, *dst_size, "timer@%-14p  %-10lld  %-12lld\n", t, (uint64_t)t->period, t->alarm);
-#define TIMER_INFO_LINE_LEN 46
+    size_t cb = snprintf(*dst, *dst_size, "timer@%-14p  %-10" PRIu64 "  %-12" PRIu64 "\n", t, (uint64_t)t->period, t->alarm);
+#define TIMER_INFO_LINE_LEN 47
 #endif
+    /* snprintf returns the length of the whole line, even if it was truncated */
+    cb = MIN(cb, *dst_size);
     *dst += cb;
     *dst_size -= cb;
 }
@@ -573,15 +952,15 @@ esp_err_t esp_timer_dump(FILE* stream)
      * print to it, then dump this memory to stdout.
      */
 
+#if WITH_PROFILING
     esp_timer_handle_t it;
+#endif
 
     /* First count the number of timers */
     size_t timer_count = 0;
     for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
         timer_list_lock(dispatch_method);
-        LIST_FOREACH(it, &s_timers[dispatch_method], list_entry) {
-            ++timer_count;
-        }
+        timer_count += s_timers[dispatch_method].count;
 #if WITH_PROFILING
         LIST_FOREACH(it, &s_inactive_timers[dispatch_method], list_entry) {
             ++timer_count;
@@ -597,16 +976,29 @@ esp_err_t esp_timer_dump(FILE* stream)
      */
     size_t buf_size = TIMER_INFO_LINE_LEN * (timer_count + 3);
     char* print_buf = calloc(1, buf_size + 1);
-    if (print_buf == NULL) {
+    /* The armed timers are printed in alarm order, taken one by one from a copy of the heap */
+    size_t sorted_size = timer_count + 3;
+    esp_timer_handle_t* sorted = calloc(sorted_size, sizeof(esp_timer_handle_t));
+    if (print_buf == NULL || sorted == NULL) {
+        free(print_buf);
+        free(sorted);
         return ESP_ERR_NO_MEM;
     }
 
     /* Print to the buffer */
     char* pos = print_buf;
+    uint32_t wakeups[ESP_TIMER_MAX];
+    uint32_t callbacks[ESP_TIMER_MAX];
     for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
         timer_list_lock(dispatch_method);
-        LIST_FOREACH(it, &s_timers[dispatch_method], list_entry) {
-            print_timer_info(it, &pos, &buf_size);
+        wakeups[dispatch_method] = s_wakeups[dispatch_method];
+        callbacks[dispatch_method] = s_callbacks[dispatch_method];
+        /* Any prefix of the heap is a heap as well, in case there are more timers than expected */
+        size_t count = MIN(s_timers[dispatch_method].count, sorted_size);
+        memcpy(sorted, s_timers[dispatch_method].timers, count * sizeof(esp_timer_handle_t));
+        while (count > 0) {
+            print_timer_info(sorted[0], &pos, &buf_size);
+            timer_array_pop_first(sorted, &count);
         }
 #if WITH_PROFILING
         LIST_FOREACH(it, &s_inactive_timers[dispatch_method], list_entry) {
@@ -619,31 +1011,36 @@ esp_err_t esp_timer_dump(FILE* stream)
     if (stream != NULL) {
         fprintf(stream, "Timer stats:\n");
 #if WITH_PROFILING
-        fprintf(stream, "%-20s  %-10s  %-12s  %-12s  %-12s  %-12s  %-12s\n",
-                "Name", "Period", "Alarm", "Times_armed", "Times_trigg", "Times_skip", "Cb_exec_time");
+        fprintf(stream, "%-20s  %-10s  %-12s  %-12s  %-12s  %-12s  %-12s  %-12s  %-12s  %-12s\n",
+                "Name", "Period", "Alarm", "Times_armed", "Times_trigg", "Times_skip", "Cb_exec_time",
+                "Cb_max_time", "Latency", "Max_latency");
 #else
         fprintf(stream, "%-20s  %-10s  %-12s\n", "Name", "Period", "Alarm");
 #endif
 
         /* Print the buffer */
         fputs(print_buf, stream);
+
+        /* Callbacks called in the same wakeup as an earlier callback did not need a wakeup of their own */
+        fprintf(stream, "%-20s  %-10s  %-12s  %-12s\n", "Dispatch", "Wakeups", "Callbacks", "Coalesced");
+        for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
+            fprintf(stream, "%-20s  %-10" PRIu32 "  %-12" PRIu32 "  %-12" PRIu32 "\n",
+                    dispatch_method == ESP_TIMER_TASK ? "task" : "isr", wakeups[dispatch_method],
+                    callbacks[dispatch_method], callbacks[dispatch_method] - wakeups[dispatch_method]);
+        }
     }
 
+    free(sorted);
     free(print_buf);
     return ESP_OK;
 }
 
 int64_t IRAM_ATTR esp_timer_get_next_alarm(void)
 {
-    int64_t next_alarm = INT64_MAX;
+    uint64_t next_alarm = INT64_MAX;
     for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
         timer_list_lock(dispatch_method);
-        esp_timer_handle_t it = LIST_FIRST(&s_timers[dispatch_method]);
-        if (it) {
-            if (next_alarm > it->alarm) {
-                next_alarm = it->alarm;
-            }
-        }
+        timer_heap_find_deadline(&s_timers[dispatch_method], 0, 0, &next_alarm);
         timer_list_unlock(dispatch_method);
     }
     return next_alarm;
@@ -651,19 +1048,11 @@ int64_t IRAM_ATTR esp_timer_get_next_alarm(void)
 
 int64_t IRAM_ATTR esp_timer_get_next_alarm_for_wake_up(void)
 {
-    int64_t next_alarm = INT64_MAX;
+    uint64_t next_alarm = INT64_MAX;
     for (esp_timer_dispatch_t dispatch_method = ESP_TIMER_TASK; dispatch_method < ESP_TIMER_MAX; ++dispatch_method) {
         timer_list_lock(dispatch_method);
-        esp_timer_handle_t it = NULL;
-        LIST_FOREACH(it, &s_timers[dispatch_method], list_entry) {
-            // timers with the SKIP_UNHANDLED_EVENTS flag do not want to wake up CPU from a sleep mode.
-            if ((it->flags & FL_SKIP_UNHANDLED_EVENTS) == 0) {
-                if (next_alarm > it->alarm) {
-                    next_alarm = it->alarm;
-                }
-                break;
-            }
-        }
+        // timers with the SKIP_UNHANDLED_EVENTS flag do not want to wake up CPU from a sleep mode.
+        timer_heap_find_deadline(&s_timers[dispatch_method], 0, FL_SKIP_UNHANDLED_EVENTS, &next_alarm);
         timer_list_unlock(dispatch_method);
     }
     return next_alarm;
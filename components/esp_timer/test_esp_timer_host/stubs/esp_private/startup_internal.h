@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "esp_err.h"
+
+/* The tests call esp_timer_init() themselves */
+#define ESP_SYSTEM_INIT_FN(f, c, priority, ...) \
+    __attribute__((unused)) static esp_err_t f(void)
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#ifdef __cplusplus
+#include <atomic>
+using std::atomic_flag;
+#else
+#include <stdatomic.h>
+#endif
+/* Included by portmacro.h on the targets */
+#include "esp_heap_caps.h"
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portNUM_PROCESSORS 2
+#define configMAX_TASK_NAME_LEN 16
+#define BIT(nr) (1UL << (nr))
+
+/* Critical sections are spinlocks, which is enough for the tests running on the host */
+typedef struct {
+    atomic_flag locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { ATOMIC_FLAG_INIT }
+
+#define portENTER_CRITICAL_SAFE(mux) do { while (atomic_flag_test_and_set(&(mux)->locked)) { } } while (0)
+#define portEXIT_CRITICAL_SAFE(mux) atomic_flag_clear(&(mux)->locked)
+
+#define portYIELD_FROM_ISR()
+
+static inline bool xPortInIsrContext(void)
+{
+    return true;
+}
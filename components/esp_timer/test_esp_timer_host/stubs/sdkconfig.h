@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#define CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD 1
+#define CONFIG_ESP_TIMER_TASK_STACK_SIZE 3584
+
+/* CONFIG_ESP_TIMER_TASK_PER_CORE is set by test_all_configs.sh */
+#ifndef CONFIG_ESP_TIMER_TASK_PER_CORE
+#define CONFIG_FREERTOS_UNICORE 1
+#endif
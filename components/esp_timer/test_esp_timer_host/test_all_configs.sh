@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+#
+# Run the test suite with all configurations enabled
+#
+
+FAIL=0
+
+for FLAGS in "" "-DCONFIG_ESP_TIMER_TASK_PER_CORE" "-DCONFIG_ESP_TIMER_PROFILING" "-DCONFIG_ESP_TIMER_TASK_PER_CORE -DCONFIG_ESP_TIMER_PROFILING" ; do
+    echo "==== Testing with config: ${FLAGS:-default} ===="
+    CPPFLAGS="${FLAGS}" make clean test || FAIL=1
+done
+
+make clean
+
+if [ $FAIL == 0 ]; then
+    echo "All configurations passed"
+else
+    echo "Some configurations failed, see log."
+    exit 1
+fi
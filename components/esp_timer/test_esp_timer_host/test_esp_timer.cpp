@@ -0,0 +1,573 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "catch.hpp"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+extern "C" {
+#include "esp_timer_impl.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/* The timer hardware is replaced by a clock which only moves when the tests advance it.
+ * The timer tasks run in threads, one loop at a time when the tests call run_timer_task().
+ */
+static int64_t s_now = 1;
+static uint64_t s_alarm[ESP_TIMER_MAX] = { UINT64_MAX, UINT64_MAX };
+static intr_handler_t s_alarm_handler;
+
+struct fake_task_t {
+    int core;
+    int notifications;
+    bool waiting;
+};
+
+/* Never destroyed, the timer task threads wait on them until the process exits */
+static std::mutex &s_task_mutex = *new std::mutex;
+static std::condition_variable &s_task_cond = *new std::condition_variable;
+static std::vector<fake_task_t> &s_tasks = *new std::vector<fake_task_t>;
+/* Index of the task running in the current thread, -1 outside of the timer tasks */
+static thread_local int s_current_task = -1;
+
+extern "C" {
+
+int64_t esp_timer_impl_get_time(void)
+{
+    return s_now;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now;
+}
+
+uint64_t esp_timer_impl_get_min_period_us(void)
+{
+    return 50;
+}
+
+void esp_timer_impl_set_alarm_id(uint64_t timestamp, unsigned alarm_id)
+{
+    s_alarm[alarm_id] = timestamp;
+}
+
+esp_err_t esp_timer_impl_early_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_impl_init(intr_handler_t alarm_handler)
+{
+    s_alarm_handler = alarm_handler;
+    return ESP_OK;
+}
+
+void esp_timer_impl_deinit(void)
+{
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    std::unique_lock<std::mutex> lock(s_task_mutex);
+    int index = s_tasks.size();
+    s_tasks.push_back({ core_id, 0, false });
+    std::thread([task, arg, index] {
+        s_current_task = index;
+        task(arg);
+    }).detach();
+    *handle = (TaskHandle_t) (intptr_t) (index + 1);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    std::unique_lock<std::mutex> lock(s_task_mutex);
+    fake_task_t &task = s_tasks[s_current_task];
+    task.waiting = true;
+    s_task_cond.notify_all();
+    s_task_cond.wait(lock, [&task] { return task.notifications > 0; });
+    task.waiting = false;
+    uint32_t notifications = task.notifications;
+    task.notifications = 0;
+    return notifications;
+}
+
+/* The timer tasks only run when run_timer_task() is called */
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+}
+
+}
+
+static void init_timers(void)
+{
+    static bool initialized;
+    if (!initialized) {
+        REQUIRE(esp_timer_init() == ESP_OK);
+        initialized = true;
+    }
+}
+
+/* Time of the next timer interrupt. With CONFIG_ESP_TIMER_TASK_PER_CORE, the interrupt handler
+ * processes the ESP_TIMER_TASK timers as well, otherwise they are processed by the timer task.
+ */
+static uint64_t next_interrupt(void)
+{
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+    return std::min(s_alarm[ESP_TIMER_ISR], s_alarm[ESP_TIMER_TASK]);
+#else
+    return s_alarm[ESP_TIMER_ISR];
+#endif
+}
+
+/* Moves the clock forward, firing the timer interrupts on the way */
+static void advance_to(int64_t time)
+{
+    while (next_interrupt() <= (uint64_t) time) {
+        s_now = std::max(s_now, (int64_t) next_interrupt());
+        s_alarm_handler(NULL);
+    }
+    s_now = time;
+}
+
+/* Lets each timer task run one loop, which processes the expired ESP_TIMER_TASK timers and frees the deleted timers */
+static void run_timer_task(void)
+{
+    advance_to(s_now);
+    std::unique_lock<std::mutex> lock(s_task_mutex);
+    for (fake_task_t &task : s_tasks) {
+        s_task_cond.wait(lock, [&task] { return task.waiting; });
+        task.notifications++;
+    }
+    s_task_cond.notify_all();
+    for (fake_task_t &task : s_tasks) {
+        s_task_cond.wait(lock, [&task] { return task.notifications == 0 && task.waiting; });
+    }
+}
+
+struct fired_t {
+    int index;
+    int64_t time;
+    int core;   // core of the timer task calling the callback, -1 for ESP_TIMER_ISR timers
+};
+
+static std::mutex s_fired_mutex;
+static std::vector<fired_t> s_fired;
+
+static void record_cb(void *arg)
+{
+    std::lock_guard<std::mutex> lock(s_fired_mutex);
+    s_fired.push_back({ (int) (intptr_t) arg, s_now, (s_current_task >= 0) ? s_tasks[s_current_task].core : -1 });
+}
+
+static void dummy_cb(void *arg)
+{
+}
+
+/* Gets the wakeup statistics of the ESP_TIMER_ISR dispatch method from the dump */
+static void get_isr_wakeups(unsigned *wakeups, unsigned *callbacks, unsigned *coalesced)
+{
+    char *dump = NULL;
+    size_t dump_size = 0;
+    FILE *stream = open_memstream(&dump, &dump_size);
+    REQUIRE(esp_timer_dump(stream) == ESP_OK);
+    fclose(stream);
+    const char *line = strstr(dump, "\nisr ");
+    REQUIRE(line != NULL);
+    REQUIRE(sscanf(line, " isr %u %u %u", wakeups, callbacks, coalesced) == 3);
+    free(dump);
+}
+
+static double elapsed_ns(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+TEST_CASE("timers fire in alarm order")
+{
+    const int TIMERS = 1000;
+    init_timers();
+    std::mt19937 rng(42);
+    std::vector<esp_timer_handle_t> timers(TIMERS);
+    std::vector<int64_t> alarms(TIMERS);
+    std::vector<bool> stopped(TIMERS);
+
+    for (int i = 0; i < TIMERS; i++) {
+        esp_timer_create_args_t args = {};
+        args.callback = &record_cb;
+        args.arg = (void *) (intptr_t) i;
+        args.dispatch_method = ESP_TIMER_ISR;
+        args.skip_unhandled_events = (i % 3 == 0);
+        REQUIRE(esp_timer_create(&args, &timers[i]) == ESP_OK);
+        uint64_t timeout = 1 + rng() % 1000000;
+        alarms[i] = s_now + timeout;
+        REQUIRE(esp_timer_start_once(timers[i], timeout) == ESP_OK);
+    }
+    for (int i = 0; i < TIMERS; i += 4) {
+        REQUIRE(esp_timer_stop(timers[i + 1]) == ESP_OK);
+        stopped[i + 1] = true;
+    }
+
+    int64_t next_alarm = INT64_MAX;
+    int64_t next_alarm_for_wake_up = INT64_MAX;
+    for (int i = 0; i < TIMERS; i++) {
+        if (!stopped[i]) {
+            next_alarm = std::min(next_alarm, alarms[i]);
+            if (i % 3 != 0) {
+                next_alarm_for_wake_up = std::min(next_alarm_for_wake_up, alarms[i]);
+            }
+        }
+    }
+    CHECK(esp_timer_get_next_alarm() == next_alarm);
+    CHECK(esp_timer_get_next_alarm_for_wake_up() == next_alarm_for_wake_up);
+    CHECK((int64_t) s_alarm[ESP_TIMER_ISR] == next_alarm);
+
+    /* The dump lists the armed timers in alarm order */
+    run_timer_task();
+    char *dump = NULL;
+    size_t dump_size = 0;
+    FILE *stream = open_memstream(&dump, &dump_size);
+    REQUIRE(esp_timer_dump(stream) == ESP_OK);
+    fclose(stream);
+    std::vector<int64_t> dumped_alarms;
+    char *line = strtok(dump, "\n");
+    line = strtok(NULL, "\n");  // header
+    while ((line = strtok(NULL, "\n")) != NULL && strncmp(line, "Dispatch", 8) != 0) {
+        void *timer;
+        long long period, alarm;
+        REQUIRE(sscanf(line, "timer@%p %lld %lld", &timer, &period, &alarm) == 3);
+        if (alarm != 0) {
+            dumped_alarms.push_back(alarm);
+        }
+    }
+    free(dump);
+    CHECK(dumped_alarms.size() == TIMERS - TIMERS / 4);
+    CHECK(std::is_sorted(dumped_alarms.begin(), dumped_alarms.end()));
+
+    s_fired.clear();
+    advance_to(s_now + 2000000);
+    REQUIRE(s_fired.size() == TIMERS - TIMERS / 4);
+    for (size_t i = 0; i < s_fired.size(); i++) {
+        CHECK_FALSE(stopped[s_fired[i].index]);
+        CHECK(s_fired[i].time >= alarms[s_fired[i].index]);
+        if (i > 0) {
+            CHECK(alarms[s_fired[i - 1].index] <= alarms[s_fired[i].index]);
+        }
+    }
+    CHECK(s_alarm[ESP_TIMER_ISR] == UINT64_MAX);
+
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+
+TEST_CASE("periodic timers are rearmed")
+{
+    init_timers();
+    esp_timer_handle_t timers[2];
+    for (int i = 0; i < 2; i++) {
+        esp_timer_create_args_t args = {};
+        args.callback = &record_cb;
+        args.arg = (void *) (intptr_t) i;
+        args.dispatch_method = ESP_TIMER_ISR;
+        REQUIRE(esp_timer_create(&args, &timers[i]) == ESP_OK);
+    }
+    s_fired.clear();
+    REQUIRE(esp_timer_start_periodic(timers[0], 1000) == ESP_OK);
+    REQUIRE(esp_timer_start_periodic(timers[1], 3000) == ESP_OK);
+    advance_to(s_now + 6000);
+    CHECK(s_fired.size() == 8);
+    CHECK(std::count_if(s_fired.begin(), s_fired.end(), [](const fired_t &f) { return f.index == 1; }) == 2);
+
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(esp_timer_stop(timers[i]) == ESP_OK);
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+
+TEST_CASE("timers with slack are dispatched together")
+{
+    const int TIMERS = 10;
+    init_timers();
+    esp_timer_handle_t timers[TIMERS + 1];
+    for (int i = 0; i <= TIMERS; i++) {
+        esp_timer_create_args_t args = {};
+        args.callback = &record_cb;
+        args.arg = (void *) (intptr_t) i;
+        args.dispatch_method = ESP_TIMER_ISR;
+        args.slack_us = (i < TIMERS) ? 1000 : 0;
+        REQUIRE(esp_timer_create(&args, &timers[i]) == ESP_OK);
+    }
+    unsigned wakeups, callbacks, coalesced;
+    get_isr_wakeups(&wakeups, &callbacks, &coalesced);
+
+    /* One-shot timers expiring within the slack of the first one are dispatched at its deadline */
+    int64_t start = s_now;
+    s_fired.clear();
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_start_once(timers[i], 1000 + i * 100) == ESP_OK);
+    }
+    CHECK(esp_timer_get_next_alarm() == start + 2000);
+    CHECK(esp_timer_get_next_alarm_for_wake_up() == start + 2000);
+    advance_to(start + 5000);
+    REQUIRE(s_fired.size() == TIMERS);
+    for (int i = 0; i < TIMERS; i++) {
+        CHECK(s_fired[i].index == i);
+        CHECK(s_fired[i].time == start + 2000);
+    }
+    unsigned new_wakeups, new_callbacks, new_coalesced;
+    get_isr_wakeups(&new_wakeups, &new_callbacks, &new_coalesced);
+    CHECK(new_wakeups - wakeups == 1);
+    CHECK(new_callbacks - callbacks == TIMERS);
+    CHECK(new_coalesced - coalesced == TIMERS - 1);
+
+    /* A timer without slack expiring before that deadline is dispatched on time, with the timers already due */
+    start = s_now;
+    s_fired.clear();
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_start_once(timers[i], 1000 + i * 100) == ESP_OK);
+    }
+    REQUIRE(esp_timer_start_once(timers[TIMERS], 1450) == ESP_OK);
+    CHECK(esp_timer_get_next_alarm() == start + 1450);
+    advance_to(start + 5000);
+    REQUIRE(s_fired.size() == TIMERS + 1);
+    for (const fired_t &f : s_fired) {
+        int64_t alarm = start + ((f.index < TIMERS) ? 1000 + f.index * 100 : 1450);
+        CHECK(f.time == ((alarm <= start + 1450) ? start + 1450 : start + 2500));
+    }
+
+    /* Periodic timers with slack stay in step */
+    start = s_now;
+    s_fired.clear();
+    get_isr_wakeups(&wakeups, &callbacks, &coalesced);
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_start_periodic(timers[i], 10000) == ESP_OK);
+        advance_to(s_now + 50);
+    }
+    advance_to(start + 100000);
+    CHECK(s_fired.size() == TIMERS * 9);
+    get_isr_wakeups(&new_wakeups, &new_callbacks, &new_coalesced);
+    CHECK(new_wakeups - wakeups == 9);
+    CHECK(new_coalesced - coalesced == (TIMERS - 1) * 9);
+
+    for (int i = 0; i <= TIMERS; i++) {
+        if (esp_timer_is_active(timers[i])) {
+            REQUIRE(esp_timer_stop(timers[i]) == ESP_OK);
+        }
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+
+#if CONFIG_ESP_TIMER_TASK_PER_CORE
+static esp_timer_handle_t create_task_timer(int index, int task_core_id, bool skip_unhandled_events = false)
+{
+    esp_timer_create_args_t args = {};
+    args.callback = &record_cb;
+    args.arg = (void *) (intptr_t) index;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.skip_unhandled_events = skip_unhandled_events;
+    args.task_core_id = task_core_id;
+    esp_timer_handle_t timer;
+    REQUIRE(esp_timer_create(&args, &timer) == ESP_OK);
+    return timer;
+}
+
+static int count_fired(int index)
+{
+    return std::count_if(s_fired.begin(), s_fired.end(), [index](const fired_t &f) { return f.index == index; });
+}
+
+TEST_CASE("timers are dispatched in alarm order by the task of their core")
+{
+    const int TIMERS = 8;
+    init_timers();
+    esp_timer_handle_t timers[TIMERS];
+    for (int i = 0; i < TIMERS; i++) {
+        timers[i] = create_task_timer(i, (i < TIMERS / 2) ? i % portNUM_PROCESSORS : ESP_TIMER_ANY_CORE);
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = &record_cb;
+    args.task_core_id = portNUM_PROCESSORS;
+    esp_timer_handle_t timer;
+    CHECK(esp_timer_create(&args, &timer) == ESP_ERR_INVALID_ARG);
+
+    s_fired.clear();
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_start_once(timers[i], 1000 * (TIMERS - i)) == ESP_OK);
+    }
+    advance_to(s_now + 1000 * TIMERS);
+    CHECK(s_fired.empty());
+    run_timer_task();
+    REQUIRE(s_fired.size() == TIMERS);
+    int last_fired[portNUM_PROCESSORS];
+    std::fill(last_fired, last_fired + portNUM_PROCESSORS, TIMERS);
+    int any_core_timers[portNUM_PROCESSORS] = {};
+    for (const fired_t &f : s_fired) {
+        if (f.index < TIMERS / 2) {
+            CHECK(f.core == f.index % portNUM_PROCESSORS);
+        } else {
+            any_core_timers[f.core]++;
+        }
+        /* The timers expiring first were started last */
+        CHECK(f.index < last_fired[f.core]);
+        last_fired[f.core] = f.index;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        CHECK(any_core_timers[core] == TIMERS / 2 / portNUM_PROCESSORS);
+    }
+
+    for (int i = 0; i < TIMERS; i++) {
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+
+static std::mutex s_slow_mutex;
+static std::condition_variable s_slow_cond;
+static bool s_fast_called;
+static bool s_slow_waited;
+
+static void slow_cb(void *arg)
+{
+    std::unique_lock<std::mutex> lock(s_slow_mutex);
+    s_slow_waited = s_slow_cond.wait_for(lock, std::chrono::seconds(10), [] { return s_fast_called; });
+}
+
+static void fast_cb(void *arg)
+{
+    std::lock_guard<std::mutex> lock(s_slow_mutex);
+    s_fast_called = true;
+    s_slow_cond.notify_all();
+}
+
+TEST_CASE("a slow callback does not delay the timers of other cores")
+{
+    init_timers();
+    esp_timer_handle_t timers[2];
+    esp_timer_cb_t callbacks[2] = { &slow_cb, &fast_cb };
+    for (int i = 0; i < 2; i++) {
+        esp_timer_create_args_t args = {};
+        args.callback = callbacks[i];
+        args.task_core_id = i;
+        REQUIRE(esp_timer_create(&args, &timers[i]) == ESP_OK);
+    }
+    s_fast_called = false;
+    s_slow_waited = false;
+    REQUIRE(esp_timer_start_once(timers[0], 1000) == ESP_OK);
+    REQUIRE(esp_timer_start_once(timers[1], 2000) == ESP_OK);
+    advance_to(s_now + 2000);
+    run_timer_task();
+    CHECK(s_slow_waited);
+
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+
+TEST_CASE("queued callbacks of periodic timers are called until the timer is stopped")
+{
+    init_timers();
+    esp_timer_handle_t timers[3];
+    timers[0] = create_task_timer(0, 1);
+    timers[1] = create_task_timer(1, 1, true);
+    timers[2] = create_task_timer(2, 0);
+
+    /* The callbacks missed by a late task are called in a row, unless the timer skips them */
+    s_fired.clear();
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(esp_timer_start_periodic(timers[i], 1000) == ESP_OK);
+    }
+    advance_to(s_now + 3500);
+    run_timer_task();
+    CHECK(count_fired(0) == 3);
+    CHECK(count_fired(1) == 1);
+
+    /* Stopping a periodic timer cancels its queued callbacks */
+    s_fired.clear();
+    advance_to(s_now + 2000);
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(esp_timer_stop(timers[i]) == ESP_OK);
+    }
+    /* Deleting an expired one-shot timer cancels its queued callback */
+    REQUIRE(esp_timer_start_once(timers[2], 100) == ESP_OK);
+    advance_to(s_now + 100);
+    REQUIRE(esp_timer_delete(timers[2]) == ESP_OK);
+    run_timer_task();
+    CHECK(s_fired.empty());
+
+    for (int i = 0; i < 2; i++) {
+        REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    run_timer_task();
+}
+#endif // CONFIG_ESP_TIMER_TASK_PER_CORE
+
+TEST_CASE("start, stop and fire benchmark", "[benchmark][.]")
+{
+    init_timers();
+    std::mt19937 rng(42);
+
+    for (int count : { 100, 1000, 10000 }) {
+        std::vector<esp_timer_handle_t> timers(count);
+        std::vector<uint64_t> timeouts(count);
+        for (int i = 0; i < count; i++) {
+            esp_timer_create_args_t args = {};
+            args.callback = &dummy_cb;
+            args.dispatch_method = ESP_TIMER_ISR;
+            REQUIRE(esp_timer_create(&args, &timers[i]) == ESP_OK);
+            timeouts[i] = 1000 + rng() % 1000000;
+        }
+        std::vector<esp_timer_handle_t> stop_order(timers);
+        std::shuffle(stop_order.begin(), stop_order.end(), rng);
+
+        struct timespec start, started, stopped, fired;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < count; i++) {
+            esp_timer_start_once(timers[i], timeouts[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &started);
+        for (int i = 0; i < count; i++) {
+            esp_timer_stop(stop_order[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &stopped);
+
+        for (int i = 0; i < count; i++) {
+            esp_timer_start_once(timers[i], timeouts[i]);
+        }
+        struct timespec fire_start;
+        clock_gettime(CLOCK_MONOTONIC, &fire_start);
+        advance_to(s_now + 2000000);
+        clock_gettime(CLOCK_MONOTONIC, &fired);
+
+        printf("%d timers: %.1f ns per start, %.1f ns per stop, %.1f ns per fire\n", count,
+               elapsed_ns(start, started) / count, elapsed_ns(started, stopped) / count,
+               elapsed_ns(fire_start, fired) / count);
+
+        for (int i = 0; i < count; i++) {
+            REQUIRE(esp_timer_delete(timers[i]) == ESP_OK);
+        }
+        run_timer_task();
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_heap_caps.h"
+#include "esp_heap_arena.h"
+
+/*
+ Arena allocator.
+
+ The data of the arena is at the start of its first chunk, which is kept until the arena is destroyed. The other
+ chunks are kept in a list, to be freed by heap_arena_reset(). Allocations are made by moving a pointer forward in
+ the current chunk. When an allocation doesn't fit in the space left, it either starts a new current chunk or, if
+ it is too large for a chunk, gets a chunk of its own so that the space left in the current chunk isn't lost.
+*/
+
+#define ALIGN_UP_BY(num, align) (((num) + ((align) - 1)) & ~((align) - 1))
+
+typedef struct heap_arena_chunk {
+    struct heap_arena_chunk *next;
+    size_t size;
+} heap_arena_chunk_t;
+
+struct heap_arena {
+    uint32_t caps;
+    size_t chunk_size;
+    uintptr_t free_start;           // space left in the current chunk
+    uintptr_t free_end;
+    heap_arena_chunk_t *chunks;     // chunks allocated after the first one
+    size_t allocated_bytes;
+};
+
+/* Start of the space of the first chunk, after the data of the arena */
+static inline uintptr_t first_chunk_start(heap_arena_handle_t arena)
+{
+    return (uintptr_t)(arena + 1);
+}
+
+heap_arena_handle_t heap_arena_create(uint32_t caps, size_t chunk_size)
+{
+    if (chunk_size <= sizeof(struct heap_arena) + sizeof(heap_arena_chunk_t)) {
+        return NULL;
+    }
+    heap_arena_handle_t arena = heap_caps_malloc(chunk_size, caps);
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->caps = caps;
+    arena->chunk_size = chunk_size;
+    arena->chunks = NULL;
+    heap_arena_reset(arena);
+    return arena;
+}
+
+static void free_chunks(heap_arena_handle_t arena)
+{
+    heap_arena_chunk_t *chunk = arena->chunks;
+    while (chunk != NULL) {
+        heap_arena_chunk_t *next = chunk->next;
+        heap_caps_free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
+
+void heap_arena_destroy(heap_arena_handle_t arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    free_chunks(arena);
+    heap_caps_free(arena);
+}
+
+void heap_arena_reset(heap_arena_handle_t arena)
+{
+    free_chunks(arena);
+    arena->free_start = first_chunk_start(arena);
+    arena->free_end = (uintptr_t)arena + arena->chunk_size;
+    arena->allocated_bytes = 0;
+}
+
+/* Allocate a chunk which can hold an allocation of 'size' bytes aligned on 'alignment', and return the allocation */
+static void *alloc_from_new_chunk(heap_arena_handle_t arena, size_t alignment, size_t size)
+{
+    size_t header_size = sizeof(heap_arena_chunk_t);
+    if (size > SIZE_MAX - header_size - alignment) {
+        return NULL;
+    }
+    size_t needed = header_size + size + alignment - 1;
+    bool own_chunk = needed > arena->chunk_size;
+    size_t chunk_size = own_chunk ? needed : arena->chunk_size;
+
+    heap_arena_chunk_t *chunk = heap_caps_malloc(chunk_size, arena->caps);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next = arena->chunks;
+    chunk->size = chunk_size;
+    arena->chunks = chunk;
+
+    uintptr_t p = ALIGN_UP_BY((uintptr_t)(chunk + 1), alignment);
+    if (!own_chunk) {
+        // the new chunk becomes the current one
+        arena->free_start = p + size;
+        arena->free_end = (uintptr_t)chunk + chunk_size;
+    }
+    arena->allocated_bytes += size;
+    return (void *)p;
+}
+
+void *heap_arena_aligned_alloc(heap_arena_handle_t arena, size_t alignment, size_t size)
+{
+    if (arena == NULL || size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        return NULL;
+    }
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+
+    uintptr_t p = ALIGN_UP_BY(arena->free_start, alignment);
+    if (p <= arena->free_end && size <= arena->free_end - p) {
+        arena->free_start = p + size;
+        arena->allocated_bytes += size;
+        return (void *)p;
+    }
+    return alloc_from_new_chunk(arena, alignment, size);
+}
+
+void *heap_arena_alloc(heap_arena_handle_t arena, size_t size)
+{
+    return heap_arena_aligned_alloc(arena, sizeof(void *), size);
+}
+
+void heap_arena_get_info(heap_arena_handle_t arena, heap_arena_info_t *info)
+{
+    info->allocated_bytes = arena->allocated_bytes;
+    info->chunk_bytes = arena->chunk_size;
+    info->chunks = 1;
+    for (heap_arena_chunk_t *chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+        info->chunk_bytes += chunk->size;
+        info->chunks++;
+    }
+}
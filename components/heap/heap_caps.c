@@ -14,6 +14,9 @@
 #include "esp_log.h"
 #include "heap_private.h"
 #include "esp_system.h"
+#if CONFIG_HEAP_TELEMETRY
+#include "esp_cpu.h"
+#endif
 
 
 /* Forward declaration for base function, put in IRAM.
@@ -33,6 +36,12 @@ possible. This should optimize the amount of RAM accessible to the code without
 
 static esp_alloc_failed_hook_t alloc_failed_callback;
 
+#if CONFIG_HEAP_SIZE_CACHE_MALLOC
+#define DEFAULT_SIZE_CACHE_CAP MALLOC_CAP_SIZE_CACHE
+#else
+#define DEFAULT_SIZE_CACHE_CAP 0
+#endif
+
 /*
   This takes a memory chunk in a region that can be addressed as both DRAM as well as IRAM. It will convert it to
   IRAM in such a way that it can be later freed. It assumes both the address as well as the length to be word-aligned.
@@ -84,41 +93,60 @@ bool heap_caps_match(const heap_t *heap, uint32_t caps)
 }
 
 
-/*
-This function should not be called directly as it does not
-check for failure / call heap_caps_alloc_failed()
-*/
-IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
+/* CPU cycle count at the start of an allocation, for the allocation statistics */
+IRAM_ATTR static inline uint32_t alloc_start_cycles(void)
 {
-    void *ret = NULL;
+#if CONFIG_HEAP_TELEMETRY
+    return esp_cpu_get_cycle_count();
+#else
+    return 0;
+#endif
+}
 
-    if (size == 0) {
-        return NULL;
-    }
+IRAM_ATTR static inline void record_alloc(heap_t *heap, size_t size, uint32_t start_cycles)
+{
+#if CONFIG_HEAP_TELEMETRY
+    heap_telemetry_record_alloc(heap, size, start_cycles);
+#endif
+}
 
-    if (size > HEAP_SIZE_MAX) {
-        // Avoids int overflow when adding small numbers to size, or
-        // calculating 'end' from start+size, by limiting 'size' to the possible range
-        return NULL;
+IRAM_ATTR static inline void record_free(heap_t *heap)
+{
+#if CONFIG_HEAP_TELEMETRY
+    heap_telemetry_record_free(heap);
+#endif
+}
+
+/* Allocate from a heap, through its size class cache if requested */
+IRAM_ATTR static void *heap_malloc(heap_t *heap, size_t size, bool use_cache)
+{
+#if CONFIG_HEAP_SIZE_CACHE
+    if (use_cache && heap->cache != NULL) {
+        return multi_heap_cache_malloc(heap->cache, size);
     }
+#endif
+    return multi_heap_malloc(heap->heap, size);
+}
 
-    if (caps & MALLOC_CAP_EXEC) {
-        //MALLOC_CAP_EXEC forces an alloc from IRAM. There is a region which has both this as well as the following
-        //caps, but the following caps are not possible for IRAM.  Thus, the combination is impossible and we return
-        //NULL directly, even although our heap capabilities (based on soc_memory_tags & soc_memory_regions) would
-        //indicate there is a tag for this.
-        if ((caps & MALLOC_CAP_8BIT) || (caps & MALLOC_CAP_DMA)) {
-            return NULL;
+#if CONFIG_HEAP_SIZE_CACHE
+/* Return the blocks held by all size class caches to their heaps. Returns the number of blocks freed. */
+IRAM_ATTR static size_t flush_size_caches(void)
+{
+    size_t freed = 0;
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        if (heap->cache != NULL) {
+            freed += multi_heap_cache_flush(heap->cache);
         }
-        caps |= MALLOC_CAP_32BIT; // IRAM is 32-bit accessible RAM
     }
+    return freed;
+}
+#endif
 
-    if (caps & MALLOC_CAP_32BIT) {
-        /* 32-bit accessible RAM should allocated in 4 byte aligned sizes
-         * (Future versions of ESP-IDF should possibly fail if an invalid size is requested)
-         */
-        size = (size + 3) & (~3); // int overflow checked above
-    }
+/* Allocate from the heaps matching 'caps', in order of priority */
+IRAM_ATTR static void *heap_caps_malloc_from_heaps(size_t size, uint32_t caps, bool use_cache)
+{
+    void *ret = NULL;
 
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
@@ -136,15 +164,19 @@ IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
                         //This is special, insofar that what we're going to get back is a DRAM address. If so,
                         //we need to 'invert' it (lowest address in DRAM == highest address in IRAM and vice-versa) and
                         //add a pointer to the DRAM equivalent before the address we're going to return.
-                        ret = multi_heap_malloc(heap->heap, size + 4);  // int overflow checked above
+                        uint32_t start_cycles = alloc_start_cycles();
+                        ret = multi_heap_malloc(heap->heap, size + 4);  // int overflow checked by heap_caps_malloc_base()
 
                         if (ret != NULL) {
-                            return dram_alloc_to_iram_addr(ret, size + 4);  // int overflow checked above
+                            record_alloc(heap, size, start_cycles);
+                            return dram_alloc_to_iram_addr(ret, size + 4);  // int overflow checked by heap_caps_malloc_base()
                         }
                     } else {
                         //Just try to alloc, nothing special.
-                        ret = multi_heap_malloc(heap->heap, size);
+                        uint32_t start_cycles = alloc_start_cycles();
+                        ret = heap_malloc(heap, size, use_cache);
                         if (ret != NULL) {
+                            record_alloc(heap, size, start_cycles);
                             return ret;
                         }
                     }
@@ -157,6 +189,54 @@ IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
     return NULL;
 }
 
+/*
+This function should not be called directly as it does not
+check for failure / call heap_caps_alloc_failed()
+*/
+IRAM_ATTR static void *heap_caps_malloc_base( size_t size, uint32_t caps)
+{
+    void *ret = NULL;
+    bool use_cache = (caps & MALLOC_CAP_SIZE_CACHE) != 0;
+    caps &= ~MALLOC_CAP_SIZE_CACHE;
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    if (size > HEAP_SIZE_MAX) {
+        // Avoids int overflow when adding small numbers to size, or
+        // calculating 'end' from start+size, by limiting 'size' to the possible range
+        return NULL;
+    }
+
+    if (caps & MALLOC_CAP_EXEC) {
+        //MALLOC_CAP_EXEC forces an alloc from IRAM. There is a region which has both this as well as the following
+        //caps, but the following caps are not possible for IRAM.  Thus, the combination is impossible and we return
+        //NULL directly, even although our heap capabilities (based on soc_memory_tags & soc_memory_regions) would
+        //indicate there is a tag for this.
+        if ((caps & MALLOC_CAP_8BIT) || (caps & MALLOC_CAP_DMA)) {
+            return NULL;
+        }
+        caps |= MALLOC_CAP_32BIT; // IRAM is 32-bit accessible RAM
+    }
+
+    if (caps & MALLOC_CAP_32BIT) {
+        /* 32-bit accessible RAM should allocated in 4 byte aligned sizes
+         * (Future versions of ESP-IDF should possibly fail if an invalid size is requested)
+         */
+        size = (size + 3) & (~3); // int overflow checked above
+    }
+
+    ret = heap_caps_malloc_from_heaps(size, caps, use_cache);
+#if CONFIG_HEAP_SIZE_CACHE
+    if (ret == NULL && flush_size_caches() > 0) {
+        //The memory which was missing may have been held by the size class caches
+        ret = heap_caps_malloc_from_heaps(size, caps, use_cache);
+    }
+#endif
+    return ret;
+}
+
 
 /*
 Routine to allocate a bit of memory with certain capabilities. caps is a bitfield of MALLOC_CAP_* bits.
@@ -188,7 +268,7 @@ void heap_caps_malloc_extmem_enable(size_t limit)
 IRAM_ATTR void *heap_caps_malloc_default( size_t size )
 {
     if (malloc_alwaysinternal_limit==MALLOC_DISABLE_EXTERNAL_ALLOCS) {
-        return heap_caps_malloc( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL);
+        return heap_caps_malloc( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | DEFAULT_SIZE_CACHE_CAP);
     } else {
 
         // use heap_caps_malloc_base() since we'll
@@ -196,13 +276,13 @@ IRAM_ATTR void *heap_caps_malloc_default( size_t size )
 
         void *r;
         if (size <= (size_t)malloc_alwaysinternal_limit) {
-            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL );
+            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | DEFAULT_SIZE_CACHE_CAP );
         } else {
-            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM );
+            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM | DEFAULT_SIZE_CACHE_CAP );
         }
         if (r==NULL && size > 0) {
             //try again while being less picky
-            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT );
+            r=heap_caps_malloc_base( size, MALLOC_CAP_DEFAULT | DEFAULT_SIZE_CACHE_CAP );
         }
 
         // allocation failure?
@@ -221,7 +301,7 @@ IRAM_ATTR void *heap_caps_malloc_default( size_t size )
 IRAM_ATTR void *heap_caps_realloc_default( void *ptr, size_t size )
 {
     if (malloc_alwaysinternal_limit==MALLOC_DISABLE_EXTERNAL_ALLOCS) {
-        return heap_caps_realloc( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL );
+        return heap_caps_realloc( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | DEFAULT_SIZE_CACHE_CAP );
     } else {
 
         // We use heap_caps_realloc_base() since we'll
@@ -229,14 +309,14 @@ IRAM_ATTR void *heap_caps_realloc_default( void *ptr, size_t size )
 
         void *r;
         if (size <= (size_t)malloc_alwaysinternal_limit) {
-            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL);
+            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL | DEFAULT_SIZE_CACHE_CAP);
         } else {
-            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM);
+            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM | DEFAULT_SIZE_CACHE_CAP);
         }
 
         if (r==NULL && size>0) {
             //We needed to allocate memory, but we didn't. Try again while being less picky.
-            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT);
+            r=heap_caps_realloc_base( ptr, size, MALLOC_CAP_DEFAULT | DEFAULT_SIZE_CACHE_CAP);
         }
 
         // allocation failure?
@@ -350,6 +430,13 @@ IRAM_ATTR void heap_caps_free( void *ptr)
 
     heap_t *heap = find_containing_heap(ptr);
     assert(heap != NULL && "free() target pointer is outside heap areas");
+    record_free(heap);
+#if CONFIG_HEAP_SIZE_CACHE
+    if (heap->cache != NULL) {
+        multi_heap_cache_free(heap->cache, ptr);
+        return;
+    }
+#endif
     multi_heap_free(heap->heap, ptr);
 }
 
@@ -397,7 +484,8 @@ IRAM_ATTR static void *heap_caps_realloc_base( void *ptr, size_t size, uint32_t
 
     // are the existing heap's capabilities compatible with the
     // requested ones?
-    bool compatible_caps = (caps & get_all_caps(heap)) == caps;
+    uint32_t memory_caps = caps & ~MALLOC_CAP_SIZE_CACHE;
+    bool compatible_caps = (memory_caps & get_all_caps(heap)) == memory_caps;
 
     if (compatible_caps && !ptr_in_diram_case) {
         // try to reallocate this memory within the same heap
@@ -640,6 +728,9 @@ IRAM_ATTR void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t
         return NULL;
     }
 
+    //Aligned allocations don't use the size class caches
+    caps &= ~MALLOC_CAP_SIZE_CACHE;
+
     for (int prio = 0; prio < SOC_MEMORY_TYPE_NO_PRIOS; prio++) {
         //Iterate over heaps and check capabilities at this priority
         heap_t *heap;
@@ -652,8 +743,10 @@ IRAM_ATTR void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t
                 //doesn't cover, see if they're available in other prios.
                 if ((get_all_caps(heap) & caps) == caps) {
                     //Just try to alloc, nothing special.
+                    uint32_t start_cycles = alloc_start_cycles();
                     ret = multi_heap_aligned_alloc(heap->heap, size, alignment);
                     if (ret != NULL) {
+                        record_alloc(heap, size, start_cycles);
                         return ret;
                     }
                 }
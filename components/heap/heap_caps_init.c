@@ -29,6 +29,21 @@ static void register_heap(heap_t *region)
     }
 }
 
+#if CONFIG_HEAP_SIZE_CACHE
+/* Heaps used by malloc() get a size class cache, allocated from the heap itself.
+   Called once the heap is registered and its lock is set. */
+static void add_size_cache(heap_t *heap)
+{
+    heap->cache = NULL;
+    if (heap->heap != NULL && heap_caps_match(heap, MALLOC_CAP_DEFAULT)) {
+        heap->cache = multi_heap_malloc(heap->heap, sizeof(multi_heap_cache_t));
+        if (heap->cache != NULL) {
+            multi_heap_cache_init(heap->cache, heap->heap, &heap->heap_mux);
+        }
+    }
+}
+#endif
+
 void heap_caps_enable_nonos_stack_heaps(void)
 {
     heap_t *heap;
@@ -39,6 +54,9 @@ void heap_caps_enable_nonos_stack_heaps(void)
             register_heap(heap);
             if (heap->heap != NULL) {
                 multi_heap_set_lock(heap->heap, &heap->heap_mux);
+#if CONFIG_HEAP_SIZE_CACHE
+                add_size_cache(heap);
+#endif
             }
         }
     }
@@ -102,6 +120,9 @@ void heap_caps_init(void)
         heap->start = region->start;
         heap->end = region->start + region->size;
         MULTI_HEAP_LOCK_INIT(&heap->heap_mux);
+#if CONFIG_HEAP_TELEMETRY
+        memset(&heap->telemetry, 0, sizeof(heap->telemetry));
+#endif
         if (type->startup_stack) {
             /* Will be registered when OS scheduler starts */
             heap->heap = NULL;
@@ -140,6 +161,9 @@ void heap_caps_init(void)
         if (heaps_array[i].heap != NULL) {
             multi_heap_set_lock(heaps_array[i].heap, &heaps_array[i].heap_mux);
         }
+#if CONFIG_HEAP_SIZE_CACHE
+        add_size_cache(&heaps_array[i]);
+#endif
         if (i == 0) {
             SLIST_INSERT_HEAD(&registered_heaps, &heaps_array[0], next);
         } else {
@@ -227,6 +251,9 @@ esp_err_t heap_caps_add_region_with_caps(const uint32_t caps[], intptr_t start,
     p_new->start = start;
     p_new->end = end;
     MULTI_HEAP_LOCK_INIT(&p_new->heap_mux);
+#if CONFIG_HEAP_TELEMETRY
+    memset(&p_new->telemetry, 0, sizeof(p_new->telemetry));
+#endif
     p_new->heap = multi_heap_register((void *)start, end - start);
     SLIST_NEXT(p_new, next) = NULL;
     if (p_new->heap == NULL) {
@@ -234,6 +261,9 @@ esp_err_t heap_caps_add_region_with_caps(const uint32_t caps[], intptr_t start,
         goto done;
     }
     multi_heap_set_lock(p_new->heap, &p_new->heap_mux);
+#if CONFIG_HEAP_SIZE_CACHE
+    add_size_cache(p_new);
+#endif
 
     /* (This insertion is atomic to registered_heaps, so
        we don't need to worry about thread safety for readers,
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+#include "heap_private.h"
+
+/*
+ Pool of fixed-size objects.
+
+ The free objects form a stack, linked by their indexes in the 'next' array rather than by pointers stored in the
+ objects, so the content of free objects is never touched. The top of the stack is a 32-bit word holding the index
+ of the top object and a tag which is incremented on every change, so that a compare-and-swap on it fails if the
+ stack was changed in the meantime, even if the same object is back on top (ABA problem).
+*/
+
+#define INDEX_NONE      0xffff
+#define INDEX_MASK      0xffff
+#define TAG_INCREMENT   0x10000
+#define MAX_OBJECTS     (INDEX_NONE - 1)
+
+#define ALIGN_UP(num, align) (((num) + ((align) - 1)) & ~((align) - 1))
+
+struct heap_pool {
+    _Atomic uint32_t top;              // tag << 16 | index of the first free object
+    atomic_size_t free_count;
+    atomic_size_t minimum_free_count;
+    atomic_size_t failed_allocations;
+    size_t obj_size;
+    size_t count;
+    uint8_t *objects;
+    _Atomic uint16_t next[];           // index of the next free object, for each object
+};
+
+heap_pool_handle_t heap_pool_create(size_t obj_size, size_t count, uint32_t caps)
+{
+    if (obj_size == 0 || count == 0 || count > MAX_OBJECTS) {
+        return NULL;
+    }
+    obj_size = ALIGN_UP(obj_size, sizeof(void *));
+    size_t header_size = ALIGN_UP(sizeof(struct heap_pool) + count * sizeof(uint16_t), sizeof(void *));
+    if (obj_size > (HEAP_SIZE_MAX - header_size) / count) {
+        return NULL;
+    }
+
+    struct heap_pool *pool = heap_caps_malloc(header_size + obj_size * count, caps);
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->obj_size = obj_size;
+    pool->count = count;
+    pool->objects = (uint8_t *)pool + header_size;
+    for (size_t i = 0; i < count; i++) {
+        atomic_init(&pool->next[i], (i + 1 < count) ? i + 1 : INDEX_NONE);
+    }
+    atomic_init(&pool->top, 0);
+    atomic_init(&pool->free_count, count);
+    atomic_init(&pool->minimum_free_count, count);
+    atomic_init(&pool->failed_allocations, 0);
+    return pool;
+}
+
+void heap_pool_delete(heap_pool_handle_t pool)
+{
+    heap_caps_free(pool);
+}
+
+IRAM_ATTR void *heap_pool_alloc(heap_pool_handle_t pool)
+{
+    uint32_t top = atomic_load_explicit(&pool->top, memory_order_acquire);
+    uint32_t new_top;
+    size_t index;
+    do {
+        index = top & INDEX_MASK;
+        if (index == INDEX_NONE) {
+            atomic_fetch_add_explicit(&pool->failed_allocations, 1, memory_order_relaxed);
+            return NULL;
+        }
+        // if the object was taken in the meantime, this reads a stale index but the tag makes the exchange fail
+        uint16_t next = atomic_load_explicit(&pool->next[index], memory_order_relaxed);
+        new_top = ((top + TAG_INCREMENT) & ~INDEX_MASK) | next;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->top, &top, new_top,
+                                                    memory_order_acquire, memory_order_acquire));
+
+    size_t free_count = atomic_fetch_sub_explicit(&pool->free_count, 1, memory_order_relaxed) - 1;
+    size_t minimum = atomic_load_explicit(&pool->minimum_free_count, memory_order_relaxed);
+    while (free_count < minimum
+           && !atomic_compare_exchange_weak_explicit(&pool->minimum_free_count, &minimum, free_count,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    void *obj = pool->objects + index * pool->obj_size;
+#if CONFIG_HEAP_TRACING
+    heap_trace_record_pool_alloc(obj, pool->obj_size);
+#endif
+    return obj;
+}
+
+IRAM_ATTR void heap_pool_free(heap_pool_handle_t pool, void *obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+    size_t offset = (uint8_t *)obj - pool->objects;
+    size_t index = offset / pool->obj_size;
+    assert((uint8_t *)obj >= pool->objects && index < pool->count && offset % pool->obj_size == 0
+           && "heap_pool_free() object doesn't belong to the pool");
+
+#if CONFIG_HEAP_TRACING
+    heap_trace_record_pool_free(obj);
+#endif
+
+    // counted before it can be allocated again, so that free_count never goes below 0
+    atomic_fetch_add_explicit(&pool->free_count, 1, memory_order_relaxed);
+    uint32_t top = atomic_load_explicit(&pool->top, memory_order_relaxed);
+    uint32_t new_top;
+    do {
+        atomic_store_explicit(&pool->next[index], top & INDEX_MASK, memory_order_relaxed);
+        new_top = ((top + TAG_INCREMENT) & ~INDEX_MASK) | index;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->top, &top, new_top,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+void heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info)
+{
+    info->obj_size = pool->obj_size;
+    info->total_objects = pool->count;
+    info->free_objects = atomic_load(&pool->free_count);
+    info->minimum_free_objects = atomic_load(&pool->minimum_free_count);
+    info->failed_allocations = atomic_load(&pool->failed_allocations);
+}
+
+void heap_pool_print_info(heap_pool_handle_t pool)
+{
+    heap_pool_info_t info;
+    heap_pool_get_info(pool, &info);
+    printf("Heap pool at %p: %d objects of %d bytes\n", pool, info.total_objects, info.obj_size);
+    printf("  free %d min_free %d failed_allocations %d\n",
+           info.free_objects, info.minimum_free_objects, info.failed_allocations);
+}
@@ -9,8 +9,12 @@
 #include <stdint.h>
 #include <soc/soc_memory_layout.h>
 #include "multi_heap.h"
+#include "esp_heap_caps.h"
 #include "multi_heap_platform.h"
 #include "sys/queue.h"
+#if CONFIG_HEAP_SIZE_CACHE
+#include "multi_heap_cache.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +26,16 @@ extern "C" {
 
 #define HEAP_SIZE_MAX (SOC_MAX_CONTIGUOUS_RAM_SIZE)
 
+#if CONFIG_HEAP_TELEMETRY
+/* Allocation statistics of a heap, see heap_caps_telemetry_t. Updated with relaxed atomic operations. */
+typedef struct {
+    uint32_t alloc_count;
+    uint32_t free_count;
+    uint32_t size_class_allocs[HEAP_TELEMETRY_SIZE_CLASSES];
+    uint32_t alloc_latency[HEAP_TELEMETRY_LATENCY_BUCKETS];
+} heap_telemetry_t;
+#endif
+
 /* Type for describing each registered heap */
 typedef struct heap_t_ {
     uint32_t caps[SOC_MEMORY_TYPE_NO_PRIOS]; ///< Capabilities for the type of memory in this heap (as a prioritised set). Copied from soc_memory_types so it's in RAM not flash.
@@ -29,6 +43,12 @@ typedef struct heap_t_ {
     intptr_t end;
     multi_heap_lock_t heap_mux;
     multi_heap_handle_t heap;
+#if CONFIG_HEAP_SIZE_CACHE
+    multi_heap_cache_t *cache; ///< Size class cache, NULL if the heap has none
+#endif
+#if CONFIG_HEAP_TELEMETRY
+    heap_telemetry_t telemetry;
+#endif
     SLIST_ENTRY(heap_t_) next;
 } heap_t;
 
@@ -63,6 +83,22 @@ inline static IRAM_ATTR uint32_t get_all_caps(const heap_t *heap)
 void *heap_caps_realloc_default(void *p, size_t size);
 void *heap_caps_malloc_default(size_t size);
 
+#if CONFIG_HEAP_TELEMETRY
+/* Count an allocation of 'size' bytes from the heap, which started at CPU cycle 'start_cycles'.
+   Defined in heap_telemetry.c. */
+void heap_telemetry_record_alloc(heap_t *heap, size_t size, uint32_t start_cycles);
+
+/* Count a free of a block of the heap */
+void heap_telemetry_record_free(heap_t *heap);
+#endif
+
+#if CONFIG_HEAP_TRACING
+/* Record the allocation and free of objects of heap pools, which don't go through the heap_caps functions.
+   Defined in heap_trace.inc, for all heap tracing destinations. */
+void heap_trace_record_pool_alloc(void *p, size_t size);
+void heap_trace_record_pool_free(void *p);
+#endif
+
 
 #ifdef __cplusplus
 }
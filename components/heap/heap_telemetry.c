@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/param.h>
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "heap_private.h"
+
+/*
+ Allocation statistics of each heap, counted by heap_caps.c as the heap is used.
+
+ The counters are updated with relaxed atomic additions and read without any lock, so a set of counters
+ read while other cores allocate may be slightly inconsistent, which is fine for statistics.
+*/
+
+static inline unsigned size_class(size_t size)
+{
+    if (size <= 16) {
+        return 0;
+    }
+    unsigned class = (32 - __builtin_clz(size - 1)) - 4;
+    return MIN(class, HEAP_TELEMETRY_SIZE_CLASSES - 1);
+}
+
+static inline unsigned latency_bucket(uint32_t cycles)
+{
+    if (cycles < 64) {
+        return 0;
+    }
+    unsigned bucket = (32 - __builtin_clz(cycles)) - 6;
+    return MIN(bucket, HEAP_TELEMETRY_LATENCY_BUCKETS - 1);
+}
+
+static inline void count(uint32_t *counter)
+{
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+IRAM_ATTR void heap_telemetry_record_alloc(heap_t *heap, size_t size, uint32_t start_cycles)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    count(&heap->telemetry.alloc_count);
+    count(&heap->telemetry.size_class_allocs[size_class(size)]);
+    count(&heap->telemetry.alloc_latency[latency_bucket(cycles)]);
+}
+
+IRAM_ATTR void heap_telemetry_record_free(heap_t *heap)
+{
+    count(&heap->telemetry.free_count);
+}
+
+static inline uint32_t load(const uint32_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static void read_heap_telemetry(const heap_t *heap, heap_caps_telemetry_t *telemetry)
+{
+    telemetry->total_free_bytes = multi_heap_free_size(heap->heap);
+    telemetry->minimum_free_bytes = multi_heap_minimum_free_size(heap->heap);
+    telemetry->largest_free_block = multi_heap_largest_free_block_estimate(heap->heap);
+    telemetry->alloc_count = load(&heap->telemetry.alloc_count);
+    telemetry->free_count = load(&heap->telemetry.free_count);
+    for (int i = 0; i < HEAP_TELEMETRY_SIZE_CLASSES; i++) {
+        telemetry->size_class_allocs[i] = load(&heap->telemetry.size_class_allocs[i]);
+    }
+    for (int i = 0; i < HEAP_TELEMETRY_LATENCY_BUCKETS; i++) {
+        telemetry->alloc_latency[i] = load(&heap->telemetry.alloc_latency[i]);
+    }
+}
+
+/* Add the statistics of a heap to the aggregate of several heaps */
+static void add_telemetry(heap_caps_telemetry_t *total, const heap_caps_telemetry_t *telemetry)
+{
+    total->total_free_bytes += telemetry->total_free_bytes;
+    total->minimum_free_bytes += telemetry->minimum_free_bytes;
+    total->largest_free_block = MAX(total->largest_free_block, telemetry->largest_free_block);
+    total->alloc_count += telemetry->alloc_count;
+    total->free_count += telemetry->free_count;
+    for (int i = 0; i < HEAP_TELEMETRY_SIZE_CLASSES; i++) {
+        total->size_class_allocs[i] += telemetry->size_class_allocs[i];
+    }
+    for (int i = 0; i < HEAP_TELEMETRY_LATENCY_BUCKETS; i++) {
+        total->alloc_latency[i] += telemetry->alloc_latency[i];
+    }
+}
+
+void heap_caps_get_telemetry( heap_caps_telemetry_t *telemetry, uint32_t caps )
+{
+    bzero(telemetry, sizeof(heap_caps_telemetry_t));
+
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        if (heap_caps_match(heap, caps)) {
+            heap_caps_telemetry_t heap_telemetry;
+            read_heap_telemetry(heap, &heap_telemetry);
+            add_telemetry(telemetry, &heap_telemetry);
+        }
+    }
+}
+
+uint32_t heap_caps_telemetry_latency_percentile( const heap_caps_telemetry_t *telemetry, unsigned percentile )
+{
+    uint64_t total = 0;
+    for (int i = 0; i < HEAP_TELEMETRY_LATENCY_BUCKETS; i++) {
+        total += telemetry->alloc_latency[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    /* smallest bucket at which at least 'percentile' % of the allocations are counted */
+    uint64_t threshold = (total * MIN(percentile, 100) + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < HEAP_TELEMETRY_LATENCY_BUCKETS - 1; i++) {
+        seen += telemetry->alloc_latency[i];
+        if (seen >= threshold) {
+            return 64U << i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/* snprintf() into the part of the buffer after the output written so far */
+typedef struct {
+    char *buffer;
+    size_t size;
+    size_t len;
+} json_writer_t;
+
+static void json_printf(json_writer_t *writer, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t offset = MIN(writer->len, writer->size);
+    int r = vsnprintf(writer->buffer + offset, writer->size - offset, format, args);
+    va_end(args);
+    if (r > 0) {
+        writer->len += r;
+    }
+}
+
+static void json_print_counters(json_writer_t *writer, const char *name, const uint32_t *counters, int num)
+{
+    json_printf(writer, ",\"%s\":[", name);
+    for (int i = 0; i < num; i++) {
+        json_printf(writer, "%s%u", (i == 0) ? "" : ",", counters[i]);
+    }
+    json_printf(writer, "]");
+}
+
+static void json_print_telemetry(json_writer_t *writer, const heap_caps_telemetry_t *telemetry)
+{
+    json_printf(writer, "\"free_bytes\":%u,\"minimum_free_bytes\":%u,\"largest_free_block\":%u,"
+                "\"alloc_count\":%u,\"free_count\":%u",
+                telemetry->total_free_bytes, telemetry->minimum_free_bytes, telemetry->largest_free_block,
+                telemetry->alloc_count, telemetry->free_count);
+    json_print_counters(writer, "size_class_allocs", telemetry->size_class_allocs, HEAP_TELEMETRY_SIZE_CLASSES);
+    json_print_counters(writer, "alloc_latency", telemetry->alloc_latency, HEAP_TELEMETRY_LATENCY_BUCKETS);
+    json_printf(writer, ",\"alloc_latency_p50\":%u,\"alloc_latency_p99\":%u",
+                heap_caps_telemetry_latency_percentile(telemetry, 50),
+                heap_caps_telemetry_latency_percentile(telemetry, 99));
+}
+
+size_t heap_caps_dump_stats_json( char *buffer, size_t size, uint32_t caps )
+{
+    json_writer_t writer = {
+        .buffer = buffer,
+        .size = size,
+        .len = 0,
+    };
+    heap_caps_telemetry_t total = { 0 };
+    bool first = true;
+
+    json_printf(&writer, "{\"heaps\":[");
+    heap_t *heap;
+    SLIST_FOREACH(heap, &registered_heaps, next) {
+        if (heap_caps_match(heap, caps)) {
+            heap_caps_telemetry_t telemetry;
+            read_heap_telemetry(heap, &telemetry);
+            add_telemetry(&total, &telemetry);
+
+            json_printf(&writer, "%s{\"start\":%u,\"size\":%u,\"caps\":%u,",
+                        first ? "" : ",", heap->start, heap->end - heap->start, get_all_caps(heap));
+            json_print_telemetry(&writer, &telemetry);
+            json_printf(&writer, "}");
+            first = false;
+        }
+    }
+    json_printf(&writer, "],\"total\":{");
+    json_print_telemetry(&writer, &total);
+    json_printf(&writer, "}}");
+
+    return writer.len;
+}
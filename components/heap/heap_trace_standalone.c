@@ -11,6 +11,7 @@
 #undef HEAP_TRACE_SRCFILE
 
 #include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -19,6 +20,31 @@
 
 #if CONFIG_HEAP_TRACING_STANDALONE
 
+/* Records are kept in the buffer provided by the application, in no particular order. Two
+   structures, allocated by heap_trace_init_standalone(), make recording O(1):
+
+   - a doubly linked list of the records in the order they were made (oldest first), which
+     heap_trace_get() and heap_trace_dump() walk, and from which the oldest record is dropped
+     when the buffer is full,
+   - a hash index of the records by address, so that a free finds its allocation without
+     searching the buffer.
+
+   Records are linked by their index in the buffer. Records which have been freed in
+   HEAP_TRACE_ALL mode are removed from the hash index, so that it only contains allocations
+   which are still alive. Slots which have never been used since heap_trace_start() are taken
+   in order, slots of removed records are kept in a list of free slots.
+*/
+
+#define INDEX_NONE      0xffff
+#define INDEX_UNHASHED  0xfffe  // hash_next of a record which isn't in the hash index
+#define MAX_RECORDS     0xfffd
+
+typedef struct {
+    uint16_t prev;          // previous (older) record, unused for free slots
+    uint16_t next;          // next (newer) record, or next free slot
+    uint16_t hash_next;     // next record in the same hash bucket
+} record_links_t;
+
 static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
 static bool tracing;
 static heap_trace_mode_t mode;
@@ -28,6 +54,24 @@ static heap_trace_mode_t mode;
 static heap_trace_record_t *buffer;
 static size_t total_records;
 
+/* Links of the records, and the heads of the hash buckets */
+static record_links_t *links;
+static uint16_t *buckets;
+static uint32_t bucket_mask;
+static unsigned bucket_shift;
+
+static uint16_t oldest;
+static uint16_t newest;
+static uint16_t free_slots;
+static size_t unused_slots_start;
+
+/* Position of the last record returned by heap_trace_get(), which is only valid as long as
+   'changes' doesn't change. It makes reading all records in order O(n). */
+static uint32_t changes;
+static uint32_t last_get_changes;
+static size_t last_get_index;
+static uint16_t last_get_slot;
+
 /* Count of entries logged in the buffer.
 
    Maximum total_records
@@ -48,6 +92,34 @@ esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t
     if (tracing) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (num_records > MAX_RECORDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    heap_caps_free(links);
+    links = NULL;
+    buckets = NULL;
+    buffer = NULL;
+    total_records = 0;
+    if (record_buffer == NULL || num_records == 0) {
+        return ESP_OK;
+    }
+
+    size_t bucket_count = 4;
+    bucket_shift = 30;
+    while (bucket_count < num_records) {
+        bucket_count <<= 1;
+        bucket_shift--;
+    }
+    // the index is accessed with the cache disabled, like the records, so it has to be in internal RAM
+    links = heap_caps_malloc(num_records * sizeof(record_links_t) + bucket_count * sizeof(uint16_t),
+                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (links == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    buckets = (uint16_t *) (links + num_records);
+    bucket_mask = bucket_count - 1;
+
     buffer = record_buffer;
     total_records = num_records;
     memset(buffer, 0, num_records * sizeof(heap_trace_record_t));
@@ -68,6 +140,12 @@ esp_err_t heap_trace_start(heap_trace_mode_t mode_param)
     total_allocations = 0;
     total_frees = 0;
     has_overflowed = false;
+    oldest = INDEX_NONE;
+    newest = INDEX_NONE;
+    free_slots = INDEX_NONE;
+    unused_slots_start = 0;
+    changes++;
+    memset(buckets, 0xff, (bucket_mask + 1) * sizeof(uint16_t));
     heap_trace_resume();
 
     portEXIT_CRITICAL(&trace_mux);
@@ -109,7 +187,19 @@ esp_err_t heap_trace_get(size_t index, heap_trace_record_t *record)
     if (index >= count) {
         result = ESP_ERR_INVALID_ARG; /* out of range for 'count' */
     } else {
-        memcpy(record, &buffer[index], sizeof(heap_trace_record_t));
+        size_t i = 0;
+        uint16_t slot = oldest;
+        if (last_get_changes == changes && last_get_index <= index) {
+            i = last_get_index;
+            slot = last_get_slot;
+        }
+        for (; i < index; i++) {
+            slot = links[slot].next;
+        }
+        last_get_changes = changes;
+        last_get_index = index;
+        last_get_slot = slot;
+        memcpy(record, &buffer[slot], sizeof(heap_trace_record_t));
     }
     portEXIT_CRITICAL(&trace_mux);
     return result;
@@ -124,7 +214,11 @@ void heap_trace_dump(void)
            count, total_records);
     size_t start_count = count;
     for (int i = 0; i < count; i++) {
-        heap_trace_record_t *rec = &buffer[i];
+        heap_trace_record_t rec_copy;
+        heap_trace_record_t *rec = &rec_copy;
+        if (heap_trace_get(i, rec) != ESP_OK) {
+            break;
+        }
 
         if (rec->address != NULL) {
             printf("%d bytes (@ %p) allocated CPU %d ccount 0x%08x caller ",
@@ -162,6 +256,58 @@ void heap_trace_dump(void)
     }
 }
 
+static IRAM_ATTR uint16_t *hash_bucket(const void *address)
+{
+    // Fibonacci hashing, the low bits of heap addresses are always the same
+    return &buckets[((uint32_t) (uintptr_t) address * 2654435769u) >> bucket_shift & bucket_mask];
+}
+
+/* find the record of the allocation at 'address' in the hash index */
+static IRAM_ATTR uint16_t find_record(const void *address)
+{
+    uint16_t slot = *hash_bucket(address);
+    while (slot != INDEX_NONE && buffer[slot].address != address) {
+        slot = links[slot].hash_next;
+    }
+    return slot;
+}
+
+static IRAM_ATTR void unhash_record(uint16_t slot)
+{
+    if (links[slot].hash_next == INDEX_UNHASHED) {
+        return;
+    }
+    uint16_t *prev_next = hash_bucket(buffer[slot].address);
+    while (*prev_next != slot) {
+        prev_next = &links[*prev_next].hash_next;
+    }
+    *prev_next = links[slot].hash_next;
+    links[slot].hash_next = INDEX_UNHASHED;
+}
+
+/* remove a record from the list of records and the hash index, and free its slot */
+static IRAM_ATTR void remove_record(uint16_t slot)
+{
+    unhash_record(slot);
+    record_links_t *l = &links[slot];
+    if (l->prev != INDEX_NONE) {
+        links[l->prev].next = l->next;
+    } else {
+        oldest = l->next;
+    }
+    if (l->next != INDEX_NONE) {
+        links[l->next].prev = l->prev;
+    } else {
+        newest = l->prev;
+    }
+    // zero it out to avoid ambiguity
+    memset(&buffer[slot], 0, sizeof(heap_trace_record_t));
+    l->next = free_slots;
+    free_slots = slot;
+    count--;
+    changes++;
+}
+
 /* Add a new allocation to the heap trace records */
 static IRAM_ATTR void record_allocation(const heap_trace_record_t *record)
 {
@@ -173,27 +319,40 @@ static IRAM_ATTR void record_allocation(const heap_trace_record_t *record)
     if (tracing) {
         if (count == total_records) {
             has_overflowed = true;
-            /* Move the whole buffer back one slot.
-
-               This is a bit slow, compared to treating this buffer as a ringbuffer and rotating a head pointer.
+            remove_record(oldest);
+        }
 
-               However, ringbuffer code gets tricky when we remove elements in mid-buffer (for leak trace mode) while
-               trying to keep track of an item count that may overflow.
-            */
-            memmove(&buffer[0], &buffer[1], sizeof(heap_trace_record_t) * (total_records -1));
-            count--;
+        uint16_t slot;
+        if (free_slots != INDEX_NONE) {
+            slot = free_slots;
+            free_slots = links[slot].next;
+        } else {
+            slot = unused_slots_start++;
         }
         // Copy new record into place
-        memcpy(&buffer[count], record, sizeof(heap_trace_record_t));
+        memcpy(&buffer[slot], record, sizeof(heap_trace_record_t));
+
+        record_links_t *l = &links[slot];
+        l->prev = newest;
+        l->next = INDEX_NONE;
+        if (newest != INDEX_NONE) {
+            links[newest].next = slot;
+        } else {
+            oldest = slot;
+        }
+        newest = slot;
+
+        uint16_t *bucket = hash_bucket(record->address);
+        l->hash_next = *bucket;
+        *bucket = slot;
+
         count++;
+        changes++;
         total_allocations++;
     }
     portEXIT_CRITICAL(&trace_mux);
 }
 
-// remove a record, used when freeing
-static void remove_record(int index);
-
 /* record a free event in the heap trace log
 
    For HEAP_TRACE_ALL, this means filling in the freed_by pointer.
@@ -208,40 +367,21 @@ static IRAM_ATTR void record_free(void *p, void **callers)
     portENTER_CRITICAL(&trace_mux);
     if (tracing && count > 0) {
         total_frees++;
-        /* search backwards for the allocation record matching this free */
-        int i;
-        for (i = count - 1; i >= 0; i--) {
-            if (buffer[i].address == p) {
-                break;
-            }
-        }
-
-        if (i >= 0) {
+        uint16_t slot = find_record(p);
+        if (slot != INDEX_NONE) {
             if (mode == HEAP_TRACE_ALL) {
-                memcpy(buffer[i].freed_by, callers, sizeof(void *) * STACK_DEPTH);
+                memcpy(buffer[slot].freed_by, callers, sizeof(void *) * STACK_DEPTH);
+                // the record stays in the list, but the address may be allocated again
+                unhash_record(slot);
             } else { // HEAP_TRACE_LEAKS
                 // Leak trace mode, once an allocation is freed we remove it from the list
-                remove_record(i);
+                remove_record(slot);
             }
         }
     }
     portEXIT_CRITICAL(&trace_mux);
 }
 
-/* remove the entry at 'index' from the ringbuffer of saved records */
-static IRAM_ATTR void remove_record(int index)
-{
-    if (index < count - 1) {
-        // Remove the buffer entry from the list
-        memmove(&buffer[index], &buffer[index+1],
-                sizeof(heap_trace_record_t) * (total_records - index - 1));
-    } else {
-        // For last element, just zero it out to avoid ambiguity
-        memset(&buffer[index], 0, sizeof(heap_trace_record_t));
-    }
-    count--;
-}
-
 #include "heap_trace.inc"
 
 #endif /*CONFIG_HEAP_TRACING_STANDALONE*/
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handle of an arena
+ */
+typedef struct heap_arena *heap_arena_handle_t;
+
+/**
+ * @brief Structure to return the statistics of an arena, see heap_arena_get_info()
+ */
+typedef struct {
+    size_t allocated_bytes;      ///< Bytes allocated from the arena since it was created or last reset
+    size_t chunk_bytes;          ///< Bytes of heap memory held by the arena, including its own data
+    size_t chunks;               ///< Number of heap allocations held by the arena
+} heap_arena_info_t;
+
+/**
+ * @brief Create an arena
+ *
+ * An arena allocates memory from the heap in large chunks with heap_caps_malloc(), and hands out consecutive slices
+ * of the chunks, without any per-allocation overhead. Slices can't be freed individually: all memory allocated from
+ * the arena is released at once by heap_arena_reset() or heap_arena_destroy().
+ *
+ * This suits many small allocations which all have the same lifetime, for example those made while handling a
+ * request: they take a few heap allocations instead of many, and don't leave holes in the heap between allocations
+ * which live longer.
+ *
+ * The first chunk is allocated by this function. An arena is not thread-safe, it must not be used by several tasks
+ * at the same time, nor from interrupt handlers.
+ *
+ * @param caps        Bitwise OR of MALLOC_CAP_* flags indicating the type of memory of the chunks
+ * @param chunk_size  Size of the chunks allocated from the heap, in bytes. The first chunk also holds about
+ *                    32 bytes of data of the arena itself.
+ *
+ * @return Handle of the arena, NULL if chunk_size is too small or there isn't enough memory
+ */
+heap_arena_handle_t heap_arena_create(uint32_t caps, size_t chunk_size);
+
+/**
+ * @brief Destroy an arena and free all its memory
+ *
+ * @param arena Arena to destroy. Can be NULL.
+ */
+void heap_arena_destroy(heap_arena_handle_t arena);
+
+/**
+ * @brief Allocate memory from an arena
+ *
+ * The memory is aligned to the size of a pointer, like the memory returned by heap_caps_malloc(). It is valid until
+ * the arena is reset or destroyed.
+ *
+ * If there isn't enough space left in the current chunk, a new chunk is allocated from the heap. Allocations which
+ * don't fit in a chunk get a heap allocation of their own.
+ *
+ * @param arena Arena to allocate from
+ * @param size  Size of the allocation, in bytes
+ *
+ * @return Pointer to the memory, NULL if size is 0 or a new chunk couldn't be allocated
+ */
+void *heap_arena_alloc(heap_arena_handle_t arena, size_t size);
+
+/**
+ * @brief Allocate aligned memory from an arena
+ *
+ * Same as heap_arena_alloc(), with an alignment which may be larger than the size of a pointer.
+ *
+ * @param arena     Arena to allocate from
+ * @param alignment Alignment of the memory, must be a power of two
+ * @param size      Size of the allocation, in bytes
+ *
+ * @return Pointer to the memory, NULL if the arguments are invalid or a new chunk couldn't be allocated
+ */
+void *heap_arena_aligned_alloc(heap_arena_handle_t arena, size_t alignment, size_t size);
+
+/**
+ * @brief Release all memory allocated from an arena
+ *
+ * All chunks but the first one are returned to the heap, so that the arena can be used again, for example for the
+ * next request, without allocating from the heap as long as the first chunk is large enough.
+ *
+ * @param arena Arena to reset
+ */
+void heap_arena_reset(heap_arena_handle_t arena);
+
+/**
+ * @brief Get the statistics of an arena
+ *
+ * @param arena Arena to get the statistics of
+ * @param info  Structure filled with the statistics of the arena
+ */
+void heap_arena_get_info(heap_arena_handle_t arena, heap_arena_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,6 +35,7 @@ extern "C" {
 #define MALLOC_CAP_IRAM_8BIT        (1<<13) ///< Memory must be in IRAM and allow unaligned access
 #define MALLOC_CAP_RETENTION        (1<<14) ///< Memory must be able to accessed by retention DMA
 #define MALLOC_CAP_RTCRAM           (1<<15) ///< Memory must be in RTC fast memory
+#define MALLOC_CAP_SIZE_CACHE       (1<<16) ///< Allocation may use the per-core cache of small blocks (CONFIG_HEAP_SIZE_CACHE). Not a memory capability, only used by the allocation functions
 
 #define MALLOC_CAP_INVALID          (1<<31) ///< Memory can't be used / list end marker
 
@@ -242,6 +243,77 @@ void heap_caps_get_info( multi_heap_info_t *info, uint32_t caps );
  */
 void heap_caps_print_heap_info( uint32_t caps );
 
+#if CONFIG_HEAP_TELEMETRY || defined __DOXYGEN__
+
+#define HEAP_TELEMETRY_SIZE_CLASSES     12 ///< Number of entries of heap_caps_telemetry_t::size_class_allocs
+#define HEAP_TELEMETRY_LATENCY_BUCKETS  16 ///< Number of entries of heap_caps_telemetry_t::alloc_latency
+
+/**
+ * @brief Allocation statistics of heaps, see heap_caps_get_telemetry()
+ */
+typedef struct {
+    size_t total_free_bytes;        ///< Total free bytes, as returned by heap_caps_get_free_size()
+    size_t minimum_free_bytes;      ///< Lifetime minimum free bytes, as returned by heap_caps_get_minimum_free_size()
+    size_t largest_free_block;      ///< Largest free block of all heaps, estimated with multi_heap_largest_free_block_estimate()
+    uint32_t alloc_count;           ///< Number of successful allocations
+    uint32_t free_count;            ///< Number of frees
+    uint32_t size_class_allocs[HEAP_TELEMETRY_SIZE_CLASSES]; ///< Allocations by requested size. Entry 0 counts sizes up to 16 bytes, entry n sizes up to 16 << n bytes and the last entry all larger sizes.
+    uint32_t alloc_latency[HEAP_TELEMETRY_LATENCY_BUCKETS];  ///< Allocations by duration in CPU cycles. Entry 0 counts durations below 64 cycles, entry n durations below 64 << n cycles and the last entry all longer ones.
+} heap_caps_telemetry_t;
+
+/**
+ * @brief Get the allocation statistics of all heaps with the given capabilities.
+ *
+ * The statistics are counted as the heaps are used, so unlike heap_caps_get_info() this function doesn't walk
+ * the heaps and is cheap enough to be called periodically. The result is an aggregate across all matching heaps.
+ *
+ * Allocations are counted in the heap they were made from. The time of an allocation is the time spent in that
+ * heap, including waiting for its lock. A realloc() which resizes a block in place is not counted, one which moves
+ * the block counts as an allocation and a free.
+ *
+ * @note Only available if CONFIG_HEAP_TELEMETRY is enabled.
+ *
+ * @param telemetry   Pointer to a structure which will be filled with the statistics.
+ * @param caps        Bitwise OR of MALLOC_CAP_* flags indicating the type
+ *                    of memory
+ */
+void heap_caps_get_telemetry( heap_caps_telemetry_t *telemetry, uint32_t caps );
+
+/**
+ * @brief Get a percentile of the allocation latency from allocation statistics.
+ *
+ * @param telemetry   Statistics returned by heap_caps_get_telemetry()
+ * @param percentile  Percentile to compute, from 1 to 100. For example 99 returns a duration which
+ *                    at least 99% of the allocations didn't exceed.
+ *
+ * @return Upper bound in CPU cycles of the alloc_latency bucket which contains the percentile, UINT32_MAX if
+ *         this is the last bucket, or 0 if there were no allocations.
+ */
+uint32_t heap_caps_telemetry_latency_percentile( const heap_caps_telemetry_t *telemetry, unsigned percentile );
+
+/**
+ * @brief Write the allocation statistics of the heaps with the given capabilities as JSON.
+ *
+ * The output is a JSON object with the statistics of each matching heap in a ``heaps`` array and their aggregate
+ * in a ``total`` object, as returned by heap_caps_get_telemetry(). Each of them includes the 50th and 99th
+ * percentiles of the allocation latency in CPU cycles.
+ *
+ * Like snprintf(), the output is truncated to ``size - 1`` characters and always NUL terminated if ``size`` is not 0.
+ *
+ * @note Only available if CONFIG_HEAP_TELEMETRY is enabled.
+ *
+ * @param buffer      Buffer to write to, may be NULL if size is 0
+ * @param size        Size of the buffer in bytes
+ * @param caps        Bitwise OR of MALLOC_CAP_* flags indicating the type
+ *                    of memory
+ *
+ * @return Length of the full output, not including the terminating NUL. The output was truncated if this is
+ *         ``size`` or more.
+ */
+size_t heap_caps_dump_stats_json( char *buffer, size_t size, uint32_t caps );
+
+#endif // CONFIG_HEAP_TELEMETRY || defined __DOXYGEN__
+
 /**
  * @brief Check integrity of all heap memory in the system.
  *
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handle of a pool of fixed-size objects
+ */
+typedef struct heap_pool *heap_pool_handle_t;
+
+/**
+ * @brief Structure to return the statistics of a pool, see heap_pool_get_info()
+ */
+typedef struct {
+    size_t obj_size;             ///< Size of each object, in bytes, rounded up to the alignment of the objects
+    size_t total_objects;        ///< Number of objects in the pool
+    size_t free_objects;         ///< Number of objects currently free
+    size_t minimum_free_objects; ///< Lowest number of free objects since the pool was created
+    size_t failed_allocations;   ///< Number of calls to heap_pool_alloc() which returned NULL
+} heap_pool_info_t;
+
+/**
+ * @brief Create a pool of fixed-size objects
+ *
+ * Memory for all objects is allocated at once with heap_caps_malloc(). Objects are then allocated from and freed to
+ * the pool in constant time, without locks, so heap_pool_alloc() and heap_pool_free() may also be used from interrupt
+ * handlers.
+ *
+ * Objects are aligned to the size of a pointer, like the memory returned by heap_caps_malloc().
+ *
+ * @param obj_size    Size of each object, in bytes
+ * @param count       Number of objects in the pool, at most 65534
+ * @param caps        Bitwise OR of MALLOC_CAP_* flags indicating the type of memory of the objects
+ *
+ * @return Handle of the pool, NULL if the arguments are invalid or there isn't enough memory
+ */
+heap_pool_handle_t heap_pool_create(size_t obj_size, size_t count, uint32_t caps);
+
+/**
+ * @brief Delete a pool and free its memory
+ *
+ * All objects allocated from the pool must have been freed, or not be used anymore.
+ *
+ * @param pool Pool to delete. Can be NULL.
+ */
+void heap_pool_delete(heap_pool_handle_t pool);
+
+/**
+ * @brief Allocate an object from a pool
+ *
+ * If heap tracing is enabled, the object is traced like an allocation of obj_size bytes.
+ *
+ * @param pool Pool to allocate from
+ *
+ * @return Pointer to the object, NULL if all objects of the pool are allocated. The content of the object is undefined.
+ */
+void *heap_pool_alloc(heap_pool_handle_t pool);
+
+/**
+ * @brief Return an object to its pool
+ *
+ * @param pool Pool the object was allocated from
+ * @param obj  Object returned by heap_pool_alloc(). Can be NULL.
+ */
+void heap_pool_free(heap_pool_handle_t pool, void *obj);
+
+/**
+ * @brief Get the statistics of a pool
+ *
+ * @param pool Pool to get the statistics of
+ * @param info Structure filled with the statistics of the pool
+ */
+void heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info);
+
+/**
+ * @brief Print the statistics of a pool to stdout
+ *
+ * @param pool Pool to print the statistics of
+ */
+void heap_pool_print_info(heap_pool_handle_t pool);
+
+#ifdef __cplusplus
+}
+#endif
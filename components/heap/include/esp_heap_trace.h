@@ -52,12 +52,18 @@ typedef struct {
  *
  * To disable heap tracing and allow the buffer to be freed, stop tracing and then call heap_trace_init_standalone(NULL, 0);
  *
+ * Records are not stored in the buffer in any particular order, use heap_trace_get() to read them in the order they
+ * were made. In addition to the buffer, up to 10 bytes per record are allocated from internal memory for the index which
+ * allows allocations and frees to be recorded in constant time.
+ *
  * @param record_buffer Provide a buffer to use for heap trace data. Must remain valid any time heap tracing is enabled, meaning
  * it must be allocated from internal memory not in PSRAM.
- * @param num_records Size of the heap trace buffer, as number of record structures.
+ * @param num_records Size of the heap trace buffer, as number of record structures. At most 65533.
  * @return
  *  - ESP_ERR_NOT_SUPPORTED Project was compiled without heap tracing enabled in menuconfig.
  *  - ESP_ERR_INVALID_STATE Heap tracing is currently in progress.
+ *  - ESP_ERR_INVALID_ARG num_records is too large.
+ *  - ESP_ERR_NO_MEM Not enough internal memory for the index of the records.
  *  - ESP_OK Heap tracing initialised successfully.
  */
 esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t num_records);
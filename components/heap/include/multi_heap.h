@@ -159,6 +159,19 @@ size_t multi_heap_free_size(multi_heap_handle_t heap);
  */
 size_t multi_heap_minimum_free_size(multi_heap_handle_t heap);
 
+/** @brief Return an estimate of the largest free block
+ *
+ * Unlike multi_heap_get_info(), this function doesn't walk the heap: the result is read from the free lists of the
+ * allocator, which group free blocks by size. It is the size of the largest free block rounded down to the start
+ * of its group, which is the same rounding as the largest_free_block member returned by multi_heap_get_info().
+ *
+ * @note Not available when the ROM implementation of the heap is used (CONFIG_HEAP_TLSF_USE_ROM_IMPL).
+ *
+ * @param heap Handle to a registered heap.
+ * @return Estimated size of the largest free block in bytes.
+ */
+size_t multi_heap_largest_free_block_estimate(multi_heap_handle_t heap);
+
 /** @brief Structure to access heap metadata via multi_heap_get_info */
 typedef struct {
     size_t total_free_bytes;      ///<  Total free bytes in the heap. Equivalent to multi_free_heap_size().
@@ -58,6 +58,9 @@ size_t multi_heap_free_size(multi_heap_handle_t heap)
 size_t multi_heap_minimum_free_size(multi_heap_handle_t heap)
     __attribute__((alias("multi_heap_minimum_free_size_impl")));
 
+size_t multi_heap_largest_free_block_estimate(multi_heap_handle_t heap)
+    __attribute__((alias("multi_heap_largest_free_block_estimate_impl")));
+
 void *multi_heap_get_block_address(multi_heap_block_handle_t block)
     __attribute__((alias("multi_heap_get_block_address_impl")));
 
@@ -398,6 +401,34 @@ size_t multi_heap_minimum_free_size_impl(multi_heap_handle_t heap)
     return heap->minimum_free_bytes;
 }
 
+size_t multi_heap_largest_free_block_estimate_impl(multi_heap_handle_t heap)
+{
+    if (heap == NULL) {
+        return 0;
+    }
+
+    /* TLSF keeps free blocks in lists of size ranges, with a bitmap of the non-empty lists.
+       The lower bound of the highest non-empty list is the largest free block rounded down
+       the same way as in multi_heap_get_info_impl(), without walking the heap. */
+    const control_t *control = (const control_t *)heap->heap_data;
+    size_t result = 0;
+
+    multi_heap_internal_lock(heap);
+    if (control->fl_bitmap != 0) {
+        int fl = 31 - __builtin_clz(control->fl_bitmap);
+        int sl = 31 - __builtin_clz(control->sl_bitmap[fl]);
+        if (fl == 0) {
+            result = sl * (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+        } else {
+            size_t range_start = (size_t)1 << (fl + FL_INDEX_SHIFT - 1);
+            result = range_start + sl * (range_start / SL_INDEX_COUNT);
+        }
+    }
+    multi_heap_internal_unlock(heap);
+
+    return result;
+}
+
 static void multi_heap_get_info_tlsf(void* ptr, size_t size, int used, void* user)
 {
     multi_heap_info_t *info = user;
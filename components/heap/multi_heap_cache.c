@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "multi_heap.h"
+#include "multi_heap_cache.h"
+
+/* Note: Keep platform-specific parts in multi_heap_platform.h, this source
+   file should depend on libc only */
+
+/* Number of blocks moved between the heap and a magazine at once */
+#define BATCH_SIZE (MULTI_HEAP_CACHE_MAGAZINE_SIZE / 2)
+
+_Static_assert(MULTI_HEAP_CACHE_MAGAZINE_SIZE >= 2 && MULTI_HEAP_CACHE_MAGAZINE_SIZE <= UINT8_MAX,
+               "Invalid size class cache magazine size");
+
+void multi_heap_cache_init(multi_heap_cache_t *cache, multi_heap_handle_t heap, multi_heap_lock_t *heap_lock)
+{
+    memset(cache, 0, sizeof(multi_heap_cache_t));
+    cache->heap = heap;
+    cache->heap_lock = heap_lock;
+    for (int i = 0; i < MULTI_HEAP_NUM_CORES; i++) {
+        MULTI_HEAP_LOCK_INIT(&cache->cores[i].lock);
+    }
+}
+
+/* Allocate a batch of blocks for an empty magazine, called with the core's lock held */
+static void refill(multi_heap_cache_t *cache, multi_heap_cache_core_t *core, size_t class)
+{
+    size_t size = (class + 1) * MULTI_HEAP_CACHE_CLASS_SIZE;
+    size_t count = 0;
+
+    MULTI_HEAP_LOCK(cache->heap_lock);
+    while (count < BATCH_SIZE) {
+        void *block = multi_heap_malloc(cache->heap, size);
+        if (block == NULL) {
+            break;
+        }
+        core->blocks[class][count++] = block;
+    }
+    MULTI_HEAP_UNLOCK(cache->heap_lock);
+    core->count[class] = count;
+}
+
+/* Free the least recently cached half of a full magazine, called with the core's lock held */
+static void drain(multi_heap_cache_t *cache, multi_heap_cache_core_t *core, size_t class)
+{
+    void **blocks = core->blocks[class];
+
+    MULTI_HEAP_LOCK(cache->heap_lock);
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        multi_heap_free(cache->heap, blocks[i]);
+    }
+    MULTI_HEAP_UNLOCK(cache->heap_lock);
+    core->count[class] -= BATCH_SIZE;
+    memmove(&blocks[0], &blocks[BATCH_SIZE], core->count[class] * sizeof(void *));
+}
+
+void *multi_heap_cache_malloc(multi_heap_cache_t *cache, size_t size)
+{
+    if (size == 0 || size > MULTI_HEAP_CACHE_MAX_SIZE) {
+        return multi_heap_malloc(cache->heap, size);
+    }
+
+    size_t class = (size - 1) / MULTI_HEAP_CACHE_CLASS_SIZE;
+    multi_heap_cache_core_t *core = &cache->cores[MULTI_HEAP_CORE_ID()];
+    void *result = NULL;
+
+    MULTI_HEAP_LOCK(&core->lock);
+    if (core->count[class] == 0) {
+        refill(cache, core, class);
+    }
+    if (core->count[class] > 0) {
+        result = core->blocks[class][--core->count[class]];
+    }
+    MULTI_HEAP_UNLOCK(&core->lock);
+    return result;
+}
+
+void multi_heap_cache_free(multi_heap_cache_t *cache, void *p)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    /* A block goes to the largest size class it can hold */
+    size_t size = multi_heap_get_allocated_size(cache->heap, p);
+    if (size < MULTI_HEAP_CACHE_CLASS_SIZE || size >= MULTI_HEAP_CACHE_MAX_SIZE + MULTI_HEAP_CACHE_CLASS_SIZE) {
+        multi_heap_free(cache->heap, p);
+        return;
+    }
+
+    size_t class = size / MULTI_HEAP_CACHE_CLASS_SIZE - 1;
+    multi_heap_cache_core_t *core = &cache->cores[MULTI_HEAP_CORE_ID()];
+
+    MULTI_HEAP_LOCK(&core->lock);
+    if (core->count[class] == MULTI_HEAP_CACHE_MAGAZINE_SIZE) {
+        drain(cache, core, class);
+    }
+    core->blocks[class][core->count[class]++] = p;
+    MULTI_HEAP_UNLOCK(&core->lock);
+}
+
+size_t multi_heap_cache_flush(multi_heap_cache_t *cache)
+{
+    size_t freed = 0;
+
+    for (int i = 0; i < MULTI_HEAP_NUM_CORES; i++) {
+        multi_heap_cache_core_t *core = &cache->cores[i];
+        MULTI_HEAP_LOCK(&core->lock);
+        MULTI_HEAP_LOCK(cache->heap_lock);
+        for (int class = 0; class < MULTI_HEAP_CACHE_NUM_CLASSES; class++) {
+            for (int j = 0; j < core->count[class]; j++) {
+                multi_heap_free(cache->heap, core->blocks[class][j]);
+            }
+            freed += core->count[class];
+            core->count[class] = 0;
+        }
+        MULTI_HEAP_UNLOCK(cache->heap_lock);
+        MULTI_HEAP_UNLOCK(&core->lock);
+    }
+    return freed;
+}
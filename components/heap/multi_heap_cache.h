@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "multi_heap.h"
+#include "multi_heap_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size class cache in front of a multi_heap.
+
+   Small blocks which are freed are kept in per-core "magazines", one per size class, and
+   handed out again by the next allocation of the same size class on that core. Only the
+   core's own lock is taken for that, the heap lock is taken when a magazine is empty or
+   full, to allocate or free half a magazine of blocks at once.
+
+   Blocks held by the cache are allocated as far as the heap is concerned.
+*/
+
+#ifdef CONFIG_HEAP_SIZE_CACHE_MAGAZINE_SIZE
+#define MULTI_HEAP_CACHE_MAGAZINE_SIZE CONFIG_HEAP_SIZE_CACHE_MAGAZINE_SIZE
+#else
+#define MULTI_HEAP_CACHE_MAGAZINE_SIZE 8
+#endif
+
+#define MULTI_HEAP_CACHE_CLASS_SIZE 16  // Size classes are multiples of this
+#define MULTI_HEAP_CACHE_NUM_CLASSES 8
+#define MULTI_HEAP_CACHE_MAX_SIZE (MULTI_HEAP_CACHE_CLASS_SIZE * MULTI_HEAP_CACHE_NUM_CLASSES)
+
+typedef struct {
+    multi_heap_lock_t lock;
+    uint8_t count[MULTI_HEAP_CACHE_NUM_CLASSES];
+    void *blocks[MULTI_HEAP_CACHE_NUM_CLASSES][MULTI_HEAP_CACHE_MAGAZINE_SIZE];
+} multi_heap_cache_core_t;
+
+typedef struct multi_heap_cache {
+    multi_heap_handle_t heap;
+    multi_heap_lock_t *heap_lock;
+    multi_heap_cache_core_t cores[MULTI_HEAP_NUM_CORES];
+} multi_heap_cache_t;
+
+/** @brief Initialise a size class cache for a heap
+ *
+ * @param cache Cache to initialise
+ * @param heap Heap the blocks are allocated from
+ * @param heap_lock Lock of the heap, as passed to multi_heap_set_lock(). It must be recursive.
+ */
+void multi_heap_cache_init(multi_heap_cache_t *cache, multi_heap_handle_t heap, multi_heap_lock_t *heap_lock);
+
+/** @brief Allocate a block through the cache
+ *
+ * Sizes above MULTI_HEAP_CACHE_MAX_SIZE are allocated from the heap directly.
+ *
+ * @return Pointer to the block, NULL if the heap has no memory left.
+ */
+void *multi_heap_cache_malloc(multi_heap_cache_t *cache, size_t size);
+
+/** @brief Free a block through the cache
+ *
+ * The block may have been allocated with multi_heap_malloc() or multi_heap_cache_malloc().
+ * Blocks which don't fit in a size class are freed to the heap directly.
+ */
+void multi_heap_cache_free(multi_heap_cache_t *cache, void *p);
+
+/** @brief Free all blocks held by the cache to the heap
+ *
+ * @return Number of blocks freed
+ */
+size_t multi_heap_cache_flush(multi_heap_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -36,6 +36,12 @@ typedef portMUX_TYPE multi_heap_lock_t;
 
 #define MULTI_HEAP_LOCK_STATIC_INITIALIZER     portMUX_INITIALIZER_UNLOCKED
 
+/* Number of CPU cores and index of the current one, for the per-core size class cache.
+   The task may be moved to the other core right after reading the index, so data indexed
+   by it still has to be locked. */
+#define MULTI_HEAP_NUM_CORES portNUM_PROCESSORS
+#define MULTI_HEAP_CORE_ID() xPortGetCoreID()
+
 /* Not safe to use std i/o while in a portmux critical section,
    can deadlock, so we use the ROM equivalent functions. */
 
@@ -81,11 +87,64 @@ inline static void multi_heap_assert(bool condition, const char *format, int lin
 
 #define MULTI_HEAP_PRINTF printf
 #define MULTI_HEAP_STDERR_PRINTF(MSG, ...) fprintf(stderr, MSG, __VA_ARGS__)
+
+#ifdef MULTI_HEAP_PTHREAD
+
+/* Multi-threaded host tests. Each thread behaves as a CPU core of its own (up to
+   MULTI_HEAP_NUM_CORES threads) and locks are recursive, like the portmux spinlocks. */
+
+#include <pthread.h>
+
+typedef pthread_mutex_t multi_heap_lock_t;
+
+#define MULTI_HEAP_LOCK(PLOCK) do {                         \
+        if((PLOCK) != NULL) {                               \
+            pthread_mutex_lock((PLOCK));                    \
+        }                                                   \
+    } while(0)
+
+#define MULTI_HEAP_UNLOCK(PLOCK) do {                       \
+        if ((PLOCK) != NULL) {                              \
+            pthread_mutex_unlock((PLOCK));                  \
+        }                                                   \
+    } while(0)
+
+#define MULTI_HEAP_LOCK_INIT(PLOCK) do {                    \
+        pthread_mutexattr_t attr;                           \
+        pthread_mutexattr_init(&attr);                      \
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE); \
+        pthread_mutex_init((PLOCK), &attr);                 \
+        pthread_mutexattr_destroy(&attr);                   \
+    } while(0)
+
+#define MULTI_HEAP_NUM_CORES 8
+
+inline static int multi_heap_host_core_id(void)
+{
+    static int next_id;
+    static __thread int id = -1;
+    if (id < 0) {
+        id = __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED) % MULTI_HEAP_NUM_CORES;
+    }
+    return id;
+}
+
+#define MULTI_HEAP_CORE_ID() multi_heap_host_core_id()
+
+#else // MULTI_HEAP_PTHREAD
+
+typedef int multi_heap_lock_t;
+
 #define MULTI_HEAP_LOCK(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_UNLOCK(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_LOCK_INIT(PLOCK)  (void) (PLOCK)
 #define MULTI_HEAP_LOCK_STATIC_INITIALIZER  0
 
+#define MULTI_HEAP_NUM_CORES 1
+#define MULTI_HEAP_CORE_ID() 0
+
+#endif // MULTI_HEAP_PTHREAD
+
 #define MULTI_HEAP_ASSERT(CONDITION, ADDRESS) assert((CONDITION) && "Heap corrupt")
 
 #define MULTI_HEAP_BLOCK_OWNER
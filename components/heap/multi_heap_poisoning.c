@@ -409,6 +409,15 @@ size_t multi_heap_minimum_free_size(multi_heap_handle_t heap)
     return r;
 }
 
+#if !CONFIG_HEAP_TLSF_USE_ROM_IMPL
+size_t multi_heap_largest_free_block_estimate(multi_heap_handle_t heap)
+{
+    size_t r = multi_heap_largest_free_block_estimate_impl(heap);
+    subtract_poison_overhead(&r);
+    return r;
+}
+#endif
+
 /* Internal hooks used by multi_heap to manage poisoning, while keeping some modularity */
 
 bool multi_heap_internal_check_block_poisoning(void *start, size_t size, bool is_free, bool print_errors)
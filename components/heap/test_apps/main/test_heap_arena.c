@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for arenas, see also the host tests in test_multi_heap_host
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_arena.h"
+#include "esp_memory_utils.h"
+
+TEST_CASE("heap arena memory is returned to the heap", "[heap][heap_arena]")
+{
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    size_t free_size = heap_caps_get_free_size(caps);
+
+    heap_arena_handle_t arena = heap_arena_create(caps, 1024);
+    TEST_ASSERT_NOT_NULL(arena);
+    TEST_ASSERT(heap_caps_get_free_size(caps) < free_size);
+
+    for (int request = 0; request < 10; request++) {
+        for (int i = 0; i < 50; i++) {
+            uint8_t *p = heap_arena_alloc(arena, 10 + i);
+            TEST_ASSERT_NOT_NULL(p);
+            TEST_ASSERT(esp_ptr_internal(p));
+            TEST_ASSERT_EQUAL(0, (intptr_t)p % sizeof(void *));
+            memset(p, i, 10 + i);
+        }
+        void *aligned = heap_arena_aligned_alloc(arena, 32, 100);
+        TEST_ASSERT_EQUAL(0, (intptr_t)aligned % 32);
+
+        heap_arena_info_t info;
+        heap_arena_get_info(arena, &info);
+        TEST_ASSERT_EQUAL(50 * 10 + 49 * 50 / 2 + 100, info.allocated_bytes);
+        TEST_ASSERT(info.chunks > 1);
+        heap_arena_reset(arena);
+    }
+
+    heap_arena_destroy(arena);
+    TEST_ASSERT_EQUAL(free_size, heap_caps_get_free_size(caps));
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for pools of fixed-size objects
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+#include "sdkconfig.h"
+
+TEST_CASE("heap pool allocates all its objects once", "[heap][heap_pool]")
+{
+    TEST_ASSERT_NULL(heap_pool_create(0, 8, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_pool_create(16, 0, MALLOC_CAP_8BIT));
+    TEST_ASSERT_NULL(heap_pool_create(16, 65535, MALLOC_CAP_8BIT));
+
+    const int count = 10;
+    heap_pool_handle_t pool = heap_pool_create(13, count, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    void *objs[count];
+    for (int i = 0; i < count; i++) {
+        objs[i] = heap_pool_alloc(pool);
+        TEST_ASSERT_NOT_NULL(objs[i]);
+        TEST_ASSERT_EQUAL(0, (intptr_t)objs[i] % sizeof(void *));
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT_NOT_EQUAL(objs[j], objs[i]);
+        }
+        memset(objs[i], 0xA5, 13);
+    }
+    TEST_ASSERT_NULL(heap_pool_alloc(pool));
+
+    heap_pool_info_t info;
+    heap_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(16, info.obj_size);
+    TEST_ASSERT_EQUAL(count, info.total_objects);
+    TEST_ASSERT_EQUAL(0, info.free_objects);
+    TEST_ASSERT_EQUAL(0, info.minimum_free_objects);
+    TEST_ASSERT_EQUAL(1, info.failed_allocations);
+
+    heap_pool_free(pool, objs[3]);
+    TEST_ASSERT_EQUAL_PTR(objs[3], heap_pool_alloc(pool));
+
+    for (int i = 0; i < count; i++) {
+        heap_pool_free(pool, objs[i]);
+    }
+    heap_pool_free(pool, NULL);
+    heap_pool_get_info(pool, &info);
+    TEST_ASSERT_EQUAL(count, info.free_objects);
+    TEST_ASSERT_EQUAL(0, info.minimum_free_objects);
+    heap_pool_print_info(pool);
+    heap_pool_delete(pool);
+}
+
+#define STRESS_OBJECTS 16
+#define STRESS_ITERATIONS 20000
+
+typedef struct {
+    heap_pool_handle_t pool;
+    SemaphoreHandle_t done;
+    bool corrupted;
+} stress_arg_t;
+
+static void stress_task(void *arg)
+{
+    stress_arg_t *a = (stress_arg_t *)arg;
+    void *held[4] = { };
+    for (int i = 0; i < STRESS_ITERATIONS; i++) {
+        int n = i % 4;
+        if (held[n] != NULL) {
+            if (*(void **)held[n] != held[n]) {
+                a->corrupted = true;
+            }
+            heap_pool_free(a->pool, held[n]);
+            held[n] = NULL;
+        } else {
+            held[n] = heap_pool_alloc(a->pool);
+            if (held[n] != NULL) {
+                *(void **)held[n] = held[n];
+            }
+        }
+    }
+    for (int n = 0; n < 4; n++) {
+        heap_pool_free(a->pool, held[n]);
+    }
+    xSemaphoreGive(a->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("heap pool objects are allocated and freed from both cores", "[heap][heap_pool]")
+{
+    stress_arg_t arg = {
+        .pool = heap_pool_create(sizeof(void *), STRESS_OBJECTS, MALLOC_CAP_8BIT),
+        .done = xSemaphoreCreateCounting(4, 0),
+    };
+    TEST_ASSERT_NOT_NULL(arg.pool);
+
+    for (int i = 0; i < 4; i++) {
+        xTaskCreatePinnedToCore(stress_task, "pool_stress", 2048, &arg, 5, NULL, i % portNUM_PROCESSORS);
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT(xSemaphoreTake(arg.done, pdMS_TO_TICKS(10000)));
+    }
+    TEST_ASSERT_FALSE(arg.corrupted);
+
+    heap_pool_info_t info;
+    heap_pool_get_info(arg.pool, &info);
+    TEST_ASSERT_EQUAL(STRESS_OBJECTS, info.free_objects);
+
+    heap_pool_delete(arg.pool);
+    vSemaphoreDelete(arg.done);
+}
+
+#ifdef CONFIG_HEAP_TRACING_STANDALONE
+#include "esp_heap_trace.h"
+
+TEST_CASE("heap pool objects are visible to heap tracing", "[heap][heap_pool]")
+{
+    heap_trace_record_t recs[8];
+    heap_pool_handle_t pool = heap_pool_create(24, 4, MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    heap_trace_init_standalone(recs, 8);
+    heap_trace_start(HEAP_TRACE_LEAKS);
+    void *a = heap_pool_alloc(pool);
+    void *b = heap_pool_alloc(pool);
+    heap_pool_free(pool, a);
+    heap_trace_stop();
+
+    TEST_ASSERT_EQUAL(1, heap_trace_get_count());
+    heap_trace_record_t rec;
+    heap_trace_get(0, &rec);
+    TEST_ASSERT_EQUAL_PTR(b, rec.address);
+    TEST_ASSERT_EQUAL(24, rec.size);
+
+    heap_pool_free(pool, b);
+    heap_pool_delete(pool);
+}
+#endif // CONFIG_HEAP_TRACING_STANDALONE
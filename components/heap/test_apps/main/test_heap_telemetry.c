@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for the allocation statistics of heaps (CONFIG_HEAP_TELEMETRY)
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#if CONFIG_HEAP_TELEMETRY
+
+TEST_CASE("heap telemetry counts allocations and frees", "[heap][heap_telemetry]")
+{
+    const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    heap_caps_telemetry_t before, after;
+
+    heap_caps_get_telemetry(&before, caps);
+    void *small = heap_caps_malloc(10, caps);
+    void *medium = heap_caps_malloc(100, caps);
+    void *large = heap_caps_malloc(20000, caps);
+    void *aligned = heap_caps_aligned_alloc(64, 200, caps);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(medium);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_NOT_NULL(aligned);
+    heap_caps_get_telemetry(&after, caps);
+
+    TEST_ASSERT_EQUAL(4, after.alloc_count - before.alloc_count);
+    TEST_ASSERT_EQUAL(1, after.size_class_allocs[0] - before.size_class_allocs[0]);
+    TEST_ASSERT_EQUAL(1, after.size_class_allocs[3] - before.size_class_allocs[3]);
+    TEST_ASSERT_EQUAL(1, after.size_class_allocs[4] - before.size_class_allocs[4]);
+    TEST_ASSERT_EQUAL(1, after.size_class_allocs[HEAP_TELEMETRY_SIZE_CLASSES - 1]
+                      - before.size_class_allocs[HEAP_TELEMETRY_SIZE_CLASSES - 1]);
+    uint32_t latencies = 0;
+    for (int i = 0; i < HEAP_TELEMETRY_LATENCY_BUCKETS; i++) {
+        latencies += after.alloc_latency[i] - before.alloc_latency[i];
+    }
+    TEST_ASSERT_EQUAL(4, latencies);
+    TEST_ASSERT_EQUAL(heap_caps_get_free_size(caps), after.total_free_bytes);
+    TEST_ASSERT(after.largest_free_block <= heap_caps_get_largest_free_block(caps));
+    TEST_ASSERT(after.largest_free_block >= heap_caps_get_largest_free_block(caps) * 31 / 32);
+
+    heap_caps_get_telemetry(&before, caps);
+    heap_caps_free(small);
+    heap_caps_free(medium);
+    heap_caps_free(large);
+    heap_caps_free(aligned);
+    heap_caps_get_telemetry(&after, caps);
+    TEST_ASSERT_EQUAL(4, after.free_count - before.free_count);
+    TEST_ASSERT_EQUAL(0, after.alloc_count - before.alloc_count);
+
+    uint32_t p50 = heap_caps_telemetry_latency_percentile(&after, 50);
+    uint32_t p99 = heap_caps_telemetry_latency_percentile(&after, 99);
+    TEST_ASSERT(p50 >= 64);
+    TEST_ASSERT(p99 >= p50);
+}
+
+TEST_CASE("heap telemetry is written as JSON", "[heap][heap_telemetry]")
+{
+    size_t len = heap_caps_dump_stats_json(NULL, 0, MALLOC_CAP_DEFAULT);
+    TEST_ASSERT(len > 0);
+
+    // leave some room for counters which grow, starting with this allocation
+    const size_t size = len + 64;
+    char *json = malloc(size);
+    TEST_ASSERT_NOT_NULL(json);
+    len = heap_caps_dump_stats_json(json, size, MALLOC_CAP_DEFAULT);
+    TEST_ASSERT(len < size);
+    TEST_ASSERT_EQUAL(len, strlen(json));
+    printf("%s\n", json);
+    TEST_ASSERT_EQUAL_STRING_LEN("{\"heaps\":[{\"start\":", json, 19);
+    TEST_ASSERT_NOT_NULL(strstr(json, "],\"total\":{\"free_bytes\":"));
+    TEST_ASSERT_EQUAL('}', json[len - 1]);
+
+    // truncated output is still terminated
+    char small[16];
+    memset(small, 'x', sizeof(small));
+    TEST_ASSERT(heap_caps_dump_stats_json(small, sizeof(small), MALLOC_CAP_DEFAULT) >= sizeof(small));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+    free(json);
+}
+
+#endif // CONFIG_HEAP_TELEMETRY
@@ -64,9 +64,9 @@ TEST_CASE("heap trace leak check", "[heap]")
     heap_trace_get(0, &trace_b);
     TEST_ASSERT_EQUAL_PTR(b, trace_b.address);
 
-    /* buffer deletes trace_a when freed,
-       so trace_b at head of buffer */
-    TEST_ASSERT_EQUAL_PTR(recs[0].address, trace_b.address);
+    /* trace_a is deleted when freed, so trace_b is the only record left.
+       (records aren't kept in order in the buffer, so this is checked through heap_trace_get) */
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_trace_get(1, &trace_a));
 
     heap_trace_stop();
 }
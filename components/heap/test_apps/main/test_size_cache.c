@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for the per-core size class cache (CONFIG_HEAP_SIZE_CACHE)
+*/
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#if CONFIG_HEAP_SIZE_CACHE
+
+TEST_CASE("size class cache hands out freed blocks again", "[heap][size_cache]")
+{
+    const uint32_t caps = MALLOC_CAP_DEFAULT | MALLOC_CAP_SIZE_CACHE;
+
+    void *a = heap_caps_malloc(40, caps);
+    TEST_ASSERT_NOT_NULL(a);
+    heap_caps_free(a);
+    void *b = heap_caps_malloc(33, caps);
+    TEST_ASSERT_EQUAL_PTR(a, b);
+    TEST_ASSERT(heap_caps_get_allocated_size(b) >= 48);
+    // blocks bigger than the size classes don't go through the cache
+    void *c = heap_caps_malloc(1024, caps);
+    TEST_ASSERT_NOT_NULL(c);
+    heap_caps_free(c);
+    heap_caps_free(b);
+}
+
+TEST_CASE("size class cache is emptied when an allocation fails", "[heap][size_cache]")
+{
+    const size_t block_size = 96;
+    size_t count = heap_caps_get_free_size(MALLOC_CAP_DEFAULT) / block_size;
+    void **blocks = heap_caps_malloc(count * sizeof(void *), MALLOC_CAP_DEFAULT);
+    TEST_ASSERT_NOT_NULL(blocks);
+
+    // fill the heaps through the caches, then free all blocks, part of them stay in the caches
+    size_t allocated = 0;
+    while (allocated < count) {
+        blocks[allocated] = heap_caps_malloc(block_size, MALLOC_CAP_DEFAULT | MALLOC_CAP_SIZE_CACHE);
+        if (blocks[allocated] == NULL) {
+            break;
+        }
+        allocated++;
+    }
+    for (size_t i = 0; i < allocated; i++) {
+        heap_caps_free(blocks[i]);
+    }
+
+    // allocations which don't use the caches get the blocks held by the caches once the heaps are full
+    size_t reallocated = 0;
+    while (reallocated < count) {
+        blocks[reallocated] = heap_caps_malloc(block_size, MALLOC_CAP_DEFAULT);
+        if (blocks[reallocated] == NULL) {
+            break;
+        }
+        reallocated++;
+    }
+    for (size_t i = 0; i < reallocated; i++) {
+        heap_caps_free(blocks[i]);
+    }
+    heap_caps_free(blocks);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(allocated, reallocated);
+}
+
+static void free_task(void *arg)
+{
+    void **blocks = (void **)arg;
+    for (int i = 0; i < 64; i++) {
+        heap_caps_free(blocks[i]);
+    }
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("size class cache blocks can be freed on the other core", "[heap][size_cache]")
+{
+    void *blocks[64];
+    multi_heap_info_t before, after;
+    heap_caps_get_info(&before, MALLOC_CAP_DEFAULT);
+
+    for (int i = 0; i < 64; i++) {
+        blocks[i] = heap_caps_malloc(16 + i, MALLOC_CAP_DEFAULT | MALLOC_CAP_SIZE_CACHE);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+    xTaskCreatePinnedToCore(free_task, "free_task", 2048, blocks, 5, NULL, portNUM_PROCESSORS - 1);
+    vTaskDelay(10);
+
+    TEST_ASSERT(heap_caps_check_integrity_all(true));
+    // at most the blocks held by the caches are missing
+    heap_caps_get_info(&after, MALLOC_CAP_DEFAULT);
+    TEST_ASSERT_INT_WITHIN(CONFIG_HEAP_SIZE_CACHE_MAGAZINE_SIZE * 8 * portNUM_PROCESSORS * 128,
+                           before.total_free_bytes, after.total_free_bytes);
+}
+
+#endif // CONFIG_HEAP_SIZE_CACHE
@@ -64,3 +64,31 @@ def test_heap_8bit_access(dut: Dut) -> None:
     dut.expect_exact('Press ENTER to see the list of tests')
     dut.write('"IRAM_8BIT capability test"')
     dut.expect_unity_test_output(timeout=300)
+
+
+@pytest.mark.generic
+@pytest.mark.supported_targets
+@pytest.mark.parametrize(
+    'config',
+    [
+        'size_cache'
+    ]
+)
+def test_heap_size_cache(dut: Dut) -> None:
+    dut.expect_exact('Press ENTER to see the list of tests')
+    dut.write('[size_cache]')
+    dut.expect_unity_test_output(timeout=300)
+
+
+@pytest.mark.generic
+@pytest.mark.supported_targets
+@pytest.mark.parametrize(
+    'config',
+    [
+        'telemetry'
+    ]
+)
+def test_heap_telemetry(dut: Dut) -> None:
+    dut.expect_exact('Press ENTER to see the list of tests')
+    dut.write('[heap_telemetry]')
+    dut.expect_unity_test_output(timeout=300)
@@ -0,0 +1,19 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Critical sections are spinlocks, which is enough for the tests running on the host */
+typedef struct {
+    atomic_flag locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { ATOMIC_FLAG_INIT }
+
+#define portENTER_CRITICAL(mux) do { while (atomic_flag_test_and_set(&(mux)->locked)) { } } while (0)
+#define portEXIT_CRITICAL(mux) atomic_flag_clear(&(mux)->locked)
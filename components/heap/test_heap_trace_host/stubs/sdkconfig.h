@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#define CONFIG_HEAP_TRACING 1
+#define CONFIG_HEAP_TRACING_STANDALONE 1
+#define CONFIG_HEAP_TRACING_STACK_DEPTH 2
+#define CONFIG_FREERTOS_UNICORE 1
@@ -0,0 +1,272 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "catch.hpp"
+#include "esp_heap_caps.h"
+#include "esp_heap_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#include <random>
+
+/* The tracer wraps the heap_caps functions, these are the functions it calls in the end */
+extern "C" {
+
+void *__wrap_malloc(size_t size);
+void __wrap_free(void *p);
+void *__wrap_realloc(void *p, size_t size);
+
+/* called by heap pools */
+void heap_trace_record_pool_alloc(void *p, size_t size);
+void heap_trace_record_pool_free(void *p);
+
+void *__real_heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void *__real_heap_caps_malloc_default(size_t size)
+{
+    return malloc(size);
+}
+
+void *__real_heap_caps_realloc(void *p, size_t size, uint32_t caps)
+{
+    return realloc(p, size);
+}
+
+void *__real_heap_caps_realloc_default(void *p, size_t size)
+{
+    return realloc(p, size);
+}
+
+void __real_heap_caps_free(void *p)
+{
+    free(p);
+}
+
+/* used by the tracer for its index */
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void heap_caps_free(void *p)
+{
+    free(p);
+}
+
+}
+
+static std::vector<void *> traced_addresses(void)
+{
+    std::vector<void *> result;
+    for (size_t i = 0; i < heap_trace_get_count(); i++) {
+        heap_trace_record_t rec;
+        REQUIRE(heap_trace_get(i, &rec) == ESP_OK);
+        result.push_back(rec.address);
+    }
+    return result;
+}
+
+static double elapsed_ns(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+TEST_CASE("leak trace keeps allocation order when records are removed", "[heap_trace]")
+{
+    heap_trace_record_t recs[8];
+    REQUIRE(heap_trace_init_standalone(recs, 8) == ESP_OK);
+    REQUIRE(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK);
+
+    void *p[5];
+    for (int i = 0; i < 5; i++) {
+        p[i] = __wrap_malloc(16 + i);
+    }
+    __wrap_free(p[2]);
+    __wrap_free(p[0]);
+    void *q = __wrap_malloc(64);
+
+    std::vector<void *> expected = { p[1], p[3], p[4], q };
+    CHECK(traced_addresses() == expected);
+
+    heap_trace_record_t rec;
+    REQUIRE(heap_trace_get(3, &rec) == ESP_OK);
+    CHECK(rec.size == 64);
+    CHECK(heap_trace_get(4, &rec) == ESP_ERR_INVALID_ARG);
+
+    heap_trace_stop();
+    __wrap_free(p[1]);
+    __wrap_free(p[3]);
+    __wrap_free(p[4]);
+    __wrap_free(q);
+    // frees after stopping are not traced
+    CHECK(heap_trace_get_count() == 4);
+
+    REQUIRE(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+}
+
+TEST_CASE("trace of all allocations records the callers which free", "[heap_trace]")
+{
+    heap_trace_record_t recs[8];
+    REQUIRE(heap_trace_init_standalone(recs, 8) == ESP_OK);
+    REQUIRE(heap_trace_start(HEAP_TRACE_ALL) == ESP_OK);
+
+    void *a = __wrap_malloc(32);
+    void *b = __wrap_malloc(48);
+    __wrap_free(a);
+    // the allocator is likely to return the same address again, which is a different allocation
+    void *c = __wrap_malloc(32);
+    b = __wrap_realloc(b, 4096);
+    __wrap_free(c);
+
+    REQUIRE(heap_trace_get_count() == 4);
+    heap_trace_record_t rec;
+    REQUIRE(heap_trace_get(0, &rec) == ESP_OK);
+    CHECK(rec.address == a);
+    CHECK(rec.freed_by[0] != NULL);
+    REQUIRE(heap_trace_get(1, &rec) == ESP_OK);
+    CHECK(rec.size == 48);
+    CHECK(rec.freed_by[0] != NULL);
+    REQUIRE(heap_trace_get(2, &rec) == ESP_OK);
+    CHECK(rec.address == c);
+    CHECK(rec.freed_by[0] != NULL);
+    REQUIRE(heap_trace_get(3, &rec) == ESP_OK);
+    CHECK(rec.address == b);
+    CHECK(rec.size == 4096);
+    CHECK(rec.freed_by[0] == NULL);
+
+    heap_trace_dump();
+    heap_trace_stop();
+    __wrap_free(b);
+    REQUIRE(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+}
+
+TEST_CASE("oldest records are dropped when the buffer is full", "[heap_trace]")
+{
+    const size_t N = 16;
+    heap_trace_record_t recs[N];
+    REQUIRE(heap_trace_init_standalone(recs, N) == ESP_OK);
+    REQUIRE(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK);
+
+    std::vector<void *> allocs;
+    for (size_t i = 0; i < N * 3; i++) {
+        allocs.push_back(__wrap_malloc(8));
+    }
+    std::vector<void *> expected(allocs.end() - N, allocs.end());
+    CHECK(traced_addresses() == expected);
+
+    // freeing an allocation whose record was dropped doesn't change anything
+    __wrap_free(allocs[0]);
+    CHECK(heap_trace_get_count() == N);
+    __wrap_free(allocs[N * 2]);
+    expected.erase(expected.begin());
+    CHECK(traced_addresses() == expected);
+
+    heap_trace_stop();
+    for (size_t i = 1; i < allocs.size(); i++) {
+        if (i != N * 2) {
+            __wrap_free(allocs[i]);
+        }
+    }
+    REQUIRE(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+}
+
+TEST_CASE("objects of heap pools are traced like allocations", "[heap_trace]")
+{
+    heap_trace_record_t recs[8];
+    uint32_t objects[4][4];
+    REQUIRE(heap_trace_init_standalone(recs, 8) == ESP_OK);
+    REQUIRE(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK);
+
+    for (int i = 0; i < 4; i++) {
+        heap_trace_record_pool_alloc(objects[i], sizeof(objects[i]));
+    }
+    heap_trace_record_pool_free(objects[1]);
+
+    std::vector<void *> expected = { objects[0], objects[2], objects[3] };
+    CHECK(traced_addresses() == expected);
+    heap_trace_record_t rec;
+    REQUIRE(heap_trace_get(0, &rec) == ESP_OK);
+    CHECK(rec.size == sizeof(objects[0]));
+    CHECK(rec.alloced_by[0] != NULL);
+
+    heap_trace_stop();
+    REQUIRE(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+}
+
+TEST_CASE("heap_trace_init_standalone checks its arguments", "[heap_trace]")
+{
+    static heap_trace_record_t recs[0x10000];
+    CHECK(heap_trace_init_standalone(recs, 0x10000) == ESP_ERR_INVALID_ARG);
+    CHECK(heap_trace_init_standalone(recs, 0xfffd) == ESP_OK);
+    CHECK(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK);
+    CHECK(heap_trace_init_standalone(recs, 8) == ESP_ERR_INVALID_STATE);
+    heap_trace_stop();
+    CHECK(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+    CHECK(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_ERR_INVALID_STATE);
+}
+
+TEST_CASE("recording is independent of the number of records", "[heap_trace][benchmark][.]")
+{
+    const size_t N = 10000;
+    std::vector<heap_trace_record_t> recs(N);
+    std::vector<void *> allocs(N);
+    std::mt19937 rng(1);
+
+    REQUIRE(heap_trace_init_standalone(recs.data(), N) == ESP_OK);
+
+    // leak trace, allocations freed in random order
+    REQUIRE(heap_trace_start(HEAP_TRACE_LEAKS) == ESP_OK);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < N; i++) {
+        allocs[i] = __wrap_malloc(16);
+    }
+    CHECK(heap_trace_get_count() == N);
+    std::shuffle(allocs.begin(), allocs.end(), rng);
+    for (size_t i = 0; i < N; i++) {
+        __wrap_free(allocs[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    CHECK(heap_trace_get_count() == 0);
+    printf("HEAP_TRACE_LEAKS, %u records: %.1f ns per malloc/free pair\n", (unsigned) N, elapsed_ns(start, end) / N);
+
+    // full trace with the buffer overflowing, 4 allocations alive at a time
+    REQUIRE(heap_trace_start(HEAP_TRACE_ALL) == ESP_OK);
+    void *alive[4] = { };
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < N * 4; i++) {
+        __wrap_free(alive[i % 4]);
+        alive[i % 4] = __wrap_malloc(16);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    CHECK(heap_trace_get_count() == N);
+    printf("HEAP_TRACE_ALL, %u records: %.1f ns per malloc/free pair\n", (unsigned) N, elapsed_ns(start, end) / (N * 4));
+
+    // reading all records in order
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t read = 0;
+    for (size_t i = 0; i < N; i++) {
+        heap_trace_record_t rec;
+        if (heap_trace_get(i, &rec) == ESP_OK) {
+            read++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    CHECK(read == N);
+    printf("heap_trace_get, %u records: %.1f ns per record\n", (unsigned) N, elapsed_ns(start, end) / N);
+
+    heap_trace_stop();
+    for (int i = 0; i < 4; i++) {
+        __wrap_free(alive[i]);
+    }
+    REQUIRE(heap_trace_init_standalone(NULL, 0) == ESP_OK);
+}
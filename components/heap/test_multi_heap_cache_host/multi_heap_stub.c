@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <stdbool.h>
+#include "multi_heap.h"
+#include "../multi_heap_platform.h"
+
+/* Stand-in for the TLSF based multi_heap, so that the size class cache can be tested
+   without the tlsf submodule. Blocks are allocated with libc malloc(), and the heap
+   only accounts for the memory they use, which is limited to the size of the region
+   passed to multi_heap_register(). */
+
+#define BLOCK_ALIGN 4
+#define BLOCK_OVERHEAD sizeof(size_t)
+
+typedef struct multi_heap_info {
+    multi_heap_lock_t *lock;
+    size_t free_bytes;
+    size_t block_count;
+} heap_t;
+
+static size_t block_size(size_t size)
+{
+    return (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+}
+
+multi_heap_handle_t multi_heap_register(void *start, size_t size)
+{
+    heap_t *heap = (heap_t *)start;
+    if (size < sizeof(heap_t)) {
+        return NULL;
+    }
+    heap->lock = NULL;
+    heap->free_bytes = size - sizeof(heap_t);
+    heap->block_count = 0;
+    return heap;
+}
+
+void multi_heap_set_lock(multi_heap_handle_t heap, void *lock)
+{
+    heap->lock = (multi_heap_lock_t *)lock;
+}
+
+void *multi_heap_malloc(multi_heap_handle_t heap, size_t size)
+{
+    size_t *block = NULL;
+
+    if (size == 0) {
+        return NULL;
+    }
+    size = block_size(size);
+    MULTI_HEAP_LOCK(heap->lock);
+    if (size + BLOCK_OVERHEAD <= heap->free_bytes) {
+        block = (size_t *)malloc(size + BLOCK_OVERHEAD);
+        if (block != NULL) {
+            *block++ = size;
+            heap->free_bytes -= size + BLOCK_OVERHEAD;
+            heap->block_count++;
+        }
+    }
+    MULTI_HEAP_UNLOCK(heap->lock);
+    return block;
+}
+
+void multi_heap_free(multi_heap_handle_t heap, void *p)
+{
+    if (p == NULL) {
+        return;
+    }
+    size_t *block = (size_t *)p - 1;
+    MULTI_HEAP_LOCK(heap->lock);
+    MULTI_HEAP_ASSERT(heap->block_count > 0, p);
+    heap->free_bytes += *block + BLOCK_OVERHEAD;
+    heap->block_count--;
+    MULTI_HEAP_UNLOCK(heap->lock);
+    free(block);
+}
+
+size_t multi_heap_get_allocated_size(multi_heap_handle_t heap, void *p)
+{
+    return ((size_t *)p)[-1];
+}
+
+size_t multi_heap_free_size(multi_heap_handle_t heap)
+{
+    return heap->free_bytes;
+}
+
+bool multi_heap_check(multi_heap_handle_t heap, bool print_errors)
+{
+    return true;
+}
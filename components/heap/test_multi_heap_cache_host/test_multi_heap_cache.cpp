@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "catch.hpp"
+#include "multi_heap.h"
+
+#include "../multi_heap_platform.h"
+#include "../multi_heap_cache.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+static uint8_t cache_test_heap[1024 * 1024];
+
+TEST_CASE("multi_heap cache hands out freed blocks again", "[multi_heap][cache]")
+{
+    multi_heap_handle_t heap = multi_heap_register(cache_test_heap, sizeof(cache_test_heap));
+    multi_heap_lock_t lock;
+    MULTI_HEAP_LOCK_INIT(&lock);
+    multi_heap_set_lock(heap, &lock);
+    multi_heap_cache_t cache;
+    multi_heap_cache_init(&cache, heap, &lock);
+    size_t free_size = multi_heap_free_size(heap);
+
+    void *a = multi_heap_cache_malloc(&cache, 40);
+    REQUIRE( a != NULL );
+    REQUIRE( multi_heap_get_allocated_size(heap, a) >= 40 );
+    multi_heap_cache_free(&cache, a);
+    void *b = multi_heap_cache_malloc(&cache, 33);
+    REQUIRE( a == b );
+
+    // blocks allocated without the cache can be freed through it
+    void *c = multi_heap_malloc(heap, 100);
+    REQUIRE( c != NULL );
+    multi_heap_cache_free(&cache, c);
+
+    // sizes above the size classes bypass the cache
+    void *d = multi_heap_cache_malloc(&cache, MULTI_HEAP_CACHE_MAX_SIZE * 2);
+    REQUIRE( d != NULL );
+    size_t before_free = multi_heap_free_size(heap);
+    multi_heap_cache_free(&cache, d);
+    REQUIRE( multi_heap_free_size(heap) > before_free );
+
+    multi_heap_cache_free(&cache, b);
+    REQUIRE( multi_heap_cache_flush(&cache) > 0 );
+    REQUIRE( multi_heap_cache_flush(&cache) == 0 );
+    REQUIRE( multi_heap_free_size(heap) == free_size );
+    REQUIRE( multi_heap_check(heap, true) );
+}
+
+TEST_CASE("multi_heap cache returns half a magazine when full", "[multi_heap][cache]")
+{
+    multi_heap_handle_t heap = multi_heap_register(cache_test_heap, sizeof(cache_test_heap));
+    multi_heap_lock_t lock;
+    MULTI_HEAP_LOCK_INIT(&lock);
+    multi_heap_set_lock(heap, &lock);
+    multi_heap_cache_t cache;
+    multi_heap_cache_init(&cache, heap, &lock);
+    size_t free_size = multi_heap_free_size(heap);
+
+    const int N = MULTI_HEAP_CACHE_MAGAZINE_SIZE * 4;
+    void *blocks[N];
+    for (int i = 0; i < N; i++) {
+        blocks[i] = multi_heap_cache_malloc(&cache, 64);
+        REQUIRE( blocks[i] != NULL );
+        memset(blocks[i], 0xEE, 64);
+    }
+    for (int i = 0; i < N; i++) {
+        multi_heap_cache_free(&cache, blocks[i]);
+    }
+    // at most a full magazine is left in the cache
+    size_t flushed = multi_heap_cache_flush(&cache);
+    REQUIRE( flushed > 0 );
+    REQUIRE( flushed <= MULTI_HEAP_CACHE_MAGAZINE_SIZE );
+    REQUIRE( multi_heap_free_size(heap) == free_size );
+    REQUIRE( multi_heap_check(heap, true) );
+}
+
+TEST_CASE("multi_heap cache allocations fail when the heap is full", "[multi_heap][cache]")
+{
+    uint8_t small_heap[4 * 1024];
+    multi_heap_handle_t heap = multi_heap_register(small_heap, sizeof(small_heap));
+    multi_heap_lock_t lock;
+    MULTI_HEAP_LOCK_INIT(&lock);
+    multi_heap_set_lock(heap, &lock);
+    multi_heap_cache_t cache;
+    multi_heap_cache_init(&cache, heap, &lock);
+
+    void *large = multi_heap_malloc(heap, multi_heap_free_size(heap) - 256);
+    REQUIRE( large != NULL );
+    int count = 0;
+    void *blocks[64];
+    while (count < 64 && (blocks[count] = multi_heap_cache_malloc(&cache, 128)) != NULL) {
+        count++;
+    }
+    REQUIRE( count < 64 );
+    REQUIRE( blocks[count] == NULL );
+
+    for (int i = 0; i < count; i++) {
+        multi_heap_cache_free(&cache, blocks[i]);
+    }
+    multi_heap_cache_flush(&cache);
+    multi_heap_free(heap, large);
+    REQUIRE( multi_heap_check(heap, true) );
+}
+
+/* Multi-threaded benchmark: each thread keeps a set of small blocks alive and
+   replaces a random one of them at each iteration */
+
+#define BENCHMARK_THREADS 4
+#define BENCHMARK_ITERATIONS 200000
+#define BENCHMARK_LIVE_BLOCKS 32
+
+typedef struct {
+    multi_heap_handle_t heap;
+    multi_heap_cache_t *cache; // NULL to use the heap directly
+    unsigned seed;
+    bool failed;
+} benchmark_thread_t;
+
+static void *benchmark_thread(void *arg)
+{
+    benchmark_thread_t *t = (benchmark_thread_t *)arg;
+    void *blocks[BENCHMARK_LIVE_BLOCKS] = { };
+
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        int n = rand_r(&t->seed) % BENCHMARK_LIVE_BLOCKS;
+        size_t size = 16 + rand_r(&t->seed) % (MULTI_HEAP_CACHE_MAX_SIZE - 16);
+        if (t->cache != NULL) {
+            multi_heap_cache_free(t->cache, blocks[n]);
+            blocks[n] = multi_heap_cache_malloc(t->cache, size);
+        } else {
+            multi_heap_free(t->heap, blocks[n]);
+            blocks[n] = multi_heap_malloc(t->heap, size);
+        }
+        if (blocks[n] == NULL) {
+            t->failed = true;
+            break;
+        }
+        memset(blocks[n], 0xAA, 16);
+    }
+    for (int n = 0; n < BENCHMARK_LIVE_BLOCKS; n++) {
+        if (t->cache != NULL) {
+            multi_heap_cache_free(t->cache, blocks[n]);
+        } else {
+            multi_heap_free(t->heap, blocks[n]);
+        }
+    }
+    return NULL;
+}
+
+static double run_benchmark(multi_heap_handle_t heap, multi_heap_cache_t *cache)
+{
+    pthread_t threads[BENCHMARK_THREADS];
+    benchmark_thread_t args[BENCHMARK_THREADS];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_THREADS; i++) {
+        args[i] = (benchmark_thread_t) { heap, cache, (unsigned) i + 1, false };
+        REQUIRE( pthread_create(&threads[i], NULL, benchmark_thread, &args[i]) == 0 );
+    }
+    for (int i = 0; i < BENCHMARK_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        REQUIRE( !args[i].failed );
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return ns / (BENCHMARK_THREADS * BENCHMARK_ITERATIONS);
+}
+
+TEST_CASE("multi_heap cache multi-threaded benchmark", "[multi_heap][cache][benchmark][.]")
+{
+    multi_heap_handle_t heap = multi_heap_register(cache_test_heap, sizeof(cache_test_heap));
+    multi_heap_lock_t lock;
+    MULTI_HEAP_LOCK_INIT(&lock);
+    multi_heap_set_lock(heap, &lock);
+    multi_heap_cache_t cache;
+    multi_heap_cache_init(&cache, heap, &lock);
+    size_t free_size = multi_heap_free_size(heap);
+
+    double heap_ns = run_benchmark(heap, NULL);
+    REQUIRE( multi_heap_free_size(heap) == free_size );
+
+    double cache_ns = run_benchmark(heap, &cache);
+    multi_heap_cache_flush(&cache);
+    REQUIRE( multi_heap_free_size(heap) == free_size );
+    REQUIRE( multi_heap_check(heap, true) );
+
+    printf("%d threads, free+malloc of 16-%d bytes: heap lock %.1f ns, size class cache %.1f ns\n",
+           BENCHMARK_THREADS, MULTI_HEAP_CACHE_MAX_SIZE, heap_ns, cache_ns);
+}
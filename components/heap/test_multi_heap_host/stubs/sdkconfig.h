@@ -0,0 +1,9 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/* Configuration for the heap_caps based code built in the host tests, the multi_heap
+   configuration is passed on the command line by test_all_configs.sh */
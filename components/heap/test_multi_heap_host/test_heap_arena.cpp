@@ -0,0 +1,212 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "catch.hpp"
+#include "multi_heap.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_arena.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/* The arena allocates its chunks with heap_caps_malloc(), which allocates from this heap in the tests */
+static multi_heap_handle_t arena_test_heap;
+
+extern "C" {
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return multi_heap_malloc(arena_test_heap, size);
+}
+
+void heap_caps_free(void *p)
+{
+    multi_heap_free(arena_test_heap, p);
+}
+
+}
+
+static uint8_t arena_test_heap_data[64 * 1024];
+
+static void register_arena_test_heap(void)
+{
+    arena_test_heap = multi_heap_register(arena_test_heap_data, sizeof(arena_test_heap_data));
+    REQUIRE( arena_test_heap != NULL );
+}
+
+TEST_CASE("heap arena allocates consecutive aligned slices", "[heap_arena]")
+{
+    register_arena_test_heap();
+    size_t free_size = multi_heap_free_size(arena_test_heap);
+
+    REQUIRE( heap_arena_create(MALLOC_CAP_8BIT, 8) == NULL );
+    heap_arena_handle_t arena = heap_arena_create(MALLOC_CAP_8BIT, 1024);
+    REQUIRE( arena != NULL );
+    REQUIRE( heap_arena_alloc(arena, 0) == NULL );
+    REQUIRE( heap_arena_aligned_alloc(arena, 3, 8) == NULL );
+
+    uint8_t *a = (uint8_t *)heap_arena_alloc(arena, 5);
+    uint8_t *b = (uint8_t *)heap_arena_alloc(arena, 16);
+    REQUIRE( a != NULL );
+    REQUIRE( (uintptr_t)a % sizeof(void *) == 0 );
+    // no header between allocations
+    REQUIRE( b == a + ((5 + sizeof(void *) - 1) & ~(sizeof(void *) - 1)) );
+    uint8_t *c = (uint8_t *)heap_arena_aligned_alloc(arena, 64, 10);
+    REQUIRE( (uintptr_t)c % 64 == 0 );
+    REQUIRE( c >= b + 16 );
+    memset(a, 0xEE, 5);
+    memset(b, 0xEE, 16);
+    memset(c, 0xEE, 10);
+
+    heap_arena_info_t info;
+    heap_arena_get_info(arena, &info);
+    REQUIRE( info.allocated_bytes == 31 );
+    REQUIRE( info.chunk_bytes == 1024 );
+    REQUIRE( info.chunks == 1 );
+
+    heap_arena_reset(arena);
+    REQUIRE( heap_arena_alloc(arena, 5) == a );
+
+    heap_arena_destroy(arena);
+    heap_arena_destroy(NULL);
+    REQUIRE( multi_heap_free_size(arena_test_heap) == free_size );
+    REQUIRE( multi_heap_check(arena_test_heap, true) );
+}
+
+TEST_CASE("heap arena allocates new chunks when full", "[heap_arena]")
+{
+    register_arena_test_heap();
+    size_t free_size = multi_heap_free_size(arena_test_heap);
+
+    heap_arena_handle_t arena = heap_arena_create(MALLOC_CAP_8BIT, 512);
+    REQUIRE( arena != NULL );
+
+    for (int i = 0; i < 100; i++) {
+        void *p = heap_arena_alloc(arena, 40);
+        REQUIRE( p != NULL );
+        memset(p, i, 40);
+    }
+    heap_arena_info_t info;
+    heap_arena_get_info(arena, &info);
+    REQUIRE( info.allocated_bytes == 4000 );
+    REQUIRE( info.chunks > 1 );
+    size_t chunks = info.chunks;
+
+    // a large allocation gets a chunk of its own, the current chunk stays in use
+    uint8_t *before = (uint8_t *)heap_arena_alloc(arena, 8);
+    void *large = heap_arena_alloc(arena, 2000);
+    REQUIRE( large != NULL );
+    memset(large, 0xEE, 2000);
+    uint8_t *after = (uint8_t *)heap_arena_alloc(arena, 8);
+    REQUIRE( after == before + 8 );
+    heap_arena_get_info(arena, &info);
+    REQUIRE( info.chunks == chunks + 1 );
+
+    // allocations fail when the heap is full, the arena can still be used
+    REQUIRE( heap_arena_alloc(arena, sizeof(arena_test_heap_data)) == NULL );
+    REQUIRE( heap_arena_alloc(arena, SIZE_MAX - 4) == NULL );
+    REQUIRE( heap_arena_alloc(arena, 8) == after + 8 );
+
+    // reset only keeps the first chunk
+    heap_arena_reset(arena);
+    heap_arena_get_info(arena, &info);
+    REQUIRE( info.allocated_bytes == 0 );
+    REQUIRE( info.chunks == 1 );
+    REQUIRE( info.chunk_bytes == 512 );
+    REQUIRE( free_size - multi_heap_free_size(arena_test_heap) < 512 + 32 );
+
+    heap_arena_destroy(arena);
+    REQUIRE( multi_heap_free_size(arena_test_heap) == free_size );
+    REQUIRE( multi_heap_check(arena_test_heap, true) );
+}
+
+/* Fragmentation benchmark: simulate a server which makes many small allocations while handling each request and
+   frees them at the end, while also allocating objects which outlive the requests (a cache of sessions here).
+
+   The allocations made for requests either come directly from the heap or from an arena. Compare how fragmented
+   the free memory of the heap is after many requests. */
+
+#define BENCHMARK_REQUESTS 2000
+#define BENCHMARK_ALLOCS_PER_REQUEST 40
+#define BENCHMARK_SESSIONS 24
+
+typedef struct {
+    size_t free_bytes;
+    size_t largest_free_block;
+    size_t free_blocks;
+    int failed_requests;
+} fragmentation_result_t;
+
+static fragmentation_result_t run_fragmentation_benchmark(bool use_arena)
+{
+    register_arena_test_heap();
+    unsigned seed = 1;
+    void *sessions[BENCHMARK_SESSIONS] = { };
+    void *request_allocs[BENCHMARK_ALLOCS_PER_REQUEST];
+    fragmentation_result_t result = { };
+
+    heap_arena_handle_t arena = NULL;
+    if (use_arena) {
+        arena = heap_arena_create(MALLOC_CAP_8BIT, 2048);
+        REQUIRE( arena != NULL );
+    }
+
+    for (int r = 0; r < BENCHMARK_REQUESTS; r++) {
+        bool failed = false;
+        for (int i = 0; i < BENCHMARK_ALLOCS_PER_REQUEST; i++) {
+            size_t size = 8 + rand_r(&seed) % 120;
+            void *p = use_arena ? heap_arena_alloc(arena, size) : multi_heap_malloc(arena_test_heap, size);
+            if (p == NULL) {
+                failed = true;
+            } else {
+                memset(p, 0xAA, size);
+            }
+            request_allocs[i] = p;
+
+            // in the middle of some requests, replace a session
+            if (i == BENCHMARK_ALLOCS_PER_REQUEST / 2 && rand_r(&seed) % 4 == 0) {
+                int s = rand_r(&seed) % BENCHMARK_SESSIONS;
+                multi_heap_free(arena_test_heap, sessions[s]);
+                sessions[s] = multi_heap_malloc(arena_test_heap, 64 + rand_r(&seed) % 192);
+            }
+        }
+        if (use_arena) {
+            heap_arena_reset(arena);
+        } else {
+            for (int i = 0; i < BENCHMARK_ALLOCS_PER_REQUEST; i++) {
+                multi_heap_free(arena_test_heap, request_allocs[i]);
+            }
+        }
+        result.failed_requests += failed;
+    }
+
+    multi_heap_info_t info;
+    multi_heap_get_info(arena_test_heap, &info);
+    result.free_bytes = info.total_free_bytes;
+    result.largest_free_block = info.largest_free_block;
+    result.free_blocks = info.free_blocks;
+
+    heap_arena_destroy(arena);
+    for (int s = 0; s < BENCHMARK_SESSIONS; s++) {
+        multi_heap_free(arena_test_heap, sessions[s]);
+    }
+    REQUIRE( multi_heap_check(arena_test_heap, true) );
+    return result;
+}
+
+TEST_CASE("heap arena fragmentation benchmark", "[heap_arena][benchmark][.]")
+{
+    fragmentation_result_t heap = run_fragmentation_benchmark(false);
+    fragmentation_result_t arena = run_fragmentation_benchmark(true);
+
+    REQUIRE( heap.failed_requests == 0 );
+    REQUIRE( arena.failed_requests == 0 );
+    printf("%d requests of %d allocations, %d long-lived sessions:\n",
+           BENCHMARK_REQUESTS, BENCHMARK_ALLOCS_PER_REQUEST, BENCHMARK_SESSIONS);
+    printf("  heap:  free %zu, largest free block %zu, %zu free blocks\n",
+           heap.free_bytes, heap.largest_free_block, heap.free_blocks);
+    printf("  arena: free %zu, largest free block %zu, %zu free blocks\n",
+           arena.free_bytes, arena.largest_free_block, arena.free_blocks);
+}
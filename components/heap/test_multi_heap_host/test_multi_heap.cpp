@@ -526,6 +526,36 @@ TEST_CASE("multi_heap allocation overhead", "[multi_heap]")
     multi_heap_free(heap, x);
 }
 
+// The estimate read from the TLSF free lists is rounded like largest_free_block of multi_heap_get_info()
+TEST_CASE("multi_heap largest free block estimate", "[multi_heap]")
+{
+    uint8_t heapdata[64 * 1024];
+    multi_heap_handle_t heap = multi_heap_register(heapdata, sizeof(heapdata));
+    multi_heap_info_t info;
+
+    void *p[16];
+    for (int i = 0; i < 16; i++) {
+        p[i] = multi_heap_malloc(heap, 1000 + i * 300);
+        REQUIRE( p[i] != NULL );
+    }
+    // leave free blocks of various sizes between allocated blocks
+    for (int i = 0; i < 16; i += 2) {
+        multi_heap_free(heap, p[i]);
+        multi_heap_get_info(heap, &info);
+        REQUIRE( multi_heap_largest_free_block_estimate(heap) == info.largest_free_block );
+    }
+
+    for (int i = 1; i < 16; i += 2) {
+        multi_heap_free(heap, p[i]);
+    }
+    multi_heap_get_info(heap, &info);
+    REQUIRE( multi_heap_largest_free_block_estimate(heap) == info.largest_free_block );
+
+    void *all = multi_heap_malloc(heap, info.largest_free_block);
+    REQUIRE( all != NULL );
+    multi_heap_free(heap, all);
+}
+
 /* This test will corrupt the memory of a free block in the heap and check
  * that in the case of comprehensive poisoning the heap corruption is detected
  * by multi_heap_check(). For light poisoning and no poisoning, the test will
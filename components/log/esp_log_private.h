@@ -1,6 +1,19 @@
 #pragma once
 #include <stdbool.h>
+#include <stdarg.h>
+#include "sdkconfig.h"
 
 void esp_log_impl_lock(void);
 bool esp_log_impl_lock_timeout(void);
 void esp_log_impl_unlock(void);
+
+// Calls the function set with esp_log_set_vprintf
+int esp_log_impl_vprintf(const char *format, va_list args);
+
+#if CONFIG_LOG_DEFERRED && !BOOTLOADER_BUILD
+// Stores the message for esp_log_deferred_flush, returns false if it has to be printed right away
+bool esp_log_deferred_write(const char *format, va_list args);
+
+// Lets the other tasks run, including lower priority ones, while waiting for them
+void esp_log_impl_yield(void);
+#endif
@@ -10,6 +10,13 @@
 #include <cstdio>
 #include <regex>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstring>
 #include "esp_log.h"
 
 #include "catch.hpp"
@@ -279,3 +286,288 @@ TEST_CASE("changing early log level")
     ESP_EARLY_LOGI(TEST_TAG, "must indeed be printed");
     CHECK(regex_search(fix.get_print_buffer_string(), test_print) == true);
 }
+
+TEST_CASE("tag levels are consistent while they are changed concurrently")
+{
+    PrintFixture fix(ESP_LOG_INFO);
+    esp_log_level_set(TEST_TAG, ESP_LOG_WARN);
+    // each change of a level replaces the table of tags
+    atomic<bool> stop(false);
+    thread setter([&stop]() {
+        char tag[16];
+        for (int i = 0; !stop; ++i) {
+            snprintf(tag, sizeof(tag), "other%d", i % 100);
+            esp_log_level_set(tag, (i % 3) ? ESP_LOG_ERROR : ESP_LOG_DEBUG);
+        }
+    });
+    bool consistent = true;
+    for (int i = 0; i < 200000; ++i) {
+        consistent &= esp_log_level_get(TEST_TAG) == ESP_LOG_WARN;
+        consistent &= esp_log_level_get("unset") == ESP_LOG_INFO;
+    }
+    stop = true;
+    setter.join();
+    CHECK(consistent);
+
+    esp_log_level_set("other1", ESP_LOG_VERBOSE);
+    CHECK(esp_log_level_get("other1") == ESP_LOG_VERBOSE);
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    CHECK(esp_log_level_get("other1") == ESP_LOG_ERROR);
+    CHECK(esp_log_level_get(TEST_TAG) == ESP_LOG_ERROR);
+}
+
+TEST_CASE("filtered out log calls don't contend")
+{
+    const int CALLS = 2000000;
+    PrintFixture fix(ESP_LOG_INFO);
+    // tags with a level of their own are looked up in the tag table
+    for (int i = 0; i < 40; ++i) {
+        char tag[16];
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        esp_log_level_set(tag, ESP_LOG_WARN);
+    }
+    esp_log_level_set(TEST_TAG, ESP_LOG_WARN);
+
+    for (int threads : { 1, 4 }) {
+        vector<thread> loggers;
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            loggers.emplace_back([]() {
+                for (int i = 0; i < CALLS; ++i) {
+                    esp_log_write(ESP_LOG_INFO, TEST_TAG, "filtered out %d", i);
+                }
+            });
+        }
+        for (auto &logger : loggers) {
+            logger.join();
+        }
+        chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+        cout << "filtered out esp_log_write with " << threads << " thread(s): "
+             << elapsed.count() / ((long long) threads * CALLS) << " ns per call" << endl;
+    }
+    CHECK(fix.get_print_buffer_string().size() == 0);
+}
+
+#if CONFIG_LOG_DEFERRED
+struct DeferredFixture : BasicLogFixture {
+    DeferredFixture(size_t buffer_size = 4096) : BasicLogFixture(ESP_LOG_VERBOSE)
+    {
+        if (instance != nullptr) {
+            throw exception();
+        }
+
+        instance = this;
+
+        old_vprintf = esp_log_set_vprintf(print_callback);
+        REQUIRE(esp_log_deferred_start(buffer_size));
+    }
+
+    ~DeferredFixture()
+    {
+        esp_log_deferred_stop();
+        esp_log_set_vprintf(old_vprintf);
+        instance = nullptr;
+    }
+
+    vector<string> lines;
+
+private:
+    static int print_callback(const char *format, va_list args)
+    {
+        // messages which can't be deferred are printed by the writers themselves
+        lock_guard<mutex> lock(instance->print_mutex);
+        int ret = vsnprintf(instance->print_buffer, BUFFER_SIZE, format, args);
+        instance->lines.push_back(instance->print_buffer);
+        return ret;
+    }
+
+    static DeferredFixture *instance;
+
+    mutex print_mutex;
+
+    vprintf_like_t old_vprintf;
+};
+
+DeferredFixture *DeferredFixture::instance = nullptr;
+
+TEST_CASE("deferred log output is printed by esp_log_deferred_flush")
+{
+    DeferredFixture fix;
+    char stack_string[16] = "on the stack";
+
+    ESP_LOGI(TEST_TAG, "int %d, unsigned %u, long long %lld, size %zu, char %c", -5, 7u, -123456789012LL, (size_t) 42, 'x');
+    ESP_LOGW(TEST_TAG, "double %.3f, string %s, padded [%-6s], precision [%.*s], percent %%", 2.5, stack_string, "ab", 3, "abcdef");
+    ESP_LOGE(TEST_TAG, "pointer %p, null string %s", (void *) 0x1234, (const char *) NULL);
+    strcpy(stack_string, "overwritten");
+    CHECK(fix.lines.size() == 0);
+
+    CHECK(esp_log_deferred_flush() == 3);
+    REQUIRE(fix.lines.size() == 3);
+    CHECK(regex_search(fix.lines[0], regex("I \\([0-9]*\\) test: int -5, unsigned 7, long long -123456789012, size 42, char x")));
+    CHECK(regex_search(fix.lines[1], regex("W \\([0-9]*\\) test: double 2.500, string on the stack, padded \\[ab    \\], precision \\[abc\\], percent %")));
+    CHECK(regex_search(fix.lines[2], regex("E \\([0-9]*\\) test: pointer 0x1234, null string \\(null\\)")));
+    CHECK(esp_log_deferred_flush() == 0);
+
+    // the level is checked when the message is logged
+    esp_log_level_set(TEST_TAG, ESP_LOG_WARN);
+    ESP_LOGI(TEST_TAG, "must not be printed");
+    CHECK(esp_log_deferred_flush() == 0);
+}
+
+TEST_CASE("deferred log output reads strings with a precision only up to the precision")
+{
+    DeferredFixture fix;
+    // not zero-terminated, as the strings printed with a precision may be
+    unique_ptr<char[]> topic(new char[5]);
+    memcpy(topic.get(), "a/b/c", 5);
+    unique_ptr<char[]> payload(new char[4]);
+    memcpy(payload.get(), "data", 4);
+
+    ESP_LOGI(TEST_TAG, "topic [%.*s], payload [%.4s], negative precision [%.*s]", 5, topic.get(), payload.get(), -1, "all");
+
+    CHECK(esp_log_deferred_flush() == 1);
+    REQUIRE(fix.lines.size() == 1);
+    CHECK(regex_search(fix.lines[0], regex("I \\([0-9]*\\) test: topic \\[a/b/c\\], payload \\[data\\], negative precision \\[all\\]")));
+}
+
+TEST_CASE("deferred log output counts dropped messages")
+{
+    DeferredFixture fix(1024);
+
+    for (int i = 0; i < 100; ++i) {
+        ESP_LOGI(TEST_TAG, "message %d", i);
+    }
+    size_t printed = esp_log_deferred_flush();
+    CHECK(printed > 0);
+    CHECK(printed < 100);
+    REQUIRE(fix.lines.size() == printed + 1);
+    CHECK(regex_search(fix.lines[0], regex("I \\([0-9]*\\) test: message 0")));
+    CHECK(fix.lines.back() == to_string(100 - printed) + " deferred log messages dropped\n");
+
+    // the space is available again after flushing, also across the end of the buffer
+    fix.lines.clear();
+    for (int j = 0; j < 10; ++j) {
+        for (int i = 0; i < 10; ++i) {
+            ESP_LOGI(TEST_TAG, "message %d", i);
+        }
+        CHECK(esp_log_deferred_flush() == 10);
+    }
+    CHECK(fix.lines.size() == 100);
+}
+
+TEST_CASE("deferred log output prints messages which can't be deferred right away")
+{
+    DeferredFixture fix(1024);
+    const string long_string(300, 'a');
+
+    ESP_LOGI(TEST_TAG, "deferred");
+    ESP_LOGI(TEST_TAG, "too long for the buffer %s%s", long_string.c_str(), long_string.c_str());
+    REQUIRE(fix.lines.size() == 1);
+    CHECK(regex_search(fix.lines[0], regex("I \\([0-9]*\\) test: too long for the buffer a")));
+    CHECK(esp_log_deferred_flush() == 1);
+    CHECK(regex_search(fix.lines[1], regex("I \\([0-9]*\\) test: deferred")));
+}
+
+TEST_CASE("deferred log output keeps the order of concurrent writers")
+{
+    DeferredFixture fix(65536);
+    const int THREADS = 4;
+    const int MESSAGES = 2000;
+    atomic<int> running(THREADS);
+    vector<thread> writers;
+    for (int t = 0; t < THREADS; ++t) {
+        writers.emplace_back([t, &running]() {
+            for (int i = 0; i < MESSAGES; ++i) {
+                ESP_LOGI(TEST_TAG, "writer %d message %d", t, i);
+            }
+            --running;
+        });
+    }
+    size_t printed = 0;
+    while (running > 0) {
+        printed += esp_log_deferred_flush();
+        this_thread::yield();
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    printed += esp_log_deferred_flush();
+
+    const std::regex message_regex("writer ([0-9]+) message ([0-9]+)");
+    int next[THREADS] = { };
+    size_t dropped = 0;
+    for (const string &line : fix.lines) {
+        smatch match;
+        if (regex_search(line, match, message_regex)) {
+            int t = stoi(match[1]);
+            int i = stoi(match[2]);
+            // messages of one writer may only be missing if they have been dropped
+            CHECK(i >= next[t]);
+            next[t] = i + 1;
+        } else {
+            dropped += stoul(line);
+        }
+    }
+    CHECK(printed + dropped == THREADS * MESSAGES);
+}
+
+TEST_CASE("deferred log output can be stopped while writers and a flush are running")
+{
+    DeferredFixture fix(4096);
+    const int THREADS = 4;
+    atomic<bool> stopped(false);
+    vector<thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([t, &stopped]() {
+            for (int i = 0; !stopped; ++i) {
+                ESP_LOGI(TEST_TAG, "writer %d message %d", t, i);
+            }
+        });
+    }
+    threads.emplace_back([&stopped]() {
+        while (!stopped) {
+            esp_log_deferred_flush();
+        }
+    });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    esp_log_deferred_stop();
+    stopped = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+    CHECK(esp_log_deferred_flush() == 0);
+}
+
+TEST_CASE("deferred log output reduces the per-call cost")
+{
+    const int ROUNDS = 50;
+    const int MESSAGES = 200;
+    chrono::nanoseconds immediate(0);
+    chrono::nanoseconds deferred(0);
+    {
+        PrintFixture fix(ESP_LOG_INFO);
+        for (int r = 0; r < ROUNDS; ++r) {
+            auto start = chrono::steady_clock::now();
+            for (int i = 0; i < MESSAGES; ++i) {
+                ESP_LOGI(TEST_TAG, "sensor %d: %.2f degrees, status %s", i, i * 0.25, "ok");
+            }
+            immediate += chrono::steady_clock::now() - start;
+        }
+    }
+    {
+        DeferredFixture fix(65536);
+        esp_log_level_set("*", ESP_LOG_INFO);
+        for (int r = 0; r < ROUNDS; ++r) {
+            auto start = chrono::steady_clock::now();
+            for (int i = 0; i < MESSAGES; ++i) {
+                ESP_LOGI(TEST_TAG, "sensor %d: %.2f degrees, status %s", i, i * 0.25, "ok");
+            }
+            deferred += chrono::steady_clock::now() - start;
+            // rendering happens outside of the measured calls, as it would in a low priority task
+            CHECK(esp_log_deferred_flush() == MESSAGES);
+        }
+    }
+    cout << "ESP_LOGI per-call cost: immediate " << immediate.count() / (ROUNDS * MESSAGES)
+         << " ns, deferred " << deferred.count() / (ROUNDS * MESSAGES) << " ns" << endl;
+}
+#endif // CONFIG_LOG_DEFERRED
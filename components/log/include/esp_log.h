@@ -8,6 +8,8 @@
 #define __ESP_LOG_H__
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <inttypes.h>
 #include "sdkconfig.h"
@@ -144,6 +146,48 @@ void esp_log_write(esp_log_level_t level, const char* tag, const char* format, .
  */
 void esp_log_writev(esp_log_level_t level, const char* tag, const char* format, va_list args);
 
+#if CONFIG_LOG_DEFERRED
+/**
+ * @brief Start deferring log output
+ *
+ * From now on, esp_log_write and esp_log_writev don't format messages themselves. They store
+ * the format string pointer and the arguments in a buffer of the current CPU core instead,
+ * and esp_log_deferred_flush formats the messages and passes them to the function set with
+ * esp_log_set_vprintf. Strings passed as arguments are copied, so they don't need to outlive
+ * the call.
+ *
+ * Messages which don't fit into the buffer are dropped and counted, the count is printed by the
+ * next esp_log_deferred_flush. Messages which use "%n" or are too large for a quarter of the
+ * buffer are printed right away.
+ *
+ * @note Only available if CONFIG_LOG_DEFERRED is enabled.
+ *
+ * @param buffer_size Size of the buffer of each CPU core in bytes, rounded up to a power of two
+ *                    (at least 1024, at most 65536).
+ *
+ * @return true if the buffers have been allocated, false if deferred output is already running
+ *         or memory couldn't be allocated
+ */
+bool esp_log_deferred_start(size_t buffer_size);
+
+/**
+ * @brief Stop deferring log output
+ *
+ * Prints the pending messages and frees the buffers. Messages are printed right away again.
+ */
+void esp_log_deferred_stop(void);
+
+/**
+ * @brief Print pending deferred messages
+ *
+ * Only one task may print the messages at a time. If another task is running this function
+ * already, it returns right away. The function stops at a message which is still being written.
+ *
+ * @return Number of messages printed
+ */
+size_t esp_log_deferred_flush(void);
+#endif // CONFIG_LOG_DEFERRED
+
 /** @cond */
 
 #include "esp_log_internal.h"
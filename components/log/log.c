@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2021 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -8,24 +8,32 @@
  * Log library implementation notes.
  *
  * Log library stores all tags provided to esp_log_level_set as a linked
- * list. See uncached_tag_entry_t structure.
+ * list. See uncached_tag_entry_t structure. The list is only used by
+ * esp_log_level_set, under the log lock.
  *
- * To avoid looking up log level for given tag each time message is
- * printed, this library caches pointers to tags. Because the suggested
- * way of creating tags uses one 'TAG' constant per file, this caching
- * should be effective. Cache is a binary min-heap of cached_tag_entry_t
- * items, ordering is done on 'generation' member. In this context,
- * generation is an integer which is incremented each time an operation
- * with cache is performed. When cache is full, new item is inserted in
- * place of an oldest item (that is, with smallest 'generation' value).
- * After that, bubble-down operation is performed to fix ordering in the
- * min-heap.
+ * To look up the log level of a tag without taking a lock, each change
+ * of the list builds an immutable tag table (log_tag_table_t), which is
+ * then published by swapping the s_log_tag_table pointer. The table is
+ * an open addressing hash table of copies of the tags and their levels.
+ * As long as no tag has a level of its own, there is no table at all and
+ * the default level applies to every tag.
  *
- * The potential problem with wrap-around of cache generation counter is
- * ignored for now. This will happen if someone happens to output more
- * than 4 billion log entries, at which point wrap-around will not be
- * the biggest problem.
+ * Because the suggested way of creating tags uses one 'TAG' constant per
+ * file, a small direct mapped cache maps tag pointers to levels, so that
+ * most lookups don't need to hash and compare the tag string, nor touch
+ * the table at all. Each slot is a sequence lock: a writer claims the
+ * slot by making its sequence number odd with a compare-and-swap, writes
+ * the tag pointer, the level and the generation of the table the level was
+ * found in, and makes the sequence number even again. A reader only uses
+ * a slot if the sequence number was even and unchanged while it read the
+ * slot, and if the generation is the one of the current table.
  *
+ * Readers which look up a tag in the table count themselves in
+ * s_log_table_readers while they use it. A table which has been replaced
+ * is kept in a list of retired tables, which esp_log_level_set frees once
+ * it finds no readers. A reader that has loaded the table pointer before
+ * the swap has incremented the counter before that, so a zero count after
+ * the swap means the retired tables are no longer in use.
  */
 
 #include <stdbool.h>
@@ -34,6 +42,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdatomic.h>
 #include <assert.h>
 #include "esp_log.h"
 #include "esp_log_private.h"
@@ -41,20 +50,12 @@
 #ifndef NDEBUG
 // Enable built-in checks in queue.h in debug builds
 #define INVARIANTS
-// Enable consistency checks and cache statistics in this file.
-#define LOG_BUILTIN_CHECKS
 #endif
 
 #include "sys/queue.h"
 
-// Number of tags to be cached. Must be 2**n - 1, n >= 2.
-#define TAG_CACHE_SIZE 31
-
-typedef struct {
-    const char *tag;
-    uint32_t level : 3;
-    uint32_t generation : 29;
-} cached_tag_entry_t;
+// Number of slots of the tag pointer cache of each table. Must be 2**n.
+#define TAG_CACHE_SIZE 32
 
 typedef struct uncached_tag_entry_ {
     SLIST_ENTRY(uncached_tag_entry_) entries;
@@ -62,23 +63,41 @@ typedef struct uncached_tag_entry_ {
     char tag[0];    // beginning of a zero-terminated string
 } uncached_tag_entry_t;
 
+typedef struct {
+    const char *tag;    // copy of the tag, stored in the table
+    uint32_t hash;
+    uint8_t level;
+} tag_table_entry_t;
+
+typedef struct {
+    _Atomic uint32_t seq;           // odd while the slot is being written
+    _Atomic(const char *) tag;      // tag pointer passed by the caller
+    _Atomic uint32_t generation;
+    _Atomic uint8_t level;
+} tag_cache_slot_t;
+
+typedef struct log_tag_table_ {
+    struct log_tag_table_ *next_retired;
+    esp_log_level_t default_level;
+    uint32_t bucket_mask;
+    tag_table_entry_t *buckets;     // bucket_mask + 1 entries, tag == NULL if empty
+} log_tag_table_t;
+
 esp_log_level_t esp_log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
 static SLIST_HEAD(log_tags_head, uncached_tag_entry_) s_log_tags = SLIST_HEAD_INITIALIZER(s_log_tags);
-static cached_tag_entry_t s_log_cache[TAG_CACHE_SIZE];
-static uint32_t s_log_cache_max_generation = 0;
-static uint32_t s_log_cache_entry_count = 0;
+static _Atomic(log_tag_table_t *) s_log_tag_table = NULL;
+static _Atomic uint32_t s_log_table_generation = 0;
+static _Atomic uint32_t s_log_table_readers = 0;
+static log_tag_table_t *s_log_retired_tables = NULL;
+static tag_cache_slot_t s_log_cache[TAG_CACHE_SIZE];
 static vprintf_like_t s_log_print_func = &vprintf;
 
-#ifdef LOG_BUILTIN_CHECKS
-static uint32_t s_log_cache_misses = 0;
-#endif
-
 
-static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level);
-static inline bool get_uncached_log_level(const char *tag, esp_log_level_t *level);
-static inline void add_to_cache(const char *tag, esp_log_level_t level);
-static void heap_bubble_down(int index);
-static inline void heap_swap(int i, int j);
+static inline esp_log_level_t get_log_level(const char *tag);
+static inline bool get_cached_log_level(const char *tag, uint32_t generation, esp_log_level_t *level);
+static inline bool get_uncached_log_level(log_tag_table_t *table, const char *tag, esp_log_level_t *level);
+static inline void add_to_cache(const char *tag, uint32_t generation, esp_log_level_t level);
+static void update_tag_table(void);
 static inline bool should_output(esp_log_level_t level_for_message, esp_log_level_t level_for_tag);
 static inline void clear_log_level_list(void);
 
@@ -95,10 +114,11 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
 {
     esp_log_impl_lock();
 
-    // for wildcard tag, remove all linked list items and clear the cache
+    // for wildcard tag, remove all linked list items and drop the tag table
     if (strcmp(tag, "*") == 0) {
         esp_log_default_level = level;
         clear_log_level_list();
+        update_tag_table();
         esp_log_impl_unlock();
         return;
     }
@@ -107,6 +127,10 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
     uncached_tag_entry_t *it = NULL;
     SLIST_FOREACH(it, &s_log_tags, entries) {
         if (strcmp(it->tag, tag) == 0) {
+            if (it->level == level) {
+                esp_log_impl_unlock();
+                return;
+            }
             // one tag in the linked list matched, update the level
             it->level = level;
             // quit with it != NULL
@@ -128,46 +152,13 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
         SLIST_INSERT_HEAD(&s_log_tags, new_entry, entries);
     }
 
-    // search in the cache and update the entry it if exists
-    for (uint32_t i = 0; i < s_log_cache_entry_count; ++i) {
-#ifdef LOG_BUILTIN_CHECKS
-        assert(i == 0 || s_log_cache[(i - 1) / 2].generation < s_log_cache[i].generation);
-#endif
-        if (strcmp(s_log_cache[i].tag, tag) == 0) {
-            s_log_cache[i].level = level;
-            break;
-        }
-    }
-    esp_log_impl_unlock();
-}
-
-
-/* Common code for getting the log level from cache, esp_log_impl_lock()
-   should be called before calling this function. The function unlocks,
-   as indicated in the name.
-*/
-static esp_log_level_t s_log_level_get_and_unlock(const char *tag)
-{
-    esp_log_level_t level_for_tag;
-    // Look for the tag in cache first, then in the linked list of all tags
-    if (!get_cached_log_level(tag, &level_for_tag)) {
-        if (!get_uncached_log_level(tag, &level_for_tag)) {
-            level_for_tag = esp_log_default_level;
-        }
-        add_to_cache(tag, level_for_tag);
-#ifdef LOG_BUILTIN_CHECKS
-        ++s_log_cache_misses;
-#endif
-    }
+    update_tag_table();
     esp_log_impl_unlock();
-
-    return level_for_tag;
 }
 
 esp_log_level_t esp_log_level_get(const char *tag)
 {
-    esp_log_impl_lock();
-    return s_log_level_get_and_unlock(tag);
+    return get_log_level(tag);
 }
 
 void clear_log_level_list(void)
@@ -177,11 +168,6 @@ void clear_log_level_list(void)
         SLIST_REMOVE_HEAD(&s_log_tags, entries);
         free(it);
     }
-    s_log_cache_entry_count = 0;
-    s_log_cache_max_generation = 0;
-#ifdef LOG_BUILTIN_CHECKS
-    s_log_cache_misses = 0;
-#endif
 }
 
 void esp_log_writev(esp_log_level_t level,
@@ -189,18 +175,25 @@ void esp_log_writev(esp_log_level_t level,
                    const char *format,
                    va_list args)
 {
-    if (!esp_log_impl_lock_timeout()) {
-        return;
-    }
-    esp_log_level_t level_for_tag = s_log_level_get_and_unlock(tag);
+    esp_log_level_t level_for_tag = get_log_level(tag);
     if (!should_output(level, level_for_tag)) {
         return;
     }
 
+#if CONFIG_LOG_DEFERRED && !BOOTLOADER_BUILD
+    if (esp_log_deferred_write(format, args)) {
+        return;
+    }
+#endif
     (*s_log_print_func)(format, args);
 
 }
 
+int esp_log_impl_vprintf(const char *format, va_list args)
+{
+    return (*s_log_print_func)(format, args);
+}
+
 void esp_log_write(esp_log_level_t level,
                    const char *tag,
                    const char *format, ...)
@@ -211,97 +204,156 @@ void esp_log_write(esp_log_level_t level,
     va_end(list);
 }
 
-static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level)
+static inline uint32_t tag_hash(const char *tag)
 {
-    // Look for `tag` in cache
-    uint32_t i;
-    for (i = 0; i < s_log_cache_entry_count; ++i) {
-#ifdef LOG_BUILTIN_CHECKS
-        assert(i == 0 || s_log_cache[(i - 1) / 2].generation < s_log_cache[i].generation);
-#endif
-        if (s_log_cache[i].tag == tag) {
-            break;
-        }
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char *p = tag; *p; ++p) {
+        hash = (hash ^ (uint8_t) *p) * 16777619u;
     }
-    if (i == s_log_cache_entry_count) { // Not found in cache
+    return hash;
+}
+
+static inline uint32_t tag_cache_index(const char *tag)
+{
+    uintptr_t ptr = (uintptr_t) tag;
+    return (uint32_t) (ptr ^ (ptr >> 5) ^ (ptr >> 11)) & (TAG_CACHE_SIZE - 1);
+}
+
+static inline bool get_cached_log_level(const char *tag, uint32_t generation, esp_log_level_t *level)
+{
+    tag_cache_slot_t *slot = &s_log_cache[tag_cache_index(tag)];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq & 1) {
         return false;
     }
-    // Return level from cache
-    *level = (esp_log_level_t) s_log_cache[i].level;
-    // If cache has been filled, start taking ordering into account
-    // (other options are: dynamically resize cache, add "dummy" entries
-    //  to the cache; this option was chosen because code is much simpler,
-    //  and the unfair behavior of cache will show it self at most once, when
-    //  it has just been filled)
-    if (s_log_cache_entry_count == TAG_CACHE_SIZE) {
-        // Update item generation
-        s_log_cache[i].generation = s_log_cache_max_generation++;
-        // Restore heap ordering
-        heap_bubble_down(i);
+    bool found = atomic_load_explicit(&slot->tag, memory_order_relaxed) == tag &&
+                 atomic_load_explicit(&slot->generation, memory_order_relaxed) == generation;
+    uint8_t cached_level = atomic_load_explicit(&slot->level, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (!found || atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+        return false;
     }
+    *level = (esp_log_level_t) cached_level;
     return true;
 }
 
-static inline void add_to_cache(const char *tag, esp_log_level_t level)
+static inline void add_to_cache(const char *tag, uint32_t generation, esp_log_level_t level)
 {
-    uint32_t generation = s_log_cache_max_generation++;
-    // First consider the case when cache is not filled yet.
-    // In this case, just add new entry at the end.
-    // This happens to satisfy binary min-heap ordering.
-    if (s_log_cache_entry_count < TAG_CACHE_SIZE) {
-        s_log_cache[s_log_cache_entry_count] = (cached_tag_entry_t) {
-            .generation = generation,
-            .level = level,
-            .tag = tag
-        };
-        ++s_log_cache_entry_count;
+    tag_cache_slot_t *slot = &s_log_cache[tag_cache_index(tag)];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    // if another task is writing the slot at the moment, leave it to that task
+    if ((seq & 1) || !atomic_compare_exchange_strong_explicit(&slot->seq, &seq, seq + 1,
+                                                              memory_order_acq_rel, memory_order_relaxed)) {
         return;
     }
-
-    // Cache is full, so we replace the oldest entry (which is at index 0
-    // because this is a min-heap) with the new one, and do bubble-down
-    // operation to restore min-heap ordering.
-    s_log_cache[0] = (cached_tag_entry_t) {
-        .tag = tag,
-        .level = level,
-        .generation = generation
-    };
-    heap_bubble_down(0);
+    atomic_store_explicit(&slot->tag, tag, memory_order_relaxed);
+    atomic_store_explicit(&slot->generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&slot->level, (uint8_t) level, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
 }
 
-static inline bool get_uncached_log_level(const char *tag, esp_log_level_t *level)
+static inline bool get_uncached_log_level(log_tag_table_t *table, const char *tag, esp_log_level_t *level)
 {
-    // Walk the linked list of all tags and see if given tag is present in the list.
-    // This is slow because tags are compared as strings.
-    uncached_tag_entry_t *it;
-    SLIST_FOREACH(it, &s_log_tags, entries) {
-        if (strcmp(tag, it->tag) == 0) {
-            *level = it->level;
+    // Look for the tag in the table, this is slower because tags are compared as strings.
+    const uint32_t hash = tag_hash(tag);
+    for (uint32_t i = hash & table->bucket_mask; table->buckets[i].tag != NULL; i = (i + 1) & table->bucket_mask) {
+        if (table->buckets[i].hash == hash && strcmp(table->buckets[i].tag, tag) == 0) {
+            *level = (esp_log_level_t) table->buckets[i].level;
             return true;
         }
     }
     return false;
 }
 
-static inline bool should_output(esp_log_level_t level_for_message, esp_log_level_t level_for_tag)
+static inline esp_log_level_t get_log_level(const char *tag)
 {
-    return level_for_message <= level_for_tag;
+    if (atomic_load_explicit(&s_log_tag_table, memory_order_relaxed) == NULL) {
+        // no tag has a level of its own
+        return esp_log_default_level;
+    }
+
+    // the generation has to be loaded before the table, as esp_log_level_set updates it after the table
+    const uint32_t generation = atomic_load(&s_log_table_generation);
+    esp_log_level_t level;
+    if (get_cached_log_level(tag, generation, &level)) {
+        return level;
+    }
+
+    atomic_fetch_add(&s_log_table_readers, 1);
+    log_tag_table_t *table = atomic_load(&s_log_tag_table);
+    if (table == NULL) {
+        level = esp_log_default_level;
+    } else if (!get_uncached_log_level(table, tag, &level)) {
+        level = table->default_level;
+    }
+    atomic_fetch_sub(&s_log_table_readers, 1);
+    add_to_cache(tag, generation, level);
+    return level;
 }
 
-static void heap_bubble_down(int index)
+/* Builds a table of the tags in the linked list and publishes it, then
+   frees the tables which have been replaced, if no task is using them.
+   Must be called under the log lock.
+*/
+static void update_tag_table(void)
 {
-    while (index < TAG_CACHE_SIZE / 2) {
-        int left_index = index * 2 + 1;
-        int right_index = left_index + 1;
-        int next = (s_log_cache[left_index].generation < s_log_cache[right_index].generation) ? left_index : right_index;
-        heap_swap(index, next);
-        index = next;
+    log_tag_table_t *table = NULL;
+    size_t count = 0;
+    size_t strings_size = 0;
+    uncached_tag_entry_t *it;
+    SLIST_FOREACH(it, &s_log_tags, entries) {
+        ++count;
+        strings_size += strlen(it->tag) + 1;
+    }
+
+    if (count > 0) {
+        size_t bucket_count = 4;
+        while (bucket_count < count * 2) {
+            bucket_count <<= 1;
+        }
+        table = calloc(1, sizeof(log_tag_table_t) + bucket_count * sizeof(tag_table_entry_t) + strings_size);
+        if (table == NULL) {
+            // keep the previous table, the next change will try again
+            return;
+        }
+        table->default_level = esp_log_default_level;
+        table->bucket_mask = bucket_count - 1;
+        table->buckets = (tag_table_entry_t *) (table + 1);
+        char *strings = (char *) (table->buckets + bucket_count);
+        SLIST_FOREACH(it, &s_log_tags, entries) {
+            size_t tag_len = strlen(it->tag) + 1;
+            uint32_t hash = tag_hash(it->tag);
+            uint32_t i = hash & table->bucket_mask;
+            while (table->buckets[i].tag != NULL) {
+                i = (i + 1) & table->bucket_mask;
+            }
+            memcpy(strings, it->tag, tag_len);
+            table->buckets[i] = (tag_table_entry_t) {
+                .tag = strings,
+                .hash = hash,
+                .level = it->level,
+            };
+            strings += tag_len;
+        }
+    }
+
+    log_tag_table_t *old_table = atomic_exchange(&s_log_tag_table, table);
+    atomic_fetch_add(&s_log_table_generation, 1);
+    if (old_table) {
+        old_table->next_retired = s_log_retired_tables;
+        s_log_retired_tables = old_table;
+    }
+    if (atomic_load(&s_log_table_readers) == 0) {
+        while (s_log_retired_tables) {
+            log_tag_table_t *retired = s_log_retired_tables;
+            s_log_retired_tables = retired->next_retired;
+            free(retired);
+        }
     }
 }
 
-static inline void heap_swap(int i, int j)
+static inline bool should_output(esp_log_level_t level_for_message, esp_log_level_t level_for_tag)
 {
-    cached_tag_entry_t tmp = s_log_cache[i];
-    s_log_cache[i] = s_log_cache[j];
-    s_log_cache[j] = tmp;
+    return level_for_message <= level_for_tag;
 }
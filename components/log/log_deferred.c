@@ -0,0 +1,584 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Deferred log output.
+ *
+ * Instead of formatting a message on the calling task, esp_log_writev
+ * stores the format string pointer and the raw arguments as a record in a
+ * ring buffer, and esp_log_deferred_flush renders the records later on.
+ * Each CPU core has its own ring buffer, so tasks on different cores don't
+ * compete for the same cache lines.
+ *
+ * A producer reserves space for a record by advancing the 'head' of the
+ * ring with a compare-and-swap, fills the record and then publishes it by
+ * setting the LOG_RECORD_COMMITTED bit of the record header. Several
+ * producers may fill their records at the same time (tasks which preempt
+ * each other or run on another core than the ring belongs to). The single
+ * consumer renders records starting at 'tail' as long as they are
+ * committed, clears their headers and advances 'tail'. Records don't wrap
+ * around the end of the ring; the space up to the end is filled with a
+ * padding record instead.
+ *
+ * Records are merged across the rings in the order of a global sequence
+ * number, which a producer takes between reading 'head' and advancing it.
+ * If another producer reserves space in the meantime, the compare-and-swap
+ * fails and a new number is taken, so the numbers of the records of a ring
+ * increase in the order of the ring. Strings passed as %s arguments are copied into the record, since
+ * they may live on the stack of the caller (or in the static buffer of
+ * esp_log_system_timestamp).
+ */
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include "soc/soc_caps.h"
+#include "esp_cpu.h"
+#define LOG_DEFERRED_CORES SOC_CPU_CORES_NUM
+#define LOG_DEFERRED_CORE_ID() esp_cpu_get_core_id()
+#else
+#define LOG_DEFERRED_CORES 1
+#define LOG_DEFERRED_CORE_ID() 0
+#endif
+
+#define LOG_RECORD_COMMITTED    (1u << 31)
+#define LOG_RECORD_PADDING      (1u << 30)
+#define LOG_RECORD_SIZE_MASK    0xffffu
+
+// Strings longer than this are truncated when they are copied into a record
+#define LOG_MAX_STRING_LEN      255
+// Precision given by a '*' argument, see parse_spec
+#define PRECISION_STAR          (-2)
+// Size of the buffer a message is rendered into, longer messages are truncated
+#define LOG_LINE_SIZE           256
+#define LOG_MIN_BUFFER_SIZE     1024
+
+typedef enum {
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_PTR,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_STR,
+    ARG_NONE,       // "%%"
+    ARG_INVALID,    // "%n" or a conversion which isn't known
+} arg_type_t;
+
+typedef struct {
+    uint32_t header;        // size of the record and LOG_RECORD_* flags
+    uint32_t seq;
+    const char *format;
+    uint8_t args[0];
+} log_record_t;
+
+#define LOG_RECORD_ALIGN        _Alignof(log_record_t)
+
+typedef struct {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint32_t writers;
+    uint32_t size;          // power of two
+    uint8_t *data;
+} log_ring_t;
+
+static log_ring_t s_rings[LOG_DEFERRED_CORES];
+static _Atomic bool s_enabled = false;
+static _Atomic bool s_flushing = false;
+static _Atomic uint32_t s_seq = 0;
+static _Atomic uint32_t s_dropped = 0;
+
+static size_t flush_records(void);
+
+/* Parses the conversion specification starting after '%'. Returns the type
+   of the argument it consumes, the number of '*' width/precision arguments
+   which precede it, the precision (-1 if there is none, PRECISION_STAR if it
+   is the last of these arguments) and the end of the specification.
+*/
+static arg_type_t parse_spec(const char *spec, const char **end, int *stars, int *precision)
+{
+    const char *p = spec;
+    *stars = 0;
+    *precision = -1;
+    while (*p && strchr("-+ #0'", *p)) {
+        ++p;
+    }
+    if (*p == '*') {
+        ++*stars;
+        ++p;
+    }
+    while (*p >= '0' && *p <= '9') {
+        ++p;
+    }
+    if (*p == '.') {
+        ++p;
+        *precision = 0;
+        if (*p == '*') {
+            ++*stars;
+            *precision = PRECISION_STAR;
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9') {
+            // only compared with LOG_MAX_STRING_LEN, don't let it overflow
+            if (*precision < LOG_MAX_STRING_LEN) {
+                *precision = *precision * 10 + (*p - '0');
+            }
+            ++p;
+        }
+    }
+
+    arg_type_t int_type = ARG_INT;
+    bool long_double = false;
+    switch (*p) {
+    case 'h':
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        if (p[1] == 'l') {
+            int_type = ARG_LLONG;
+            p += 2;
+        } else {
+            int_type = ARG_LONG;
+            ++p;
+        }
+        break;
+    case 'j':
+        int_type = ARG_INTMAX;
+        ++p;
+        break;
+    case 'z':
+        int_type = ARG_SIZE;
+        ++p;
+        break;
+    case 't':
+        int_type = ARG_PTRDIFF;
+        ++p;
+        break;
+    case 'L':
+        long_double = true;
+        ++p;
+        break;
+    default:
+        break;
+    }
+
+    if (*p == '\0') {
+        *end = p;
+        return ARG_INVALID;
+    }
+    *end = p + 1;
+    switch (*p) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        return int_type;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        return long_double ? ARG_LDOUBLE : ARG_DOUBLE;
+    case 'p':
+        return ARG_PTR;
+    case 's':
+        return (int_type == ARG_INT) ? ARG_STR : ARG_INVALID; // no wide strings
+    case '%':
+        return ARG_NONE;
+    default:
+        return ARG_INVALID;
+    }
+}
+
+/* Walks the format string and either measures (dst == NULL) or stores the
+   arguments. Returns the size of the stored arguments, or 0 with *ok set to
+   false if the format contains a conversion which can't be deferred.
+*/
+static size_t capture_args(const char *format, va_list args, uint8_t *dst, bool *ok)
+{
+    size_t size = 0;
+    *ok = true;
+    for (const char *p = strchr(format, '%'); p != NULL; p = strchr(p, '%')) {
+        int stars;
+        int precision;
+        arg_type_t type = parse_spec(p + 1, &p, &stars, &precision);
+        if (type == ARG_INVALID) {
+            *ok = false;
+            return 0;
+        }
+        int star_values[2];
+        for (int i = 0; i < stars; ++i) {
+            star_values[i] = va_arg(args, int);
+            if (dst) {
+                memcpy(dst + size, &star_values[i], sizeof(int));
+            }
+            size += sizeof(int);
+        }
+        if (precision == PRECISION_STAR) {
+            // a negative precision is taken as if it was omitted
+            precision = star_values[stars - 1] >= 0 ? star_values[stars - 1] : -1;
+        }
+
+#define CAPTURE(type_) do { \
+            type_ value_ = va_arg(args, type_); \
+            if (dst) { \
+                memcpy(dst + size, &value_, sizeof(value_)); \
+            } \
+            size += sizeof(value_); \
+        } while(0)
+
+        switch (type) {
+        case ARG_INT:       CAPTURE(int); break;
+        case ARG_LONG:      CAPTURE(long); break;
+        case ARG_LLONG:     CAPTURE(long long); break;
+        case ARG_INTMAX:    CAPTURE(intmax_t); break;
+        case ARG_SIZE:      CAPTURE(size_t); break;
+        case ARG_PTRDIFF:   CAPTURE(ptrdiff_t); break;
+        case ARG_PTR:       CAPTURE(void *); break;
+        case ARG_DOUBLE:    CAPTURE(double); break;
+        case ARG_LDOUBLE:   CAPTURE(long double); break;
+        case ARG_STR: {
+            // stored as a length byte followed by the zero-terminated string, 0xff for NULL
+            const char *str = va_arg(args, const char *);
+            if (str == NULL) {
+                if (dst) {
+                    dst[size] = 0xff;
+                }
+                size += 1;
+                break;
+            }
+            // with a precision, the string doesn't need to be zero-terminated
+            size_t max_len = LOG_MAX_STRING_LEN - 1;
+            if (precision >= 0 && (size_t) precision < max_len) {
+                max_len = precision;
+            }
+            size_t len = strnlen(str, max_len);
+            if (dst) {
+                dst[size] = (uint8_t) len;
+                memcpy(dst + size + 1, str, len);
+                dst[size + 1 + len] = '\0';
+            }
+            size += len + 2;
+            break;
+        }
+        default:
+            break;
+        }
+#undef CAPTURE
+    }
+    return size;
+}
+
+bool esp_log_deferred_start(size_t buffer_size)
+{
+    if (atomic_load(&s_enabled)) {
+        return false;
+    }
+    size_t size = LOG_MIN_BUFFER_SIZE;
+    while (size < buffer_size && size <= LOG_RECORD_SIZE_MASK) {
+        size <<= 1;
+    }
+    for (int i = 0; i < LOG_DEFERRED_CORES; ++i) {
+        log_ring_t *ring = &s_rings[i];
+        ring->data = calloc(1, size);
+        if (ring->data == NULL) {
+            for (int j = 0; j < i; ++j) {
+                free(s_rings[j].data);
+                s_rings[j].data = NULL;
+            }
+            return false;
+        }
+        ring->size = size;
+        atomic_store(&ring->head, 0);
+        atomic_store(&ring->tail, 0);
+    }
+    atomic_store(&s_dropped, 0);
+    atomic_store(&s_enabled, true);
+    return true;
+}
+
+void esp_log_deferred_stop(void)
+{
+    if (!atomic_exchange(&s_enabled, false)) {
+        return;
+    }
+    // wait for the writers which have seen s_enabled set and for a flush in progress before
+    // rendering the remaining records, they may have been preempted by this task
+    for (int i = 0; i < LOG_DEFERRED_CORES; ++i) {
+        while (atomic_load(&s_rings[i].writers) != 0) {
+            esp_log_impl_yield();
+        }
+    }
+    bool expected = false;
+    while (!atomic_compare_exchange_strong(&s_flushing, &expected, true)) {
+        expected = false;
+        esp_log_impl_yield();
+    }
+    flush_records();
+    for (int i = 0; i < LOG_DEFERRED_CORES; ++i) {
+        free(s_rings[i].data);
+        s_rings[i].data = NULL;
+    }
+    atomic_store(&s_flushing, false);
+}
+
+/* Reserves space for a record of the given size (a multiple of LOG_RECORD_ALIGN) and
+   returns it along with its sequence number, or NULL if the ring is full.
+*/
+static log_record_t *ring_reserve(log_ring_t *ring, uint32_t size, uint32_t *seq)
+{
+    const uint32_t mask = ring->size - 1;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t padding;
+    do {
+        const uint32_t offset = head & mask;
+        padding = (offset + size > ring->size) ? ring->size - offset : 0;
+        const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head + padding + size - tail > ring->size) {
+            return NULL;
+        }
+        *seq = atomic_fetch_add_explicit(&s_seq, 1, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&ring->head, &head, head + padding + size,
+                                                    memory_order_acq_rel, memory_order_acquire));
+    if (padding) {
+        log_record_t *pad = (log_record_t *) (ring->data + (head & mask));
+        atomic_store_explicit((_Atomic uint32_t *) &pad->header, LOG_RECORD_COMMITTED | LOG_RECORD_PADDING | padding,
+                              memory_order_release);
+    }
+    return (log_record_t *) (ring->data + ((head + padding) & mask));
+}
+
+bool esp_log_deferred_write(const char *format, va_list args)
+{
+    if (!atomic_load_explicit(&s_enabled, memory_order_relaxed)) {
+        return false;
+    }
+    log_ring_t *ring = &s_rings[LOG_DEFERRED_CORE_ID()];
+    atomic_fetch_add_explicit(&ring->writers, 1, memory_order_acquire);
+    if (!atomic_load_explicit(&s_enabled, memory_order_acquire)) {
+        atomic_fetch_sub_explicit(&ring->writers, 1, memory_order_release);
+        return false;
+    }
+
+    bool ok;
+    va_list measure;
+    va_copy(measure, args);
+    size_t args_size = capture_args(format, measure, NULL, &ok);
+    va_end(measure);
+    const uint32_t size = (offsetof(log_record_t, args) + args_size + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+    if (!ok || size > ring->size / 4) {
+        // can't be deferred, let the caller print the message right away
+        atomic_fetch_sub_explicit(&ring->writers, 1, memory_order_release);
+        return false;
+    }
+
+    uint32_t seq;
+    log_record_t *record = ring_reserve(ring, size, &seq);
+    if (record == NULL) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+    } else {
+        record->seq = seq;
+        record->format = format;
+        capture_args(format, args, record->args, &ok);
+        atomic_store_explicit((_Atomic uint32_t *) &record->header, LOG_RECORD_COMMITTED | size, memory_order_release);
+    }
+    atomic_fetch_sub_explicit(&ring->writers, 1, memory_order_release);
+    return true;
+}
+
+static size_t render_one(char *dst, size_t size, const char *spec, ...)
+{
+    va_list args;
+    va_start(args, spec);
+    int len = vsnprintf(dst, size, spec, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return ((size_t) len < size) ? (size_t) len : size - 1;
+}
+
+/* Renders a record into line, which is LOG_LINE_SIZE bytes long, following
+   the format string once more to find out the types of the arguments.
+*/
+static void render_record(const log_record_t *record, char *line)
+{
+    const uint8_t *arg = record->args;
+    const char *p = record->format;
+    size_t len = 0;
+    char spec[32];
+    line[0] = '\0';
+    while (*p && len < LOG_LINE_SIZE - 1) {
+        const char *percent = strchr(p, '%');
+        size_t literal = percent ? (size_t) (percent - p) : strlen(p);
+        if (literal > LOG_LINE_SIZE - 1 - len) {
+            literal = LOG_LINE_SIZE - 1 - len;
+        }
+        memcpy(line + len, p, literal);
+        len += literal;
+        line[len] = '\0';
+        if (percent == NULL || len == LOG_LINE_SIZE - 1) {
+            break;
+        }
+
+        int stars;
+        const char *end;
+        int precision;
+        arg_type_t type = parse_spec(percent + 1, &end, &stars, &precision);
+        size_t spec_len = end - percent;
+        if (spec_len >= sizeof(spec)) {
+            break;
+        }
+        memcpy(spec, percent, spec_len);
+        spec[spec_len] = '\0';
+        p = end;
+
+        int star[2] = { 0, 0 };
+        for (int i = 0; i < stars; ++i) {
+            memcpy(&star[i], arg, sizeof(int));
+            arg += sizeof(int);
+        }
+
+#define RENDER(value_) do { \
+            if (stars == 0) { \
+                len += render_one(line + len, LOG_LINE_SIZE - len, spec, value_); \
+            } else if (stars == 1) { \
+                len += render_one(line + len, LOG_LINE_SIZE - len, spec, star[0], value_); \
+            } else { \
+                len += render_one(line + len, LOG_LINE_SIZE - len, spec, star[0], star[1], value_); \
+            } \
+        } while(0)
+
+#define RENDER_ARG(type_) do { \
+            type_ value_; \
+            memcpy(&value_, arg, sizeof(value_)); \
+            arg += sizeof(value_); \
+            RENDER(value_); \
+        } while(0)
+
+        switch (type) {
+        case ARG_INT:       RENDER_ARG(int); break;
+        case ARG_LONG:      RENDER_ARG(long); break;
+        case ARG_LLONG:     RENDER_ARG(long long); break;
+        case ARG_INTMAX:    RENDER_ARG(intmax_t); break;
+        case ARG_SIZE:      RENDER_ARG(size_t); break;
+        case ARG_PTRDIFF:   RENDER_ARG(ptrdiff_t); break;
+        case ARG_PTR:       RENDER_ARG(void *); break;
+        case ARG_DOUBLE:    RENDER_ARG(double); break;
+        case ARG_LDOUBLE:   RENDER_ARG(long double); break;
+        case ARG_STR:
+            if (arg[0] == 0xff) {
+                arg += 1;
+                RENDER((const char *) NULL);
+            } else {
+                const char *str = (const char *) arg + 1;
+                arg += arg[0] + 2;
+                RENDER(str);
+            }
+            break;
+        default:
+            len += render_one(line + len, LOG_LINE_SIZE - len, spec);
+            break;
+        }
+#undef RENDER_ARG
+#undef RENDER
+    }
+    if (len == LOG_LINE_SIZE - 1 && line[len - 1] != '\n') {
+        // keep messages which have been cut off on separate lines
+        line[len - 1] = '\n';
+    }
+}
+
+static int print_line(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int ret = esp_log_impl_vprintf(format, args);
+    va_end(args);
+    return ret;
+}
+
+/* Returns the committed record at the tail of the ring, skipping padding,
+   NULL if the ring is empty. Sets *busy if the record at the tail hasn't
+   been committed yet.
+*/
+static log_record_t *ring_peek(log_ring_t *ring, bool *busy)
+{
+    const uint32_t mask = ring->size - 1;
+    while (true) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            return NULL;
+        }
+        log_record_t *record = (log_record_t *) (ring->data + (tail & mask));
+        uint32_t header = atomic_load_explicit((_Atomic uint32_t *) &record->header, memory_order_acquire);
+        if (!(header & LOG_RECORD_COMMITTED)) {
+            *busy = true;
+            return NULL;
+        }
+        if (!(header & LOG_RECORD_PADDING)) {
+            return record;
+        }
+        record->header = 0;
+        atomic_store_explicit(&ring->tail, tail + (header & LOG_RECORD_SIZE_MASK), memory_order_release);
+    }
+}
+
+static void ring_pop(log_ring_t *ring, log_record_t *record)
+{
+    uint32_t size = record->header & LOG_RECORD_SIZE_MASK;
+    memset(record, 0, size);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + size, memory_order_release);
+}
+
+// Renders the pending records, s_flushing must be set by the caller
+static size_t flush_records(void)
+{
+    size_t count = 0;
+    char line[LOG_LINE_SIZE];
+    while (s_rings[0].data != NULL) {
+        // render the oldest record of all rings
+        log_ring_t *oldest_ring = NULL;
+        log_record_t *oldest = NULL;
+        bool busy = false;
+        for (int i = 0; i < LOG_DEFERRED_CORES; ++i) {
+            log_record_t *record = ring_peek(&s_rings[i], &busy);
+            if (record && (oldest == NULL || (int32_t) (record->seq - oldest->seq) < 0)) {
+                oldest = record;
+                oldest_ring = &s_rings[i];
+            }
+        }
+        if (oldest == NULL || busy) {
+            break;
+        }
+        render_record(oldest, line);
+        ring_pop(oldest_ring, oldest);
+        print_line("%s", line);
+        ++count;
+    }
+    uint32_t dropped = atomic_exchange(&s_dropped, 0);
+    if (dropped) {
+        print_line("%u deferred log messages dropped\n", (unsigned) dropped);
+    }
+    return count;
+}
+
+size_t esp_log_deferred_flush(void)
+{
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&s_flushing, &expected, true)) {
+        return 0;
+    }
+    size_t count = flush_records();
+    atomic_store(&s_flushing, false);
+    return count;
+}
@@ -56,6 +56,15 @@ void esp_log_impl_unlock(void)
     xSemaphoreGive(s_log_mutex);
 }
 
+#if CONFIG_LOG_DEFERRED
+void esp_log_impl_yield(void)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        vTaskDelay(1);
+    }
+}
+#endif
+
 char *esp_log_system_timestamp(void)
 {
     static char buffer[18] = {0};
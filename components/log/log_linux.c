@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 #include <assert.h>
 #include <stdint.h>
@@ -36,6 +37,13 @@ void esp_log_impl_unlock(void)
     assert(pthread_mutex_unlock(&mutex1) == 0);
 }
 
+#if CONFIG_LOG_DEFERRED
+void esp_log_impl_yield(void)
+{
+    sched_yield();
+}
+#endif
+
 uint32_t esp_log_timestamp(void)
 {
     struct timespec current_time;
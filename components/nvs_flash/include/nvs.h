@@ -64,8 +64,9 @@ typedef nvs_handle_t nvs_handle IDF_DEPRECATED("Replace with nvs_handle_t");
  * @brief Mode of opening the non-volatile storage
  */
 typedef enum {
-	NVS_READONLY,  /*!< Read only */
-	NVS_READWRITE  /*!< Read and write */
+	NVS_READONLY,                /*!< Read only */
+	NVS_READWRITE,               /*!< Read and write */
+	NVS_READWRITE_TRANSACTIONAL  /*!< Read and write; modifications are kept in RAM until nvs_commit writes them atomically */
 } nvs_open_mode_t;
 
 /*
@@ -106,6 +107,11 @@ typedef struct {
  */
 typedef struct nvs_opaque_iterator_t *nvs_iterator_t;
 
+/**
+ * Opaque pointer type representing a blob being written piece by piece, see nvs_blob_writer_open
+ */
+typedef struct nvs_opaque_blob_writer_t *nvs_blob_writer_t;
+
 /**
  * @brief      Open non-volatile storage with a given namespace from the default NVS partition
  *
@@ -116,9 +122,11 @@ typedef struct nvs_opaque_iterator_t *nvs_iterator_t;
  * table.
  *
  * @param[in]  namespace_name   Namespace name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
- * @param[in]  open_mode        NVS_READWRITE or NVS_READONLY. If NVS_READONLY, will
- *                              open a handle for reading only. All write requests will
- *                              be rejected for this handle.
+ * @param[in]  open_mode        NVS_READWRITE, NVS_READWRITE_TRANSACTIONAL or NVS_READONLY.
+ *                              If NVS_READONLY, will open a handle for reading only.
+ *                              All write requests will be rejected for this handle.
+ *                              If NVS_READWRITE_TRANSACTIONAL, changes are applied
+ *                              atomically by nvs_commit, see there.
  * @param[out] out_handle       If successful (return code is zero), handle will be
  *                              returned in this argument.
  *
@@ -147,9 +155,11 @@ esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode, nvs_ha
  *
  * @param[in]  part_name        Label (name) of the partition of interest for object read/write/erase
  * @param[in]  namespace_name   Namespace name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
- * @param[in]  open_mode        NVS_READWRITE or NVS_READONLY. If NVS_READONLY, will
- *                              open a handle for reading only. All write requests will
- *                              be rejected for this handle.
+ * @param[in]  open_mode        NVS_READWRITE, NVS_READWRITE_TRANSACTIONAL or NVS_READONLY.
+ *                              If NVS_READONLY, will open a handle for reading only.
+ *                              All write requests will be rejected for this handle.
+ *                              If NVS_READWRITE_TRANSACTIONAL, changes are applied
+ *                              atomically by nvs_commit, see there.
  * @param[out] out_handle       If successful (return code is zero), handle will be
  *                              returned in this argument.
  *
@@ -307,6 +317,93 @@ esp_err_t nvs_set_str (nvs_handle_t handle, const char* key, const char* value);
  */
 esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
 
+/**
+ * @brief      Start writing a blob piece by piece
+ *
+ * Unlike nvs_set_blob, the value doesn't have to be available in one buffer. Data passed to
+ * nvs_blob_writer_append is collected in a buffer of the size of one chunk (about 4000 bytes)
+ * and written to flash whenever the buffer is full. The previous value of the blob stays
+ * readable until nvs_blob_writer_finish replaces it. If the write is aborted, or power is lost
+ * before it is finished, the data written so far is discarded and the previous value is kept.
+ *
+ * \code{c}
+ * // Example (without error checking) of storing data received in packets:
+ * nvs_blob_writer_t writer;
+ * nvs_blob_writer_open(my_handle, "artifact", &writer);
+ * while ((len = receive_packet(packet, sizeof(packet))) > 0) {
+ *     nvs_blob_writer_append(writer, packet, len);
+ * }
+ * nvs_blob_writer_finish(writer);
+ * \endcode
+ *
+ * If the key is written by other means while the writer is open, e.g. by nvs_set_blob or by another
+ * writer, or if its namespace is erased, the data written so far is discarded, and the writer fails
+ * with ESP_ERR_NVS_INVALID_STATE. Transactional handles don't support writers.
+ *
+ * @param[in]  handle      Handle obtained from nvs_open function.
+ *                         Handles that were opened read only cannot be used.
+ * @param[in]  key         Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[out] out_writer  Writer, which has to be released with nvs_blob_writer_finish or nvs_blob_writer_abort.
+ *
+ * @return
+ *             - ESP_OK if the writer was created successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if storage handle was opened as read only
+ *             - ESP_ERR_NVS_KEY_TOO_LONG if the key is too long
+ *             - ESP_ERR_NOT_SUPPORTED if the handle is transactional
+ *             - ESP_ERR_NO_MEM if memory for the writer can't be allocated
+ */
+esp_err_t nvs_blob_writer_open(nvs_handle_t handle, const char* key, nvs_blob_writer_t* out_writer);
+
+/**
+ * @brief      Append data to a blob opened with nvs_blob_writer_open
+ *
+ * @param[in]  writer  Writer obtained from nvs_blob_writer_open.
+ * @param[in]  data    Data to append.
+ * @param[in]  length  Length of data in bytes.
+ *
+ * @return
+ *             - ESP_OK if the data was appended successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if the handle of the writer has been closed
+ *             - ESP_ERR_NVS_INVALID_STATE if the key has been written by other means meanwhile
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space in the
+ *               underlying storage to save the value
+ *             - ESP_ERR_NVS_VALUE_TOO_LONG if the blob would become too long, in which case
+ *               the data isn't appended
+ *             - other errors if writing to flash failed; the writer then only accepts
+ *               nvs_blob_writer_abort or nvs_blob_writer_finish, which both discard the data
+ */
+esp_err_t nvs_blob_writer_append(nvs_blob_writer_t writer, const void* data, size_t length);
+
+/**
+ * @brief      Write the rest of the blob, replace the previous value of the key with it and release the writer
+ *
+ * @param[in]  writer  Writer obtained from nvs_blob_writer_open.
+ *
+ * @return
+ *             - ESP_OK if the blob was stored successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if the handle of the writer has been closed; the data is discarded
+ *             - ESP_ERR_NVS_INVALID_STATE if the key has been written by other means meanwhile
+ *             - ESP_ERR_NVS_REMOVE_FAILED if the blob was stored, but the previous value couldn't be erased.
+ *               It will be erased after re-initialization of nvs.
+ *             - the error of a failed nvs_blob_writer_append or other errors if writing to flash failed;
+ *               in these cases the data is discarded and the previous value is kept
+ */
+esp_err_t nvs_blob_writer_finish(nvs_blob_writer_t writer);
+
+/**
+ * @brief      Discard the data written so far and release the writer
+ *
+ * @param[in]  writer  Writer obtained from nvs_blob_writer_open.
+ *
+ * @return
+ *             - ESP_OK if the data has been discarded
+ *             - ESP_ERR_NVS_INVALID_HANDLE if the handle of the writer has been closed; the data is
+ *               discarded all the same, or after re-initialization of nvs if the partition has been
+ *               deinitialized
+ */
+esp_err_t nvs_blob_writer_abort(nvs_blob_writer_t writer);
+
 /**@{*/
 /**
  * @brief      get int8_t value for given key
@@ -463,6 +560,117 @@ esp_err_t nvs_get_str (nvs_handle_t handle, const char* key, char* out_value, si
 esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length);
 /**@}*/
 
+/**
+ * @brief      Callback receiving one chunk of a blob read by nvs_get_blob_chunks
+ *
+ * @param[in]  data    Chunk data. Only valid until the callback returns.
+ * @param[in]  length  Length of the chunk in bytes.
+ * @param[in]  offset  Offset of the chunk within the blob.
+ * @param[in]  arg     Argument passed to nvs_get_blob_chunks.
+ *
+ * @return     ESP_OK to continue with the next chunk, any other value to stop the read
+ */
+typedef esp_err_t (*nvs_blob_chunk_cb_t)(const void* data, size_t length, size_t offset, void* arg);
+
+/**
+ * @brief      Read a blob chunk by chunk, without copying it into a buffer of the size of the blob
+ *
+ * The callback is called with each non-empty chunk of the blob, in order of offset. If the partition can
+ * be memory-mapped, the chunks are passed to the callback directly from flash. Otherwise, e.g. for
+ * encrypted partitions, each chunk is read into a temporary buffer of the size of a single chunk.
+ * This makes it possible to process large blobs, such as certificates or calibration tables,
+ * while using little RAM.
+ *
+ * The callback runs while NVS is locked, so it must not call other NVS functions.
+ *
+ * @param[in]  handle  Handle obtained from nvs_open function.
+ * @param[in]  key     Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+ * @param[in]  cb      Function called with each chunk of the blob.
+ * @param[in]  arg     Argument passed to cb.
+ *
+ * @return
+ *             - ESP_OK if the whole blob was passed to cb
+ *             - ESP_FAIL if there is an internal error; most likely due to corrupted
+ *               NVS partition (only if NVS assertion checks are disabled)
+ *             - ESP_ERR_NVS_NOT_FOUND if the requested key doesn't exist
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_INVALID_NAME if key name doesn't satisfy constraints
+ *             - ESP_ERR_INVALID_ARG if cb is NULL
+ *             - ESP_ERR_NO_MEM if the temporary chunk buffer can't be allocated
+ *             - the value returned by cb if it stopped the read
+ */
+esp_err_t nvs_get_blob_chunks(nvs_handle_t handle, const char* key, nvs_blob_chunk_cb_t cb, void* arg);
+
+/**
+ * @brief Describes one key-value pair read by nvs_get_many or written by nvs_set_many
+ */
+typedef struct {
+    const char *key;    /*!< Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty. */
+    nvs_type_t type;    /*!< Type of the value. NVS_TYPE_ANY is not allowed. */
+    void *value;        /*!< Pointer to a variable of the given type, or to the buffer holding the string or blob */
+    size_t length;      /*!< Length of the string or blob buffer, including the zero terminator of strings.
+                             Ignored for integer types and by nvs_set_many for strings.
+                             Set by nvs_get_many to the actual length of the string or blob. */
+    esp_err_t err;      /*!< Result for this key-value pair, set by nvs_get_many and nvs_set_many */
+} nvs_item_desc_t;
+
+/**
+ * @brief      get values for several keys at once
+ *
+ * Behaves like calling nvs_get_* for each element of items, except that the NVS lock is taken once
+ * and all keys are looked up through the item index (or, without it, in a single pass over the pages),
+ * so that loading many values, e.g. the configuration of an application at boot, is faster. Each value is retrieved
+ * the same way as by the nvs_get_* function of its type; in particular, strings and blobs support
+ * length queries with value set to NULL. The result for each key is stored in its err field.
+ * All keys are processed, even if some of them fail.
+ *
+ * \code{c}
+ * // Example (without error checking) of reading several settings at once:
+ * uint32_t baud_rate;
+ * char host[32];
+ * nvs_item_desc_t items[] = {
+ *     { .key = "baud_rate", .type = NVS_TYPE_U32, .value = &baud_rate },
+ *     { .key = "host", .type = NVS_TYPE_STR, .value = host, .length = sizeof(host) },
+ * };
+ * nvs_get_many(my_handle, items, sizeof(items) / sizeof(items[0]));
+ * \endcode
+ *
+ * @param[in]     handle     Handle obtained from nvs_open function.
+ * @param[inout]  items      Array of descriptors of the key-value pairs to read.
+ * @param[in]     count      Number of elements of items.
+ *
+ * @return
+ *             - ESP_OK if all values were retrieved successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_INVALID_ARG if items is NULL while count is not zero
+ *             - otherwise, the error of the first key-value pair which couldn't be retrieved,
+ *               with the same meaning as for nvs_get_*; ESP_ERR_INVALID_ARG for an invalid type
+ */
+esp_err_t nvs_get_many(nvs_handle_t handle, nvs_item_desc_t* items, size_t count);
+
+/**
+ * @brief      set values for several keys at once
+ *
+ * Behaves like calling nvs_set_* for each element of items, except that the NVS lock is taken once.
+ * Values are written in the order of items, the same way as by the nvs_set_* function of their type.
+ * The result for each key is stored in its err field. All keys are processed, even if some of them fail.
+ * To have all values written atomically, use a handle opened with NVS_READWRITE_TRANSACTIONAL.
+ *
+ * @param[in]     handle     Handle obtained from nvs_open function.
+ *                           Handles that were opened read only cannot be used.
+ * @param[inout]  items      Array of descriptors of the key-value pairs to write.
+ * @param[in]     count      Number of elements of items.
+ *
+ * @return
+ *             - ESP_OK if all values were set successfully
+ *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NVS_READ_ONLY if storage handle was opened as read only
+ *             - ESP_ERR_INVALID_ARG if items is NULL while count is not zero
+ *             - otherwise, the error of the first key-value pair which couldn't be set,
+ *               with the same meaning as for nvs_set_*; ESP_ERR_INVALID_ARG for an invalid type
+ */
+esp_err_t nvs_set_many(nvs_handle_t handle, nvs_item_desc_t* items, size_t count);
+
 /**
  * @brief      Erase key-value pair with given key name.
  *
@@ -509,12 +717,22 @@ esp_err_t nvs_erase_all(nvs_handle_t handle);
  * to non-volatile storage. Individual implementations may write to storage at other times,
  * but this is not guaranteed.
  *
+ * For a handle opened with NVS_READWRITE_TRANSACTIONAL, all values set and keys erased
+ * since the last commit are written here, and only here. They are written atomically:
+ * if power is lost during the commit, either all or none of them are visible after
+ * nvs_flash_init. Values which are set several times are written only once, and values
+ * which equal the stored ones are not written at all. If the commit fails, the changes
+ * stay pending, so the commit can be retried.
+ *
  * @param[in]  handle  Storage handle obtained with nvs_open.
  *                     Handles that were opened read only cannot be used.
  *
  * @return
  *             - ESP_OK if the changes have been written successfully
  *             - ESP_ERR_NVS_INVALID_HANDLE if handle has been closed or is NULL
+ *             - ESP_ERR_NO_MEM if memory for the transaction journal could not be allocated
+ *             - ESP_ERR_NVS_NOT_ENOUGH_SPACE if there is not enough space for the journal and
+ *               all the changes, in which case none of them is written
  *             - other error codes from the underlying storage driver
  */
 esp_err_t nvs_commit(nvs_handle_t handle);
@@ -525,7 +743,8 @@ esp_err_t nvs_commit(nvs_handle_t handle);
  * This function should be called for each handle opened with nvs_open once
  * the handle is not in use any more. Closing the handle may not automatically
  * write the changes to nonvolatile storage. This has to be done explicitly using
- * nvs_commit function.
+ * nvs_commit function. Changes pending in a handle opened with NVS_READWRITE_TRANSACTIONAL
+ * are discarded.
  * Once this function is called on a handle, the handle should no longer be used.
  *
  * @param[in]  handle  Storage handle to close
@@ -577,6 +796,36 @@ typedef struct {
  */
 esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats);
 
+/**
+ * @note Info about the read cache of a partition, see CONFIG_NVS_READ_CACHE_SIZE.
+ */
+typedef struct {
+    uint32_t hits;            /**< Number of reads served from the cache. */
+    uint32_t misses;          /**< Number of reads which had to access the flash. */
+    uint32_t evictions;       /**< Number of values dropped to make room for other values. */
+    size_t used_bytes;        /**< Memory currently used by the cached values. */
+    size_t total_bytes;       /**< Capacity of the cache. */
+    size_t entry_count;       /**< Number of values currently cached. */
+} nvs_cache_stats_t;
+
+/**
+ * @brief      Fill structure nvs_cache_stats_t. It provides info about the read cache of the partition.
+ *
+ * Hits and misses are counted since the partition has been initialized. If the cache is disabled,
+ * all fields are 0.
+ *
+ * @param[in]   part_name   Partition name NVS in the partition table.
+ *                          If pass a NULL than will use NVS_DEFAULT_PART_NAME ("nvs").
+ *
+ * @param[out]  cache_stats Returns filled structure nvs_cache_stats_t.
+ *
+ * @return
+ *             - ESP_OK if cache_stats has been filled.
+ *             - ESP_ERR_NVS_NOT_INITIALIZED if the storage driver is not initialized.
+ *             - ESP_ERR_INVALID_ARG if cache_stats equal to NULL.
+ */
+esp_err_t nvs_get_cache_stats(const char *part_name, nvs_cache_stats_t *cache_stats);
+
 /**
  * @brief      Calculate all entries in a namespace.
  *
@@ -117,6 +117,50 @@ esp_err_t nvs_flash_deinit(void);
  */
 esp_err_t nvs_flash_deinit_partition(const char* partition_label);
 
+/**
+ * @brief Reclaim space of the default NVS partition in a short, bounded step
+ *
+ * When the active page of a partition is full and less than two free pages are left,
+ * writing an item first copies all items of another page and erases that page, which
+ * delays the write considerably. This function does the same work ahead of time, in
+ * small steps: items are moved one by one out of the page with the most erased entries,
+ * and once the page is empty, it is erased. Steps are taken until the partition has
+ * CONFIG_NVS_GC_RESERVE_PAGES free pages, so that the following writes don't have to
+ * reclaim space themselves. If the erased entries are too few for the reserve, steps stop
+ * once every used page has been reclaimed without leaving more pages free, and no further
+ * work is done until an item is written or erased.
+ *
+ * Call it repeatedly while it returns ESP_ERR_NOT_FINISHED, e.g. from a low priority task.
+ * Alternatively, enable CONFIG_NVS_GC_TASK to run the steps in a background task.
+ *
+ * @param[in]  max_items  Maximum number of items moved in this step. At most one page is erased per step.
+ *
+ * @return
+ *      - ESP_OK if enough pages are free or no more space can be reclaimed
+ *      - ESP_ERR_NOT_FINISHED if another step is needed to complete the reserve of free pages
+ *      - ESP_ERR_NVS_NOT_INITIALIZED if the storage was not initialized prior to this call
+ *      - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_flash_gc_step(size_t max_items);
+
+/**
+ * @brief Reclaim space of the given NVS partition in a short, bounded step
+ *
+ * This is the same as nvs_flash_gc_step, but for the partition with the given label.
+ *
+ * @param[in]  partition_label  Label of the partition
+ * @param[in]  max_items        Maximum number of items moved in this step.
+ *
+ * @return
+ *      - ESP_OK if enough pages are free or no more space can be reclaimed
+ *      - ESP_ERR_NOT_FINISHED if another step is needed to complete the reserve of free pages
+ *      - ESP_ERR_NVS_NOT_INITIALIZED if the storage for given partition was not
+ *        initialized prior to this call
+ *      - ESP_ERR_INVALID_ARG if partition_label is NULL
+ *      - other error codes from the underlying storage driver
+ */
+esp_err_t nvs_flash_gc_step_partition(const char *partition_label, size_t max_items);
+
 /**
  * @brief Erase the default NVS partition
  *
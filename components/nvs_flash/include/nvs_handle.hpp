@@ -150,6 +150,22 @@ public:
     virtual esp_err_t get_string(const char *key, char* out_str, size_t len) = 0;
     virtual esp_err_t get_blob(const char *key, void* out_blob, size_t len) = 0;
 
+    /**
+     * @brief Passes the value of a blob to a callback chunk by chunk, without copying the whole blob into a buffer.
+     *
+     * @param[in]     key        Key name. Maximum length is (NVS_KEY_NAME_MAX_SIZE-1) characters. Shouldn't be empty.
+     * @param[in]     cb         Function called with each chunk of the blob, in order.
+     * @param[in]     arg        Argument passed to cb.
+     *
+     * @return
+     *             - ESP_OK if the whole blob was passed to cb
+     *             - ESP_ERR_NVS_NOT_FOUND if the requested key doesn't exist
+     *             - the error returned by cb if it stopped the read
+     *
+     * @note compare to \ref nvs_get_blob_chunks in nvs.h
+     */
+    virtual esp_err_t get_blob_chunks(const char *key, nvs_blob_chunk_cb_t cb, void *arg) = 0;
+
     /**
      * @brief Look up the size of an entry's data.
      *
@@ -164,6 +180,38 @@ public:
      */
     virtual esp_err_t get_item_size(ItemType datatype, const char *key, size_t &size) = 0;
 
+    /**
+     * @brief Retrieves the values of several keys at once.
+     *
+     * The keys are looked up under a single lock, see nvs_get_many. The result for each key is stored in its err field.
+     *
+     * @param[inout]  items      Array of descriptors of the key-value pairs to read.
+     * @param[in]     count      Number of elements of items.
+     *
+     * @return
+     *             - ESP_OK if all values were retrieved successfully
+     *             - the error of the first key-value pair which couldn't be retrieved otherwise
+     *
+     * @note compare to \ref nvs_get_many in nvs.h
+     */
+    virtual esp_err_t get_many(nvs_item_desc_t *items, size_t count) = 0;
+
+    /**
+     * @brief Sets the values of several keys at once.
+     *
+     * The values are written in the order of items. The result for each key is stored in its err field.
+     *
+     * @param[inout]  items      Array of descriptors of the key-value pairs to write.
+     * @param[in]     count      Number of elements of items.
+     *
+     * @return
+     *             - ESP_OK if all values were set successfully
+     *             - the error of the first key-value pair which couldn't be set otherwise
+     *
+     * @note compare to \ref nvs_set_many in nvs.h
+     */
+    virtual esp_err_t set_many(nvs_item_desc_t *items, size_t count) = 0;
+
     /**
      * @brief Erases an entry.
      */
@@ -180,6 +228,7 @@ public:
      * Commits all changes done through this handle so far.
      * Currently, NVS writes to storage right after the set and get functions,
      * but this is not guaranteed.
+     * Handles opened with NVS_READWRITE_TRANSACTIONAL write all changes here, atomically; see nvs_commit.
      */
     virtual esp_err_t commit() = 0;
 
@@ -16,6 +16,9 @@
 #include "esp_err.h"
 #include <esp_rom_crc.h>
 #include "nvs_internal.h"
+#if CONFIG_NVS_GC_TASK && !defined LINUX_TARGET
+#include "freertos/task.h"
+#endif
 
 // Uncomment this line to force output from this module
 // #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
@@ -53,6 +56,49 @@ using namespace nvs;
 
 static intrusive_list<NVSHandleEntry> s_nvs_handles;
 
+#if CONFIG_NVS_GC_TASK && !defined LINUX_TARGET
+// Number of items moved by each step of the background garbage collection, between which the lock is released
+#define NVS_GC_TASK_STEP_ITEMS 8
+
+static TaskHandle_t s_nvs_gc_task;
+
+static void nvs_gc_task(void* arg)
+{
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_NVS_GC_TASK_PERIOD_MS));
+        while (true) {
+            esp_err_t err;
+            {
+                Lock lock;
+                err = NVSPartitionManager::get_instance()->collect_garbage(nullptr, NVS_GC_TASK_STEP_ITEMS);
+            }
+            if (err != ESP_ERR_NOT_FINISHED) {
+                break;
+            }
+            // let the tasks of equal or lower priority run between the steps
+            vTaskDelay(1);
+        }
+    }
+}
+
+static esp_err_t nvs_gc_task_start(void)
+{
+    if (s_nvs_gc_task) {
+        return ESP_OK;
+    }
+    if (xTaskCreate(nvs_gc_task, "nvs_gc", CONFIG_NVS_GC_TASK_STACK_SIZE, nullptr,
+            CONFIG_NVS_GC_TASK_PRIORITY, &s_nvs_gc_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+#else
+static esp_err_t nvs_gc_task_start(void)
+{
+    return ESP_OK;
+}
+#endif // CONFIG_NVS_GC_TASK && !defined LINUX_TARGET
+
 static nvs::Storage* lookup_storage_from_name(const char *name)
 {
     return NVSPartitionManager::get_instance()->lookup_storage_from_name(name);
@@ -111,9 +157,10 @@ extern "C" esp_err_t nvs_flash_init_partition_ptr(const esp_partition_t *partiti
 
     if (init_res != ESP_OK) {
         delete part;
+        return init_res;
     }
 
-    return init_res;
+    return nvs_gc_task_start();
 }
 
 #ifndef LINUX_HOST_LEGACY_TEST
@@ -125,7 +172,12 @@ extern "C" esp_err_t nvs_flash_init_partition(const char *part_name)
     }
     Lock lock;
 
-    return NVSPartitionManager::get_instance()->init_partition(part_name);
+    esp_err_t init_res = NVSPartitionManager::get_instance()->init_partition(part_name);
+    if (init_res != ESP_OK) {
+        return init_res;
+    }
+
+    return nvs_gc_task_start();
 }
 
 extern "C" esp_err_t nvs_flash_init(void)
@@ -174,7 +226,12 @@ extern "C" esp_err_t nvs_flash_secure_init_partition(const char *part_name, nvs_
     }
     Lock lock;
 
-    return NVSPartitionManager::get_instance()->secure_init_partition(part_name, cfg);
+    esp_err_t init_res = NVSPartitionManager::get_instance()->secure_init_partition(part_name, cfg);
+    if (init_res != ESP_OK) {
+        return init_res;
+    }
+
+    return nvs_gc_task_start();
 }
 
 extern "C" esp_err_t nvs_flash_secure_init(nvs_sec_cfg_t* cfg)
@@ -257,6 +314,22 @@ extern "C" esp_err_t nvs_flash_deinit(void)
     return nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME);
 }
 
+extern "C" esp_err_t nvs_flash_gc_step_partition(const char *partition_label, size_t max_items)
+{
+    Lock lock;
+
+    if (partition_label == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return NVSPartitionManager::get_instance()->collect_garbage(partition_label, max_items);
+}
+
+extern "C" esp_err_t nvs_flash_gc_step(size_t max_items)
+{
+    return nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, max_items);
+}
+
 static esp_err_t nvs_find_ns_handle(nvs_handle_t c_handle, NVSHandleSimple** handle)
 {
     auto it = find_if(begin(s_nvs_handles), end(s_nvs_handles), [=](NVSHandleEntry& e) -> bool {
@@ -519,6 +592,112 @@ extern "C" esp_err_t nvs_get_blob(nvs_handle_t c_handle, const char* key, void*
     return nvs_get_str_or_blob(c_handle, nvs::ItemType::BLOB, key, out_value, length);
 }
 
+extern "C" esp_err_t nvs_blob_writer_open(nvs_handle_t c_handle, const char* key, nvs_blob_writer_t* out_writer)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s", __func__, key);
+    if (out_writer == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    nvs_opaque_blob_writer_t* writer = new (std::nothrow) nvs_opaque_blob_writer_t;
+    if (writer == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    writer->handle = c_handle;
+    err = handle->open_blob_writer(key, writer->writer);
+    if (err != ESP_OK) {
+        delete writer;
+        return err;
+    }
+    *out_writer = writer;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_blob_writer_append(nvs_blob_writer_t writer, const void* data, size_t length)
+{
+    Lock lock;
+    if (writer == nullptr || (data == nullptr && length != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(writer->handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return writer->writer.append(data, length);
+}
+
+extern "C" esp_err_t nvs_blob_writer_finish(nvs_blob_writer_t writer)
+{
+    Lock lock;
+    if (writer == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(writer->handle, &handle);
+    if (err == ESP_OK) {
+        err = writer->writer.finish();
+    }
+    // if the handle has been closed, deleting the writer erases the chunks it has written
+    delete writer;
+    return err;
+}
+
+extern "C" esp_err_t nvs_blob_writer_abort(nvs_blob_writer_t writer)
+{
+    Lock lock;
+    if (writer == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(writer->handle, &handle);
+    // the chunks are erased even if the handle has been closed, as long as the partition is initialized
+    writer->writer.abort();
+    delete writer;
+    return err;
+}
+
+extern "C" esp_err_t nvs_get_blob_chunks(nvs_handle_t c_handle, const char* key, nvs_blob_chunk_cb_t cb, void* arg)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %s", __func__, key);
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->get_blob_chunks(key, cb, arg);
+}
+
+extern "C" esp_err_t nvs_get_many(nvs_handle_t c_handle, nvs_item_desc_t* items, size_t count)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, static_cast<int>(count));
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->get_many(items, count);
+}
+
+extern "C" esp_err_t nvs_set_many(nvs_handle_t c_handle, nvs_item_desc_t* items, size_t count)
+{
+    Lock lock;
+    ESP_LOGD(TAG, "%s %d", __func__, static_cast<int>(count));
+    NVSHandleSimple *handle;
+    auto err = nvs_find_ns_handle(c_handle, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return handle->set_many(items, count);
+}
+
 extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats)
 {
     Lock lock;
@@ -544,6 +723,24 @@ extern "C" esp_err_t nvs_get_stats(const char* part_name, nvs_stats_t* nvs_stats
     return pStorage->fillStats(*nvs_stats);
 }
 
+extern "C" esp_err_t nvs_get_cache_stats(const char* part_name, nvs_cache_stats_t* cache_stats)
+{
+    Lock lock;
+
+    if (cache_stats == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *cache_stats = nvs_cache_stats_t();
+
+    nvs::Storage* pStorage = lookup_storage_from_name((part_name == nullptr) ? NVS_DEFAULT_PART_NAME : part_name);
+    if (pStorage == nullptr) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    pStorage->fillCacheStats(*cache_stats);
+    return ESP_OK;
+}
+
 extern "C" esp_err_t nvs_get_used_entry_count(nvs_handle_t c_handle, size_t* used_entries)
 {
     Lock lock;
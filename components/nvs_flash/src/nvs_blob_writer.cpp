@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_blob_writer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace nvs
+{
+
+esp_err_t BlobWriter::begin(Storage* storage, uint8_t nsIndex, const char* key)
+{
+    if (strlen(key) > Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+
+    mBuffer = new (std::nothrow) uint8_t[Page::CHUNK_MAX_SIZE];
+    if (!mBuffer) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    auto err = storage->beginBlobWrite(mWrite, nsIndex, key);
+    if (err != ESP_OK) {
+        return err;
+    }
+    mStorage = storage;
+    return ESP_OK;
+}
+
+esp_err_t BlobWriter::writeChunks(const void* data, size_t length)
+{
+    mError = mStorage->writeBlobChunks(mWrite, data, length);
+    if (mError == ESP_ERR_NVS_PAGE_FULL) {
+        mError = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    return mError;
+}
+
+esp_err_t BlobWriter::append(const void* data, size_t length)
+{
+    if (mError == ESP_OK && !mWrite.isActive()) {
+        mError = ESP_ERR_NVS_INVALID_STATE;
+    }
+    if (mError != ESP_OK) {
+        return mError;
+    }
+    if (mDataSize + length > mStorage->getMaxBlobSize()) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        // full chunks are written straight from the caller's data
+        if (mBufferUsed == 0 && length >= Page::CHUNK_MAX_SIZE) {
+            const size_t size = length - length % Page::CHUNK_MAX_SIZE;
+            if (writeChunks(src, size) != ESP_OK) {
+                return mError;
+            }
+            src += size;
+            length -= size;
+            mDataSize += size;
+            continue;
+        }
+
+        const size_t size = std::min(length, Page::CHUNK_MAX_SIZE - mBufferUsed);
+        memcpy(mBuffer + mBufferUsed, src, size);
+        mBufferUsed += size;
+        src += size;
+        length -= size;
+        mDataSize += size;
+
+        if (mBufferUsed == Page::CHUNK_MAX_SIZE) {
+            if (writeChunks(mBuffer, mBufferUsed) != ESP_OK) {
+                return mError;
+            }
+            mBufferUsed = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t BlobWriter::finish()
+{
+    // an empty blob is stored as a single empty chunk, as Storage::writeMultiPageBlob does
+    if (mError == ESP_OK && (mBufferUsed > 0 || mDataSize == 0)) {
+        writeChunks(mBuffer, mBufferUsed);
+        mBufferUsed = 0;
+    }
+    if (mError == ESP_OK) {
+        // if only erasing the previous blob fails, the new one has been published all the same
+        mError = mStorage->finishBlobWrite(mWrite, mDataSize);
+    }
+    abort();
+    return mError;
+}
+
+void BlobWriter::abort()
+{
+    // a write which isn't active anymore has been published or cancelled, or the storage has been deleted
+    if (mWrite.isActive()) {
+        mStorage->abortBlobWrite(mWrite);
+    }
+    mBufferUsed = 0;
+}
+
+} // namespace nvs
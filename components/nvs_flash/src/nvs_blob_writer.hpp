@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_blob_writer_hpp
+#define nvs_blob_writer_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "esp_err.h"
+#include "nvs.h"
+#include "nvs_storage.hpp"
+
+namespace nvs
+{
+
+/**
+ * Writes a blob piece by piece, see nvs_blob_writer_open.
+ *
+ * Appended data is collected in a buffer of the size of a chunk and written to the storage as blob data chunks
+ * whenever the buffer is full, so the whole blob never has to be held in RAM. The chunks get the other version
+ * (VerOffset) than the current value of the blob, which stays readable until finish() publishes the new blob
+ * index. Chunks left behind by a power loss have no index and are erased by Storage::init. If the blob is written
+ * by other means before, the storage cancels the write and erases its chunks, see Storage::BlobWrite.
+ */
+class BlobWriter
+{
+public:
+    BlobWriter() { }
+
+    ~BlobWriter()
+    {
+        abort();
+        delete[] mBuffer;
+    }
+
+    esp_err_t begin(Storage* storage, uint8_t nsIndex, const char* key);
+
+    esp_err_t append(const void* data, size_t length);
+
+    /**
+     * Writes the rest of the data and publishes the blob. If this fails, the chunks written so far are erased.
+     */
+    esp_err_t finish();
+
+    /**
+     * Erases the chunks written so far, unless the write has been cancelled or the storage has gone.
+     */
+    void abort();
+
+protected:
+    esp_err_t writeChunks(const void* data, size_t length);
+
+    Storage* mStorage = nullptr;
+    Storage::BlobWrite mWrite;
+    size_t mDataSize = 0;
+    uint8_t* mBuffer = nullptr;
+    size_t mBufferUsed = 0;
+    esp_err_t mError = ESP_OK;
+
+private:
+    BlobWriter(const BlobWriter& other);
+    const BlobWriter& operator= (const BlobWriter& rhs);
+}; // class BlobWriter
+
+} // namespace nvs
+
+struct nvs_opaque_blob_writer_t
+{
+    nvs_handle_t handle;
+    nvs::BlobWriter writer;
+};
+
+#endif /* nvs_blob_writer_hpp */
@@ -47,6 +47,21 @@ esp_err_t NVSHandleLocked::get_item_size(ItemType datatype, const char *key, siz
     return handle->get_item_size(datatype, key, size);
 }
 
+esp_err_t NVSHandleLocked::get_blob_chunks(const char *key, nvs_blob_chunk_cb_t cb, void *arg) {
+    Lock lock;
+    return handle->get_blob_chunks(key, cb, arg);
+}
+
+esp_err_t NVSHandleLocked::get_many(nvs_item_desc_t *items, size_t count) {
+    Lock lock;
+    return handle->get_many(items, count);
+}
+
+esp_err_t NVSHandleLocked::set_many(nvs_item_desc_t *items, size_t count) {
+    Lock lock;
+    return handle->set_many(items, count);
+}
+
 esp_err_t NVSHandleLocked::erase_item(const char* key) {
     Lock lock;
     return handle->erase_item(key);
@@ -49,6 +49,12 @@ public:
 
     esp_err_t get_item_size(ItemType datatype, const char *key, size_t &size) override;
 
+    esp_err_t get_blob_chunks(const char *key, nvs_blob_chunk_cb_t cb, void *arg) override;
+
+    esp_err_t get_many(nvs_item_desc_t *items, size_t count) override;
+
+    esp_err_t set_many(nvs_item_desc_t *items, size_t count) override;
+
     esp_err_t erase_item(const char* key) override;
 
     esp_err_t erase_all() override;
@@ -21,11 +21,71 @@ NVSHandleSimple::~NVSHandleSimple() {
     NVSPartitionManager::get_instance()->close_handle(this);
 }
 
+esp_err_t NVSHandleSimple::stageItem(ItemType datatype, const char *key, const void* data, size_t dataSize)
+{
+    // report the errors Page::writeItem would report, as the item is only written in commit()
+    if (strlen(key) > Item::MAX_KEY_LENGTH) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    if (!isVariableLengthType(datatype) && dataSize > 8) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (datatype == ItemType::SZ && dataSize > Page::CHUNK_MAX_SIZE) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    return mTransaction.write(mNsIndex, datatype, key, data, dataSize);
+}
+
+esp_err_t NVSHandleSimple::readStagedItem(ItemType datatype, const char *key, void* data, size_t dataSize)
+{
+    Transaction::Op* op;
+    esp_err_t err = mTransaction.find(mNsIndex, datatype, key, op);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (!isVariableLengthType(datatype)) {
+        if (dataSize != op->mDataSize) {
+            return ESP_ERR_NVS_TYPE_MISMATCH;
+        }
+    } else if (dataSize < op->mDataSize) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    memcpy(data, op->mData, op->mDataSize);
+    return ESP_OK;
+}
+
+esp_err_t NVSHandleSimple::readStagedItem(ItemType datatype, nvs_item_desc_t &desc)
+{
+    Transaction::Op* op;
+    esp_err_t err = mTransaction.find(mNsIndex, datatype, desc.key, op);
+    if (err != ESP_OK || !isVariableLengthType(datatype)) {
+        return (err == ESP_OK) ? readStagedItem(datatype, desc.key, desc.value, Page::getAlignmentForType(datatype)) : err;
+    }
+
+    if (desc.value == nullptr) {
+        desc.length = op->mDataSize;
+        return ESP_OK;
+    } else if (desc.length < op->mDataSize) {
+        desc.length = op->mDataSize;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(desc.value, op->mData, op->mDataSize);
+    desc.length = op->mDataSize;
+    return ESP_OK;
+}
+
 esp_err_t NVSHandleSimple::set_typed_item(ItemType datatype, const char *key, const void* data, size_t dataSize)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransactional) {
+        return stageItem(datatype, key, data, dataSize);
+    }
+
     return mStoragePtr->writeItem(mNsIndex, datatype, key, data, dataSize);
 }
 
@@ -33,6 +93,13 @@ esp_err_t NVSHandleSimple::get_typed_item(ItemType datatype, const char *key, vo
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
 
+    if (mTransactional) {
+        esp_err_t err = readStagedItem(datatype, key, data, dataSize);
+        if (err != ESP_ERR_NVS_INVALID_STATE) {
+            return err;
+        }
+    }
+
     return mStoragePtr->readItem(mNsIndex, datatype, key, data, dataSize);
 }
 
@@ -41,6 +108,10 @@ esp_err_t NVSHandleSimple::set_string(const char *key, const char* str)
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransactional) {
+        return stageItem(nvs::ItemType::SZ, key, str, strlen(str) + 1);
+    }
+
     return mStoragePtr->writeItem(mNsIndex, nvs::ItemType::SZ, key, str, strlen(str) + 1);
 }
 
@@ -49,6 +120,10 @@ esp_err_t NVSHandleSimple::set_blob(const char *key, const void* blob, size_t le
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransactional) {
+        return stageItem(nvs::ItemType::BLOB, key, blob, len);
+    }
+
     return mStoragePtr->writeItem(mNsIndex, nvs::ItemType::BLOB, key, blob, len);
 }
 
@@ -56,6 +131,13 @@ esp_err_t NVSHandleSimple::get_string(const char *key, char* out_str, size_t len
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
 
+    if (mTransactional) {
+        esp_err_t err = readStagedItem(nvs::ItemType::SZ, key, out_str, len);
+        if (err != ESP_ERR_NVS_INVALID_STATE) {
+            return err;
+        }
+    }
+
     return mStoragePtr->readItem(mNsIndex, nvs::ItemType::SZ, key, out_str, len);
 }
 
@@ -63,6 +145,13 @@ esp_err_t NVSHandleSimple::get_blob(const char *key, void* out_blob, size_t len)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
 
+    if (mTransactional) {
+        esp_err_t err = readStagedItem(nvs::ItemType::BLOB, key, out_blob, len);
+        if (err != ESP_ERR_NVS_INVALID_STATE) {
+            return err;
+        }
+    }
+
     return mStoragePtr->readItem(mNsIndex, nvs::ItemType::BLOB, key, out_blob, len);
 }
 
@@ -70,14 +159,123 @@ esp_err_t NVSHandleSimple::get_item_size(ItemType datatype, const char *key, siz
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
 
+    if (mTransactional) {
+        Transaction::Op* op;
+        esp_err_t err = mTransaction.find(mNsIndex, datatype, key, op);
+        if (err == ESP_OK) {
+            size = op->mDataSize;
+        }
+        if (err != ESP_ERR_NVS_INVALID_STATE) {
+            return err;
+        }
+    }
+
     return mStoragePtr->getItemDataSize(mNsIndex, datatype, key, size);
 }
 
+esp_err_t NVSHandleSimple::get_blob_chunks(const char *key, nvs_blob_chunk_cb_t cb, void *arg)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (cb == nullptr) return ESP_ERR_INVALID_ARG;
+
+    if (mTransactional) {
+        Transaction::Op* op;
+        esp_err_t err = mTransaction.find(mNsIndex, ItemType::BLOB, key, op);
+        if (err == ESP_OK) {
+            return (op->mDataSize != 0) ? cb(op->mData, op->mDataSize, 0, arg) : ESP_OK;
+        }
+        if (err != ESP_ERR_NVS_INVALID_STATE) {
+            return err;
+        }
+    }
+
+    return mStoragePtr->readBlobChunks(mNsIndex, key, cb, arg);
+}
+
+esp_err_t NVSHandleSimple::open_blob_writer(const char *key, BlobWriter &writer)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    // staging the pieces in RAM would defeat the purpose of the writer
+    if (mTransactional) return ESP_ERR_NOT_SUPPORTED;
+    if (key == nullptr) return ESP_ERR_INVALID_ARG;
+
+    return writer.begin(mStoragePtr, mNsIndex, key);
+}
+
+esp_err_t NVSHandleSimple::get_many(nvs_item_desc_t *items, size_t count)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (items == nullptr && count != 0) return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < count; ++i) {
+        items[i].err = ESP_ERR_NOT_FINISHED;
+        ItemType datatype;
+        if (mTransactional && items[i].key != nullptr && itemTypeOfNvsType(items[i].type, datatype)
+                && (items[i].value != nullptr || isVariableLengthType(datatype))) {
+            esp_err_t err = readStagedItem(datatype, items[i]);
+            if (err != ESP_ERR_NVS_INVALID_STATE) {
+                items[i].err = err;
+            }
+        }
+    }
+
+    esp_err_t err = mStoragePtr->readItems(mNsIndex, items, count);
+    if (err == ESP_ERR_NVS_NOT_INITIALIZED) {
+        for (size_t i = 0; i < count; ++i) {
+            if (items[i].err == ESP_ERR_NOT_FINISHED) {
+                items[i].err = err;
+            }
+        }
+    }
+    return err;
+}
+
+esp_err_t NVSHandleSimple::set_many(nvs_item_desc_t *items, size_t count)
+{
+    if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
+    if (items == nullptr && count != 0) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t result = ESP_OK;
+    for (size_t i = 0; i < count; ++i) {
+        nvs_item_desc_t& desc = items[i];
+        ItemType datatype;
+        if (desc.key == nullptr || desc.value == nullptr || !itemTypeOfNvsType(desc.type, datatype)) {
+            desc.err = ESP_ERR_INVALID_ARG;
+        } else if (datatype == ItemType::SZ) {
+            desc.err = set_string(desc.key, static_cast<const char*>(desc.value));
+        } else if (datatype == ItemType::BLOB) {
+            desc.err = set_blob(desc.key, desc.value, desc.length);
+        } else {
+            desc.err = set_typed_item(datatype, desc.key, desc.value, Page::getAlignmentForType(datatype));
+        }
+        if (result == ESP_OK) {
+            result = desc.err;
+        }
+    }
+    return result;
+}
+
 esp_err_t NVSHandleSimple::erase_item(const char* key)
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransactional) {
+        // erasing an item which doesn't exist fails, whether the item has been staged or written before
+        Transaction::Op* op;
+        esp_err_t err = mTransaction.find(mNsIndex, ItemType::ANY, key, op);
+        if (err == ESP_ERR_NVS_INVALID_STATE) {
+            size_t size;
+            err = mStoragePtr->getItemDataSize(mNsIndex, ItemType::ANY, key, size);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        return mTransaction.erase(mNsIndex, key);
+    }
+
     return mStoragePtr->eraseItem(mNsIndex, key);
 }
 
@@ -86,6 +284,10 @@ esp_err_t NVSHandleSimple::erase_all()
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
     if (mReadOnly) return ESP_ERR_NVS_READ_ONLY;
 
+    if (mTransactional) {
+        return mTransaction.eraseAll(mNsIndex);
+    }
+
     return mStoragePtr->eraseNamespace(mNsIndex);
 }
 
@@ -93,6 +295,15 @@ esp_err_t NVSHandleSimple::commit()
 {
     if (!valid) return ESP_ERR_NVS_INVALID_HANDLE;
 
+    if (mTransactional && !mTransaction.empty()) {
+        // on failure, the staged modifications are kept, so that the commit can be retried
+        esp_err_t err = mStoragePtr->writeTransaction(mTransaction);
+        if (err != ESP_OK) {
+            return err;
+        }
+        mTransaction.clear();
+    }
+
     return ESP_OK;
 }
 
@@ -16,6 +16,7 @@
 
 #include "intrusive_list.h"
 #include "nvs_storage.hpp"
+#include "nvs_blob_writer.hpp"
 #include "nvs_platform.hpp"
 
 #include "nvs_handle.hpp"
@@ -27,17 +28,20 @@ namespace nvs {
  *
  * It is used by both the C API and the C++ API. The main responsibility is to check whether the handle is valid
  * and in the right read/write mode and then forward the calls to the storage object.
+ * A handle opened in NVS_READWRITE_TRANSACTIONAL mode stages all modifications in RAM instead and
+ * writes them atomically in commit(). Reads through such a handle return the staged values.
  *
  * For more details about the general member functions, see nvs_handle.hpp.
  */
 class NVSHandleSimple : public intrusive_list_node<NVSHandleSimple>, public NVSHandle {
     friend class NVSPartitionManager;
 public:
-    NVSHandleSimple(bool readOnly, uint8_t nsIndex, Storage *StoragePtr) :
+    NVSHandleSimple(bool readOnly, uint8_t nsIndex, Storage *StoragePtr, bool transactional = false) :
         mStoragePtr(StoragePtr),
         mNsIndex(nsIndex),
         mReadOnly(readOnly),
-        valid(1)
+        valid(1),
+        mTransactional(transactional)
     { }
 
     ~NVSHandleSimple();
@@ -56,6 +60,12 @@ public:
 
     esp_err_t get_item_size(ItemType datatype, const char *key, size_t &size) override;
 
+    esp_err_t get_blob_chunks(const char *key, nvs_blob_chunk_cb_t cb, void *arg) override;
+
+    esp_err_t get_many(nvs_item_desc_t *items, size_t count) override;
+
+    esp_err_t set_many(nvs_item_desc_t *items, size_t count) override;
+
     esp_err_t erase_item(const char *key) override;
 
     esp_err_t erase_all() override;
@@ -66,6 +76,11 @@ public:
 
     esp_err_t getItemDataSize(ItemType datatype, const char *key, size_t &dataSize);
 
+    /**
+     * Prepares writer for writing the blob with the given key piece by piece, see nvs_blob_writer_open.
+     */
+    esp_err_t open_blob_writer(const char *key, BlobWriter &writer);
+
     void debugDump();
 
     esp_err_t fillStats(nvs_stats_t &nvsStats);
@@ -79,6 +94,12 @@ public:
     const char *get_partition_name() const;
 
 private:
+    esp_err_t stageItem(ItemType datatype, const char *key, const void *data, size_t dataSize);
+
+    esp_err_t readStagedItem(ItemType datatype, const char *key, void *data, size_t dataSize);
+
+    esp_err_t readStagedItem(ItemType datatype, nvs_item_desc_t &desc);
+
     /**
      * The underlying storage's object.
      */
@@ -100,6 +121,16 @@ private:
      * Upon opening, a handle is valid. It becomes invalid if the underlying storage is de-initialized.
      */
     uint8_t valid;
+
+    /**
+     * Whether this handle stages modifications in mTransaction until commit() instead of writing them directly.
+     */
+    uint8_t mTransactional;
+
+    /**
+     * Modifications staged since the last commit, if the handle is transactional.
+     */
+    Transaction mTransaction;
 };
 
 } // nvs
@@ -24,6 +24,13 @@ HashList::HashList()
 void HashList::clear()
 {
     for (auto it = mBlockList.begin(); it != mBlockList.end();) {
+        if (mItemIndex) {
+            for (size_t i = 0; i < it->mCount; ++i) {
+                if (it->mNodes[i].mIndex != 0xff) {
+                    mItemIndex->erase(it->mNodes[i].mHash, mOwner);
+                }
+            }
+        }
         auto tmp = it;
         ++it;
         mBlockList.erase(tmp);
@@ -36,6 +43,12 @@ HashList::~HashList()
     clear();
 }
 
+void HashList::setItemIndex(ItemIndex* itemIndex, Page* owner)
+{
+    mItemIndex = itemIndex;
+    mOwner = owner;
+}
+
 HashList::HashListBlock::HashListBlock()
 {
     static_assert(sizeof(HashListBlock) == HashListBlock::BYTE_SIZE,
@@ -50,6 +63,9 @@ esp_err_t HashList::insert(const Item& item, size_t index)
         auto& block = mBlockList.back();
         if (block.mCount < HashListBlock::ENTRY_COUNT) {
             block.mNodes[block.mCount++] = HashListNode(hash_24, index);
+            if (mItemIndex) {
+                mItemIndex->insert(hash_24, mOwner);
+            }
             return ESP_OK;
         }
     }
@@ -61,6 +77,9 @@ esp_err_t HashList::insert(const Item& item, size_t index)
     mBlockList.push_back(newBlock);
     newBlock->mNodes[0] = HashListNode(hash_24, index);
     newBlock->mCount++;
+    if (mItemIndex) {
+        mItemIndex->insert(hash_24, mOwner);
+    }
 
     return ESP_OK;
 }
@@ -73,6 +92,9 @@ bool HashList::erase(size_t index)
         for (size_t i = 0; i < it->mCount; ++i) {
             if (it->mNodes[i].mIndex == index) {
                 it->mNodes[i].mIndex = 0xff;
+                if (mItemIndex) {
+                    mItemIndex->erase(it->mNodes[i].mHash, mOwner);
+                }
                 foundIndex = true;
                 /* found the item and removed it */
             }
@@ -18,6 +18,7 @@
 #include "nvs.h"
 #include "nvs_types.hpp"
 #include "intrusive_list.h"
+#include "nvs_item_index.hpp"
 
 namespace nvs
 {
@@ -33,6 +34,12 @@ public:
     size_t find(size_t start, const Item& item);
     void clear();
 
+    /**
+     * Makes this list mirror all of its insertions and removals into the storage-wide index,
+     * recording owner as the page which holds the items.
+     */
+    void setItemIndex(ItemIndex* itemIndex, Page* owner);
+
 private:
     HashList(const HashList& other);
     const HashList& operator= (const HashList& rhs);
@@ -66,6 +73,9 @@ protected:
 
     typedef intrusive_list<HashListBlock> TBlockList;
     TBlockList mBlockList;
+
+    ItemIndex* mItemIndex = nullptr;
+    Page* mOwner = nullptr;
 }; // class HashList
 
 } // namespace nvs
@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_item_index.hpp"
+#include <new>
+
+namespace nvs
+{
+
+ItemIndex::ItemIndex()
+{
+}
+
+ItemIndex::~ItemIndex()
+{
+    clear();
+}
+
+void ItemIndex::init()
+{
+    clear();
+    mValid = true;
+}
+
+void ItemIndex::clear()
+{
+    delete[] mSlots;
+    mSlots = nullptr;
+    mCapacity = 0;
+    mSize = 0;
+    mValid = false;
+}
+
+void ItemIndex::place(Slot* slots, size_t capacity, const Slot& slot)
+{
+    size_t pos = slot.mHash & (capacity - 1);
+    while (slots[pos].mPage != nullptr) {
+        pos = (pos + 1) & (capacity - 1);
+    }
+    slots[pos] = slot;
+}
+
+bool ItemIndex::reserve(size_t count)
+{
+    // keep the load factor at or below 3/4
+    if (count * 4 <= mCapacity * 3) {
+        return true;
+    }
+
+    size_t newCapacity = mCapacity ? mCapacity * 2 : MIN_CAPACITY;
+    Slot* newSlots = new (std::nothrow) Slot[newCapacity];
+    if (!newSlots) {
+        return false;
+    }
+    for (size_t i = 0; i < newCapacity; ++i) {
+        newSlots[i].mPage = nullptr;
+    }
+    for (size_t i = 0; i < mCapacity; ++i) {
+        if (mSlots[i].mPage != nullptr) {
+            place(newSlots, newCapacity, mSlots[i]);
+        }
+    }
+    delete[] mSlots;
+    mSlots = newSlots;
+    mCapacity = newCapacity;
+    return true;
+}
+
+void ItemIndex::insert(uint32_t hash, Page* page)
+{
+    if (!mValid) {
+        return;
+    }
+
+    if (mCapacity) {
+        for (size_t pos = home(hash); mSlots[pos].mPage != nullptr; pos = (pos + 1) & (mCapacity - 1)) {
+            if (mSlots[pos].mPage == page && mSlots[pos].mHash == hash) {
+                ++mSlots[pos].mCount;
+                return;
+            }
+        }
+    }
+
+    if (!reserve(mSize + 1)) {
+        // not enough memory to keep the index complete, searches will visit all pages
+        clear();
+        return;
+    }
+
+    Slot slot;
+    slot.mPage = page;
+    slot.mHash = hash;
+    slot.mCount = 1;
+    place(mSlots, mCapacity, slot);
+    ++mSize;
+}
+
+void ItemIndex::erase(uint32_t hash, Page* page)
+{
+    if (!mValid || !mCapacity) {
+        return;
+    }
+
+    const size_t mask = mCapacity - 1;
+    size_t pos = home(hash);
+    while (mSlots[pos].mPage != nullptr &&
+            (mSlots[pos].mPage != page || mSlots[pos].mHash != hash)) {
+        pos = (pos + 1) & mask;
+    }
+    if (mSlots[pos].mPage == nullptr) {
+        return;
+    }
+    if (--mSlots[pos].mCount > 0) {
+        return;
+    }
+
+    // backward shift deletion: move up the following slots of the cluster which may not stay behind the hole
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; mSlots[next].mPage != nullptr; next = (next + 1) & mask) {
+        size_t nextHome = home(mSlots[next].mHash);
+        bool stays = (hole <= next) ? (hole < nextHome && nextHome <= next)
+                                    : (hole < nextHome || nextHome <= next);
+        if (!stays) {
+            mSlots[hole] = mSlots[next];
+            hole = next;
+        }
+    }
+    mSlots[hole].mPage = nullptr;
+    --mSize;
+}
+
+size_t ItemIndex::find(uint32_t hash, Page** pages, size_t maxCount) const
+{
+    size_t count = 0;
+    if (!mCapacity) {
+        return count;
+    }
+    for (size_t pos = home(hash); mSlots[pos].mPage != nullptr; pos = (pos + 1) & (mCapacity - 1)) {
+        if (mSlots[pos].mHash == hash) {
+            if (count < maxCount) {
+                pages[count] = mSlots[pos].mPage;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace nvs
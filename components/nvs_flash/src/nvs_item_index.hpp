@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_item_index_hpp
+#define nvs_item_index_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "esp_err.h"
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Storage-wide index of items. For each 24-bit item hash (namespace index, key and chunk index, same as
+ * in HashList), the index records the pages which hold at least one item with this hash.
+ * The index is not updated directly; instead, each Page's HashList mirrors its insertions and removals into it.
+ * This lets Storage visit only the candidate pages of an item instead of asking every page in turn.
+ *
+ * The index is an open-addressing hash table with linear probing which grows on demand.
+ * If memory can't be allocated, the index invalidates itself and Storage falls back to searching all pages.
+ */
+class ItemIndex
+{
+public:
+    ItemIndex();
+    ~ItemIndex();
+
+    /**
+     * Drops all records and makes the index valid (enabled).
+     */
+    void init();
+
+    /**
+     * Drops all records and invalidates (disables) the index.
+     */
+    void clear();
+
+    bool isValid() const
+    {
+        return mValid;
+    }
+
+    void insert(uint32_t hash, Page* page);
+
+    void erase(uint32_t hash, Page* page);
+
+    /**
+     * Copies up to maxCount pages which hold an item with the given hash into pages.
+     *
+     * @return total number of such pages, which may be larger than maxCount
+     */
+    size_t find(uint32_t hash, Page** pages, size_t maxCount) const;
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    static const size_t MAX_CANDIDATES = 8;
+
+private:
+    ItemIndex(const ItemIndex& other);
+    const ItemIndex& operator= (const ItemIndex& rhs);
+
+protected:
+    struct Slot {
+        Page* mPage;
+        uint32_t mHash  : 24;
+        uint32_t mCount : 8;
+    };
+
+    static const size_t MIN_CAPACITY = 64;
+
+    bool reserve(size_t count);
+
+    static void place(Slot* slots, size_t capacity, const Slot& slot);
+
+    size_t home(uint32_t hash) const
+    {
+        return hash & (mCapacity - 1);
+    }
+
+    Slot* mSlots = nullptr;
+    size_t mCapacity = 0;
+    size_t mSize = 0;
+    bool mValid = false;
+}; // class ItemIndex
+
+} // namespace nvs
+
+#endif /* nvs_item_index_hpp */
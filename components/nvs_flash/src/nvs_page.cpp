@@ -21,7 +21,7 @@ uint32_t Page::Header::calculateCrc32()
                     offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
-esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
+esp_err_t Page::load(Partition *partition, uint32_t sectorNumber, bool deferBlankCheck)
 {
     if (partition == nullptr) {
         return ESP_ERR_INVALID_ARG;
@@ -31,6 +31,7 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     mBaseAddress = sectorNumber * SEC_SIZE;
     mUsedEntryCount = 0;
     mErasedEntryCount = 0;
+    mBlankCheckPending = false;
 
     Header header;
     auto rc = mPartition->read_raw(mBaseAddress, &header, sizeof(header));
@@ -40,27 +41,14 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     }
     if (header.mState == PageState::UNINITIALIZED) {
         mState = header.mState;
-        // check if the whole page is really empty
-        // reading the whole page takes ~40 times less than erasing it
-        const int BLOCK_SIZE = 128;
-        uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
-
-        if (!block) return ESP_ERR_NO_MEM;
-
-        for (uint32_t i = 0; i < SPI_FLASH_SEC_SIZE; i += 4 * BLOCK_SIZE) {
-            rc = mPartition->read_raw(mBaseAddress + i, block, 4 * BLOCK_SIZE);
+        if (deferBlankCheck) {
+            mBlankCheckPending = true;
+        } else {
+            rc = mCheckBlank();
             if (rc != ESP_OK) {
-                mState = PageState::INVALID;
-                delete[] block;
                 return rc;
             }
-            if (std::any_of(block, block + BLOCK_SIZE, [](uint32_t val) -> bool { return val != 0xffffffff; })) {
-                // page isn't as empty after all, mark it as corrupted
-                mState = PageState::CORRUPT;
-                break;
-            }
         }
-        delete[] block;
     } else if (header.mCrc32 != header.calculateCrc32()) {
         header.mState = PageState::CORRUPT;
     } else {
@@ -91,6 +79,47 @@ esp_err_t Page::load(Partition *partition, uint32_t sectorNumber)
     return ESP_OK;
 }
 
+esp_err_t Page::checkBlank()
+{
+    if (!mBlankCheckPending) {
+        return ESP_OK;
+    }
+    auto err = mCheckBlank();
+    if (err != ESP_OK) {
+        // the page hasn't been used yet, check it again the next time
+        mState = PageState::UNINITIALIZED;
+        return err;
+    }
+    mBlankCheckPending = false;
+    return ESP_OK;
+}
+
+esp_err_t Page::mCheckBlank()
+{
+    // check if the whole page is really empty
+    // reading the whole page takes ~40 times less than erasing it
+    const int BLOCK_SIZE = 128;
+    uint32_t* block = new (std::nothrow) uint32_t[BLOCK_SIZE];
+
+    if (!block) return ESP_ERR_NO_MEM;
+
+    for (uint32_t i = 0; i < SPI_FLASH_SEC_SIZE; i += 4 * BLOCK_SIZE) {
+        auto rc = mPartition->read_raw(mBaseAddress + i, block, 4 * BLOCK_SIZE);
+        if (rc != ESP_OK) {
+            mState = PageState::INVALID;
+            delete[] block;
+            return rc;
+        }
+        if (std::any_of(block, block + BLOCK_SIZE, [](uint32_t val) -> bool { return val != 0xffffffff; })) {
+            // page isn't as empty after all, mark it as corrupted
+            mState = PageState::CORRUPT;
+            break;
+        }
+    }
+    delete[] block;
+    return ESP_OK;
+}
+
 esp_err_t Page::writeEntry(const Item& item)
 {
     uint32_t phyAddr;
@@ -260,8 +289,15 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
         return rc;
     }
 
-    if (!isVariableLengthType(datatype)) {
-        if (dataSize != getAlignmentForType(datatype)) {
+    return readItemData(index, item, data, dataSize);
+}
+
+esp_err_t Page::readItemData(size_t index, const Item& item, void* data, size_t dataSize)
+{
+    esp_err_t rc;
+
+    if (!isVariableLengthType(item.datatype)) {
+        if (dataSize != getAlignmentForType(item.datatype)) {
             return ESP_ERR_NVS_TYPE_MISMATCH;
         }
 
@@ -297,6 +333,37 @@ esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, vo
     return ESP_OK;
 }
 
+esp_err_t Page::mapItemData(size_t index, const Item& item, const void*& data, uint32_t& handle)
+{
+    NVS_ASSERT_OR_RETURN(isVariableLengthType(item.datatype), ESP_FAIL);
+
+    uint32_t address;
+    esp_err_t rc = getEntryAddress(index + 1, &address);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    // the data entries of an item follow its header entry without a gap
+    rc = mPartition->mmap(address, item.varLength.dataSize, &data, &handle);
+    if (rc != ESP_OK) {
+        // whether the partition can't be mapped at all or the MMU pages are used up, the data can still be read
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (Item::calculateCrc32(reinterpret_cast<const uint8_t*>(data), item.varLength.dataSize) != item.varLength.dataCrc32) {
+        mPartition->munmap(handle);
+        rc = eraseEntryAndSpan(index);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+void Page::unmapItemData(uint32_t handle)
+{
+    mPartition->munmap(handle);
+}
+
 esp_err_t Page::cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -519,6 +586,66 @@ esp_err_t Page::copyItems(Page& other)
     return ESP_OK;
 }
 
+esp_err_t Page::moveFirstItem(Page& other)
+{
+    if (mFirstUsedEntry == INVALID_ENTRY) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    if (other.mState == PageState::UNINITIALIZED) {
+        auto err = other.initialize();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (other.mState != PageState::ACTIVE) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    const size_t index = mFirstUsedEntry;
+    Item entry;
+    auto err = readEntry(index, entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // findItem would drop an item with a corrupted header as well
+    if (entry.crc32 != entry.calculateCrc32()) {
+        return eraseEntryAndSpan(index);
+    }
+
+    const size_t span = entry.span;
+    NVS_ASSERT_OR_RETURN(index + span <= ENTRY_COUNT, ESP_FAIL);
+
+    if (other.mNextFreeEntry == INVALID_ENTRY || other.mNextFreeEntry + span > ENTRY_COUNT) {
+        return ESP_ERR_NVS_PAGE_FULL;
+    }
+
+    err = other.mHashList.insert(entry, other.mNextFreeEntry);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = other.writeEntry(entry);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (size_t i = index + 1; i < index + span; ++i) {
+        err = readEntry(i, entry);
+        if (err != ESP_OK) {
+            return err;
+        }
+        err = other.writeEntry(entry);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return eraseEntryAndSpan(index);
+}
+
 esp_err_t Page::mLoadEntryTable()
 {
     // for states where we actually care about data in the page, read entry state table
@@ -1003,6 +1130,7 @@ esp_err_t Page::erase()
     mFirstUsedEntry = INVALID_ENTRY;
     mNextFreeEntry = INVALID_ENTRY;
     mState = PageState::UNINITIALIZED;
+    mBlankCheckPending = false;
     mHashList.clear();
     return ESP_OK;
 }
@@ -77,7 +77,25 @@ public:
         return mState;
     }
 
-    esp_err_t load(Partition *partition, uint32_t sectorNumber);
+    /**
+     * Loads the page from flash. Checking that an uninitialized page is really empty means reading the whole
+     * page; if deferBlankCheck is set, this is left to checkBlank(), which has to be called before the page is used.
+     */
+    esp_err_t load(Partition *partition, uint32_t sectorNumber, bool deferBlankCheck = false);
+
+    /**
+     * Does the check deferred by load(), marking the page as CORRUPT if it isn't empty. If the page can't
+     * be read, the check is done again by the next call.
+     */
+    esp_err_t checkBlank();
+
+    /**
+     * Makes the page record its items in the storage-wide item index. Has to be called before load().
+     */
+    void setItemIndex(ItemIndex* itemIndex)
+    {
+        mHashList.setItemIndex(itemIndex, this);
+    }
 
     esp_err_t getSeqNumber(uint32_t& seqNumber) const;
 
@@ -89,6 +107,26 @@ public:
 
     esp_err_t readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    static constexpr size_t getAlignmentForType(ItemType type)
+    {
+        return static_cast<uint8_t>(type) & 0x0f;
+    }
+
+    /**
+     * Reads the value of an item which has been found at itemIndex by findItem, without searching it again.
+     */
+    esp_err_t readItemData(size_t itemIndex, const Item& item, void* data, size_t dataSize);
+
+    /**
+     * Maps the data of a variable length item found at itemIndex by findItem, so that it can be read in place.
+     * The CRC of the data is checked, as in readItemData. The mapping has to be released with unmapItemData.
+     *
+     * @return ESP_ERR_NOT_SUPPORTED if the data can't be mapped, whatever the error of the partition
+     */
+    esp_err_t mapItemData(size_t itemIndex, const Item& item, const void*& data, uint32_t& handle);
+
+    void unmapItemData(uint32_t handle);
+
     esp_err_t cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
     esp_err_t eraseItem(uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx = CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
@@ -138,6 +176,13 @@ public:
 
     esp_err_t copyItems(Page& other);
 
+    /**
+     * Copies the first item of this page to the other page, then erases it from this page.
+     * If power goes off in between, the copy is the last item of the last page and
+     * PageManager::load removes the original, just as for an item which has been overwritten.
+     */
+    esp_err_t moveFirstItem(Page& other);
+
     esp_err_t erase();
 
     void debugDump() const;
@@ -173,6 +218,8 @@ protected:
 
     esp_err_t mLoadEntryTable();
 
+    esp_err_t mCheckBlank();
+
     esp_err_t initialize();
 
     esp_err_t alterEntryState(size_t index, EntryState state);
@@ -191,11 +238,6 @@ protected:
 
     esp_err_t updateFirstUsedEntry(size_t index, size_t span);
 
-    static constexpr size_t getAlignmentForType(ItemType type)
-    {
-        return static_cast<uint8_t>(type) & 0x0f;
-    }
-
     esp_err_t getEntryAddress(size_t entry, uint32_t *address) const
     {
         NVS_ASSERT_OR_RETURN(entry < ENTRY_COUNT, ESP_FAIL);
@@ -217,6 +259,7 @@ protected:
     size_t mFirstUsedEntry = INVALID_ENTRY;
     uint16_t mUsedEntryCount = 0;
     uint16_t mErasedEntryCount = 0;
+    bool mBlankCheckPending = false;
 
     /**
      * This hash list stores hashes of namespace index, key, and ChunkIndex for quick lookup when searching items.
@@ -7,7 +7,7 @@
 
 namespace nvs
 {
-esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount)
+esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, ItemIndex* index)
 {
     if (partition == nullptr) {
         return ESP_ERR_INVALID_ARG;
@@ -17,12 +17,16 @@ esp_err_t PageManager::load(Partition *partition, uint32_t baseSector, uint32_t
     mPageCount = sectorCount;
     mPageList.clear();
     mFreePageList.clear();
+    mGarbagePage = nullptr;
+    resumeGarbageCollection();
     mPages.reset(new (nothrow) Page[sectorCount]);
 
     if (!mPages) return ESP_ERR_NO_MEM;
 
     for (uint32_t i = 0; i < sectorCount; ++i) {
-        auto err = mPages[i].load(partition, baseSector + i);
+        mPages[i].setItemIndex(index);
+        // free pages are only checked for leftover data once they are activated
+        auto err = mPages[i].load(partition, baseSector + i, true);
         if (err != ESP_OK) {
             return err;
         }
@@ -195,12 +199,127 @@ esp_err_t PageManager::requestNewPage()
     return ESP_OK;
 }
 
+Page* PageManager::selectGarbagePage()
+{
+    // keep on emptying the same page, unless it has been reclaimed by requestNewPage in the meantime
+    if (mGarbagePage != nullptr && mGarbagePage->state() == Page::PageState::FULL) {
+        return mGarbagePage;
+    }
+
+    mGarbagePage = nullptr;
+    size_t maxUnusedItems = 0;
+    for (auto it = begin(); it != end(); ++it) {
+        if (it->state() != Page::PageState::FULL) {
+            continue;
+        }
+        auto unused = Page::ENTRY_COUNT - it->getUsedEntryCount();
+        if (unused > maxUnusedItems) {
+            mGarbagePage = it;
+            maxUnusedItems = unused;
+        }
+    }
+    return mGarbagePage;
+}
+
+void PageManager::resumeGarbageCollection()
+{
+    mGarbageStopped = false;
+    mGarbagePassPages = 0;
+}
+
+esp_err_t PageManager::finishGarbagePage(size_t reservePages)
+{
+    if (mFreePageList.size() >= reservePages) {
+        mGarbagePassPages = 0;
+        return ESP_OK;
+    }
+    if (--mGarbagePassPages > 0) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    // every used page has been reclaimed once, without leaving more pages free
+    if (mFreePageList.size() <= mGarbagePassFreePages) {
+        mGarbageStopped = true;
+        return ESP_OK;
+    }
+    mGarbagePassPages = mPageList.size();
+    mGarbagePassFreePages = mFreePageList.size();
+    return ESP_ERR_NOT_FINISHED;
+}
+
+esp_err_t PageManager::collectGarbage(size_t maxItems, size_t reservePages)
+{
+    size_t movedItems = 0;
+
+    if (mGarbageStopped) {
+        return ESP_OK;
+    }
+    if (mGarbagePassPages == 0) {
+        mGarbagePassPages = mPageList.size();
+        mGarbagePassFreePages = mFreePageList.size();
+    }
+
+    while (mFreePageList.size() < reservePages) {
+        Page* page = selectGarbagePage();
+        if (page == nullptr) {
+            mGarbageStopped = true;
+            return ESP_OK;
+        }
+
+        if (page->getUsedEntryCount() == 0) {
+            auto err = page->erase();
+            if (err != ESP_OK) {
+                return err;
+            }
+            mPageList.erase(page);
+            mFreePageList.push_back(page);
+            mGarbagePage = nullptr;
+            return finishGarbagePage(reservePages);
+        }
+
+        if (movedItems == maxItems) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+
+        auto err = page->moveFirstItem(back());
+        if (err == ESP_ERR_NVS_PAGE_FULL) {
+            if (back().state() != Page::PageState::FULL) {
+                err = back().markFull();
+                if (err != ESP_OK) {
+                    return err;
+                }
+            }
+            // With a single free page left, items can't be moved one by one: if power went off,
+            // no free page would be left. requestNewPage reclaims a whole page at once in that case.
+            if (mFreePageList.size() < 2) {
+                err = requestNewPage();
+                return (err == ESP_OK) ? finishGarbagePage(reservePages) : err;
+            }
+            err = activatePage();
+            if (err != ESP_OK) {
+                return err;
+            }
+            continue;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        ++movedItems;
+    }
+
+    mGarbagePassPages = 0;
+    return ESP_OK;
+}
+
 esp_err_t PageManager::activatePage()
 {
     if (mFreePageList.empty()) {
         return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
     }
     Page* p = &mFreePageList.front();
+    auto err = p->checkBlank();
+    if (err != ESP_OK) {
+        return err;
+    }
     if (p->state() == Page::PageState::CORRUPT) {
         auto err = p->erase();
         if (err != ESP_OK) {
@@ -31,7 +31,7 @@ public:
 
     PageManager() {}
 
-    esp_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount);
+    esp_err_t load(Partition *partition, uint32_t baseSector, uint32_t sectorCount, ItemIndex* index = nullptr);
 
     TPageListIterator begin()
     {
@@ -54,6 +54,30 @@ public:
 
     esp_err_t requestNewPage();
 
+    /**
+     * Reclaims erased entries ahead of time, until at least reservePages pages are free.
+     * Items are moved one by one from the full page with the most unused entries into the active page,
+     * then the emptied page is erased. Unlike requestNewPage, this keeps every step short:
+     * at most maxItems items are moved and at most one page is erased per call.
+     *
+     * If reclaiming as many pages as there are used pages doesn't leave more pages free, the reserve
+     * can't be reached and collection stops until resumeGarbageCollection is called.
+     *
+     * @return ESP_OK if enough pages are free or there is nothing left to reclaim,
+     *         ESP_ERR_NOT_FINISHED if another call is needed.
+     */
+    esp_err_t collectGarbage(size_t maxItems, size_t reservePages);
+
+    /**
+     * Lets collectGarbage run again after it has stopped, to be called when items are written or erased.
+     */
+    void resumeGarbageCollection();
+
+    size_t getFreePageCount() const
+    {
+        return mFreePageList.size();
+    }
+
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
     uint32_t getBaseSector()
@@ -66,12 +90,20 @@ protected:
 
     esp_err_t activatePage();
 
+    Page* selectGarbagePage();
+
+    esp_err_t finishGarbagePage(size_t reservePages);
+
     TPageList mPageList;
     TPageList mFreePageList;
     std::unique_ptr<Page[]> mPages;
     uint32_t mBaseSector;
     uint32_t mPageCount;
     uint32_t mSeqNumber;
+    Page* mGarbagePage = nullptr;
+    bool mGarbageStopped = false;
+    size_t mGarbagePassPages = 0; // pages left to reclaim in the current pass, 0 if none started
+    size_t mGarbagePassFreePages = 0; // free pages when the current pass started
 }; // class PageManager
 
 
@@ -64,6 +64,21 @@ esp_err_t NVSPartition::erase_range(size_t dst_offset, size_t size)
     return esp_partition_erase_range(mESPPartition, dst_offset, size);
 }
 
+esp_err_t NVSPartition::mmap(size_t src_offset, size_t size, const void** ptr, uint32_t* handle)
+{
+    spi_flash_mmap_handle_t mmap_handle;
+    esp_err_t err = esp_partition_mmap(mESPPartition, src_offset, size, SPI_FLASH_MMAP_DATA, ptr, &mmap_handle);
+    if (err == ESP_OK) {
+        *handle = mmap_handle;
+    }
+    return err;
+}
+
+void NVSPartition::munmap(uint32_t handle)
+{
+    spi_flash_munmap(handle);
+}
+
 uint32_t NVSPartition::get_address()
 {
     return mESPPartition->address;
@@ -96,6 +96,20 @@ public:
      */
     esp_err_t erase_range(size_t dst_offset, size_t size) override;
 
+    /**
+     * Look into \c esp_partition_mmap for more details.
+     *
+     * @return
+     *      - ESP_OK on success
+     *      - error codes from the esp_partition API
+     */
+    esp_err_t mmap(size_t src_offset, size_t size, const void** ptr, uint32_t* handle) override;
+
+    /**
+     * Look into \c spi_flash_munmap for more details.
+     */
+    void munmap(uint32_t handle) override;
+
     /**
      * @return the base address of the partition.
      */
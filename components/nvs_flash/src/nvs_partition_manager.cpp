@@ -194,12 +194,13 @@ esp_err_t NVSPartitionManager::open_handle(const char *part_name,
         return ESP_ERR_NVS_PART_NOT_FOUND;
     }
 
-    esp_err_t err = sHandle->createOrOpenNamespace(ns_name, open_mode == NVS_READWRITE, nsIndex);
+    esp_err_t err = sHandle->createOrOpenNamespace(ns_name, open_mode != NVS_READONLY, nsIndex);
     if (err != ESP_OK) {
         return err;
     }
 
-    NVSHandleSimple* new_handle = new (std::nothrow) NVSHandleSimple(open_mode==NVS_READONLY, nsIndex, sHandle);
+    NVSHandleSimple* new_handle = new (std::nothrow) NVSHandleSimple(open_mode==NVS_READONLY, nsIndex, sHandle,
+            open_mode == NVS_READWRITE_TRANSACTIONAL);
     if (new_handle == nullptr) {
         return ESP_ERR_NO_MEM;
     }
@@ -210,6 +211,28 @@ esp_err_t NVSPartitionManager::open_handle(const char *part_name,
     return ESP_OK;
 }
 
+esp_err_t NVSPartitionManager::collect_garbage(const char *part_name, size_t max_items)
+{
+    if (part_name != nullptr) {
+        Storage* storage = lookup_storage_from_name(part_name);
+        if (storage == nullptr) {
+            return ESP_ERR_NVS_NOT_INITIALIZED;
+        }
+        return storage->collectGarbage(max_items);
+    }
+
+    esp_err_t result = ESP_OK;
+    for (auto it = nvs_storage_list.begin(); it != nvs_storage_list.end(); ++it) {
+        esp_err_t err = it->collectGarbage(max_items);
+        if (err == ESP_ERR_NOT_FINISHED) {
+            result = err;
+        } else if (err != ESP_OK && result == ESP_OK) {
+            result = err;
+        }
+    }
+    return result;
+}
+
 esp_err_t NVSPartitionManager::close_handle(NVSHandleSimple* handle) {
     for (auto it = nvs_handles.begin(); it != nvs_handles.end(); ++it) {
         if (it == intrusive_list<NVSHandleSimple>::iterator(handle)) {
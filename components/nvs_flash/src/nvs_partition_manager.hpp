@@ -39,6 +39,11 @@ public:
 
     Storage* lookup_storage_from_name(const char* name);
 
+    /**
+     * Runs a garbage collection step on the given partition, or on all partitions if part_name is nullptr.
+     */
+    esp_err_t collect_garbage(const char *part_name, size_t max_items);
+
     esp_err_t open_handle(const char *part_name, const char *ns_name, nvs_open_mode_t open_mode, NVSHandleSimple** handle);
 
     esp_err_t close_handle(NVSHandleSimple* handle);
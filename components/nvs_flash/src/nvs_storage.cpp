@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "nvs_storage.hpp"
+#include "sdkconfig.h"
+#include "esp_rom_crc.h"
 #if __has_include(<bsd/string.h>)
 // for strlcpy
 #include <bsd/string.h>
@@ -23,8 +25,33 @@
 namespace nvs
 {
 
+// Journal of the transaction being committed, see Storage::writeTransaction
+static const char* TXN_NAMESPACE = "nvs.txn";
+static const char* TXN_JOURNAL_KEY = "journal";
+
+// Upper bound of the number of entries taken by writing a value, including the entries left unused at the end
+// of a page when its item doesn't fit there
+static size_t entriesToWrite(ItemType datatype, size_t dataSize)
+{
+    const size_t dataEntries = (dataSize + Page::ENTRY_SIZE - 1) / Page::ENTRY_SIZE;
+
+    switch (datatype) {
+    case ItemType::SZ:
+        return 2 * (1 + dataEntries);
+
+    case ItemType::BLOB:
+        // the index, a header for each chunk, and the tailroom skipped by the first chunk
+        return 1 + dataEntries + dataEntries / (Page::ENTRY_COUNT - 1) + 2
+                + Page::CHUNK_MAX_SIZE / 10 / Page::ENTRY_SIZE + 1;
+
+    default:
+        return 1;
+    }
+}
+
 Storage::~Storage()
 {
+    cancelBlobWrites(Page::NS_ANY, nullptr, false);
     clearNamespaces();
 }
 
@@ -33,97 +60,233 @@ void Storage::clearNamespaces()
     mNamespaces.clearAndFreeNodes();
 }
 
-esp_err_t Storage::populateBlobIndices(TBlobIndexList& blobIdxList)
+static uint32_t blobKeyHash(uint8_t nsIndex, const char* key)
+{
+    uint32_t result = esp_rom_crc32_le(0xffffffff, &nsIndex, sizeof(nsIndex));
+    return esp_rom_crc32_le(result, reinterpret_cast<const uint8_t*>(key), strnlen(key, Item::MAX_KEY_LENGTH));
+}
+
+/**
+ * Hash table of the blob nodes collected during init, chained through their nextInBucket field.
+ * If there is no memory for more buckets, the table keeps the ones it has, down to a single bucket.
+ */
+template<typename TNode>
+class BlobBuckets
+{
+public:
+    BlobBuckets() : mBuckets(&mSingleBucket), mBucketCount(1), mSingleBucket(nullptr) { }
+
+    ~BlobBuckets()
+    {
+        if (mBuckets != &mSingleBucket) {
+            delete[] mBuckets;
+        }
+    }
+
+    size_t bucketCount() const
+    {
+        return mBucketCount;
+    }
+
+    TNode* bucket(uint32_t keyHash)
+    {
+        return mBuckets[keyHash % mBucketCount];
+    }
+
+    void insert(TNode* node)
+    {
+        TNode*& bucket = mBuckets[node->keyHash % mBucketCount];
+        node->nextInBucket = bucket;
+        bucket = node;
+    }
+
+    void rehash(intrusive_list<TNode>& nodes, size_t bucketCount)
+    {
+        TNode** buckets = new (std::nothrow) TNode*[bucketCount];
+        if (buckets != nullptr) {
+            if (mBuckets != &mSingleBucket) {
+                delete[] mBuckets;
+            }
+            mBuckets = buckets;
+            mBucketCount = bucketCount;
+        }
+        std::fill_n(mBuckets, mBucketCount, nullptr);
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            insert(it);
+        }
+    }
+
+private:
+    TNode** mBuckets;
+    size_t mBucketCount;
+    TNode* mSingleBucket;
+};
+
+/* Chunks with same <ns,key> and with chunkIndex in the following ranges
+ * belong to same family.
+ * 1) VER_0_OFFSET <= chunkIndex < VER_1_OFFSET-1 => Version0 chunks
+ * 2) VER_1_OFFSET <= chunkIndex < VER_ANY => Version1 chunks
+ */
+static VerOffset chunkVersion(uint8_t chunkIndex)
 {
+    return (chunkIndex < static_cast<uint8_t> (VerOffset::VER_1_OFFSET)) ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
+}
+
+esp_err_t Storage::loadItems(TBlobIndexList& blobIdxList, TBlobDataList& blobDataList)
+{
+    // Namespaces, blob indices and blob data chunks are all collected in a single pass over the items,
+    // as every item visited has to be read from flash. The data chunks are only recorded per blob version,
+    // so that the memory used doesn't depend on the number of chunks.
+    BlobBuckets<BlobDataNode> dataBuckets;
+
     for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
         Page& p = *it;
         size_t itemIndex = 0;
         Item item;
 
-        /* If the power went off just after writing a blob index, the duplicate detection
-         * logic in pagemanager will remove the earlier index. So we should never find a
-         * duplicate index at this point */
+        while (p.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            itemIndex += item.span;
+
+            if (item.nsIndex == Page::NS_INDEX && item.datatype == ItemType::U8) {
+                NamespaceEntry* entry = new (std::nothrow) NamespaceEntry;
+
+                if (!entry) return ESP_ERR_NO_MEM;
+
+                item.getKey(entry->mName, sizeof(entry->mName));
+                auto err = item.getValue(entry->mIndex);
+                if (err != ESP_OK) {
+                    delete entry;
+                    return err;
+                }
+                mNamespaces.push_back(entry);
+                if (mNamespaceUsage.set(entry->mIndex, true) != ESP_OK) {
+                    return ESP_FAIL;
+                }
+            } else if (item.datatype == ItemType::BLOB_IDX && item.chunkIndex == Page::CHUNK_ANY) {
+                /* If the power went off just after writing a blob index, the duplicate detection
+                 * logic in pagemanager will remove the earlier index. So we should never find a
+                 * duplicate index at this point */
+                BlobIndexNode* entry = new (std::nothrow) BlobIndexNode;
+
+                if (!entry) return ESP_ERR_NO_MEM;
+
+                item.getKey(entry->key, sizeof(entry->key));
+                entry->nsIndex = item.nsIndex;
+                entry->chunkStart = item.blobIndex.chunkStart;
+                entry->chunkCount = item.blobIndex.chunkCount;
+                entry->keyHash = blobKeyHash(entry->nsIndex, entry->key);
+                entry->nextInBucket = nullptr;
+
+                blobIdxList.push_back(entry);
+            } else if (item.datatype == ItemType::BLOB_DATA) {
+                char key[Item::MAX_KEY_LENGTH + 1];
+                item.getKey(key, sizeof(key));
+                const uint32_t keyHash = blobKeyHash(item.nsIndex, key);
+                const VerOffset chunkStart = chunkVersion(item.chunkIndex);
+
+                BlobDataNode* entry = dataBuckets.bucket(keyHash);
+                while (entry != nullptr && !(entry->keyHash == keyHash
+                            && entry->nsIndex == item.nsIndex
+                            && entry->chunkStart == chunkStart
+                            && strncmp(entry->key, key, sizeof(entry->key) - 1) == 0)) {
+                    entry = entry->nextInBucket;
+                }
+                if (entry != nullptr) {
+                    entry->firstChunk = std::min(entry->firstChunk, item.chunkIndex);
+                    entry->lastChunk = std::max(entry->lastChunk, item.chunkIndex);
+                    continue;
+                }
 
-        while (p.findItem(Page::NS_ANY, ItemType::BLOB_IDX, nullptr, itemIndex, item) == ESP_OK) {
-            BlobIndexNode* entry = new (std::nothrow) BlobIndexNode;
+                entry = new (std::nothrow) BlobDataNode;
 
-            if (!entry) return ESP_ERR_NO_MEM;
+                if (!entry) return ESP_ERR_NO_MEM;
 
-            item.getKey(entry->key, sizeof(entry->key));
-            entry->nsIndex = item.nsIndex;
-            entry->chunkStart = item.blobIndex.chunkStart;
-            entry->chunkCount = item.blobIndex.chunkCount;
+                strncpy(entry->key, key, sizeof(entry->key));
+                entry->nsIndex = item.nsIndex;
+                entry->chunkStart = chunkStart;
+                entry->firstChunk = item.chunkIndex;
+                entry->lastChunk = item.chunkIndex;
+                entry->keyHash = keyHash;
 
-            blobIdxList.push_back(entry);
-            itemIndex += item.span;
+                blobDataList.push_back(entry);
+                if (blobDataList.size() > dataBuckets.bucketCount()) {
+                    dataBuckets.rehash(blobDataList, 2 * blobDataList.size());
+                } else {
+                    dataBuckets.insert(entry);
+                }
+            }
         }
     }
 
     return ESP_OK;
 }
 
-void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
+void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList, TBlobDataList& blobDataList)
 {
-    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
-        Page& p = *it;
-        size_t itemIndex = 0;
-        Item item;
-        /* Chunks with same <ns,key> and with chunkIndex in the following ranges
-         * belong to same family.
-         * 1) VER_0_OFFSET <= chunkIndex < VER_1_OFFSET-1 => Version0 chunks
-         * 2) VER_1_OFFSET <= chunkIndex < VER_ANY => Version1 chunks
-         */
-        while (p.findItem(Page::NS_ANY, ItemType::BLOB_DATA, nullptr, itemIndex, item) == ESP_OK) {
-
-            auto iter = std::find_if(blobIdxList.begin(),
-                    blobIdxList.end(),
-                    [=] (const BlobIndexNode& e) -> bool
-                    {return (strncmp(item.key, e.key, sizeof(e.key) - 1) == 0)
-                            && (item.nsIndex == e.nsIndex)
-                            && (item.chunkIndex >=  static_cast<uint8_t> (e.chunkStart))
-                            && (item.chunkIndex < static_cast<uint8_t> (e.chunkStart) + e.chunkCount);});
-            if (iter == std::end(blobIdxList)) {
-                p.eraseItem(item.nsIndex, item.datatype, item.key, item.chunkIndex);
+    // Hash the blob indices by namespace and key
+    BlobBuckets<BlobIndexNode> buckets;
+    buckets.rehash(blobIdxList, blobIdxList.size() + 1);
+
+    for (auto it = blobDataList.begin(); it != blobDataList.end(); ++it) {
+        const BlobIndexNode* e = buckets.bucket(it->keyHash);
+        while (e != nullptr && !(e->keyHash == it->keyHash
+                    && e->nsIndex == it->nsIndex
+                    && e->chunkStart == it->chunkStart
+                    && strncmp(it->key, e->key, sizeof(e->key) - 1) == 0)) {
+            e = e->nextInBucket;
+        }
+
+        // Erase the chunks of this version which the index doesn't refer to, which are all of them
+        // if there is no index
+        for (int chunkIdx = it->firstChunk; chunkIdx <= it->lastChunk; ++chunkIdx) {
+            if (e != nullptr && chunkIdx >= static_cast<uint8_t> (e->chunkStart)
+                    && chunkIdx < static_cast<uint8_t> (e->chunkStart) + e->chunkCount) {
+                continue;
+            }
+            // a power loss may have left the chunk on two pages
+            Page* findPage = nullptr;
+            Item item;
+            while (findItem(it->nsIndex, ItemType::BLOB_DATA, it->key, findPage, item, chunkIdx) == ESP_OK) {
+                if (findPage->eraseItem(it->nsIndex, ItemType::BLOB_DATA, it->key, chunkIdx) != ESP_OK) {
+                    break;
+                }
             }
-            itemIndex += item.span;
         }
     }
 }
 
 esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 {
-    auto err = mPageManager.load(mPartition, baseSector, sectorCount);
+    // the chunks of the blob writes in progress are erased below, along with other orphaned chunks
+    cancelBlobWrites(Page::NS_ANY, nullptr, false);
+#if CONFIG_NVS_ITEM_INDEX
+    mItemIndex.init();
+#else
+    mItemIndex.clear();
+#endif
+#if CONFIG_NVS_READ_CACHE_SIZE
+    mValueCache.setCapacity(CONFIG_NVS_READ_CACHE_SIZE, CONFIG_NVS_READ_CACHE_MAX_VALUE_SIZE);
+#else
+    mValueCache.setCapacity(0, 0);
+#endif
+    auto err = mPageManager.load(mPartition, baseSector, sectorCount, &mItemIndex);
     if (err != ESP_OK) {
         mState = StorageState::INVALID;
         return err;
     }
 
-    // load namespaces list
+    // load namespaces list, together with the list of multi-page index entries and their data chunks
     clearNamespaces();
     std::fill_n(mNamespaceUsage.data(), mNamespaceUsage.byteSize() / 4, 0);
-    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
-        Page& p = *it;
-        size_t itemIndex = 0;
-        Item item;
-        while (p.findItem(Page::NS_INDEX, ItemType::U8, nullptr, itemIndex, item) == ESP_OK) {
-            NamespaceEntry* entry = new (std::nothrow) NamespaceEntry;
-
-            if (!entry) {
-                mState = StorageState::INVALID;
-                return ESP_ERR_NO_MEM;
-            }
-
-            item.getKey(entry->mName, sizeof(entry->mName));
-            err = item.getValue(entry->mIndex);
-            if (err != ESP_OK) {
-                return err;
-            }
-            mNamespaces.push_back(entry);
-            if (mNamespaceUsage.set(entry->mIndex, true) != ESP_OK) {
-                return ESP_FAIL;
-            }
-            itemIndex += item.span;
-        }
+    TBlobIndexList blobIdxList;
+    TBlobDataList blobDataList;
+    err = loadItems(blobIdxList, blobDataList);
+    if (err != ESP_OK) {
+        blobIdxList.clearAndFreeNodes();
+        blobDataList.clearAndFreeNodes();
+        clearNamespaces();
+        mState = StorageState::INVALID;
+        return err;
     }
     if (mNamespaceUsage.set(0, true) != ESP_OK) {
         return ESP_FAIL;
@@ -133,19 +296,20 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
     }
     mState = StorageState::ACTIVE;
 
-    // Populate list of multi-page index entries.
-    TBlobIndexList blobIdxList;
-    err = populateBlobIndices(blobIdxList);
-    if (err != ESP_OK) {
-        mState = StorageState::INVALID;
-        return ESP_ERR_NO_MEM;
-    }
-
     // Remove the entries for which there is no parent multi-page index.
-    eraseOrphanDataBlobs(blobIdxList);
+    eraseOrphanDataBlobs(blobIdxList, blobDataList);
 
-    // Purge the blob index list
+    // Purge the blob lists
     blobIdxList.clearAndFreeNodes();
+    blobDataList.clearAndFreeNodes();
+
+    // Complete a transaction which was interrupted by a power loss. If that fails, the journal is kept for the
+    // next init, and no other modification must be made before it has been replayed.
+    err = replayTransactionJournal();
+    if (err != ESP_OK) {
+        mState = StorageState::INVALID;
+        return err;
+    }
 
 #ifdef DEBUG_STORAGE
     debugCheck();
@@ -160,8 +324,45 @@ bool Storage::isValid() const
 
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
+    size_t itemIndex;
+    return findItem(nsIndex, datatype, key, page, itemIndex, item, chunkIdx, chunkStart);
+}
+
+esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, size_t& itemIndex, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
+{
+    // Page::findItem only consults its hash list for fully specified searches, do the same here.
+    // A page which doesn't have the item hash in its hash list can't return the item in that case.
+    if (mItemIndex.isValid() && nsIndex != Page::NS_ANY && datatype != ItemType::ANY && key != nullptr) {
+        Page* candidates[ItemIndex::MAX_CANDIDATES];
+        const uint32_t hash = Item(nsIndex, datatype, 0, key, chunkIdx).calculateCrc32WithoutValue() & 0xffffff;
+        const size_t count = mItemIndex.find(hash, candidates, ItemIndex::MAX_CANDIDATES);
+        if (count <= ItemIndex::MAX_CANDIDATES) {
+            // if several pages hold the item, return the oldest one, as the page walk below would do
+            Page* foundPage = nullptr;
+            uint32_t foundSeqNumber = UINT32_MAX;
+            for (size_t i = 0; i < count; ++i) {
+                size_t candidateIndex = 0;
+                Item candidateItem;
+                uint32_t seqNumber;
+                if (candidates[i]->findItem(nsIndex, datatype, key, candidateIndex, candidateItem, chunkIdx, chunkStart) == ESP_OK
+                        && candidates[i]->getSeqNumber(seqNumber) == ESP_OK
+                        && (foundPage == nullptr || seqNumber < foundSeqNumber)) {
+                    foundPage = candidates[i];
+                    foundSeqNumber = seqNumber;
+                    itemIndex = candidateIndex;
+                    item = candidateItem;
+                }
+            }
+            if (foundPage == nullptr) {
+                return ESP_ERR_NVS_NOT_FOUND;
+            }
+            page = foundPage;
+            return ESP_OK;
+        }
+    }
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
-        size_t itemIndex = 0;
+        itemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart);
         if (err == ESP_OK) {
             page = it;
@@ -171,30 +372,29 @@ esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key,
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
-esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
+size_t Storage::getMaxBlobSize()
 {
-    uint8_t chunkCount = 0;
-    TUsedPageList usedPages;
-    size_t remainingSize = dataSize;
-    size_t offset = 0;
-    esp_err_t err = ESP_OK;
-
     /* Check how much maximum data can be accommodated**/
     uint32_t max_pages = mPageManager.getPageCount() - 1;
 
     if(max_pages > (Page::CHUNK_ANY-1)/2) {
        max_pages = (Page::CHUNK_ANY-1)/2;
     }
+    return max_pages * Page::CHUNK_MAX_SIZE;
+}
 
-    if (dataSize > max_pages * Page::CHUNK_MAX_SIZE) {
-        return ESP_ERR_NVS_VALUE_TOO_LONG;
-    }
+esp_err_t Storage::writeBlobChunks(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart, uint8_t& chunkCount)
+{
+    size_t remainingSize = dataSize;
+    size_t offset = 0;
+    bool firstChunk = true;
+    esp_err_t err = ESP_OK;
 
     do {
         Page& page = getCurrentPage();
         size_t tailroom = page.getVarDataTailroom();
         size_t chunkSize = 0;
-        if (chunkCount == 0U && ((tailroom < dataSize) || (tailroom == 0 && dataSize == 0)) && tailroom < Page::CHUNK_MAX_SIZE/10) {
+        if (firstChunk && ((tailroom < dataSize) || (tailroom == 0 && dataSize == 0)) && tailroom < Page::CHUNK_MAX_SIZE/10) {
             /** This is the first chunk and tailroom is too small ***/
             if (page.state() != Page::PageState::FULL) {
                 err = page.markFull();
@@ -212,8 +412,12 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
                 continue;
             }
         } else if (!tailroom) {
-            err = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
-            break;
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+
+        /* A version has room for (CHUNK_ANY-1)/2 chunk indices */
+        if (chunkCount >= (Page::CHUNK_ANY-1)/2) {
+            return ESP_ERR_NVS_VALUE_TOO_LONG;
         }
 
         /* Split the blob into two and store the chunk of available size onto the current page */
@@ -225,67 +429,215 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
         err = page.writeItem(nsIndex, ItemType::BLOB_DATA, key,
                 static_cast<const uint8_t*> (data) + offset, chunkSize, static_cast<uint8_t> (chunkStart) + chunkCount);
         chunkCount++;
+        firstChunk = false;
 
         if (err != ESP_OK) {
             NVS_ASSERT_OR_RETURN(err != ESP_ERR_NVS_PAGE_FULL, err);
-            break;
-        } else {
-            UsedPageNode* node = new (std::nothrow) UsedPageNode();
-            if (!node) {
-                err = ESP_ERR_NO_MEM;
-                break;
-            }
-            node->mPage = &page;
-            usedPages.push_back(node);
-            if (remainingSize || (tailroom - chunkSize) < Page::ENTRY_SIZE) {
-                if (page.state() != Page::PageState::FULL) {
-                    err = page.markFull();
-                    if (err != ESP_OK) {
-                        break;
-                    }
-                }
-                err = mPageManager.requestNewPage();
+            return err;
+        }
+        if (remainingSize || (tailroom - chunkSize) < Page::ENTRY_SIZE) {
+            if (page.state() != Page::PageState::FULL) {
+                err = page.markFull();
                 if (err != ESP_OK) {
-                    break;
+                    return err;
                 }
             }
+            err = mPageManager.requestNewPage();
+            if (err != ESP_OK) {
+                return err;
+            }
         }
         offset += chunkSize;
-        if (!remainingSize) {
-            /* All pages are stored. Now store the index.*/
-            Item item;
-            std::fill_n(item.data, sizeof(item.data), 0xff);
-            item.blobIndex.dataSize = dataSize;
-            item.blobIndex.chunkCount = chunkCount;
-            item.blobIndex.chunkStart = chunkStart;
+    } while (remainingSize);
 
-            err = getCurrentPage().writeItem(nsIndex, ItemType::BLOB_IDX, key, item.data, sizeof(item.data));
-            NVS_ASSERT_OR_RETURN(err != ESP_ERR_NVS_PAGE_FULL, err);
-            break;
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobIndex(uint8_t nsIndex, const char* key, size_t dataSize, VerOffset chunkStart, uint8_t chunkCount)
+{
+    Item item;
+    std::fill_n(item.data, sizeof(item.data), 0xff);
+    item.blobIndex.dataSize = dataSize;
+    item.blobIndex.chunkCount = chunkCount;
+    item.blobIndex.chunkStart = chunkStart;
+
+    auto err = getCurrentPage().writeItem(nsIndex, ItemType::BLOB_IDX, key, item.data, sizeof(item.data));
+    NVS_ASSERT_OR_RETURN(err != ESP_ERR_NVS_PAGE_FULL, err);
+    return err;
+}
+
+void Storage::eraseBlobChunks(uint8_t nsIndex, const char* key, VerOffset chunkStart, uint8_t chunkCount)
+{
+    Item item;
+    Page* findPage = nullptr;
+    for (uint8_t chunkNum = 0; chunkNum < chunkCount; chunkNum++) {
+        const uint8_t chunkIdx = static_cast<uint8_t> (chunkStart) + chunkNum;
+        if (findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, chunkIdx) == ESP_OK) {
+            findPage->eraseItem(nsIndex, ItemType::BLOB_DATA, key, chunkIdx);
         }
-    } while (1);
+    }
+}
+
+esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
+{
+    uint8_t chunkCount = 0;
+
+    if (dataSize > getMaxBlobSize()) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+
+    esp_err_t err = writeBlobChunks(nsIndex, key, data, dataSize, chunkStart, chunkCount);
+    if (err == ESP_OK) {
+        /* All pages are stored. Now store the index.*/
+        err = writeBlobIndex(nsIndex, key, dataSize, chunkStart, chunkCount);
+    }
 
     if (err != ESP_OK) {
         /* Anything failed, then we should erase all the written chunks*/
-        int ii=0;
-        for (auto it = std::begin(usedPages); it != std::end(usedPages); it++) {
-            it->mPage->eraseItem(nsIndex, ItemType::BLOB_DATA, key, ii++);
-        }
+        eraseBlobChunks(nsIndex, key, chunkStart, chunkCount);
     }
-    usedPages.clearAndFreeNodes();
     return err;
 }
 
+esp_err_t Storage::beginBlobWrite(BlobWrite& write, uint8_t nsIndex, const char* key)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    // another write of the blob in pieces would write chunks of the same version
+    cancelBlobWrites(nsIndex, key, true);
+
+    Page* findPage = nullptr;
+    Item item;
+    VerOffset chunkStart = VerOffset::VER_0_OFFSET;
+    auto err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if (err == ESP_OK) {
+        NVS_ASSERT_OR_RETURN(item.blobIndex.chunkStart == VerOffset::VER_0_OFFSET
+                || item.blobIndex.chunkStart == VerOffset::VER_1_OFFSET, ESP_FAIL);
+        /* Toggle the version by changing the offset */
+        chunkStart = (item.blobIndex.chunkStart == VerOffset::VER_1_OFFSET) ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+
+    write.mNsIndex = nsIndex;
+    std::fill_n(write.mKey, sizeof(write.mKey), 0);
+    strncpy(write.mKey, key, sizeof(write.mKey) - 1);
+    write.mChunkStart = chunkStart;
+    write.mChunkCount = 0;
+    write.mActive = true;
+    mBlobWrites.push_back(&write);
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeBlobChunks(BlobWrite& write, const void* data, size_t dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (!write.mActive) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    return writeBlobChunks(write.mNsIndex, write.mKey, data, dataSize, write.mChunkStart, write.mChunkCount);
+}
+
+esp_err_t Storage::finishBlobWrite(BlobWrite& write, size_t dataSize)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    // completing a transaction which writes the blob cancels the write
+    auto err = completeTransaction();
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!write.mActive) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    const uint8_t nsIndex = write.mNsIndex;
+    const char* key = write.mKey;
+
+    mPageManager.resumeGarbageCollection();
+    mValueCache.invalidate(nsIndex, key);
+
+    Page* findPage = nullptr;
+    Item item;
+    err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    const bool hasPrevious = (err == ESP_OK);
+
+    // Any other write of the blob has cancelled this one, so the current version has to be the other one
+    NVS_ASSERT_OR_RETURN(!hasPrevious || item.blobIndex.chunkStart != write.mChunkStart, ESP_FAIL);
+
+    err = writeBlobIndex(nsIndex, key, dataSize, write.mChunkStart, write.mChunkCount);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The new blob is published now, so any failure from here on only leaves the previous one behind
+    write.mActive = false;
+    mBlobWrites.erase(&write);
+    if (hasPrevious) {
+        /* Erase the blob with earlier version*/
+        err = eraseMultiPageBlob(nsIndex, key, item.blobIndex.chunkStart);
+    } else {
+        /* Support for earlier versions where BLOBS were stored without index */
+        err = findItem(nsIndex, ItemType::BLOB, key, findPage, item);
+        if (err == ESP_OK) {
+            err = findPage->eraseItem(nsIndex, ItemType::BLOB, key);
+        } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    return (err == ESP_OK) ? ESP_OK : ESP_ERR_NVS_REMOVE_FAILED;
+}
+
+void Storage::abortBlobWrite(BlobWrite& write)
+{
+    if (!write.mActive) {
+        return;
+    }
+    // the write hasn't been cancelled, so no other write has written chunks of its version
+    eraseBlobChunks(write.mNsIndex, write.mKey, write.mChunkStart, write.mChunkCount);
+    write.mActive = false;
+    mBlobWrites.erase(&write);
+}
+
+void Storage::cancelBlobWrites(uint8_t nsIndex, const char* key, bool eraseChunks)
+{
+    for (auto it = mBlobWrites.begin(); it != mBlobWrites.end();) {
+        auto write = it++;
+        if ((nsIndex == Page::NS_ANY || write->mNsIndex == nsIndex)
+                && (key == nullptr || strncmp(write->mKey, key, sizeof(write->mKey) - 1) == 0)) {
+            if (eraseChunks) {
+                eraseBlobChunks(write->mNsIndex, write->mKey, write->mChunkStart, write->mChunkCount);
+            }
+            write->mActive = false;
+            mBlobWrites.erase(write);
+        }
+    }
+}
+
 esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
 {
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    esp_err_t err = completeTransaction();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    mPageManager.resumeGarbageCollection();
+    mValueCache.invalidate(nsIndex, key);
+
     Page* findPage = nullptr;
     Item item;
 
-    esp_err_t err;
     if (datatype == ItemType::BLOB) {
         err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
     } else {
@@ -323,6 +675,9 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
             nextStart
                 = (prevStart == VerOffset::VER_1_OFFSET) ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
         }
+        // A blob write in progress has written chunks of the new version, which can't be told apart from ours
+        cancelBlobWrites(nsIndex, key, true);
+
         /* Write the blob with new version*/
         err = writeMultiPageBlob(nsIndex, key, data, dataSize, nextStart);
 
@@ -504,6 +859,98 @@ esp_err_t Storage::readMultiPageBlob(uint8_t nsIndex, const char* key, void* dat
     return err;
 }
 
+esp_err_t Storage::passChunk(Page& page, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx,
+        uint8_t*& buffer, size_t& offset, nvs_blob_chunk_cb_t cb, void* arg)
+{
+    size_t itemIndex = 0;
+    Item item;
+    auto err = page.findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const size_t dataSize = item.varLength.dataSize;
+    if (dataSize == 0) {
+        return ESP_OK;
+    }
+
+    const void* data;
+    uint32_t handle;
+    err = page.mapItemData(itemIndex, item, data, handle);
+    if (err == ESP_OK) {
+        err = cb(data, dataSize, offset, arg);
+        page.unmapItemData(handle);
+    } else if (err == ESP_ERR_NOT_SUPPORTED) {
+        // the data can't be mapped, read it through the buffer
+        if (buffer == nullptr) {
+            buffer = new (std::nothrow) uint8_t[Page::CHUNK_MAX_SIZE];
+            if (buffer == nullptr) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        NVS_ASSERT_OR_RETURN(dataSize <= Page::CHUNK_MAX_SIZE, ESP_FAIL);
+        err = page.readItemData(itemIndex, item, buffer, dataSize);
+        if (err == ESP_OK) {
+            err = cb(buffer, dataSize, offset, arg);
+        }
+    }
+    if (err == ESP_OK) {
+        offset += dataSize;
+    }
+    return err;
+}
+
+esp_err_t Storage::readBlobChunks(uint8_t nsIndex, const char* key, nvs_blob_chunk_cb_t cb, void* arg)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    Item item;
+    Page* findPage = nullptr;
+    uint8_t* buffer = nullptr;
+    size_t offset = 0;
+
+    auto err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        // blob stored with earlier version format without index
+        err = findItem(nsIndex, ItemType::BLOB, key, findPage, item);
+        if (err == ESP_OK) {
+            err = passChunk(*findPage, nsIndex, ItemType::BLOB, key, Page::CHUNK_ANY, buffer, offset, cb, arg);
+        }
+        delete[] buffer;
+        return err;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t chunkCount = item.blobIndex.chunkCount;
+    VerOffset chunkStart = item.blobIndex.chunkStart;
+    size_t dataSize = item.blobIndex.dataSize;
+
+    for (uint8_t chunkNum = 0; chunkNum < chunkCount; chunkNum++) {
+        const uint8_t chunkIdx = static_cast<uint8_t> (chunkStart) + chunkNum;
+        err = findItem(nsIndex, ItemType::BLOB_DATA, key, findPage, item, chunkIdx);
+        if (err != ESP_OK) {
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                eraseMultiPageBlob(nsIndex, key); // cleanup if a chunk is not found
+            }
+            break;
+        }
+        err = passChunk(*findPage, nsIndex, ItemType::BLOB_DATA, key, chunkIdx, buffer, offset, cb, arg);
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+    delete[] buffer;
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    NVS_ASSERT_OR_RETURN(offset == dataSize, ESP_FAIL);
+    return ESP_OK;
+}
+
 esp_err_t Storage::cmpMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize)
 {
     Item item;
@@ -552,21 +999,33 @@ esp_err_t Storage::readItem(uint8_t nsIndex, ItemType datatype, const char* key,
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    auto err = mValueCache.read(nsIndex, datatype, key, data, dataSize);
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+
     Item item;
     Page* findPage = nullptr;
     if (datatype == ItemType::BLOB) {
-        auto err = readMultiPageBlob(nsIndex, key, data, dataSize);
+        err = readMultiPageBlob(nsIndex, key, data, dataSize);
+        if (err == ESP_OK) {
+            mValueCache.insert(nsIndex, datatype, key, data, dataSize);
+        }
         if (err != ESP_ERR_NVS_NOT_FOUND) {
             return err;
         } // else check if the blob is stored with earlier version format without index
     }
 
-    auto err = findItem(nsIndex, datatype, key, findPage, item);
+    err = findItem(nsIndex, datatype, key, findPage, item);
     if (err != ESP_OK) {
         return err;
     }
-    return findPage->readItem(nsIndex, datatype, key, data, dataSize);
-
+    err = findPage->readItem(nsIndex, datatype, key, data, dataSize);
+    if (err == ESP_OK) {
+        mValueCache.insert(nsIndex, datatype, key, data,
+                isVariableLengthType(datatype) ? item.varLength.dataSize : dataSize);
+    }
+    return err;
 }
 
 esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffset chunkStart)
@@ -577,6 +1036,8 @@ esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffse
     Item item;
     Page* findPage = nullptr;
 
+    mValueCache.invalidate(nsIndex, key);
+
     auto err = findItem(nsIndex, ItemType::BLOB_IDX, key, findPage, item, Page::CHUNK_ANY, chunkStart);
     if (err != ESP_OK) {
         return err;
@@ -620,13 +1081,21 @@ esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    auto err = completeTransaction();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    mPageManager.resumeGarbageCollection();
+    mValueCache.invalidate(nsIndex, key);
+
     if (datatype == ItemType::BLOB) {
         return eraseMultiPageBlob(nsIndex, key);
     }
 
     Item item;
     Page* findPage = nullptr;
-    auto err = findItem(nsIndex, datatype, key, findPage, item);
+    err = findItem(nsIndex, datatype, key, findPage, item);
     if (err != ESP_OK) {
         return err;
     }
@@ -644,9 +1113,19 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    auto err = completeTransaction();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    mPageManager.resumeGarbageCollection();
+    mValueCache.invalidate(nsIndex, nullptr);
+    // the chunks of the blob writes in progress are erased below
+    cancelBlobWrites(nsIndex, nullptr, false);
+
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         while (true) {
-            auto err = it->eraseItem(nsIndex, ItemType::ANY, nullptr);
+            err = it->eraseItem(nsIndex, ItemType::ANY, nullptr);
             if (err == ESP_ERR_NVS_NOT_FOUND) {
                 break;
             }
@@ -659,12 +1138,260 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
 
 }
 
+bool Storage::isModification(Transaction::Op& op)
+{
+    Page* findPage = nullptr;
+    Item item;
+
+    switch (op.mType) {
+    case Transaction::OpType::WRITE:
+        if (op.mDatatype == ItemType::BLOB) {
+            return cmpMultiPageBlob(op.mNsIndex, op.mKey, op.mData, op.mDataSize) != ESP_OK;
+        }
+        return findItem(op.mNsIndex, op.mDatatype, op.mKey, findPage, item) != ESP_OK
+                || findPage->cmpItem(op.mNsIndex, op.mDatatype, op.mKey, op.mData, op.mDataSize) != ESP_OK;
+
+    case Transaction::OpType::ERASE:
+        return findItem(op.mNsIndex, ItemType::ANY, op.mKey, findPage, item) != ESP_ERR_NVS_NOT_FOUND;
+
+    default:
+        return true;
+    }
+}
+
+esp_err_t Storage::applyTransactionOp(Transaction::Op& op)
+{
+    esp_err_t err;
+
+    switch (op.mType) {
+    case Transaction::OpType::WRITE:
+        return writeItem(op.mNsIndex, op.mDatatype, op.mKey, op.mData, op.mDataSize);
+
+    case Transaction::OpType::ERASE:
+        // erase items of all types, so that applying the operation again has no effect
+        do {
+            err = eraseItem(op.mNsIndex, ItemType::ANY, op.mKey);
+        } while (err == ESP_OK);
+        return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+
+    case Transaction::OpType::ERASE_ALL:
+        return eraseNamespace(op.mNsIndex);
+
+    default:
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+}
+
+esp_err_t Storage::applyTransaction(Transaction& txn)
+{
+    for (auto it = txn.begin(); it != txn.end(); ++it) {
+        auto err = applyTransactionOp(*it);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t Storage::replayTransactionJournal()
+{
+    uint8_t journalNsIndex;
+    auto err = createOrOpenNamespace(TXN_NAMESPACE, false, journalNsIndex);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        mJournalPending = false;
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t journalSize;
+    err = getItemDataSize(journalNsIndex, ItemType::BLOB, TXN_JOURNAL_KEY, journalSize);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        mJournalPending = false;
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    mJournalPending = true;
+    uint8_t* journal = new (std::nothrow) uint8_t[journalSize];
+    if (!journal) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = readItem(journalNsIndex, ItemType::BLOB, TXN_JOURNAL_KEY, journal, journalSize);
+    if (err != ESP_OK) {
+        delete[] journal;
+        return err;
+    }
+
+    Transaction txn;
+    err = txn.parse(journal, journalSize);
+    delete[] journal;
+    if (err == ESP_ERR_NO_MEM) {
+        return err;
+    }
+
+    // The transaction has been committed once its journal is valid, so it is kept until all of its operations
+    // have been applied. Applying them again is harmless. A journal which is not valid is dropped.
+    mApplyingJournal = true;
+    if (err == ESP_OK) {
+        err = applyTransaction(txn);
+        if (err != ESP_OK) {
+            mApplyingJournal = false;
+            return err;
+        }
+    }
+    err = eraseItem(journalNsIndex, ItemType::BLOB, TXN_JOURNAL_KEY);
+    mApplyingJournal = false;
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        return err;
+    }
+    mJournalPending = false;
+    return ESP_OK;
+}
+
+esp_err_t Storage::completeTransaction()
+{
+    if (!mJournalPending || mApplyingJournal) {
+        return ESP_OK;
+    }
+    return replayTransactionJournal();
+}
+
+esp_err_t Storage::checkTransaction(Transaction& txn, size_t journalSize)
+{
+    size_t neededEntries = entriesToWrite(ItemType::BLOB, journalSize);
+    for (auto it = txn.begin(); it != txn.end(); ++it) {
+        if (it->mType != Transaction::OpType::WRITE) {
+            continue;
+        }
+        if (it->mDatatype == ItemType::BLOB && it->mDataSize > getMaxBlobSize()) {
+            return ESP_ERR_NVS_VALUE_TOO_LONG;
+        }
+        neededEntries += entriesToWrite(it->mDatatype, it->mDataSize);
+    }
+
+    // Entries which are erased can be reclaimed by garbage collection, which needs a free page of its own.
+    // The entries freed by the transaction itself are not counted.
+    nvs_stats_t stats;
+    auto err = mPageManager.fillStats(stats);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (stats.free_entries < Page::ENTRY_COUNT || neededEntries > stats.free_entries - Page::ENTRY_COUNT) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t Storage::writeTransaction(Transaction& txn)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    // The journal of an incomplete transaction would be overwritten below, so complete that transaction first.
+    if (mJournalPending) {
+        auto err = replayTransactionJournal();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Drop the writes of values which are already stored and the erasures of items which don't exist.
+    // Operations which follow an erasure of the same key or namespace have to be kept.
+    for (auto it = txn.begin(); it != txn.end();) {
+        auto op = it++;
+        bool followsErase = false;
+        for (auto prev = txn.begin(); prev != op; ++prev) {
+            if (prev->mNsIndex == op->mNsIndex && (prev->mType == Transaction::OpType::ERASE_ALL
+                    || (prev->mType == Transaction::OpType::ERASE && strncmp(prev->mKey, op->mKey, sizeof(prev->mKey) - 1) == 0))) {
+                followsErase = true;
+                break;
+            }
+        }
+        if (!followsErase && !isModification(*op)) {
+            txn.remove(op);
+        }
+    }
+
+    if (txn.empty()) {
+        return ESP_OK;
+    }
+
+    // Writing or erasing a single item is atomic on its own
+    if (txn.size() == 1 && txn.begin()->mType != Transaction::OpType::ERASE_ALL) {
+        return applyTransactionOp(*txn.begin());
+    }
+
+    // Otherwise, record the operations in a journal blob first. The blob becomes visible only once its index
+    // has been written, so a power loss before that point leaves the storage unchanged, and a power loss after
+    // that point lets init() apply the rest of the operations from the journal.
+    uint8_t journalNsIndex;
+    auto err = createOrOpenNamespace(TXN_NAMESPACE, true, journalNsIndex);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Once the journal has been written, the transaction has to be applied as a whole, so make sure it can be
+    const size_t journalSize = txn.journalSize();
+    err = checkTransaction(txn, journalSize);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t* journal = new (std::nothrow) uint8_t[journalSize];
+    if (!journal) {
+        return ESP_ERR_NO_MEM;
+    }
+    txn.serialize(journal);
+    err = writeItem(journalNsIndex, ItemType::BLOB, TXN_JOURNAL_KEY, journal, journalSize);
+    delete[] journal;
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // If applying the operations fails, for example because of a flash failure, the journal stays pending and
+    // the rest of them are applied before any other modification, or by the next init.
+    mJournalPending = true;
+    mApplyingJournal = true;
+    err = applyTransaction(txn);
+    if (err == ESP_OK) {
+        err = eraseItem(journalNsIndex, ItemType::BLOB, TXN_JOURNAL_KEY);
+    }
+    mApplyingJournal = false;
+    if (err != ESP_OK) {
+        return err;
+    }
+    mJournalPending = false;
+    return ESP_OK;
+}
+
+esp_err_t Storage::collectGarbage(size_t maxItems)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    auto err = mPageManager.collectGarbage(maxItems, CONFIG_NVS_GC_RESERVE_PAGES);
+#ifdef DEBUG_STORAGE
+    debugCheck();
+#endif
+    return err;
+}
+
 esp_err_t Storage::getItemDataSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize)
 {
     if (mState != StorageState::ACTIVE) {
         return ESP_ERR_NVS_NOT_INITIALIZED;
     }
 
+    if (isVariableLengthType(datatype) && mValueCache.getSize(nsIndex, datatype, key, dataSize)) {
+        return ESP_OK;
+    }
+
     Item item;
     Page* findPage = nullptr;
     auto err = findItem(nsIndex, datatype, key, findPage, item);
@@ -684,6 +1411,134 @@ esp_err_t Storage::getItemDataSize(uint8_t nsIndex, ItemType datatype, const cha
     return ESP_OK;
 }
 
+esp_err_t Storage::readDescribedItem(uint8_t nsIndex, ItemType datatype, nvs_item_desc_t& desc)
+{
+    if (!isVariableLengthType(datatype)) {
+        return readItem(nsIndex, datatype, desc.key, desc.value, Page::getAlignmentForType(datatype));
+    }
+
+    size_t dataSize;
+    auto err = getItemDataSize(nsIndex, datatype, desc.key, dataSize);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (desc.value == nullptr) {
+        desc.length = dataSize;
+        return ESP_OK;
+    } else if (desc.length < dataSize) {
+        desc.length = dataSize;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    err = readItem(nsIndex, datatype, desc.key, desc.value, dataSize);
+    if (err == ESP_OK) {
+        desc.length = dataSize;
+    }
+    return err;
+}
+
+esp_err_t Storage::readFoundItem(Page& page, size_t itemIndex, const Item& item, nvs_item_desc_t& desc)
+{
+    size_t dataSize = Page::getAlignmentForType(item.datatype);
+    if (isVariableLengthType(item.datatype)) {
+        dataSize = item.varLength.dataSize;
+        if (desc.value == nullptr) {
+            desc.length = dataSize;
+            return ESP_OK;
+        } else if (desc.length < dataSize) {
+            desc.length = dataSize;
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+    }
+
+    auto err = page.readItemData(itemIndex, item, desc.value, dataSize);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (isVariableLengthType(item.datatype)) {
+        desc.length = dataSize;
+    }
+    mValueCache.insert(item.nsIndex, item.datatype, desc.key, desc.value, dataSize);
+    return ESP_OK;
+}
+
+esp_err_t Storage::readItems(uint8_t nsIndex, nvs_item_desc_t* items, size_t count)
+{
+    if (mState != StorageState::ACTIVE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+
+    // Cached values are read directly. So are blobs, whose chunks may be spread over several pages.
+    size_t pending = 0;
+    for (size_t i = 0; i < count; ++i) {
+        nvs_item_desc_t& desc = items[i];
+        if (desc.err != ESP_ERR_NOT_FINISHED) {
+            continue;
+        }
+        ItemType datatype;
+        if (desc.key == nullptr || !itemTypeOfNvsType(desc.type, datatype)
+                || (desc.value == nullptr && !isVariableLengthType(datatype))) {
+            desc.err = ESP_ERR_INVALID_ARG;
+            continue;
+        }
+        size_t dataSize;
+        if (datatype == ItemType::BLOB || mValueCache.getSize(nsIndex, datatype, desc.key, dataSize)) {
+            desc.err = readDescribedItem(nsIndex, datatype, desc);
+            continue;
+        }
+        ++pending;
+    }
+
+    // Look up all other items through the item index. Without it, look them up in a single pass over the pages
+    // instead of a page walk per item. Like findItem, the pass returns the item found on the oldest page if
+    // a power loss has left a duplicate.
+    if (mItemIndex.isValid()) {
+        for (size_t i = 0; i < count; ++i) {
+            nvs_item_desc_t& desc = items[i];
+            if (desc.err != ESP_ERR_NOT_FINISHED) {
+                continue;
+            }
+            ItemType datatype = ItemType::ANY;
+            itemTypeOfNvsType(desc.type, datatype);
+            Page* findPage = nullptr;
+            size_t itemIndex;
+            Item item;
+            desc.err = findItem(nsIndex, datatype, desc.key, findPage, itemIndex, item);
+            if (desc.err == ESP_OK) {
+                desc.err = readFoundItem(*findPage, itemIndex, item, desc);
+            }
+        }
+        pending = 0;
+    }
+    for (auto it = std::begin(mPageManager); it != std::end(mPageManager) && pending > 0; ++it) {
+        for (size_t i = 0; i < count; ++i) {
+            nvs_item_desc_t& desc = items[i];
+            if (desc.err != ESP_ERR_NOT_FINISHED) {
+                continue;
+            }
+            ItemType datatype = ItemType::ANY;
+            itemTypeOfNvsType(desc.type, datatype);
+            size_t itemIndex = 0;
+            Item item;
+            if (it->findItem(nsIndex, datatype, desc.key, itemIndex, item) != ESP_OK) {
+                continue;
+            }
+            desc.err = readFoundItem(*it, itemIndex, item, desc);
+            --pending;
+        }
+    }
+
+    esp_err_t result = ESP_OK;
+    for (size_t i = 0; i < count; ++i) {
+        if (items[i].err == ESP_ERR_NOT_FINISHED) {
+            items[i].err = ESP_ERR_NVS_NOT_FOUND;
+        }
+        if (result == ESP_OK) {
+            result = items[i].err;
+        }
+    }
+    return result;
+}
+
 void Storage::debugDump()
 {
     for (auto p = mPageManager.begin(); p != mPageManager.end(); ++p) {
@@ -710,6 +1565,13 @@ void Storage::debugCheck()
                 assert(0);
             }
             keys.insert(std::make_pair(keystr, static_cast<Page*>(p)));
+            if (mItemIndex.isValid()) {
+                Page* candidates[ItemIndex::MAX_CANDIDATES];
+                const uint32_t hash = item.calculateCrc32WithoutValue() & 0xffffff;
+                size_t count = mItemIndex.find(hash, candidates, ItemIndex::MAX_CANDIDATES);
+                assert(count > ItemIndex::MAX_CANDIDATES ||
+                        std::find(candidates, candidates + count, static_cast<Page*>(p)) != candidates + count);
+            }
             itemIndex += item.span;
             usedCount += item.span;
         }
@@ -20,6 +20,9 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_item_index.hpp"
+#include "nvs_transaction.hpp"
+#include "nvs_value_cache.hpp"
 #include "partition.hpp"
 
 //extern void dumpBytes(const uint8_t* data, size_t count);
@@ -42,23 +45,55 @@ class Storage : public intrusive_list_node<Storage>
 
     typedef intrusive_list<NamespaceEntry> TNamespaces;
 
-    struct UsedPageNode: public intrusive_list_node<UsedPageNode> {
-        public: Page* mPage;
-    };
-
-    typedef intrusive_list<UsedPageNode> TUsedPageList;
-
     struct BlobIndexNode: public intrusive_list_node<BlobIndexNode> {
         public:
             char key[Item::MAX_KEY_LENGTH + 1];
             uint8_t nsIndex;
             uint8_t chunkCount;
             VerOffset chunkStart;
+            uint32_t keyHash;
+            BlobIndexNode* nextInBucket;
     };
 
     typedef intrusive_list<BlobIndexNode> TBlobIndexList;
 
+    // One node per version of a blob found in the data chunks, whatever the number of its chunks
+    struct BlobDataNode: public intrusive_list_node<BlobDataNode> {
+        public:
+            char key[Item::MAX_KEY_LENGTH + 1];
+            uint8_t nsIndex;
+            VerOffset chunkStart;
+            uint8_t firstChunk;
+            uint8_t lastChunk;
+            uint32_t keyHash;
+            BlobDataNode* nextInBucket;
+    };
+
+    typedef intrusive_list<BlobDataNode> TBlobDataList;
+
 public:
+    /**
+     * A blob being written in pieces, see BlobWriter. Storage keeps track of the writes in progress, because their
+     * chunks have the same version as the ones the next write of the blob by other means would get. Such a write,
+     * another write of the blob in pieces or the erasure of the namespace cancels them and erases their chunks first.
+     */
+    class BlobWrite : public intrusive_list_node<BlobWrite>
+    {
+    public:
+        bool isActive() const
+        {
+            return mActive;
+        }
+
+    protected:
+        friend class Storage;
+        uint8_t mNsIndex = 0;
+        char mKey[Item::MAX_KEY_LENGTH + 1];
+        VerOffset mChunkStart = VerOffset::VER_0_OFFSET;
+        uint8_t mChunkCount = 0;
+        bool mActive = false;
+    };
+
     ~Storage();
 
     Storage(Partition *partition) : mPartition(partition) {
@@ -81,6 +116,14 @@ public:
 
     esp_err_t eraseItem(uint8_t nsIndex, ItemType datatype, const char* key);
 
+    /**
+     * Reads the items described by the elements of items whose err field is ESP_ERR_NOT_FINISHED, as nvs_get_many
+     * does, and stores the result for each of them in err. Other elements are left untouched.
+     *
+     * @return ESP_OK if all items have been read, the first error stored in items otherwise
+     */
+    esp_err_t readItems(uint8_t nsIndex, nvs_item_desc_t* items, size_t count);
+
     template<typename T>
     esp_err_t writeItem(uint8_t nsIndex, const char* key, const T& value)
     {
@@ -100,6 +143,17 @@ public:
 
     esp_err_t eraseNamespace(uint8_t nsIndex);
 
+    /**
+     * Applies all modifications of a transaction, so that after a power loss either all or none of them
+     * are visible. Modifications which don't change the contents of the storage are removed from txn.
+     */
+    esp_err_t writeTransaction(Transaction& txn);
+
+    /**
+     * Reclaims space in a bounded step, see PageManager::collectGarbage.
+     */
+    esp_err_t collectGarbage(size_t maxItems);
+
     const Partition *getPart() const
     {
         return mPartition;
@@ -117,8 +171,31 @@ public:
 
     esp_err_t writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart);
 
+    size_t getMaxBlobSize();
+
+    /**
+     * Writing a blob in pieces, see BlobWriter. beginBlobWrite picks the version of the new chunks, writeBlobChunks
+     * writes each piece as one or more chunks of that version, and finishBlobWrite publishes the blob index and erases
+     * the previous version of the blob. Until then, the new chunks are orphans, which init() erases after a power loss.
+     * If the write isn't finished, abortBlobWrite erases the chunks written so far. Once the write has been cancelled,
+     * see BlobWrite, writeBlobChunks and finishBlobWrite fail with ESP_ERR_NVS_INVALID_STATE.
+     */
+    esp_err_t beginBlobWrite(BlobWrite& write, uint8_t nsIndex, const char* key);
+
+    esp_err_t writeBlobChunks(BlobWrite& write, const void* data, size_t dataSize);
+
+    esp_err_t finishBlobWrite(BlobWrite& write, size_t dataSize);
+
+    void abortBlobWrite(BlobWrite& write);
+
     esp_err_t readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize);
 
+    /**
+     * Passes the value of a blob to cb chunk by chunk, as nvs_get_blob_chunks does. Chunks are read in place
+     * if they can be mapped, otherwise through a buffer of the size of a single chunk.
+     */
+    esp_err_t readBlobChunks(uint8_t nsIndex, const char* key, nvs_blob_chunk_cb_t cb, void* arg);
+
     esp_err_t cmpMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize);
 
     esp_err_t eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffset chunkStart = VerOffset::VER_ANY);
@@ -129,6 +206,11 @@ public:
 
     esp_err_t fillStats(nvs_stats_t& nvsStats);
 
+    void fillCacheStats(nvs_cache_stats_t& cacheStats) const
+    {
+        mValueCache.fillStats(cacheStats);
+    }
+
     esp_err_t calcEntriesInNamespace(uint8_t nsIndex, size_t& usedEntries);
 
     bool findEntry(nvs_opaque_iterator_t*, const char* name);
@@ -144,21 +226,66 @@ protected:
 
     void clearNamespaces();
 
-    esp_err_t populateBlobIndices(TBlobIndexList&);
+    esp_err_t loadItems(TBlobIndexList&, TBlobDataList&);
 
-    void eraseOrphanDataBlobs(TBlobIndexList&);
+    void eraseOrphanDataBlobs(TBlobIndexList&, TBlobDataList&);
 
     void fillEntryInfo(Item &item, nvs_entry_info_t &info);
 
+    bool isModification(Transaction::Op& op);
+
+    esp_err_t applyTransactionOp(Transaction::Op& op);
+
+    esp_err_t applyTransaction(Transaction& txn);
+
+    esp_err_t replayTransactionJournal();
+
+    /**
+     * Replays the journal of a committed transaction whose operations failed to be applied, before any other
+     * modification, so that replaying it later can't overwrite that modification.
+     */
+    esp_err_t completeTransaction();
+
+    /**
+     * Checks that the writes of a transaction can be applied, and that there is room for them and for the journal.
+     */
+    esp_err_t checkTransaction(Transaction& txn, size_t journalSize);
+
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+    esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, size_t& itemIndex, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
+
+    esp_err_t readDescribedItem(uint8_t nsIndex, ItemType datatype, nvs_item_desc_t& desc);
+
+    esp_err_t readFoundItem(Page& page, size_t itemIndex, const Item& item, nvs_item_desc_t& desc);
+
+    esp_err_t writeBlobIndex(uint8_t nsIndex, const char* key, size_t dataSize, VerOffset chunkStart, uint8_t chunkCount);
+
+    esp_err_t writeBlobChunks(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart, uint8_t& chunkCount);
+
+    void eraseBlobChunks(uint8_t nsIndex, const char* key, VerOffset chunkStart, uint8_t chunkCount);
+
+    /**
+     * Cancels the blob writes in progress of the given key, or of the whole namespace if key is nullptr,
+     * or of all namespaces if nsIndex is Page::NS_ANY. Their chunks are erased if eraseChunks is set.
+     */
+    void cancelBlobWrites(uint8_t nsIndex, const char* key, bool eraseChunks);
+
+    esp_err_t passChunk(Page& page, uint8_t nsIndex, ItemType datatype, const char* key, uint8_t chunkIdx,
+            uint8_t*& buffer, size_t& offset, nvs_blob_chunk_cb_t cb, void* arg);
+
 protected:
     Partition *mPartition;
     size_t mPageCount;
+    ItemIndex mItemIndex; // has to outlive mPageManager, whose pages refer to it
     PageManager mPageManager;
+    ValueCache mValueCache;
     TNamespaces mNamespaces;
+    intrusive_list<BlobWrite> mBlobWrites;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
     StorageState mState = StorageState::INVALID;
+    bool mJournalPending = false;
+    bool mApplyingJournal = false;
 };
 
 } // namespace nvs
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_transaction.hpp"
+#include "nvs_page.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace nvs
+{
+
+// Whether a write recorded in a journal is one which Storage::writeItem can apply
+static bool isValidWrite(ItemType datatype, size_t dataSize)
+{
+    switch (datatype) {
+    case ItemType::U8:
+    case ItemType::I8:
+    case ItemType::U16:
+    case ItemType::I16:
+    case ItemType::U32:
+    case ItemType::I32:
+    case ItemType::U64:
+    case ItemType::I64:
+        // the size of primitive types is in the low nibble of their type
+        return dataSize == (static_cast<uint8_t>(datatype) & 0x0f);
+    case ItemType::SZ:
+        return dataSize <= Page::CHUNK_MAX_SIZE;
+    case ItemType::BLOB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Transaction::Op* Transaction::append(OpType type, uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    Op* op = new (std::nothrow) Op;
+    if (!op) {
+        return nullptr;
+    }
+    if (dataSize) {
+        op->mData = new (std::nothrow) uint8_t[dataSize];
+        if (!op->mData) {
+            delete op;
+            return nullptr;
+        }
+        memcpy(op->mData, data, dataSize);
+    }
+    op->mType = type;
+    op->mNsIndex = nsIndex;
+    op->mDatatype = datatype;
+    std::fill_n(op->mKey, sizeof(op->mKey), 0);
+    if (key) {
+        strncpy(op->mKey, key, sizeof(op->mKey) - 1);
+    }
+    op->mDataSize = dataSize;
+    mOps.push_back(op);
+    return op;
+}
+
+void Transaction::remove(Op* op)
+{
+    mOps.erase(op);
+    delete op;
+}
+
+esp_err_t Transaction::write(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    // allocate first, so that a failure leaves the staged value untouched
+    Op* newOp = append(OpType::WRITE, nsIndex, datatype, key, data, dataSize);
+    if (!newOp) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (auto it = mOps.begin(); it != mOps.end(); ++it) {
+        if (it->mType == OpType::WRITE && it != TOpList::iterator(newOp) && it->mNsIndex == nsIndex
+                && it->mDatatype == datatype && strncmp(it->mKey, key, sizeof(it->mKey) - 1) == 0) {
+            remove(it);
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t Transaction::erase(uint8_t nsIndex, const char* key)
+{
+    for (auto it = mOps.begin(); it != mOps.end();) {
+        auto op = it++;
+        if (op->mNsIndex == nsIndex && strncmp(op->mKey, key, sizeof(op->mKey) - 1) == 0) {
+            if (op->mType == OpType::ERASE) {
+                return ESP_OK;
+            }
+            remove(op);
+        }
+    }
+    if (!append(OpType::ERASE, nsIndex, ItemType::ANY, key, nullptr, 0)) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t Transaction::eraseAll(uint8_t nsIndex)
+{
+    for (auto it = mOps.begin(); it != mOps.end();) {
+        auto op = it++;
+        if (op->mNsIndex == nsIndex) {
+            remove(op);
+        }
+    }
+    if (!append(OpType::ERASE_ALL, nsIndex, ItemType::ANY, nullptr, nullptr, 0)) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t Transaction::find(uint8_t nsIndex, ItemType datatype, const char* key, Op*& op)
+{
+    esp_err_t err = ESP_ERR_NVS_INVALID_STATE;
+    for (auto it = mOps.begin(); it != mOps.end(); ++it) {
+        if (it->mNsIndex != nsIndex) {
+            continue;
+        }
+        if (it->mType == OpType::ERASE_ALL) {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        } else if (strncmp(it->mKey, key, sizeof(it->mKey) - 1) != 0) {
+            continue;
+        } else if (it->mType == OpType::ERASE) {
+            err = ESP_ERR_NVS_NOT_FOUND;
+        } else if (datatype == ItemType::ANY || it->mDatatype == datatype) {
+            op = it;
+            err = ESP_OK;
+        }
+    }
+    return err;
+}
+
+size_t Transaction::journalSize()
+{
+    size_t size = sizeof(JournalHeader);
+    for (auto it = mOps.begin(); it != mOps.end(); ++it) {
+        size += sizeof(JournalRecord) + it->mDataSize;
+    }
+    return size;
+}
+
+void Transaction::serialize(uint8_t* journal)
+{
+    JournalHeader header;
+    std::fill_n(reinterpret_cast<uint8_t*>(&header), sizeof(header), 0xff);
+    header.version = JOURNAL_VERSION;
+    header.opCount = mOps.size();
+    memcpy(journal, &header, sizeof(header));
+    journal += sizeof(header);
+
+    for (auto it = mOps.begin(); it != mOps.end(); ++it) {
+        JournalRecord record;
+        std::fill_n(reinterpret_cast<uint8_t*>(&record), sizeof(record), 0xff);
+        record.type = static_cast<uint8_t>(it->mType);
+        record.nsIndex = it->mNsIndex;
+        record.datatype = static_cast<uint8_t>(it->mDatatype);
+        memcpy(record.key, it->mKey, sizeof(record.key));
+        record.dataSize = it->mDataSize;
+        memcpy(journal, &record, sizeof(record));
+        journal += sizeof(record);
+        if (it->mDataSize) {
+            memcpy(journal, it->mData, it->mDataSize);
+            journal += it->mDataSize;
+        }
+    }
+}
+
+esp_err_t Transaction::parse(const uint8_t* journal, size_t size)
+{
+    clear();
+
+    JournalHeader header;
+    if (size < sizeof(header)) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(&header, journal, sizeof(header));
+    if (header.version != JOURNAL_VERSION) {
+        return ESP_ERR_NVS_INVALID_STATE;
+    }
+    size_t offset = sizeof(header);
+
+    for (uint32_t i = 0; i < header.opCount; ++i) {
+        JournalRecord record;
+        if (size - offset < sizeof(record)) {
+            clear();
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        memcpy(&record, journal + offset, sizeof(record));
+        offset += sizeof(record);
+        if (size - offset < record.dataSize) {
+            clear();
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        record.key[sizeof(record.key) - 1] = 0;
+        const OpType type = static_cast<OpType>(record.type);
+        if (type != OpType::WRITE && type != OpType::ERASE && type != OpType::ERASE_ALL) {
+            clear();
+            return ESP_ERR_NVS_INVALID_STATE;
+        }
+        if (type == OpType::WRITE && !isValidWrite(static_cast<ItemType>(record.datatype), record.dataSize)) {
+            clear();
+            return ESP_ERR_NVS_INVALID_STATE;
+        }
+        if (!append(type, record.nsIndex, static_cast<ItemType>(record.datatype), record.key,
+                journal + offset, record.dataSize)) {
+            clear();
+            return ESP_ERR_NO_MEM;
+        }
+        offset += record.dataSize;
+    }
+    return ESP_OK;
+}
+
+} // namespace nvs
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_transaction_hpp
+#define nvs_transaction_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "esp_err.h"
+#include "intrusive_list.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+/**
+ * Ordered list of modifications staged in RAM by a transactional handle.
+ *
+ * Modifications of the same item are coalesced while they are staged, so that only the last value of each item
+ * is written when the transaction is committed. Storage::writeTransaction applies the list to flash atomically.
+ *
+ * The list can also be serialized into a journal and parsed back from it, which is how Storage completes
+ * a transaction interrupted by a power loss.
+ */
+class Transaction
+{
+public:
+    enum class OpType : uint8_t {
+        WRITE = 1,
+        ERASE = 2,
+        ERASE_ALL = 3,
+    };
+
+    struct Op : public intrusive_list_node<Op> {
+    public:
+        ~Op()
+        {
+            delete[] mData;
+        }
+
+        OpType mType;
+        uint8_t mNsIndex;
+        ItemType mDatatype;
+        char mKey[Item::MAX_KEY_LENGTH + 1];
+        size_t mDataSize = 0;
+        uint8_t* mData = nullptr;
+    };
+
+    typedef intrusive_list<Op> TOpList;
+
+    Transaction() { }
+
+    ~Transaction()
+    {
+        clear();
+    }
+
+    /**
+     * Stages a write of an item, replacing a previously staged write of the same item.
+     */
+    esp_err_t write(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    /**
+     * Stages the erasure of all items with the given key, dropping previously staged writes of that key.
+     */
+    esp_err_t erase(uint8_t nsIndex, const char* key);
+
+    /**
+     * Stages the erasure of the whole namespace, dropping all previously staged modifications of it.
+     */
+    esp_err_t eraseAll(uint8_t nsIndex);
+
+    /**
+     * Looks up the staged state of an item. If datatype is ItemType::ANY, a staged write of any type matches.
+     *
+     * @return ESP_OK and the staged write in op if the item has been written,
+     *         ESP_ERR_NVS_NOT_FOUND if the item has been erased,
+     *         ESP_ERR_NVS_INVALID_STATE if the transaction doesn't touch the item and the value in flash is current.
+     */
+    esp_err_t find(uint8_t nsIndex, ItemType datatype, const char* key, Op*& op);
+
+    void clear()
+    {
+        mOps.clearAndFreeNodes();
+    }
+
+    bool empty() const
+    {
+        return mOps.empty();
+    }
+
+    size_t size() const
+    {
+        return mOps.size();
+    }
+
+    TOpList::iterator begin()
+    {
+        return mOps.begin();
+    }
+
+    TOpList::iterator end()
+    {
+        return mOps.end();
+    }
+
+    void remove(Op* op);
+
+    /**
+     * Size of the journal produced by serialize, in bytes.
+     */
+    size_t journalSize();
+
+    void serialize(uint8_t* journal);
+
+    /**
+     * Replaces the contents of the transaction with the operations recorded in a journal. Fails if the journal
+     * is not valid, including when it records writes of values of the wrong size for their type.
+     */
+    esp_err_t parse(const uint8_t* journal, size_t size);
+
+    static const uint8_t JOURNAL_VERSION = 1;
+
+protected:
+    struct JournalHeader {
+        uint8_t version;
+        uint8_t reserved[3];
+        uint32_t opCount;
+    };
+
+    struct JournalRecord {
+        uint8_t type;
+        uint8_t nsIndex;
+        uint8_t datatype;
+        uint8_t reserved;
+        char key[Item::MAX_KEY_LENGTH + 1];
+        uint32_t dataSize;
+    };
+
+    Op* append(OpType type, uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    TOpList mOps;
+
+private:
+    Transaction(const Transaction& other);
+    const Transaction& operator= (const Transaction& rhs);
+}; // class Transaction
+
+} // namespace nvs
+
+#endif /* nvs_transaction_hpp */
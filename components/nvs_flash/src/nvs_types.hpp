@@ -39,6 +39,34 @@ inline bool isVariableLengthType(ItemType type)
             type == ItemType::BLOB_DATA);
 }
 
+/**
+ * Translates the type of a value in the C API into the type used to look it up in storage.
+ * Blobs are looked up by ItemType::BLOB, as nvs_get_blob does.
+ *
+ * @return false if type is not the type of a value
+ */
+inline bool itemTypeOfNvsType(nvs_type_t type, ItemType& datatype)
+{
+    switch (type) {
+    case NVS_TYPE_U8:
+    case NVS_TYPE_I8:
+    case NVS_TYPE_U16:
+    case NVS_TYPE_I16:
+    case NVS_TYPE_U32:
+    case NVS_TYPE_I32:
+    case NVS_TYPE_U64:
+    case NVS_TYPE_I64:
+    case NVS_TYPE_STR:
+        datatype = static_cast<ItemType>(type);
+        return true;
+    case NVS_TYPE_BLOB:
+        datatype = ItemType::BLOB;
+        return true;
+    default:
+        return false;
+    }
+}
+
 class Item
 {
 public:
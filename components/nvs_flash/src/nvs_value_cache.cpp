@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_value_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "esp_rom_crc.h"
+
+namespace nvs
+{
+
+void ValueCache::setCapacity(size_t capacity, size_t maxValueSize)
+{
+    clear();
+    mCapacity = capacity;
+    // a single value must not be able to flush the whole cache
+    mMaxValueSize = std::min(maxValueSize, capacity / 2 > sizeof(Entry) ? capacity / 2 - sizeof(Entry) : 0);
+
+    if (mBuckets != &mSingleBucket) {
+        delete[] mBuckets;
+    }
+    mBuckets = &mSingleBucket;
+    mBucketCount = 1;
+
+    size_t bucketCount = 1;
+    while (bucketCount < capacity / cost(0)) {
+        bucketCount *= 2;
+    }
+    if (bucketCount > 1) {
+        Entry** buckets = new (std::nothrow) Entry*[bucketCount]();
+        // without buckets, the entries are all looked up in the single one
+        if (buckets) {
+            mBuckets = buckets;
+            mBucketCount = bucketCount;
+        }
+    }
+}
+
+uint32_t ValueCache::hash(uint8_t nsIndex, const char* key)
+{
+    uint32_t result = esp_rom_crc32_le(0xffffffff, &nsIndex, sizeof(nsIndex));
+    return esp_rom_crc32_le(result, reinterpret_cast<const uint8_t*>(key), strnlen(key, Item::MAX_KEY_LENGTH));
+}
+
+ValueCache::Entry* ValueCache::find(uint8_t nsIndex, ItemType datatype, const char* key)
+{
+    const uint32_t keyHash = hash(nsIndex, key);
+    for (Entry* entry = bucket(keyHash); entry; entry = entry->mNextInBucket) {
+        if (entry->mHash == keyHash && entry->mNsIndex == nsIndex && entry->mDatatype == datatype
+                && strncmp(entry->mKey, key, Item::MAX_KEY_LENGTH) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+void ValueCache::remove(Entry* entry)
+{
+    Entry** link = &bucket(entry->mHash);
+    while (*link != entry) {
+        link = &(*link)->mNextInBucket;
+    }
+    *link = entry->mNextInBucket;
+    mEntries.erase(entry);
+    mUsedBytes -= cost(entry->mDataSize);
+    --mEntryCount;
+    delete entry;
+}
+
+esp_err_t ValueCache::read(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize)
+{
+    if (!isEnabled()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    Entry* entry = find(nsIndex, datatype, key);
+    if (!entry) {
+        ++mMisses;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    ++mHits;
+    if (entry != &mEntries.front()) {
+        mEntries.erase(entry);
+        mEntries.push_front(entry);
+    }
+
+    if (!isVariableLengthType(datatype)) {
+        if (dataSize != entry->mDataSize) {
+            return ESP_ERR_NVS_TYPE_MISMATCH;
+        }
+    } else if (dataSize < entry->mDataSize) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(data, entry->mData, entry->mDataSize);
+    return ESP_OK;
+}
+
+bool ValueCache::getSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    Entry* entry = find(nsIndex, datatype, key);
+    if (!entry) {
+        return false;
+    }
+    dataSize = entry->mDataSize;
+    return true;
+}
+
+void ValueCache::insert(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize)
+{
+    if (!isEnabled() || dataSize > mMaxValueSize) {
+        return;
+    }
+
+    Entry* entry = find(nsIndex, datatype, key);
+    if (entry) {
+        remove(entry);
+    }
+
+    while (mUsedBytes + cost(dataSize) > mCapacity && !mEntries.empty()) {
+        remove(&mEntries.back());
+        ++mEvictions;
+    }
+
+    entry = new (std::nothrow) Entry;
+    if (!entry) {
+        return;
+    }
+    if (dataSize) {
+        entry->mData = new (std::nothrow) uint8_t[dataSize];
+        if (!entry->mData) {
+            delete entry;
+            return;
+        }
+        memcpy(entry->mData, data, dataSize);
+    }
+    entry->mHash = hash(nsIndex, key);
+    entry->mNsIndex = nsIndex;
+    entry->mDatatype = datatype;
+    std::fill_n(entry->mKey, sizeof(entry->mKey), 0);
+    strncpy(entry->mKey, key, sizeof(entry->mKey) - 1);
+    entry->mDataSize = dataSize;
+    entry->mNextInBucket = bucket(entry->mHash);
+    bucket(entry->mHash) = entry;
+    mEntries.push_front(entry);
+    mUsedBytes += cost(dataSize);
+    ++mEntryCount;
+}
+
+void ValueCache::invalidate(uint8_t nsIndex, const char* key)
+{
+    if (mEntries.empty()) {
+        return;
+    }
+    if (key) {
+        // the values of all types of the key are in the same bucket
+        const uint32_t keyHash = hash(nsIndex, key);
+        Entry* next;
+        for (Entry* entry = bucket(keyHash); entry; entry = next) {
+            next = entry->mNextInBucket;
+            if (entry->mHash == keyHash && entry->mNsIndex == nsIndex
+                    && strncmp(entry->mKey, key, Item::MAX_KEY_LENGTH) == 0) {
+                remove(entry);
+            }
+        }
+        return;
+    }
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        auto entry = it++;
+        if (entry->mNsIndex == nsIndex) {
+            remove(entry);
+        }
+    }
+}
+
+void ValueCache::clear()
+{
+    mEntries.clearAndFreeNodes();
+    std::fill_n(mBuckets, mBucketCount, nullptr);
+    mUsedBytes = 0;
+    mEntryCount = 0;
+}
+
+void ValueCache::fillStats(nvs_cache_stats_t& stats) const
+{
+    stats.hits = mHits;
+    stats.misses = mMisses;
+    stats.evictions = mEvictions;
+    stats.used_bytes = mUsedBytes;
+    stats.total_bytes = mCapacity;
+    stats.entry_count = mEntryCount;
+}
+
+} // namespace nvs
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_value_cache_hpp
+#define nvs_value_cache_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "esp_err.h"
+#include "nvs.h"
+#include "intrusive_list.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+/**
+ * Bounded cache of recently read item values, kept in least recently used order.
+ *
+ * Storage fills the cache after each successful read and drops the entries of an item whenever the item
+ * is written or erased, so that a cached value is always the one stored in flash. Moving an item to
+ * another page doesn't change its value, so garbage collection doesn't touch the cache.
+ *
+ * The capacity accounts for the values as well as for the bookkeeping of each entry. A capacity of zero
+ * disables the cache. Entries are found through a hash table of the namespace index and key, with about one
+ * bucket for every entry the capacity can hold, so that a lookup doesn't depend on the number of entries.
+ */
+class ValueCache
+{
+public:
+    ValueCache() { }
+
+    ~ValueCache()
+    {
+        clear();
+        if (mBuckets != &mSingleBucket) {
+            delete[] mBuckets;
+        }
+    }
+
+    /**
+     * Drops all entries and sets the capacity of the cache in bytes and the size of the largest value it holds.
+     */
+    void setCapacity(size_t capacity, size_t maxValueSize);
+
+    bool isEnabled() const
+    {
+        return mCapacity != 0;
+    }
+
+    /**
+     * Copies a cached value into data, with the same size checks as Page::readItem.
+     *
+     * @return ESP_ERR_NVS_NOT_FOUND if the value is not cached, otherwise the result of the read
+     */
+    esp_err_t read(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize);
+
+    /**
+     * Looks up the size of a cached value without counting a hit or a miss.
+     */
+    bool getSize(uint8_t nsIndex, ItemType datatype, const char* key, size_t& dataSize);
+
+    /**
+     * Caches a value which has just been read from flash, evicting the least recently used values if needed.
+     * Values larger than the maximum size are not cached.
+     */
+    void insert(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize);
+
+    /**
+     * Drops the values of all types with the given key, or all values of the namespace if key is nullptr.
+     */
+    void invalidate(uint8_t nsIndex, const char* key);
+
+    void clear();
+
+    void fillStats(nvs_cache_stats_t& stats) const;
+
+protected:
+    struct Entry : public intrusive_list_node<Entry> {
+    public:
+        ~Entry()
+        {
+            delete[] mData;
+        }
+
+        uint32_t mHash;
+        Entry* mNextInBucket = nullptr;
+        uint8_t mNsIndex;
+        ItemType mDatatype;
+        char mKey[Item::MAX_KEY_LENGTH + 1];
+        size_t mDataSize = 0;
+        uint8_t* mData = nullptr;
+    };
+
+    typedef intrusive_list<Entry> TEntryList;
+
+    static uint32_t hash(uint8_t nsIndex, const char* key);
+
+    static size_t cost(size_t dataSize)
+    {
+        return sizeof(Entry) + dataSize;
+    }
+
+    Entry*& bucket(uint32_t keyHash)
+    {
+        return mBuckets[keyHash & (mBucketCount - 1)];
+    }
+
+    Entry* find(uint8_t nsIndex, ItemType datatype, const char* key);
+
+    void remove(Entry* entry);
+
+    TEntryList mEntries; // most recently used first
+    Entry** mBuckets = &mSingleBucket;
+    Entry* mSingleBucket = nullptr; // used when the buckets can't be allocated
+    size_t mBucketCount = 1; // power of two
+    size_t mCapacity = 0;
+    size_t mMaxValueSize = 0;
+    size_t mUsedBytes = 0;
+    size_t mEntryCount = 0;
+    uint32_t mHits = 0;
+    uint32_t mMisses = 0;
+    uint32_t mEvictions = 0;
+
+private:
+    ValueCache(const ValueCache& other);
+    const ValueCache& operator= (const ValueCache& rhs);
+}; // class ValueCache
+
+} // namespace nvs
+
+#endif /* nvs_value_cache_hpp */
@@ -43,6 +43,20 @@ public:
 
     virtual esp_err_t erase_range(size_t dst_offset, size_t size) = 0;
 
+    /**
+     * Map size bytes at src_offset into the data address space, so that they can be read in place.
+     * The data is mapped as it is stored, so partitions which decrypt data in read() don't support mapping.
+     * The mapping has to be released with munmap().
+     *
+     * @return ESP_ERR_NOT_SUPPORTED if the partition can't be mapped
+     */
+    virtual esp_err_t mmap(size_t src_offset, size_t size, const void** ptr, uint32_t* handle)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    virtual void munmap(uint32_t handle) { }
+
     /**
      * Return the address of the beginning of the partition.
      */
@@ -3,3 +3,7 @@
 #define CONFIG_LOG_TIMESTAMP_SOURCE_RTOS 1
 #define CONFIG_IDF_TARGET_LINUX 1
 #define CONFIG_NVS_ASSERT_ERROR_CHECK 1
+#define CONFIG_NVS_ITEM_INDEX 1
+#define CONFIG_NVS_GC_RESERVE_PAGES 2
+#define CONFIG_NVS_READ_CACHE_SIZE 2048
+#define CONFIG_NVS_READ_CACHE_MAX_VALUE_SIZE 64
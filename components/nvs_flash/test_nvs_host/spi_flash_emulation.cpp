@@ -104,6 +104,27 @@ esp_err_t esp_partition_write_raw(const esp_partition_t* partition,
     return ESP_OK;
 }
 
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory,
+                             const void** out_ptr, spi_flash_mmap_handle_t* out_handle)
+{
+    if (!s_emulator) {
+        return ESP_ERR_FLASH_OP_TIMEOUT;
+    }
+
+    if (offset + size > s_emulator->size()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_ptr = s_emulator->bytes() + offset;
+    *out_handle = 0;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle)
+{
+}
+
 // timing data for ESP8266, 160MHz CPU frequency, 80MHz flash requency
 // all values in microseconds
 // values are for block sizes starting at 4 bytes and going up to 4096 bytes
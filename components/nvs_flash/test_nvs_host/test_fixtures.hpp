@@ -91,6 +91,17 @@ public:
         return ESP_OK;
     }
 
+    esp_err_t mmap(size_t src_offset, size_t size, const void** ptr, uint32_t* handle) override
+    {
+        if (src_offset + size > flash_emu->size()) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        *ptr = flash_emu->bytes() + src_offset;
+        *handle = 0;
+        return ESP_OK;
+    }
+
     uint32_t get_address() override
     {
         return address;
@@ -11,6 +11,7 @@
 #include "nvs_partition_manager.hpp"
 #include "nvs_partition.hpp"
 #include "mbedtls/aes.h"
+#include "esp_rom_crc.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -19,6 +20,7 @@
 #include <sys/wait.h>
 #include <string.h>
 #include <string>
+#include <chrono>
 
 #include "test_fixtures.hpp"
 
@@ -324,6 +326,47 @@ TEST_CASE("HashList is cleaned up as soon as items are erased", "[nvs]")
     CHECK(hashlist.getBlockCount() == 0);
 }
 
+TEST_CASE("ItemIndex keeps track of pages holding item hashes", "[nvs]")
+{
+    ItemIndex index;
+    Page pages[3];
+    Page* found[ItemIndex::MAX_CANDIDATES];
+
+    index.insert(1, &pages[0]);
+    CHECK(index.find(1, found, ItemIndex::MAX_CANDIDATES) == 0); // index is not valid until init()
+
+    index.init();
+    // many hashes sharing the same home slot, so that erasing has to shift the probe sequence
+    const size_t count = 200;
+    for (uint32_t i = 0; i < count; ++i) {
+        index.insert(i << 12, &pages[i % 3]);
+    }
+    index.insert(0, &pages[0]);
+    index.insert(0, &pages[1]);
+    CHECK(index.size() == count + 1);
+    CHECK(index.find(0, found, ItemIndex::MAX_CANDIDATES) == 2);
+
+    for (uint32_t i = 0; i < count; i += 2) {
+        index.erase(i << 12, &pages[i % 3]);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t n = index.find(i << 12, found, ItemIndex::MAX_CANDIDATES);
+        if (i == 0) {
+            // two inserts for pages[0], one for pages[1], one erase for pages[0]
+            CHECK(n == 2);
+        } else if (i % 2) {
+            REQUIRE(n == 1);
+            CHECK(found[0] == &pages[i % 3]);
+        } else {
+            CHECK(n == 0);
+        }
+    }
+
+    index.clear();
+    CHECK(index.isValid() == false);
+    CHECK(index.find(1 << 12, found, ItemIndex::MAX_CANDIDATES) == 0);
+}
+
 TEST_CASE("can init PageManager in empty flash", "[nvs]")
 {
     PartitionEmulationFixture f(0, 4);
@@ -331,6 +374,26 @@ TEST_CASE("can init PageManager in empty flash", "[nvs]")
     CHECK(pm.load(&f.part, 0, 4) == ESP_OK);
 }
 
+TEST_CASE("PageManager checks free pages for leftover data once they are activated", "[nvs]")
+{
+    PartitionEmulationFixture f(0, 3);
+    const uint32_t garbage = 0x12345678;
+    const size_t garbageAddr = SPI_FLASH_SEC_SIZE + 1024;
+    CHECK(f.emu.write(garbageAddr, &garbage, sizeof(garbage)));
+
+    // only the page activated by load is read in full
+    f.emu.clearStats();
+    PageManager pm;
+    CHECK(pm.load(&f.part, 0, 3) == ESP_OK);
+    CHECK(f.emu.getReadOps() == 3 + SPI_FLASH_SEC_SIZE / 512);
+    CHECK(f.emu.getEraseOps() == 0);
+
+    CHECK(pm.requestNewPage() == ESP_OK);
+    CHECK(pm.back().state() == Page::PageState::UNINITIALIZED);
+    CHECK(f.emu.getEraseOps() == 1);
+    CHECK(f.emu.words()[garbageAddr / 4] == 0xffffffff);
+}
+
 TEST_CASE("PageManager adds page in the correct order", "[nvs]")
 {
     const size_t pageCount = 8;
@@ -1888,6 +1951,73 @@ TEST_CASE("nvs_flash_init checks for an empty page", "[nvs]")
     nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME);
 }
 
+// Fails the next failCount reads of sector failSector
+class FailingReadPartitionEmulation : public PartitionEmulation {
+public:
+    FailingReadPartitionEmulation(SpiFlashEmulator *spi_flash_emulator, uint32_t address, uint32_t size)
+        : PartitionEmulation(spi_flash_emulator, address, size) { }
+
+    esp_err_t read_raw(size_t src_offset, void* dst, size_t size) override
+    {
+        if (src_offset / SPI_FLASH_SEC_SIZE == failSector && failCount > 0) {
+            --failCount;
+            return ESP_ERR_FLASH_OP_FAIL;
+        }
+        return PartitionEmulation::read_raw(src_offset, dst, size);
+    }
+
+    uint32_t failSector = 0;
+    size_t failCount = 0;
+};
+
+TEST_CASE("check of an empty page is retried after a read failure and erases a page which isn't empty", "[nvs]")
+{
+    const uint32_t sectorCount = 4;
+    const size_t itemCount = Page::ENTRY_COUNT * 2;
+    SpiFlashEmulator emu(sectorCount);
+    FailingReadPartitionEmulation part(&emu, 0, sectorCount * SPI_FLASH_SEC_SIZE);
+    // data left in the second page, whose header is blank, as by an interrupted erase
+    const uint32_t garbage = 0x12345678;
+    REQUIRE(emu.write(SPI_FLASH_SEC_SIZE + 0x400, &garbage, sizeof(garbage)));
+
+    char key[16];
+    uint8_t ns;
+    {
+        Storage storage(&part);
+        TEST_ESP_OK(storage.init(0, sectorCount));
+        TEST_ESP_OK(storage.createOrOpenNamespace("test", true, ns));
+        // fill the first page, so that the second one is used next
+        part.failSector = 1;
+        part.failCount = 1;
+        size_t written = 0;
+        esp_err_t err;
+        do {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(written));
+            err = storage.writeItem(ns, key, static_cast<uint32_t>(written));
+            if (err == ESP_OK) {
+                ++written;
+            }
+        } while (err == ESP_OK && written < itemCount);
+        CHECK(err == ESP_ERR_FLASH_OP_FAIL);
+        CHECK(written < itemCount / 2);
+
+        // the next write checks the page again, and erases it before using it
+        for (; written < itemCount; ++written) {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(written));
+            TEST_ESP_OK(storage.writeItem(ns, key, static_cast<uint32_t>(written)));
+        }
+    }
+
+    Storage storage(&part);
+    TEST_ESP_OK(storage.init(0, sectorCount));
+    for (size_t i = 0; i < itemCount; ++i) {
+        uint32_t value;
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+        TEST_ESP_OK(storage.readItem(ns, key, value));
+        CHECK(value == i);
+    }
+}
+
 TEST_CASE("multiple partitions access check", "[nvs]")
 {
     SpiFlashEmulator emu(10);
@@ -2145,6 +2275,947 @@ TEST_CASE("Recovery from power-off when page is being freed.", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
 }
 
+TEST_CASE("transactional handle stages modifications until commit", "[nvs]")
+{
+    PartitionEmulationFixture f(0, 5);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 5));
+    nvs_handle_t handle, txn;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_i32(handle, "old", 1));
+    TEST_ESP_OK(nvs_set_i32(handle, "gone", 2));
+    TEST_ESP_OK(nvs_commit(handle));
+
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &txn));
+    TEST_ESP_OK(nvs_set_i32(txn, "old", 10));
+    TEST_ESP_OK(nvs_set_i32(txn, "new", 3));
+    TEST_ESP_OK(nvs_set_str(txn, "str", "staged"));
+    TEST_ESP_OK(nvs_erase_key(txn, "gone"));
+    TEST_ESP_ERR(nvs_erase_key(txn, "gone"), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_erase_key(txn, "missing"), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_set_i32(txn, "0123456789abcdef", 0), ESP_ERR_NVS_KEY_TOO_LONG);
+
+    // the handle reads its own modifications, other handles don't see them yet
+    int32_t value;
+    char str[16];
+    size_t len = sizeof(str);
+    TEST_ESP_OK(nvs_get_i32(txn, "old", &value));
+    CHECK(value == 10);
+    TEST_ESP_OK(nvs_get_str(txn, "str", str, &len));
+    CHECK(len == strlen("staged") + 1);
+    CHECK(strcmp(str, "staged") == 0);
+    TEST_ESP_ERR(nvs_get_i32(txn, "gone", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_get_i32(handle, "old", &value));
+    CHECK(value == 1);
+    TEST_ESP_ERR(nvs_get_i32(handle, "new", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_get_i32(handle, "gone", &value));
+
+    TEST_ESP_OK(nvs_commit(txn));
+    TEST_ESP_OK(nvs_get_i32(handle, "old", &value));
+    CHECK(value == 10);
+    TEST_ESP_OK(nvs_get_i32(handle, "new", &value));
+    CHECK(value == 3);
+    TEST_ESP_ERR(nvs_get_i32(handle, "gone", &value), ESP_ERR_NVS_NOT_FOUND);
+
+    // erasing the namespace drops earlier modifications, later ones are kept
+    TEST_ESP_OK(nvs_set_i32(txn, "dropped", 4));
+    TEST_ESP_OK(nvs_erase_all(txn));
+    TEST_ESP_OK(nvs_set_i32(txn, "kept", 5));
+    TEST_ESP_ERR(nvs_get_i32(txn, "old", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_commit(txn));
+    TEST_ESP_ERR(nvs_get_i32(handle, "old", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_get_i32(handle, "dropped", &value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_get_i32(handle, "kept", &value));
+    CHECK(value == 5);
+
+    // closing the handle discards uncommitted modifications
+    TEST_ESP_OK(nvs_set_i32(txn, "kept", 6));
+    nvs_close(txn);
+    TEST_ESP_OK(nvs_get_i32(handle, "kept", &value));
+    CHECK(value == 5);
+
+    // no journal is left behind, even after re-initialization
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 5));
+    nvs_iterator_t it = nullptr;
+    TEST_ESP_ERR(nvs_entry_find(NVS_DEFAULT_PART_NAME, "nvs.txn", NVS_TYPE_ANY, &it), ESP_ERR_NVS_NOT_FOUND);
+    nvs_release_iterator(it);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("transactional handle writes only the last value of each item", "[nvs]")
+{
+    const size_t keyCount = 20;
+    const size_t rounds = 10;
+    size_t directWrites, txnWrites;
+    char key[16];
+    {
+        PartitionEmulationFixture f(0, 5);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 5));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        f.emu.clearStats();
+        for (size_t i = 0; i < rounds; ++i) {
+            for (size_t k = 0; k < keyCount; ++k) {
+                snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+                TEST_ESP_OK(nvs_set_u32(handle, key, i));
+            }
+            TEST_ESP_OK(nvs_commit(handle));
+        }
+        directWrites = f.emu.getWriteOps();
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+    }
+    {
+        PartitionEmulationFixture f(0, 5);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 5));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &handle));
+        f.emu.clearStats();
+        for (size_t i = 0; i < rounds; ++i) {
+            for (size_t k = 0; k < keyCount; ++k) {
+                snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+                TEST_ESP_OK(nvs_set_u32(handle, key, i));
+            }
+        }
+        TEST_ESP_OK(nvs_commit(handle));
+        txnWrites = f.emu.getWriteOps();
+
+        // committing unchanged values writes nothing
+        f.emu.clearStats();
+        for (size_t k = 0; k < keyCount; ++k) {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+            TEST_ESP_OK(nvs_set_u32(handle, key, rounds - 1));
+        }
+        TEST_ESP_OK(nvs_commit(handle));
+        CHECK(f.emu.getWriteOps() == 0);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+    }
+    CHECK(txnWrites < directWrites);
+    s_perf << "Flash writes to update " << keyCount << " keys " << rounds << " times: " << directWrites
+           << " with commit after each round, " << txnWrites << " with one transaction" << std::endl;
+}
+
+TEST_CASE("transactional commit is atomic when power is lost", "[nvs][recovery]")
+{
+    const size_t keyCount = 12;
+    const size_t blobSize = Page::CHUNK_MAX_SIZE / 2;
+    uint8_t blob[blobSize];
+    char key[16];
+
+    auto checkValues = [&](nvs_handle_t handle, uint32_t expected) {
+        for (size_t k = 0; k < keyCount; ++k) {
+            uint32_t value;
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == expected);
+        }
+        size_t len = blobSize;
+        TEST_ESP_OK(nvs_get_blob(handle, "blob", blob, &len));
+        CHECK(len == blobSize);
+        CHECK(std::all_of(blob, blob + blobSize, [=](uint8_t b) { return b == static_cast<uint8_t>(expected); }));
+        uint8_t flag;
+        esp_err_t err = nvs_get_u8(handle, "flag", &flag);
+        CHECK(err == (expected == 1 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND));
+    };
+
+    size_t oldCount = 0, newCount = 0;
+    for (uint32_t errDelay = 0; ; ++errDelay) {
+        INFO(errDelay);
+        PartitionEmulationFixture f(0, 6);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 6));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        for (size_t k = 0; k < keyCount; ++k) {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+            TEST_ESP_OK(nvs_set_u32(handle, key, 1));
+        }
+        std::fill_n(blob, blobSize, 1);
+        TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blobSize));
+        TEST_ESP_OK(nvs_set_u8(handle, "flag", 1));
+        nvs_close(handle);
+
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &handle));
+        for (size_t k = 0; k < keyCount; ++k) {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+            TEST_ESP_OK(nvs_set_u32(handle, key, 2));
+        }
+        std::fill_n(blob, blobSize, 2);
+        TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blobSize));
+        TEST_ESP_OK(nvs_erase_key(handle, "flag"));
+
+        f.emu.clearStats();
+        f.emu.failAfter(errDelay);
+        esp_err_t err = nvs_commit(handle);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+
+        // reboot, the storage has to contain either all old or all new values
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 6));
+        TEST_ESP_OK(nvs_open("test", NVS_READONLY, &handle));
+        uint32_t value;
+        TEST_ESP_OK(nvs_get_u32(handle, "key0", &value));
+        if (err == ESP_OK) {
+            CHECK(value == 2);
+        }
+        if (value == 2) {
+            ++newCount;
+        } else {
+            ++oldCount;
+        }
+        checkValues(handle, value);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+
+        if (err == ESP_OK) {
+            break;
+        }
+    }
+    CHECK(oldCount > 0);
+    CHECK(newCount > 0);
+}
+
+TEST_CASE("journal which fails to be replayed at init is not applied later", "[nvs][recovery]")
+{
+    PartitionEmulationFixture f(0, 5);
+    uint8_t ns, txnNs;
+    uint32_t value;
+    size_t size;
+
+    // leaves the journal of a transaction writing 2 to "key" and otherSize bytes to "other", as a power loss would
+    auto writeJournal = [&](size_t otherSize) {
+        Storage storage(&f.part);
+        TEST_ESP_OK(storage.init(0, 5));
+        TEST_ESP_OK(storage.createOrOpenNamespace("test", true, ns));
+        TEST_ESP_OK(storage.writeItem(ns, "key", static_cast<uint32_t>(1)));
+        TEST_ESP_OK(storage.createOrOpenNamespace("nvs.txn", true, txnNs));
+        Transaction txn;
+        uint8_t other[16] = {2};
+        value = 2;
+        TEST_ESP_OK(txn.write(ns, ItemType::U32, "key", &value, sizeof(value)));
+        TEST_ESP_OK(txn.write(ns, ItemType::U32, "other", other, otherSize));
+        uint8_t journal[128];
+        REQUIRE(txn.journalSize() <= sizeof(journal));
+        txn.serialize(journal);
+        TEST_ESP_OK(storage.writeItem(txnNs, ItemType::BLOB, "journal", journal, txn.journalSize()));
+    };
+
+    // a flash failure while replaying the journal fails init, and the journal is replayed by the next init
+    writeJournal(sizeof(uint32_t));
+    {
+        Storage storage(&f.part);
+        f.emu.failAfter(0);
+        CHECK(storage.init(0, 5) == ESP_ERR_FLASH_OP_FAIL);
+        CHECK(!storage.isValid());
+    }
+    {
+        Storage storage(&f.part);
+        TEST_ESP_OK(storage.init(0, 5));
+        TEST_ESP_OK(storage.readItem(ns, "key", value));
+        CHECK(value == 2);
+        TEST_ESP_OK(storage.readItem(ns, "other", value));
+        CHECK(value == 2);
+        TEST_ESP_ERR(storage.getItemDataSize(txnNs, ItemType::BLOB, "journal", size), ESP_ERR_NVS_NOT_FOUND);
+    }
+
+    // a journal which is not valid, here because of a U32 of 16 bytes, is dropped, so that it doesn't overwrite
+    // later values
+    writeJournal(16);
+    {
+        Storage storage(&f.part);
+        TEST_ESP_OK(storage.init(0, 5));
+        TEST_ESP_ERR(storage.getItemDataSize(txnNs, ItemType::BLOB, "journal", size), ESP_ERR_NVS_NOT_FOUND);
+        TEST_ESP_OK(storage.writeItem(ns, "key", static_cast<uint32_t>(3)));
+
+        Transaction txn;
+        value = 4;
+        TEST_ESP_OK(txn.write(ns, ItemType::U32, "a", &value, sizeof(value)));
+        TEST_ESP_OK(txn.write(ns, ItemType::U32, "b", &value, sizeof(value)));
+        TEST_ESP_OK(storage.writeTransaction(txn));
+        TEST_ESP_OK(storage.readItem(ns, "key", value));
+        CHECK(value == 3);
+    }
+    {
+        Storage storage(&f.part);
+        TEST_ESP_OK(storage.init(0, 5));
+        TEST_ESP_OK(storage.readItem(ns, "key", value));
+        CHECK(value == 3);
+    }
+}
+
+TEST_CASE("transactional commit which doesn't fit is not applied at all", "[nvs]")
+{
+    const uint32_t sectorCount = 6;
+    const size_t blobSize = 3000;
+    uint8_t blob[blobSize] = {2};
+    char key[16];
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    for (int k = 0; k < 4; ++k) {
+        snprintf(key, sizeof(key), "key%d", k);
+        TEST_ESP_OK(nvs_set_u32(handle, key, 1));
+    }
+    // leave room for the journal, but not for the journal and the blob
+    nvs_stats_t stats;
+    size_t fillCount = 0;
+    while (true) {
+        TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats));
+        if (stats.free_entries <= Page::ENTRY_COUNT + 150) {
+            break;
+        }
+        snprintf(key, sizeof(key), "fill%d", static_cast<int>(fillCount++));
+        TEST_ESP_OK(nvs_set_u32(handle, key, 0));
+    }
+
+    auto commit = [&]() {
+        nvs_handle_t txnHandle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &txnHandle));
+        for (int k = 0; k < 4; ++k) {
+            snprintf(key, sizeof(key), "key%d", k);
+            TEST_ESP_OK(nvs_set_u32(txnHandle, key, 2));
+        }
+        TEST_ESP_OK(nvs_set_blob(txnHandle, "blob", blob, blobSize));
+        esp_err_t err = nvs_commit(txnHandle);
+        nvs_close(txnHandle);
+        return err;
+    };
+
+    // after a reboot, either all or none of the modifications are visible
+    auto checkValues = [&](uint32_t expected) {
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        for (int k = 0; k < 4; ++k) {
+            uint32_t value;
+            snprintf(key, sizeof(key), "key%d", k);
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == expected);
+        }
+        size_t size;
+        CHECK(nvs_get_blob(handle, "blob", nullptr, &size) == (expected == 2 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND));
+    };
+
+    TEST_ESP_ERR(commit(), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    checkValues(1);
+
+    for (size_t k = 0; k < fillCount; ++k) {
+        snprintf(key, sizeof(key), "fill%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_erase_key(handle, key));
+    }
+    TEST_ESP_OK(commit());
+    checkValues(2);
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_flash_gc_step reclaims pages ahead of writes", "[nvs]")
+{
+    const uint32_t sectorCount = 6;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    TEST_ESP_ERR(nvs_flash_gc_step_partition("nonexistent", 8), ESP_ERR_NVS_NOT_INITIALIZED);
+    TEST_ESP_ERR(nvs_flash_gc_step_partition(nullptr, 8), ESP_ERR_INVALID_ARG);
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    char key[16];
+    const size_t keyCount = 255;
+    // fill all but one page with items which are never changed, interleaved with
+    // items which are changed over and over, leaving erased entries on every page.
+    // The last write moves on to the last but one free page.
+    for (size_t k = 0; k < keyCount; ++k) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+        snprintf(key, sizeof(key), "hot%d", static_cast<int>(k % 10));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+    }
+
+    // steps are bounded: each moves at most the given number of items
+    size_t steps = 0;
+    esp_err_t err;
+    do {
+        f.emu.clearStats();
+        err = nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 4);
+        CHECK(f.emu.getEraseOps() <= 1);
+        CHECK(f.emu.getWriteOps() <= 4 * 3 + 2);
+        ++steps;
+    } while (err == ESP_ERR_NOT_FINISHED && steps < 1000);
+    TEST_ESP_OK(err);
+    CHECK(steps > 1);
+
+    // the reserve is complete, the next page switch doesn't have to erase a page
+    f.emu.clearStats();
+    for (size_t i = 0; i < Page::ENTRY_COUNT; ++i) {
+        snprintf(key, sizeof(key), "hot%d", static_cast<int>(i % 10));
+        TEST_ESP_OK(nvs_set_u32(handle, key, i));
+    }
+    CHECK(f.emu.getEraseOps() == 0);
+
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    for (size_t k = 0; k < keyCount; ++k) {
+        uint32_t value;
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+        CHECK(value == k);
+    }
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_flash_gc_step stops when the reserve can't be reached", "[nvs]")
+{
+    const uint32_t sectorCount = 6;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    char key[16];
+    char str[200];
+    // fill all but one page with strings which are never changed, and of spans which
+    // leave a few unused entries at the end of the pages they are moved to
+    size_t k = 0;
+    nvs_stats_t stats;
+    do {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        memset(str, 'a' + k % 26, sizeof(str));
+        str[32 * (k % 5) + 40] = 0;
+        TEST_ESP_OK(nvs_set_str(handle, key, str));
+        snprintf(key, sizeof(key), "hot%d", static_cast<int>(k % 3));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+        ++k;
+        TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    } while (stats.free_entries > Page::ENTRY_COUNT + 40);
+
+    // a pass over the used pages frees no page, so the collection stops after it
+    size_t steps = 0;
+    esp_err_t err;
+    f.emu.clearStats();
+    do {
+        err = nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 4);
+        ++steps;
+    } while (err == ESP_ERR_NOT_FINISHED && steps < 1000);
+    TEST_ESP_OK(err);
+    CHECK(f.emu.getEraseOps() < sectorCount);
+
+    // and doesn't start again until an item is written or erased
+    f.emu.clearStats();
+    TEST_ESP_OK(nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 4));
+    CHECK(f.emu.getEraseOps() == 0);
+    CHECK(f.emu.getWriteOps() == 0);
+
+    for (size_t i = 0; i < k / 2; ++i) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(i));
+        TEST_ESP_OK(nvs_erase_key(handle, key));
+    }
+    steps = 0;
+    do {
+        err = nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 4);
+        ++steps;
+    } while (err == ESP_ERR_NOT_FINISHED && steps < 1000);
+    TEST_ESP_OK(err);
+    TEST_ESP_OK(nvs_get_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.free_entries >= CONFIG_NVS_GC_RESERVE_PAGES * Page::ENTRY_COUNT);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_flash_gc_step recovers from power-off", "[nvs][recovery]")
+{
+    const uint32_t sectorCount = 5;
+    const size_t keyCount = 30;
+    const size_t blobSize = Page::CHUNK_MAX_SIZE / 3;
+    uint8_t blob[blobSize];
+    char key[16];
+
+    for (uint32_t errDelay = 0; ; ++errDelay) {
+        INFO(errDelay);
+        PartitionEmulationFixture f(0, sectorCount);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        for (uint32_t round = 0; round < 6; ++round) {
+            for (size_t k = 0; k < keyCount; ++k) {
+                snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+                TEST_ESP_OK(nvs_set_u32(handle, key, round * 100 + k));
+            }
+            std::fill_n(blob, blobSize, round);
+            TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, blobSize));
+        }
+
+        f.emu.clearStats();
+        f.emu.failAfter(errDelay);
+        esp_err_t err;
+        do {
+            err = nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 3);
+        } while (err == ESP_ERR_NOT_FINISHED);
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+        TEST_ESP_OK(nvs_open("test", NVS_READONLY, &handle));
+        for (size_t k = 0; k < keyCount; ++k) {
+            uint32_t value;
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+            TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+            CHECK(value == 500 + k);
+        }
+        size_t len = blobSize;
+        TEST_ESP_OK(nvs_get_blob(handle, "blob", blob, &len));
+        CHECK(std::all_of(blob, blob + blobSize, [](uint8_t b) { return b == 5; }));
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+
+        if (err == ESP_OK) {
+            break;
+        }
+    }
+}
+
+TEST_CASE("benchmark worst-case write latency with incremental garbage collection", "[nvs]")
+{
+    const uint32_t sectorCount = 8;
+    const size_t keyCount = 60;
+    const size_t writeCount = 3000;
+    char key[16];
+
+    for (int useGc = 0; useGc < 2; ++useGc) {
+        PartitionEmulationFixture f(0, sectorCount);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<size_t> keyDist(0, keyCount - 1);
+        size_t maxWriteTime = 0;
+        size_t writeTime = 0;
+        size_t erasingWrites = 0;
+        size_t gcTime = 0;
+        for (size_t i = 0; i < writeCount; ++i) {
+            snprintf(key, sizeof(key), "key%d", static_cast<int>(keyDist(gen)));
+            size_t start = f.emu.getTotalTime();
+            size_t eraseOps = f.emu.getEraseOps();
+            TEST_ESP_OK(nvs_set_u32(handle, key, i));
+            size_t elapsed = f.emu.getTotalTime() - start;
+            if (f.emu.getEraseOps() != eraseOps) {
+                ++erasingWrites;
+            }
+            writeTime += elapsed;
+            maxWriteTime = std::max(maxWriteTime, elapsed);
+
+            if (useGc) {
+                // one step per write, as a low priority task would do while the application is idle
+                start = f.emu.getTotalTime();
+                esp_err_t err = nvs_flash_gc_step_partition(NVS_DEFAULT_PART_NAME, 4);
+                CHECK((err == ESP_OK || err == ESP_ERR_NOT_FINISHED));
+                gcTime += f.emu.getTotalTime() - start;
+            }
+        }
+        if (useGc) {
+            CHECK(erasingWrites == 0);
+        } else {
+            CHECK(erasingWrites > 0);
+        }
+
+        s_perf << "Write latency " << (useGc ? "with" : "without") << " incremental garbage collection: max "
+               << maxWriteTime << " us, average " << writeTime / writeCount << " us, "
+               << erasingWrites << " of " << writeCount << " writes erased a page";
+        if (useGc) {
+            s_perf << ", garbage collection " << gcTime / writeCount << " us per write";
+        }
+        s_perf << std::endl;
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+    }
+}
+
+TEST_CASE("read cache serves repeated reads without accessing flash", "[nvs]")
+{
+    const uint32_t sectorCount = 4;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_cache_stats_t stats;
+    TEST_ESP_ERR(nvs_get_cache_stats(nullptr, nullptr), ESP_ERR_INVALID_ARG);
+    TEST_ESP_ERR(nvs_get_cache_stats("nonexistent", &stats), ESP_ERR_NVS_NOT_INITIALIZED);
+    TEST_ESP_OK(nvs_get_cache_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.total_bytes == CONFIG_NVS_READ_CACHE_SIZE);
+    CHECK(stats.hits == 0);
+    CHECK(stats.entry_count == 0);
+
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_u32(handle, "u32", 42));
+    TEST_ESP_OK(nvs_set_str(handle, "str", "cached"));
+    const uint8_t blob[] = {1, 2, 3, 4, 5};
+    TEST_ESP_OK(nvs_set_blob(handle, "blob", blob, sizeof(blob)));
+
+    uint32_t value;
+    char str[16];
+    uint8_t blobOut[sizeof(blob)];
+    size_t size;
+    TEST_ESP_OK(nvs_get_u32(handle, "u32", &value));
+    size = sizeof(str);
+    TEST_ESP_OK(nvs_get_str(handle, "str", str, &size));
+    size = sizeof(blobOut);
+    TEST_ESP_OK(nvs_get_blob(handle, "blob", blobOut, &size));
+
+    f.emu.clearStats();
+    for (int i = 0; i < 10; ++i) {
+        value = 0;
+        TEST_ESP_OK(nvs_get_u32(handle, "u32", &value));
+        CHECK(value == 42);
+        size = sizeof(str);
+        TEST_ESP_OK(nvs_get_str(handle, "str", str, &size));
+        CHECK(size == strlen("cached") + 1);
+        CHECK(strcmp(str, "cached") == 0);
+        size = 0;
+        TEST_ESP_OK(nvs_get_str(handle, "str", nullptr, &size));
+        CHECK(size == strlen("cached") + 1);
+        size = sizeof(blobOut);
+        TEST_ESP_OK(nvs_get_blob(handle, "blob", blobOut, &size));
+        CHECK(memcmp(blobOut, blob, sizeof(blob)) == 0);
+    }
+    CHECK(f.emu.getReadOps() == 0);
+
+    // size checks are the same as for values read from flash, a different type is a miss
+    uint16_t u16;
+    TEST_ESP_ERR(nvs_get_u16(handle, "u32", &u16), ESP_ERR_NVS_NOT_FOUND);
+    size = 3;
+    TEST_ESP_ERR(nvs_get_str(handle, "str", str, &size), ESP_ERR_NVS_INVALID_LENGTH);
+
+    TEST_ESP_OK(nvs_get_cache_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.hits == 30);
+    CHECK(stats.misses == 4);
+    CHECK(stats.entry_count == 3);
+    CHECK(stats.used_bytes > strlen("cached") + 1 + sizeof(blob) + sizeof(uint32_t));
+    CHECK(stats.used_bytes <= stats.total_bytes);
+
+    // writes and erasures replace the cached values
+    TEST_ESP_OK(nvs_set_u32(handle, "u32", 43));
+    TEST_ESP_OK(nvs_get_u32(handle, "u32", &value));
+    CHECK(value == 43);
+    TEST_ESP_OK(nvs_set_str(handle, "str", "longer string"));
+    size = sizeof(str);
+    TEST_ESP_OK(nvs_get_str(handle, "str", str, &size));
+    CHECK(strcmp(str, "longer string") == 0);
+    TEST_ESP_OK(nvs_erase_key(handle, "blob"));
+    size = sizeof(blobOut);
+    TEST_ESP_ERR(nvs_get_blob(handle, "blob", blobOut, &size), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(nvs_erase_all(handle));
+    TEST_ESP_ERR(nvs_get_u32(handle, "u32", &value), ESP_ERR_NVS_NOT_FOUND);
+    size = sizeof(str);
+    TEST_ESP_ERR(nvs_get_str(handle, "str", str, &size), ESP_ERR_NVS_NOT_FOUND);
+
+    // values which are too large are not cached
+    char large[CONFIG_NVS_READ_CACHE_MAX_VALUE_SIZE + 2];
+    std::fill_n(large, sizeof(large) - 1, 'a');
+    large[sizeof(large) - 1] = 0;
+    TEST_ESP_OK(nvs_set_str(handle, "large", large));
+    TEST_ESP_OK(nvs_get_cache_stats(NVS_DEFAULT_PART_NAME, &stats));
+    const uint32_t misses = stats.misses;
+    for (int i = 0; i < 2; ++i) {
+        char largeOut[sizeof(large)];
+        size = sizeof(largeOut);
+        TEST_ESP_OK(nvs_get_str(handle, "large", largeOut, &size));
+        CHECK(strcmp(largeOut, large) == 0);
+    }
+    TEST_ESP_OK(nvs_get_cache_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.misses == misses + 2);
+    CHECK(stats.entry_count == 0);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("read cache evicts least recently used values", "[nvs]")
+{
+    const uint32_t sectorCount = 4;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+    const size_t keyCount = 200;
+    char key[16];
+    for (size_t k = 0; k < keyCount; ++k) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+    }
+    // keep reading one hot key while all other keys are read once
+    for (size_t k = 0; k < keyCount; ++k) {
+        uint32_t value;
+        TEST_ESP_OK(nvs_get_u32(handle, "key0", &value));
+        CHECK(value == 0);
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+        CHECK(value == k);
+    }
+
+    nvs_cache_stats_t stats;
+    TEST_ESP_OK(nvs_get_cache_stats(NVS_DEFAULT_PART_NAME, &stats));
+    CHECK(stats.evictions > 0);
+    CHECK(stats.entry_count < keyCount);
+    CHECK(stats.used_bytes <= stats.total_bytes);
+    CHECK(stats.misses == keyCount);
+
+    f.emu.clearStats();
+    uint32_t value;
+    TEST_ESP_OK(nvs_get_u32(handle, "key0", &value));
+    CHECK(f.emu.getReadOps() == 0);
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("benchmark reads of frequently polled keys with the read cache", "[nvs]")
+{
+    const uint32_t sectorCount = 8;
+    const size_t keyCount = 100;
+    const size_t hotKeyCount = 10;
+    const size_t readCount = 1000;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    char key[16];
+    for (size_t k = 0; k < keyCount; ++k) {
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+    }
+
+    // the first pass fills the cache, the following ones are served from RAM
+    size_t firstPassReads = 0;
+    size_t firstPassTime = 0;
+    f.emu.clearStats();
+    for (size_t i = 0; i < readCount; ++i) {
+        if (i == hotKeyCount) {
+            firstPassReads = f.emu.getReadOps();
+            firstPassTime = f.emu.getTotalTime();
+            f.emu.clearStats();
+        }
+        uint32_t value;
+        snprintf(key, sizeof(key), "key%d", static_cast<int>(i % hotKeyCount));
+        TEST_ESP_OK(nvs_get_u32(handle, key, &value));
+        CHECK(value == i % hotKeyCount);
+    }
+    CHECK(firstPassReads > 0);
+    CHECK(f.emu.getReadOps() == 0);
+
+    s_perf << "Reads of " << hotKeyCount << " hot keys: " << firstPassReads / hotKeyCount
+           << " flash reads (" << firstPassTime / hotKeyCount << " us) per uncached get, "
+           << f.emu.getReadOps() << " flash reads (" << f.emu.getTotalTime() << " us) for "
+           << readCount - hotKeyCount << " cached gets" << std::endl;
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_get_many and nvs_set_many read and write several values", "[nvs]")
+{
+    const uint32_t sectorCount = 4;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+    uint8_t u8 = 0xab;
+    int32_t i32 = -1000000;
+    uint64_t u64 = 0x0123456789abcdefULL;
+    char str[] = "hello many";
+    uint8_t blob[100];
+    for (size_t i = 0; i < sizeof(blob); ++i) {
+        blob[i] = i;
+    }
+    nvs_item_desc_t setItems[] = {
+        { "u8", NVS_TYPE_U8, &u8, 0, ESP_FAIL },
+        { "i32", NVS_TYPE_I32, &i32, 0, ESP_FAIL },
+        { "u64", NVS_TYPE_U64, &u64, 0, ESP_FAIL },
+        { "str", NVS_TYPE_STR, str, 0, ESP_FAIL },
+        { "blob", NVS_TYPE_BLOB, blob, sizeof(blob), ESP_FAIL },
+        { "any", NVS_TYPE_ANY, &u8, 0, ESP_FAIL },
+    };
+    TEST_ESP_ERR(nvs_set_many(handle, nullptr, 1), ESP_ERR_INVALID_ARG);
+    TEST_ESP_OK(nvs_set_many(handle, setItems, 0));
+    TEST_ESP_ERR(nvs_set_many(handle, setItems, 6), ESP_ERR_INVALID_ARG);
+    for (size_t i = 0; i < 5; ++i) {
+        TEST_ESP_OK(setItems[i].err);
+    }
+    TEST_ESP_ERR(setItems[5].err, ESP_ERR_INVALID_ARG);
+
+    uint8_t readU8 = 0;
+    int32_t readI32 = 0;
+    uint64_t readU64 = 0;
+    uint16_t readU16 = 0;
+    char readStr[32];
+    uint8_t readBlob[sizeof(blob)];
+    char shortStr[4];
+    nvs_item_desc_t getItems[] = {
+        { "u8", NVS_TYPE_U8, &readU8, 0, ESP_FAIL },
+        { "i32", NVS_TYPE_I32, &readI32, 0, ESP_FAIL },
+        { "u64", NVS_TYPE_U64, &readU64, 0, ESP_FAIL },
+        { "str", NVS_TYPE_STR, readStr, sizeof(readStr), ESP_FAIL },
+        { "blob", NVS_TYPE_BLOB, readBlob, sizeof(readBlob), ESP_FAIL },
+        { "str", NVS_TYPE_STR, nullptr, 0, ESP_FAIL },
+        { "blob", NVS_TYPE_BLOB, nullptr, 0, ESP_FAIL },
+        { "missing", NVS_TYPE_U16, &readU16, 0, ESP_FAIL },
+        { "u8", NVS_TYPE_U16, &readU16, 0, ESP_FAIL },
+        { "str", NVS_TYPE_STR, shortStr, sizeof(shortStr), ESP_FAIL },
+        { "u8", NVS_TYPE_U8, nullptr, 0, ESP_FAIL },
+    };
+    const size_t getCount = sizeof(getItems) / sizeof(getItems[0]);
+    TEST_ESP_ERR(nvs_get_many(handle, nullptr, 1), ESP_ERR_INVALID_ARG);
+    TEST_ESP_ERR(nvs_get_many(handle, getItems, getCount), ESP_ERR_NVS_NOT_FOUND);
+    for (size_t i = 0; i < 7; ++i) {
+        TEST_ESP_OK(getItems[i].err);
+    }
+    CHECK(readU8 == u8);
+    CHECK(readI32 == i32);
+    CHECK(readU64 == u64);
+    CHECK(strcmp(readStr, str) == 0);
+    CHECK(getItems[3].length == sizeof(str));
+    CHECK(memcmp(readBlob, blob, sizeof(blob)) == 0);
+    CHECK(getItems[4].length == sizeof(blob));
+    CHECK(getItems[5].length == sizeof(str));
+    CHECK(getItems[6].length == sizeof(blob));
+    TEST_ESP_ERR(getItems[7].err, ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(getItems[8].err, ESP_ERR_NVS_NOT_FOUND);
+    CHECK(readU16 == 0);
+    TEST_ESP_ERR(getItems[9].err, ESP_ERR_NVS_INVALID_LENGTH);
+    CHECK(getItems[9].length == sizeof(str));
+    TEST_ESP_ERR(getItems[10].err, ESP_ERR_INVALID_ARG);
+
+    // the same results are returned when the values are cached
+    readU8 = 0;
+    getItems[9].length = sizeof(shortStr);
+    TEST_ESP_ERR(nvs_get_many(handle, getItems, getCount), ESP_ERR_NVS_NOT_FOUND);
+    CHECK(readU8 == u8);
+    TEST_ESP_OK(getItems[3].err);
+    CHECK(getItems[3].length == sizeof(str));
+    TEST_ESP_ERR(getItems[9].err, ESP_ERR_NVS_INVALID_LENGTH);
+
+    // a read-only handle can read but not write
+    nvs_handle_t readOnlyHandle;
+    TEST_ESP_OK(nvs_open("test", NVS_READONLY, &readOnlyHandle));
+    TEST_ESP_ERR(nvs_set_many(readOnlyHandle, setItems, 1), ESP_ERR_NVS_READ_ONLY);
+    TEST_ESP_OK(nvs_get_many(readOnlyHandle, getItems, 5));
+    nvs_close(readOnlyHandle);
+
+    // a transactional handle reads its staged values
+    nvs_handle_t txnHandle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &txnHandle));
+    char stagedStr[] = "staged";
+    nvs_item_desc_t stageItems[] = {
+        { "str", NVS_TYPE_STR, stagedStr, 0, ESP_FAIL },
+    };
+    TEST_ESP_OK(nvs_set_many(txnHandle, stageItems, 1));
+    TEST_ESP_OK(nvs_erase_key(txnHandle, "u8"));
+    TEST_ESP_ERR(nvs_get_many(txnHandle, getItems, 4), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(getItems[0].err, ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(getItems[3].err);
+    CHECK(strcmp(readStr, stagedStr) == 0);
+    CHECK(getItems[3].length == sizeof(stagedStr));
+    getItems[3].length = sizeof(readStr);
+    TEST_ESP_OK(nvs_get_many(handle, getItems, 4));
+    CHECK(strcmp(readStr, str) == 0);
+    nvs_close(txnHandle);
+
+    nvs_close(handle);
+    TEST_ESP_ERR(nvs_get_many(handle, getItems, 1), ESP_ERR_NVS_INVALID_HANDLE);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("benchmark loading many settings with nvs_get_many", "[nvs]")
+{
+    const uint32_t sectorCount = 8;
+    const size_t settingCount = 50;
+    const size_t otherCount = 300;
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("other", NVS_READWRITE, &handle));
+    char key[16];
+    for (size_t k = 0; k < otherCount; ++k) {
+        snprintf(key, sizeof(key), "other%d", static_cast<int>(k));
+        TEST_ESP_OK(nvs_set_u32(handle, key, k));
+    }
+    nvs_close(handle);
+
+    // half of the settings are integers, the other half strings
+    static char keys[settingCount][16];
+    static char strings[settingCount][32];
+    uint32_t values[settingCount];
+    nvs_item_desc_t items[settingCount];
+    TEST_ESP_OK(nvs_open("config", NVS_READWRITE, &handle));
+    for (size_t k = 0; k < settingCount; ++k) {
+        snprintf(keys[k], sizeof(keys[k]), "setting%d", static_cast<int>(k));
+        if (k % 2) {
+            snprintf(strings[k], sizeof(strings[k]), "value of setting %d", static_cast<int>(k));
+            items[k] = { keys[k], NVS_TYPE_STR, strings[k], 0, ESP_FAIL };
+        } else {
+            values[k] = k;
+            items[k] = { keys[k], NVS_TYPE_U32, &values[k], 0, ESP_FAIL };
+        }
+    }
+    TEST_ESP_OK(nvs_set_many(handle, items, settingCount));
+    nvs_close(handle);
+
+    size_t time[2];
+    size_t reads[2];
+    for (int useMany = 0; useMany < 2; ++useMany) {
+        // start with an empty read cache, as after boot
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+        TEST_ESP_OK(nvs_open("config", NVS_READWRITE, &handle));
+        char readStrings[settingCount][32];
+        uint32_t readValues[settingCount];
+        f.emu.clearStats();
+        if (useMany) {
+            for (size_t k = 0; k < settingCount; ++k) {
+                if (k % 2) {
+                    items[k] = { keys[k], NVS_TYPE_STR, readStrings[k], sizeof(readStrings[k]), ESP_FAIL };
+                } else {
+                    items[k] = { keys[k], NVS_TYPE_U32, &readValues[k], 0, ESP_FAIL };
+                }
+            }
+            TEST_ESP_OK(nvs_get_many(handle, items, settingCount));
+        } else {
+            for (size_t k = 0; k < settingCount; ++k) {
+                if (k % 2) {
+                    size_t length = sizeof(readStrings[k]);
+                    TEST_ESP_OK(nvs_get_str(handle, keys[k], readStrings[k], &length));
+                } else {
+                    TEST_ESP_OK(nvs_get_u32(handle, keys[k], &readValues[k]));
+                }
+            }
+        }
+        time[useMany] = f.emu.getTotalTime();
+        reads[useMany] = f.emu.getReadOps();
+        for (size_t k = 0; k < settingCount; ++k) {
+            if (k % 2) {
+                CHECK(strcmp(readStrings[k], strings[k]) == 0);
+            } else {
+                CHECK(readValues[k] == k);
+            }
+        }
+        nvs_close(handle);
+    }
+    CHECK(reads[1] < reads[0]);
+
+    s_perf << "Loading " << settingCount << " settings: " << time[0] << " us (" << reads[0]
+           << " flash reads) with nvs_get_*, " << time[1] << " us (" << reads[1]
+           << " flash reads) with nvs_get_many" << std::endl;
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
 TEST_CASE("Multi-page blobs are supported", "[nvs]")
 {
     const size_t blob_size = Page::CHUNK_MAX_SIZE *2;
@@ -2197,6 +3268,398 @@ TEST_CASE("Reading multi-page blobs", "[nvs]")
     TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
 }
 
+struct BlobChunkCollector {
+    uint8_t* data;
+    size_t size;
+    size_t chunkCount;
+    const uint8_t* flashBegin;
+    const uint8_t* flashEnd;
+    size_t mappedChunks;
+    esp_err_t stopAtChunk;
+
+    static esp_err_t collect(const void* chunk, size_t length, size_t offset, void* arg)
+    {
+        BlobChunkCollector* self = static_cast<BlobChunkCollector*>(arg);
+        CHECK(offset == self->size);
+        const uint8_t* p = static_cast<const uint8_t*>(chunk);
+        if (p >= self->flashBegin && p + length <= self->flashEnd) {
+            ++self->mappedChunks;
+        }
+        if (self->chunkCount++ == static_cast<size_t>(self->stopAtChunk)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        memcpy(self->data + offset, chunk, length);
+        self->size += length;
+        return ESP_OK;
+    }
+};
+
+class UnmappablePartitionEmulation : public PartitionEmulation {
+public:
+    UnmappablePartitionEmulation(SpiFlashEmulator *spi_flash_emulator, uint32_t address, uint32_t size, esp_err_t mmapErr)
+        : PartitionEmulation(spi_flash_emulator, address, size), mMmapErr(mmapErr) { }
+
+    esp_err_t mmap(size_t src_offset, size_t size, const void** ptr, uint32_t* handle) override
+    {
+        return mMmapErr;
+    }
+
+private:
+    esp_err_t mMmapErr;
+};
+
+TEST_CASE("nvs_get_blob_chunks reads multi-page blobs in place", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 3 + 100;
+    static uint8_t blob[blob_size];
+    static uint8_t blob_read[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 7);
+    }
+    PartitionEmulationFixture f(0, 6);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 6));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "big", blob, blob_size));
+    TEST_ESP_OK(nvs_set_blob(handle, "small", blob, 10));
+
+    BlobChunkCollector c = { blob_read, 0, 0, f.emu.bytes(), f.emu.bytes() + f.emu.size(), 0, -1 };
+    TEST_ESP_OK(nvs_get_blob_chunks(handle, "big", BlobChunkCollector::collect, &c));
+    CHECK(c.size == blob_size);
+    CHECK(c.chunkCount == 4);
+    CHECK(c.mappedChunks == c.chunkCount);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+
+    c = { blob_read, 0, 0, f.emu.bytes(), f.emu.bytes() + f.emu.size(), 0, -1 };
+    TEST_ESP_OK(nvs_get_blob_chunks(handle, "small", BlobChunkCollector::collect, &c));
+    CHECK(c.size == 10);
+    CHECK(c.chunkCount == 1);
+    CHECK(memcmp(blob, blob_read, 10) == 0);
+
+    // the error returned by the callback stops the read and is passed on
+    c = { blob_read, 0, 0, f.emu.bytes(), f.emu.bytes() + f.emu.size(), 0, 1 };
+    TEST_ESP_ERR(nvs_get_blob_chunks(handle, "big", BlobChunkCollector::collect, &c), ESP_ERR_INVALID_RESPONSE);
+    CHECK(c.chunkCount == 2);
+    CHECK(c.size > 0);
+    CHECK(c.size < blob_size);
+    CHECK(memcmp(blob, blob_read, c.size) == 0);
+
+    TEST_ESP_ERR(nvs_get_blob_chunks(handle, "missing", BlobChunkCollector::collect, &c), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(nvs_get_blob_chunks(handle, "big", nullptr, &c), ESP_ERR_INVALID_ARG);
+    nvs_close(handle);
+
+    // staged values of a transaction are passed as a single chunk
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "small", blob + 5, 20));
+    TEST_ESP_OK(nvs_erase_key(handle, "big"));
+    c = { blob_read, 0, 0, f.emu.bytes(), f.emu.bytes() + f.emu.size(), 0, -1 };
+    TEST_ESP_OK(nvs_get_blob_chunks(handle, "small", BlobChunkCollector::collect, &c));
+    CHECK(c.size == 20);
+    CHECK(memcmp(blob + 5, blob_read, 20) == 0);
+    TEST_ESP_ERR(nvs_get_blob_chunks(handle, "big", BlobChunkCollector::collect, &c), ESP_ERR_NVS_NOT_FOUND);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_get_blob_chunks reads through a chunk buffer if the partition can't be mapped", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 2 + 1;
+    static uint8_t blob[blob_size];
+    static uint8_t blob_read[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 13);
+    }
+    // the partition may not support mapping at all, or the MMU pages may be used up
+    for (esp_err_t mmapErr : { ESP_ERR_NOT_SUPPORTED, ESP_ERR_NO_MEM }) {
+        INFO(mmapErr);
+        SpiFlashEmulator emu(5);
+        UnmappablePartitionEmulation part(&emu, 0, 5 * SPI_FLASH_SEC_SIZE, mmapErr);
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&part, 0, 5));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+        TEST_ESP_OK(nvs_set_blob(handle, "big", blob, blob_size));
+
+        memset(blob_read, 0, blob_size);
+        BlobChunkCollector c = { blob_read, 0, 0, emu.bytes(), emu.bytes() + emu.size(), 0, -1 };
+        TEST_ESP_OK(nvs_get_blob_chunks(handle, "big", BlobChunkCollector::collect, &c));
+        CHECK(c.size == blob_size);
+        CHECK(c.chunkCount == 3);
+        CHECK(c.mappedChunks == 0);
+        CHECK(memcmp(blob, blob_read, blob_size) == 0);
+        nvs_close(handle);
+
+        TEST_ESP_OK(nvs_flash_deinit_partition(part.get_partition_name()));
+    }
+}
+
+TEST_CASE("nvs_blob_writer stores a blob appended in pieces", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 3 + 100;
+    static uint8_t blob[blob_size];
+    static uint8_t blob_read[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 11);
+    }
+    PartitionEmulationFixture f(0, 8);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 8));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+    // small pieces which end up in the chunk buffer, followed by a piece larger than a chunk
+    nvs_blob_writer_t writer;
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    size_t offset = 0;
+    for (size_t piece = 1; offset + piece < Page::CHUNK_MAX_SIZE; offset += piece, piece = piece * 2 + 1) {
+        TEST_ESP_OK(nvs_blob_writer_append(writer, blob + offset, piece));
+    }
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob + offset, blob_size - offset));
+    TEST_ESP_OK(nvs_blob_writer_finish(writer));
+
+    size_t size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+
+    // overwriting the blob erases the chunks of the previous value, so writing it twice uses no more entries
+    nvs_stats_t stats_before;
+    nvs_stats_t stats_after;
+    for (int i = 0; i < 2; ++i) {
+        TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+        TEST_ESP_OK(nvs_blob_writer_append(writer, blob + 1, blob_size - 1));
+        TEST_ESP_OK(nvs_blob_writer_append(writer, blob, 1));
+        TEST_ESP_OK(nvs_blob_writer_finish(writer));
+        size = blob_size;
+        TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+        CHECK(size == blob_size);
+        CHECK(memcmp(blob + 1, blob_read, blob_size - 1) == 0);
+        CHECK(blob_read[blob_size - 1] == blob[0]);
+        TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), i == 0 ? &stats_before : &stats_after));
+    }
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+
+    // an aborted write keeps the previous value
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob, blob_size));
+    TEST_ESP_OK(nvs_blob_writer_abort(writer));
+    size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size);
+    CHECK(memcmp(blob + 1, blob_read, blob_size - 1) == 0);
+    TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats_after));
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+
+    // a legacy or single page blob is replaced as well
+    TEST_ESP_OK(nvs_set_blob(handle, "small", blob, 10));
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "small", &writer));
+    TEST_ESP_OK(nvs_blob_writer_finish(writer));
+    size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "small", blob_read, &size));
+    CHECK(size == 0);
+
+    TEST_ESP_ERR(nvs_blob_writer_open(handle, "a_key_which_is_too_long", &writer), ESP_ERR_NVS_KEY_TOO_LONG);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_open("test", NVS_READONLY, &handle));
+    TEST_ESP_ERR(nvs_blob_writer_open(handle, "big", &writer), ESP_ERR_NVS_READ_ONLY);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE_TRANSACTIONAL, &handle));
+    TEST_ESP_ERR(nvs_blob_writer_open(handle, "big", &writer), ESP_ERR_NOT_SUPPORTED);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_blob_writer rejects blobs which don't fit", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 3;
+    static uint8_t blob[blob_size];
+    PartitionEmulationFixture f(0, 3);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 3));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+
+    // a blob can't be larger than the pages but the one reserved for garbage collection
+    nvs_blob_writer_t writer;
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_ERR(nvs_blob_writer_append(writer, blob, blob_size), ESP_ERR_NVS_VALUE_TOO_LONG);
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob, 100));
+    TEST_ESP_OK(nvs_blob_writer_finish(writer));
+
+    size_t size = 0;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", nullptr, &size));
+    CHECK(size == 100);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_blob_writer keeps the previous value if the write is interrupted", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 2 + 10;
+    static uint8_t blob[blob_size];
+    static uint8_t blob_read[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 3);
+    }
+    PartitionEmulationFixture f(0, 8);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 8));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "big", blob, blob_size));
+    nvs_stats_t stats_before;
+    TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats_before));
+
+    nvs_blob_writer_t writer;
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob + 2, blob_size - 2));
+
+    // simulate a power loss: the partition goes away while the writer still holds unpublished chunks
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+    TEST_ESP_ERR(nvs_blob_writer_abort(writer), ESP_ERR_NVS_INVALID_HANDLE);
+
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 8));
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    size_t size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+
+    // the orphaned chunks have been erased during initialization
+    nvs_stats_t stats_after;
+    TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats_after));
+    CHECK(stats_after.used_entries == stats_before.used_entries);
+
+    // and the next write can reuse their version
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob + 2, blob_size - 2));
+    TEST_ESP_OK(nvs_blob_writer_finish(writer));
+    size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size - 2);
+    CHECK(memcmp(blob + 2, blob_read, blob_size - 2) == 0);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("nvs_blob_writer is cancelled when its key is written by other means", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 2 + 10;
+    static uint8_t blob[blob_size];
+    static uint8_t blob_read[blob_size];
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i * 5);
+    }
+    PartitionEmulationFixture f(0, 10);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 10));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "big", blob, blob_size));
+    size_t size;
+
+    // no chunks are left behind if init() doesn't find any orphaned chunks to erase
+    auto checkNoOrphans = [&]() {
+        nvs_stats_t stats_before, stats_after;
+        TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats_before));
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+        TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, 10));
+        TEST_ESP_OK(nvs_get_stats(f.part.get_partition_name(), &stats_after));
+        CHECK(stats_after.used_entries == stats_before.used_entries);
+        TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    };
+
+    // a blob set while the writer is open replaces the chunks of the writer, which can't publish them anymore
+    nvs_blob_writer_t writer;
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob + 1, blob_size - 1));
+    TEST_ESP_OK(nvs_set_blob(handle, "big", blob + 2, blob_size - 2));
+    TEST_ESP_ERR(nvs_blob_writer_append(writer, blob, 1), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_blob_writer_finish(writer), ESP_ERR_NVS_INVALID_STATE);
+    size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size - 2);
+    CHECK(memcmp(blob + 2, blob_read, blob_size - 2) == 0);
+    checkNoOrphans();
+
+    // so does a second writer of the same key
+    nvs_blob_writer_t writer2;
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob + 3, blob_size - 3));
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer2));
+    TEST_ESP_OK(nvs_blob_writer_append(writer2, blob, blob_size));
+    TEST_ESP_OK(nvs_blob_writer_finish(writer2));
+    TEST_ESP_ERR(nvs_blob_writer_abort(writer), ESP_OK);
+    size = blob_size;
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read, &size));
+    CHECK(size == blob_size);
+    CHECK(memcmp(blob, blob_read, blob_size) == 0);
+    checkNoOrphans();
+
+    // the chunks of a writer are erased even if its handle has been closed
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob, blob_size));
+    nvs_close(handle);
+    TEST_ESP_ERR(nvs_blob_writer_finish(writer), ESP_ERR_NVS_INVALID_HANDLE);
+    checkNoOrphans();
+
+    // erasing the namespace cancels the writer as well
+    TEST_ESP_OK(nvs_blob_writer_open(handle, "big", &writer));
+    TEST_ESP_OK(nvs_blob_writer_append(writer, blob, blob_size));
+    TEST_ESP_OK(nvs_erase_all(handle));
+    TEST_ESP_ERR(nvs_blob_writer_finish(writer), ESP_ERR_NVS_INVALID_STATE);
+    TEST_ESP_ERR(nvs_get_blob(handle, "big", nullptr, &size), ESP_ERR_NVS_NOT_FOUND);
+    nvs_close(handle);
+
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
+TEST_CASE("benchmark reading a large blob with nvs_get_blob_chunks", "[nvs]")
+{
+    const size_t blob_size = Page::CHUNK_MAX_SIZE * 10;
+    const uint32_t sectorCount = 16;
+    std::unique_ptr<uint8_t[]> blob(new uint8_t[blob_size]);
+    for (size_t i = 0; i < blob_size; ++i) {
+        blob[i] = static_cast<uint8_t>(i);
+    }
+    PartitionEmulationFixture f(0, sectorCount);
+    TEST_ESP_OK(NVSPartitionManager::get_instance()->init_custom(&f.part, 0, sectorCount));
+    nvs_handle_t handle;
+    TEST_ESP_OK(nvs_open("test", NVS_READWRITE, &handle));
+    TEST_ESP_OK(nvs_set_blob(handle, "big", blob.get(), blob_size));
+
+    // nvs_get_blob needs a buffer for the whole blob and reads all of it through the flash driver
+    std::unique_ptr<uint8_t[]> blob_read(new uint8_t[blob_size]);
+    size_t read_size = blob_size;
+    f.emu.clearStats();
+    TEST_ESP_OK(nvs_get_blob(handle, "big", blob_read.get(), &read_size));
+    const size_t copyReads = f.emu.getReadOps();
+    const size_t copyTime = f.emu.getTotalTime();
+    CHECK(memcmp(blob.get(), blob_read.get(), blob_size) == 0);
+
+    uint32_t crc = 0;
+    auto checksum = [](const void* data, size_t length, size_t offset, void* arg) -> esp_err_t {
+        uint32_t* crc = static_cast<uint32_t*>(arg);
+        *crc = esp_rom_crc32_le(*crc, static_cast<const uint8_t*>(data), length);
+        return ESP_OK;
+    };
+    f.emu.clearStats();
+    TEST_ESP_OK(nvs_get_blob_chunks(handle, "big", checksum, &crc));
+    const size_t chunkReads = f.emu.getReadOps();
+    const size_t chunkTime = f.emu.getTotalTime();
+    CHECK(crc == esp_rom_crc32_le(0, blob.get(), blob_size));
+    CHECK(chunkReads < copyReads);
+
+    s_perf << "Reading a " << blob_size << " byte blob: nvs_get_blob " << copyReads << " flash reads ("
+           << copyTime << " us) into a " << blob_size << " byte buffer, nvs_get_blob_chunks "
+           << chunkReads << " flash reads (" << chunkTime << " us) without a buffer" << std::endl;
+
+    nvs_close(handle);
+    TEST_ESP_OK(nvs_flash_deinit_partition(f.part.get_partition_name()));
+}
+
 TEST_CASE("Modification of values for Multi-page blobs are supported", "[nvs]")
 {
     const size_t blob_size = Page::CHUNK_MAX_SIZE *2;
@@ -3158,6 +4621,116 @@ TEST_CASE("check and read data from partition generated via manufacturing utilit
 
 }
 
+// Gives access to the item index, which is enabled by CONFIG_NVS_ITEM_INDEX
+class ItemIndexStorage : public Storage {
+public:
+    ItemIndexStorage(Partition *partition) : Storage(partition) { }
+
+    void disableItemIndex()
+    {
+        mItemIndex.clear();
+    }
+};
+
+TEST_CASE("benchmark item lookup on large partitions", "[nvs]")
+{
+    const size_t pageCounts[] = {8, 32, 128};
+    const size_t keysPerPage = 8;
+    const size_t rounds = 16;
+    char str[360];
+    fill_n(str, sizeof(str) - 1, 'x');
+    str[sizeof(str) - 1] = 0;
+
+    for (size_t pageCount : pageCounts) {
+        for (int useIndex = 0; useIndex < 2; ++useIndex) {
+            PartitionEmulationFixture f(0, pageCount);
+            ItemIndexStorage storage(&f.part);
+            REQUIRE(storage.init(0, pageCount) == ESP_OK);
+            if (!useIndex) {
+                storage.disableItemIndex();
+            }
+
+            const size_t keyCount = (pageCount - 1) * keysPerPage;
+            char key[16];
+            for (size_t i = 0; i < keyCount; ++i) {
+                snprintf(key, sizeof(key), "key%05d", static_cast<int>(i));
+                REQUIRE(storage.writeItem(1, ItemType::SZ, key, str, sizeof(str)) == ESP_OK);
+            }
+
+            f.emu.clearStats();
+            size_t size;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < keyCount; ++i) {
+                    snprintf(key, sizeof(key), "key%05d", static_cast<int>(i));
+                    REQUIRE(storage.getItemDataSize(1, ItemType::SZ, key, size) == ESP_OK);
+                }
+            }
+            auto hitTime = std::chrono::steady_clock::now() - start;
+            size_t hitReadOps = f.emu.getReadOps();
+
+            start = std::chrono::steady_clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < keyCount; ++i) {
+                    snprintf(key, sizeof(key), "miss%05d", static_cast<int>(i));
+                    REQUIRE(storage.getItemDataSize(1, ItemType::SZ, key, size) == ESP_ERR_NVS_NOT_FOUND);
+                }
+            }
+            auto missTime = std::chrono::steady_clock::now() - start;
+
+            s_perf << "Item lookup " << (useIndex ? "with" : "without") << " index, with " << pageCount
+                   << " pages and " << keyCount << " keys: "
+                   << std::chrono::duration_cast<std::chrono::nanoseconds>(hitTime).count() / (rounds * keyCount) << " ns per hit ("
+                   << hitReadOps / (rounds * keyCount) << " reads), "
+                   << std::chrono::duration_cast<std::chrono::nanoseconds>(missTime).count() / (rounds * keyCount) << " ns per miss"
+                   << std::endl;
+        }
+    }
+}
+
+TEST_CASE("benchmark storage initialization on large partitions", "[nvs]")
+{
+    struct {
+        size_t pageCount;
+        size_t keyCount;
+    } const configs[] = { {16, 0}, {16, 200}, {128, 0}, {128, 200}, {128, 1600} };
+    uint8_t blob[48];
+    fill_n(blob, sizeof(blob), 0x5a);
+
+    for (auto& config : configs) {
+        PartitionEmulationFixture f(0, config.pageCount);
+        {
+            Storage storage(&f.part);
+            REQUIRE(storage.init(0, config.pageCount) == ESP_OK);
+            char key[16];
+            // every other key is a blob, which is stored as a blob index and a data chunk
+            for (size_t i = 0; i < config.keyCount; ++i) {
+                snprintf(key, sizeof(key), "key%05d", static_cast<int>(i));
+                if (i % 2) {
+                    REQUIRE(storage.writeItem(1, ItemType::BLOB, key, blob, sizeof(blob)) == ESP_OK);
+                } else {
+                    REQUIRE(storage.writeItem(1, key, static_cast<uint32_t>(i)) == ESP_OK);
+                }
+            }
+        }
+
+        Storage storage(&f.part);
+        f.emu.clearStats();
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(storage.init(0, config.pageCount) == ESP_OK);
+        auto initTime = std::chrono::steady_clock::now() - start;
+
+        uint32_t value;
+        if (config.keyCount > 0) {
+            REQUIRE(storage.readItem(1, "key00000", value) == ESP_OK);
+        }
+
+        s_perf << "Storage init with " << config.pageCount << " pages and " << config.keyCount << " keys: "
+               << std::chrono::duration_cast<std::chrono::microseconds>(initTime).count() << " us, "
+               << f.emu.getReadOps() << " flash reads (" << f.emu.getTotalTime() << " us emulated)" << std::endl;
+    }
+}
+
 #if CONFIG_NVS_ENCRYPTION
 TEST_CASE("check underlying xts code for 32-byte size sector encryption", "[nvs]")
 {
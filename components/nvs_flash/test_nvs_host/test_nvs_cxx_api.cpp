@@ -191,3 +191,47 @@ TEST_CASE("NVSHandleSimple CXX api read/write blob", "[nvs cxx]")
 
     nvs::NVSPartitionManager::get_instance()->deinit_partition("nvs");
 }
+
+TEST_CASE("NVSHandleSimple CXX api read/write many", "[nvs cxx]")
+{
+    const uint32_t NVS_FLASH_SECTOR = 6;
+    const uint32_t NVS_FLASH_SECTOR_COUNT_MIN = 3;
+    PartitionEmulationFixture f(0, 10);
+    uint16_t u16 = 0x1234;
+    int64_t i64 = -5;
+    char str[] = "test string";
+    esp_err_t result;
+    shared_ptr<nvs::NVSHandle> handle;
+
+    REQUIRE(nvs::NVSPartitionManager::get_instance()->init_custom(&f.part, NVS_FLASH_SECTOR, NVS_FLASH_SECTOR_COUNT_MIN)
+            == ESP_OK);
+
+    handle = nvs::open_nvs_handle("test_ns", NVS_READWRITE, &result);
+    CHECK(result == ESP_OK);
+    REQUIRE(handle);
+
+    nvs_item_desc_t set_items[] = {
+        { "u16", NVS_TYPE_U16, &u16, 0, ESP_FAIL },
+        { "i64", NVS_TYPE_I64, &i64, 0, ESP_FAIL },
+        { "str", NVS_TYPE_STR, str, 0, ESP_FAIL },
+    };
+    CHECK(handle->set_many(set_items, 3) == ESP_OK);
+    CHECK(set_items[2].err == ESP_OK);
+    CHECK(handle->commit() == ESP_OK);
+
+    uint16_t read_u16 = 0;
+    int64_t read_i64 = 0;
+    char read_str[32] = {0};
+    nvs_item_desc_t get_items[] = {
+        { "u16", NVS_TYPE_U16, &read_u16, 0, ESP_FAIL },
+        { "i64", NVS_TYPE_I64, &read_i64, 0, ESP_FAIL },
+        { "str", NVS_TYPE_STR, read_str, sizeof(read_str), ESP_FAIL },
+    };
+    CHECK(handle->get_many(get_items, 3) == ESP_OK);
+    CHECK(read_u16 == u16);
+    CHECK(read_i64 == i64);
+    CHECK(string(read_str) == str);
+    CHECK(get_items[2].length == sizeof(str));
+
+    nvs::NVSPartitionManager::get_instance()->deinit_partition("nvs");
+}
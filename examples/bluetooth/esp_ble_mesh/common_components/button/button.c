@@ -287,7 +287,7 @@ button_handle_t iot_button_create(gpio_num_t gpio_num, button_active_t active_le
     btn->tap_rls_cb.tmr = xTimerCreate("btn_rls_tmr", btn->tap_rls_cb.interval, pdFALSE,
             &btn->tap_rls_cb, button_tap_rls_cb);
     #else
-    esp_timer_create_args_t tmr_param_rls;
+    esp_timer_create_args_t tmr_param_rls = {0};
     tmr_param_rls.arg = &btn->tap_rls_cb;
     tmr_param_rls.callback = button_tap_rls_cb;
     tmr_param_rls.dispatch_method = ESP_TIMER_TASK;
@@ -303,7 +303,7 @@ button_handle_t iot_button_create(gpio_num_t gpio_num, button_active_t active_le
     btn->tap_psh_cb.tmr = xTimerCreate("btn_psh_tmr", btn->tap_psh_cb.interval, pdFALSE,
             &btn->tap_psh_cb, button_tap_psh_cb);
     #else
-    esp_timer_create_args_t tmr_param_psh;
+    esp_timer_create_args_t tmr_param_psh = {0};
     tmr_param_psh.arg = &btn->tap_psh_cb;
     tmr_param_psh.callback = button_tap_psh_cb;
     tmr_param_psh.dispatch_method = ESP_TIMER_TASK;
@@ -352,7 +352,7 @@ esp_err_t iot_button_set_serial_cb(button_handle_t btn_handle, uint32_t start_af
         btn->press_serial_cb.tmr = xTimerCreate("btn_serial_tmr", btn->serial_thres_sec*1000 / portTICK_PERIOD_MS,
                             pdFALSE, btn, button_press_serial_cb);
         #else
-        esp_timer_create_args_t tmr_param_ser;
+        esp_timer_create_args_t tmr_param_ser = {0};
         tmr_param_ser.arg = btn;
         tmr_param_ser.callback = button_press_serial_cb;
         tmr_param_ser.dispatch_method = ESP_TIMER_TASK;
@@ -415,7 +415,7 @@ esp_err_t iot_button_add_custom_cb(button_handle_t btn_handle, uint32_t press_se
     #if !USE_ESP_TIMER
     cb_new->tmr = xTimerCreate("btn_press_tmr", cb_new->interval, pdFALSE, cb_new, button_press_cb);
     #else
-    esp_timer_create_args_t tmr_param_cus;
+    esp_timer_create_args_t tmr_param_cus = {0};
     tmr_param_cus.arg = cb_new;
     tmr_param_cus.callback = button_press_cb;
     tmr_param_cus.dispatch_method = ESP_TIMER_TASK;